@@ -0,0 +1,464 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group 
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+// Replays a camera path against the cut update without creating a GL
+// context. The temporary and primary gpu buffers are stood in for by plain
+// main memory, uploads are memcpys of the transfer list.
+
+#include <lamure/types.h>
+#include <lamure/ren/camera.h>
+#include <lamure/ren/config.h>
+#include <lamure/ren/controller.h>
+#include <lamure/ren/cut_database.h>
+#include <lamure/ren/cut_update_pool.h>
+#include <lamure/ren/data_provenance.h>
+#include <lamure/ren/model_database.h>
+#include <lamure/ren/ooc_cache.h>
+#include <lamure/ren/policy.h>
+
+#include <scm/core/math.h>
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace
+{
+
+struct frame_stats
+{
+    double cut_update_ms_;
+    size_t cut_size_;
+    size_t num_splits_;
+    size_t num_collapses_;
+    size_t num_uploaded_nodes_;
+    size_t num_requests_;
+    size_t num_resident_requests_;
+    size_t num_compressed_requests_;
+    size_t bytes_loaded_;
+};
+
+// one view matrix per line, as written by the rendering app
+std::vector<scm::math::mat4d> parse_camera_session_file(const std::string &session_file_path)
+{
+    std::ifstream camera_session_file(session_file_path);
+    if(!camera_session_file.is_open())
+    {
+        throw std::runtime_error("Unable to open camera session: " + session_file_path);
+    }
+
+    std::vector<scm::math::mat4d> view_matrices;
+    std::string line;
+
+    while(std::getline(camera_session_file, line))
+    {
+        std::istringstream line_stream(line);
+        scm::math::mat4d view_matrix;
+        int num_elements = 0;
+        for(; num_elements < 16 && (line_stream >> view_matrix[num_elements]); ++num_elements)
+        {
+        }
+        if(num_elements == 16)
+        {
+            view_matrices.push_back(view_matrix);
+        }
+    }
+
+    return view_matrices;
+}
+
+// same as interpolate() in apps/rendering/MatrixInterpolation.cpp
+scm::math::mat4d interpolate(const scm::math::mat4d &a, const scm::math::mat4d &b, const double t)
+{
+    glm::dmat4 ma, mb;
+    for(int i = 0; i < 16; ++i)
+    {
+        ma[i / 4][i % 4] = a[i];
+        mb[i / 4][i % 4] = b[i];
+    }
+
+    glm::dmat4 r = glm::mat4_cast(glm::slerp(glm::quat_cast(ma), glm::quat_cast(mb), t));
+    r[3] = (1.0 - t) * ma[3] + t * mb[3];
+
+    scm::math::mat4d result;
+    for(int i = 0; i < 16; ++i)
+    {
+        result[i] = r[i / 4][i % 4];
+    }
+    return result;
+}
+
+scm::math::vec3d camera_position(const scm::math::mat4d &view_matrix)
+{
+    scm::math::mat4d inverse_view = scm::math::inverse(view_matrix);
+    return scm::math::vec3d(inverse_view[12], inverse_view[13], inverse_view[14]);
+}
+
+// inserts views so that the camera moves at most step_size per frame
+std::vector<scm::math::mat4d> resample_camera_path(const std::vector<scm::math::mat4d> &views, const double step_size)
+{
+    if(step_size <= 0.0 || views.size() < 2)
+    {
+        return views;
+    }
+
+    std::vector<scm::math::mat4d> resampled;
+    for(size_t i = 0; i + 1 < views.size(); ++i)
+    {
+        double distance = scm::math::length(camera_position(views[i + 1]) - camera_position(views[i]));
+        size_t num_steps = std::max(size_t(1), size_t(std::ceil(distance / step_size)));
+        for(size_t step = 0; step < num_steps; ++step)
+        {
+            resampled.push_back(interpolate(views[i], views[i + 1], double(step) / num_steps));
+        }
+    }
+    resampled.push_back(views.back());
+    return resampled;
+}
+
+// circles the first model if no camera session is given
+std::vector<scm::math::mat4d> create_orbit(const scm::math::vec3f &center, const float radius, const size_t num_frames)
+{
+    std::vector<scm::math::mat4d> views;
+    for(size_t frame = 0; frame < num_frames; ++frame)
+    {
+        float angle = 2.f * float(M_PI) * frame / num_frames;
+        scm::math::vec3f eye = center + scm::math::vec3f(radius * std::cos(angle), 0.25f * radius, radius * std::sin(angle));
+        views.push_back(scm::math::mat4d(scm::math::make_look_at_matrix(eye, center, scm::math::vec3f(0.f, 1.f, 0.f))));
+    }
+    return views;
+}
+
+double percentile(std::vector<double> values, const double p)
+{
+    if(values.empty())
+    {
+        return 0.0;
+    }
+    size_t n = std::min(values.size() - 1, size_t(p * values.size()));
+    std::nth_element(values.begin(), values.begin() + n, values.end());
+    return values[n];
+}
+
+// nodes that were replaced by their children and groups of siblings
+// that were replaced by their parent since the previous cut
+void count_cut_changes(const std::unordered_set<lamure::node_t> &previous_cut, const std::unordered_set<lamure::node_t> &current_cut, const uint32_t fan_factor,
+                       size_t &num_splits, size_t &num_collapses)
+{
+    for(const auto node_id : previous_cut)
+    {
+        if(current_cut.find(node_id) == current_cut.end() && current_cut.find(node_id * fan_factor + 1) != current_cut.end())
+        {
+            ++num_splits;
+        }
+    }
+    for(const auto node_id : current_cut)
+    {
+        if(previous_cut.find(node_id) == previous_cut.end() && previous_cut.find(node_id * fan_factor + 1) != previous_cut.end())
+        {
+            ++num_collapses;
+        }
+    }
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    namespace po = boost::program_options;
+    namespace fs = boost::filesystem;
+
+    const std::string exec_name = (argc > 0) ? fs::basename(argv[0]) : "";
+
+    std::vector<std::string> model_filenames;
+    std::string camera_session_path = "";
+    std::string csv_path = "";
+    double step_size;
+    size_t num_orbit_frames;
+    unsigned frame_time_in_ms;
+    float error_threshold;
+    int window_width;
+    int window_height;
+    unsigned main_memory_budget;
+    unsigned compressed_memory_budget;
+    unsigned video_memory_budget;
+    unsigned max_upload_budget;
+
+    po::options_description desc("Usage: " + exec_name + " [OPTION]... INPUT...\n\n"
+                                 "Replays a camera path against the cut update without OpenGL.\n\n"
+                                 "Allowed Options");
+    desc.add_options()
+      ("help", "print help message")
+      ("input,i", po::value<std::vector<std::string>>(&model_filenames)->multitoken(), "specify input .bvh files")
+      ("camera-session,c", po::value<std::string>(&camera_session_path), "specify a recorded camera session (.csn), orbits the first model if omitted")
+      ("stepsize,s", po::value<double>(&step_size)->default_value(0.0), "interpolate the camera session so that the camera moves at most this far per frame (default=0, off)")
+      ("frames,n", po::value<size_t>(&num_orbit_frames)->default_value(600), "number of frames if no camera session is given (default=600)")
+      ("frame-time,t", po::value<unsigned>(&frame_time_in_ms)->default_value(0), "emulated render time per frame in ms (default=0)")
+      ("threshold", po::value<float>(&error_threshold)->default_value(LAMURE_DEFAULT_THRESHOLD), "specify the lod error threshold")
+      ("width,w", po::value<int>(&window_width)->default_value(1920), "specify emulated viewport width (default=1920)")
+      ("height,h", po::value<int>(&window_height)->default_value(1080), "specify emulated viewport height (default=1080)")
+      ("vram,v", po::value<unsigned>(&video_memory_budget)->default_value(2048), "specify emulated graphics memory budget in MB (default=2048)")
+      ("mem,m", po::value<unsigned>(&main_memory_budget)->default_value(4096), "specify main memory budget in MB (default=4096)")
+      ("compressed-mem", po::value<unsigned>(&compressed_memory_budget)->default_value(0), "specify main memory budget of the compressed cache in MB (default=0, off)")
+      ("upload,u", po::value<unsigned>(&max_upload_budget)->default_value(64), "specify maximum upload budget per frame in MB (default=64)")
+      ("csv", po::value<std::string>(&csv_path), "write per-frame statistics to this file");
+
+    po::positional_options_description pod;
+    pod.add("input", -1);
+
+    po::variables_map vm;
+
+    try
+    {
+        po::store(po::command_line_parser(argc, argv).options(desc).positional(pod).run(), vm);
+        po::notify(vm);
+
+        if(vm.count("help") || model_filenames.empty())
+        {
+            std::cout << desc;
+            return 0;
+        }
+    }
+    catch(std::exception &e)
+    {
+        std::cout << "Warning: " << e.what() << "\n" << desc;
+        return 0;
+    }
+
+    window_width = std::max(window_width, 1);
+    window_height = std::max(window_height, 1);
+
+    lamure::ren::policy *policy = lamure::ren::policy::get_instance();
+    policy->set_max_upload_budget_in_mb(max_upload_budget);
+    policy->set_render_budget_in_mb(video_memory_budget);
+    policy->set_out_of_core_budget_in_mb(main_memory_budget);
+    policy->set_compressed_cache_budget_in_mb(compressed_memory_budget);
+    policy->set_window_width(window_width);
+    policy->set_window_height(window_height);
+
+    lamure::ren::model_database *database = lamure::ren::model_database::get_instance();
+    lamure::ren::cut_database *cuts = lamure::ren::cut_database::get_instance();
+    lamure::ren::controller *controller = lamure::ren::controller::get_instance();
+
+    for(const auto &filename : model_filenames)
+    {
+        database->add_model(filename, std::to_string(database->num_models()));
+    }
+
+    controller->reset_system();
+
+    const lamure::context_t context_id = 0;
+    const lamure::view_t view_id = 0;
+
+    // model transforms and camera path
+    std::vector<scm::math::mat4f> model_transforms;
+    float scene_diameter = 0.f;
+    for(lamure::model_t model_id = 0; model_id < database->num_models(); ++model_id)
+    {
+        const auto &bvh = database->get_model(model_id)->get_bvh();
+        const auto &bb = bvh->get_bounding_boxes()[0];
+        scene_diameter = std::max(scm::math::length(bb.max_vertex() - bb.min_vertex()), scene_diameter);
+        model_transforms.push_back(scm::math::make_translation(bvh->get_translation()));
+    }
+
+    std::vector<scm::math::mat4d> views;
+    if(!camera_session_path.empty())
+    {
+        views = resample_camera_path(parse_camera_session_file(camera_session_path), step_size);
+    }
+    else
+    {
+        const auto &bvh = database->get_model(0)->get_bvh();
+        const auto &root_bb = bvh->get_bounding_boxes()[0];
+        views = create_orbit(root_bb.center() + bvh->get_translation(), scm::math::length(root_bb.max_vertex() - root_bb.min_vertex()), num_orbit_frames);
+    }
+
+    if(views.empty())
+    {
+        std::cout << "No camera views to replay" << std::endl;
+        return 1;
+    }
+
+    lamure::ren::camera camera(view_id, scm::math::mat4f(views.front()), scene_diameter, false, false);
+    camera.set_projection_matrix(30.0f, float(window_width) / float(window_height), 0.01f, 2.0f * scene_diameter);
+
+    // main memory stand-ins for the gpu buffers, budgets as in gpu_context
+    uint64_t size_of_provenance = lamure::ren::data_provenance::get_instance()->get_size_in_bytes();
+    size_t slot_size = database->get_slot_size();
+    size_t node_size_total = database->get_primitives_per_node() * size_of_provenance + slot_size;
+
+    size_t upload_budget_in_mb = std::max(size_t(max_upload_budget), size_t(LAMURE_MIN_UPLOAD_BUDGET));
+    lamure::node_t upload_budget_in_nodes = (upload_budget_in_mb * 1024u * 1024u) / node_size_total;
+    lamure::node_t render_budget_in_nodes = (size_t(video_memory_budget) * 1024u * 1024u) / node_size_total;
+
+    size_t provenance_slot_size = database->get_primitives_per_node() * size_of_provenance;
+
+    std::vector<char> temporary_storage_a(upload_budget_in_nodes * slot_size);
+    std::vector<char> temporary_storage_b(upload_budget_in_nodes * slot_size);
+    std::vector<char> temporary_storage_a_provenance(upload_budget_in_nodes * provenance_slot_size + 1);
+    std::vector<char> temporary_storage_b_provenance(upload_budget_in_nodes * provenance_slot_size + 1);
+    std::vector<char> primary_storage(render_budget_in_nodes * slot_size);
+
+    std::cout << "render budget: " << render_budget_in_nodes << " nodes, upload budget: " << upload_budget_in_nodes << " nodes" << std::endl;
+    std::cout << "replaying " << views.size() << " frames" << std::endl;
+
+    lamure::ren::ooc_cache *ooc_cache = lamure::ren::ooc_cache::get_instance();
+    lamure::ren::cut_update_pool *pool = new lamure::ren::cut_update_pool(context_id, upload_budget_in_nodes, render_budget_in_nodes);
+
+    std::vector<std::unordered_set<lamure::node_t>> previous_cuts(database->num_models());
+    std::vector<frame_stats> stats;
+    stats.reserve(views.size());
+
+    ooc_cache->begin_measure();
+    auto benchmark_start = std::chrono::steady_clock::now();
+
+    for(const auto &view : views)
+    {
+        frame_stats frame = {};
+
+        camera.set_view_matrix(view);
+
+        for(lamure::model_t model_id = 0; model_id < database->num_models(); ++model_id)
+        {
+            cuts->send_transform(context_id, model_id, model_transforms[model_id]);
+            cuts->send_threshold(context_id, model_id, error_threshold);
+            cuts->send_rendered(context_id, model_id);
+            database->get_model(model_id)->set_transform(model_transforms[model_id]);
+        }
+
+        cuts->send_camera(context_id, view_id, camera);
+
+        std::vector<scm::math::vec3d> corner_values = camera.get_frustum_corners();
+        double top_minus_bottom = scm::math::length((corner_values[2]) - (corner_values[0]));
+        cuts->send_height_divided_by_top_minus_bottom(context_id, view_id, float(window_height / top_minus_bottom));
+
+        size_t num_requests = ooc_cache->num_requests();
+        size_t num_resident_requests = ooc_cache->num_resident_requests();
+        size_t num_compressed_requests = ooc_cache->num_compressed_requests();
+        size_t bytes_loaded = ooc_cache->bytes_loaded();
+
+        auto update_start = std::chrono::steady_clock::now();
+
+        pool->dispatch_cut_update(temporary_storage_a.data(), temporary_storage_b.data(), temporary_storage_a_provenance.data(), temporary_storage_b_provenance.data());
+        while(pool->is_running())
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+
+        frame.cut_update_ms_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - update_start).count();
+        frame.num_requests_ = ooc_cache->num_requests() - num_requests;
+        frame.num_resident_requests_ = ooc_cache->num_resident_requests() - num_resident_requests;
+        frame.num_compressed_requests_ = ooc_cache->num_compressed_requests() - num_compressed_requests;
+        frame.bytes_loaded_ = ooc_cache->bytes_loaded() - bytes_loaded;
+
+        // what controller::dispatch does with the gpu
+        cuts->swap(context_id);
+
+        if(cuts->is_front_modified(context_id))
+        {
+            const std::vector<char> &source =
+                cuts->get_buffer(context_id) == lamure::ren::cut_database_record::temporary_buffer::BUFFER_A ? temporary_storage_a : temporary_storage_b;
+
+            for(const auto &transfer_desc : cuts->get_updated_set(context_id))
+            {
+                memcpy(primary_storage.data() + transfer_desc.dst_ * slot_size, source.data() + transfer_desc.src_ * slot_size, slot_size);
+                ++frame.num_uploaded_nodes_;
+            }
+
+            cuts->signal_upload_complete(context_id);
+        }
+
+        for(lamure::model_t model_id = 0; model_id < database->num_models(); ++model_id)
+        {
+            std::unordered_set<lamure::node_t> current_cut;
+            for(const auto &node_slot_aggregate : cuts->get_cut(context_id, view_id, model_id).complete_set())
+            {
+                current_cut.insert(node_slot_aggregate.node_id_);
+            }
+
+            count_cut_changes(previous_cuts[model_id], current_cut, database->get_model(model_id)->get_bvh()->get_fan_factor(), frame.num_splits_, frame.num_collapses_);
+
+            frame.cut_size_ += current_cut.size();
+            previous_cuts[model_id].swap(current_cut);
+        }
+
+        stats.push_back(frame);
+
+        if(frame_time_in_ms > 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(frame_time_in_ms));
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - benchmark_start).count();
+
+    ooc_cache->end_measure();
+
+    delete pool;
+
+    // report
+    std::vector<double> latencies;
+    size_t total_splits = 0, total_collapses = 0, total_uploads = 0, total_requests = 0, total_resident_requests = 0, total_compressed_requests = 0, total_bytes = 0;
+
+    for(const auto &frame : stats)
+    {
+        latencies.push_back(frame.cut_update_ms_);
+        total_splits += frame.num_splits_;
+        total_collapses += frame.num_collapses_;
+        total_uploads += frame.num_uploaded_nodes_;
+        total_requests += frame.num_requests_;
+        total_resident_requests += frame.num_resident_requests_;
+        total_compressed_requests += frame.num_compressed_requests_;
+        total_bytes += frame.bytes_loaded_;
+    }
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "frames: " << stats.size() << " in " << seconds << " s" << std::endl;
+    std::cout << "cut update latency in ms: p50 " << percentile(latencies, 0.5) << " / p95 " << percentile(latencies, 0.95) << " / p99 " << percentile(latencies, 0.99)
+              << " / max " << percentile(latencies, 1.0) << std::endl;
+    std::cout << "per frame: " << double(total_splits) / stats.size() << " splits, " << double(total_collapses) / stats.size() << " collapses, "
+              << double(total_uploads) / stats.size() << " uploaded nodes" << std::endl;
+    std::cout << "ooc cache hit rate: " << (total_requests > 0 ? 100.0 * total_resident_requests / total_requests : 100.0) << "% of " << total_requests << " requests"
+              << std::endl;
+    // requests that are neither resident nor compressed wait for the disk
+    size_t total_missed_requests = total_requests - total_resident_requests;
+    std::cout << "compressed cache hit rate: " << (total_missed_requests > 0 ? 100.0 * total_compressed_requests / total_missed_requests : 0.0) << "% of "
+              << total_missed_requests << " misses, " << total_missed_requests - total_compressed_requests << " left to the disk" << std::endl;
+    std::cout << "bytes loaded: " << total_bytes / (1024.0 * 1024.0) << " MB (" << (seconds > 0.0 ? total_bytes / (1024.0 * 1024.0) / seconds : 0.0) << " MB/s)"
+              << std::endl;
+
+    if(!csv_path.empty())
+    {
+        std::ofstream csv_file(csv_path);
+        csv_file << "frame,cut_update_ms,cut_size,splits,collapses,uploaded_nodes,ooc_requests,ooc_resident_requests,compressed_requests,bytes_loaded\n";
+        for(size_t i = 0; i < stats.size(); ++i)
+        {
+            const auto &frame = stats[i];
+            csv_file << i << "," << frame.cut_update_ms_ << "," << frame.cut_size_ << "," << frame.num_splits_ << "," << frame.num_collapses_ << ","
+                     << frame.num_uploaded_nodes_ << "," << frame.num_requests_ << "," << frame.num_resident_requests_ << "," << frame.num_compressed_requests_ << ","
+                     << frame.bytes_loaded_ << "\n";
+        }
+    }
+
+    return 0;
+}
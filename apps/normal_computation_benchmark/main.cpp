@@ -0,0 +1,204 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group 
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+// Compares the jacobi based plane fitting with the batched closed-form
+// plane fitting on synthetic, noisy planar neighbourhoods.
+
+#include <lamure/pre/normal_computation_batched_plane_fitting.h>
+#include <lamure/pre/normal_computation_plane_fitting.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace lamure;
+using namespace lamure::pre;
+
+namespace
+{
+
+// angle between two normals, ignoring orientation
+double angle_in_degrees(const scm::math::vec3f &a, const scm::math::vec3f &b)
+{
+    double la = scm::math::length(a);
+    double lb = scm::math::length(b);
+    if (la == 0.0 || lb == 0.0)
+        return 90.0;
+    double c = std::min(1.0, std::abs(double(scm::math::dot(a, b))) / (la * lb));
+    return std::acos(c) * 180.0 / M_PI;
+}
+
+// legacy path of normal_computation_plane_fitting::compute_normal
+vec3f fit_plane_jacobi(const normal_computation_plane_fitting &strategy, const vec3r *neighbours, const size_t num_neighbours)
+{
+    vec3r centroid(0.0, 0.0, 0.0);
+    for (size_t n = 0; n < num_neighbours; ++n)
+        centroid += neighbours[n];
+    centroid *= 1.0 / num_neighbours;
+
+    scm::math::mat3d covariance_mat = scm::math::mat3d::zero();
+    for (size_t n = 0; n < num_neighbours; ++n) {
+        vec3r d = neighbours[n] - centroid;
+        covariance_mat.m00 += d.x * d.x;
+        covariance_mat.m01 += d.x * d.y;
+        covariance_mat.m02 += d.x * d.z;
+        covariance_mat.m03 += d.y * d.x;
+        covariance_mat.m04 += d.y * d.y;
+        covariance_mat.m05 += d.y * d.z;
+        covariance_mat.m06 += d.z * d.x;
+        covariance_mat.m07 += d.z * d.y;
+        covariance_mat.m08 += d.z * d.z;
+    }
+
+    real *eigenvalues = new real[3];
+    real **eigenvectors = new real *[3];
+    for (int i = 0; i < 3; ++i)
+        eigenvectors[i] = new real[3];
+
+    strategy.jacobi_rotation(covariance_mat, eigenvalues, eigenvectors);
+    vec3f normal(eigenvectors[0][0], eigenvectors[1][0], eigenvectors[2][0]);
+
+    delete[] eigenvalues;
+    for (int i = 0; i < 3; ++i)
+        delete[] eigenvectors[i];
+    delete[] eigenvectors;
+
+    return normal;
+}
+
+}
+
+int main(int argc, const char *argv[])
+{
+    namespace po = boost::program_options;
+    namespace fs = boost::filesystem;
+
+    const std::string exec_name = (argc > 0) ? fs::basename(argv[0]) : "";
+
+    size_t num_surfels;
+    uint16_t num_neighbours;
+    double noise;
+    unsigned seed;
+
+    po::options_description desc("Usage: " + exec_name + " [OPTION]...\n\n"
+                                 "Compares plane fitting normal computation strategies on synthetic data.\n\n"
+                                 "Allowed Options");
+    desc.add_options()
+        ("help,h", "print help message")
+        ("surfels,s", po::value<size_t>(&num_surfels)->default_value(1000000), "number of surfels")
+        ("neighbours,k", po::value<uint16_t>(&num_neighbours)->default_value(24), "number of neighbours per surfel")
+        ("noise,n", po::value<double>(&noise)->default_value(0.01), "standard deviation of the offset along the normal, relative to the patch radius")
+        ("seed", po::value<unsigned>(&seed)->default_value(42), "random seed");
+
+    po::variables_map vm;
+    try {
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+        po::notify(vm);
+    }
+    catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl << desc;
+        return EXIT_FAILURE;
+    }
+
+    if (vm.count("help")) {
+        std::cout << desc;
+        return EXIT_SUCCESS;
+    }
+
+    num_neighbours = std::max(num_neighbours, uint16_t(3));
+
+    // random planar patches around the origin
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    std::normal_distribution<double> gauss(0.0, noise);
+
+    std::vector<vec3f> reference_normals(num_surfels);
+    std::vector<vec3r> neighbours(num_surfels * num_neighbours);
+
+    for (size_t s = 0; s < num_surfels; ++s) {
+        vec3r normal;
+        do {
+            normal = vec3r(uniform(rng), uniform(rng), uniform(rng));
+        } while (scm::math::length(normal) < 0.1 || scm::math::length(normal) > 1.0);
+        normal = scm::math::normalize(normal);
+
+        vec3r tangent = scm::math::normalize(scm::math::cross(normal, std::abs(normal.x) < 0.9 ? vec3r(1.0, 0.0, 0.0) : vec3r(0.0, 1.0, 0.0)));
+        vec3r bitangent = scm::math::cross(normal, tangent);
+
+        for (size_t n = 0; n < num_neighbours; ++n)
+            neighbours[s * num_neighbours + n] = tangent * uniform(rng) + bitangent * uniform(rng) + normal * gauss(rng);
+
+        reference_normals[s] = vec3f(normal);
+    }
+
+    std::cout << "surfels: " << num_surfels << ", neighbours: " << num_neighbours << ", noise: " << noise << std::endl;
+
+    // jacobi
+    normal_computation_plane_fitting jacobi_strategy(num_neighbours);
+    std::vector<vec3f> jacobi_normals(num_surfels);
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t s = 0; s < num_surfels; ++s)
+        jacobi_normals[s] = fit_plane_jacobi(jacobi_strategy, &neighbours[s * num_neighbours], num_neighbours);
+    double jacobi_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // batched, including the gather into SoA layout
+    const size_t batch_size = normal_computation_batched_plane_fitting::batch_size;
+    std::vector<vec3f> batched_normals(num_surfels);
+    std::vector<real> x(num_neighbours * batch_size), y(num_neighbours * batch_size), z(num_neighbours * batch_size);
+    std::vector<uint32_t> counts(batch_size);
+    std::vector<vec3f> batch_normals(batch_size);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t batch_begin = 0; batch_begin < num_surfels; batch_begin += batch_size) {
+        const size_t batch_end = std::min(batch_begin + batch_size, num_surfels);
+        std::fill(x.begin(), x.end(), 0.0);
+        std::fill(y.begin(), y.end(), 0.0);
+        std::fill(z.begin(), z.end(), 0.0);
+        std::fill(counts.begin(), counts.end(), 0);
+
+        for (size_t s = batch_begin; s < batch_end; ++s) {
+            const size_t lane = s - batch_begin;
+            for (size_t n = 0; n < num_neighbours; ++n) {
+                const vec3r &p = neighbours[s * num_neighbours + n];
+                x[n * batch_size + lane] = p.x;
+                y[n * batch_size + lane] = p.y;
+                z[n * batch_size + lane] = p.z;
+            }
+            counts[lane] = num_neighbours;
+        }
+
+        normal_computation_batched_plane_fitting::fit_planes(x.data(), y.data(), z.data(), counts.data(), num_neighbours, batch_normals.data());
+        std::copy(batch_normals.begin(), batch_normals.begin() + (batch_end - batch_begin), batched_normals.begin() + batch_begin);
+    }
+    double batched_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // accuracy
+    double jacobi_error = 0.0, batched_error = 0.0, max_deviation = 0.0, mean_deviation = 0.0;
+    for (size_t s = 0; s < num_surfels; ++s) {
+        jacobi_error += angle_in_degrees(jacobi_normals[s], reference_normals[s]);
+        batched_error += angle_in_degrees(batched_normals[s], reference_normals[s]);
+        double deviation = angle_in_degrees(jacobi_normals[s], batched_normals[s]);
+        mean_deviation += deviation;
+        max_deviation = std::max(max_deviation, deviation);
+    }
+
+    std::cout << "jacobi:  " << jacobi_seconds << " s (" << num_surfels / jacobi_seconds / 1e6 << " M surfels/s), "
+              << "mean error " << jacobi_error / num_surfels << " deg" << std::endl;
+    std::cout << "batched: " << batched_seconds << " s (" << num_surfels / batched_seconds / 1e6 << " M surfels/s), "
+              << "mean error " << batched_error / num_surfels << " deg" << std::endl;
+    std::cout << "speedup: " << jacobi_seconds / batched_seconds << "x" << std::endl;
+    std::cout << "deviation between strategies: mean " << mean_deviation / num_surfels << " deg, max " << max_deviation << " deg" << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -138,7 +138,8 @@ int main(int argc, const char *argv[])
         ("normal-computation-algo",
          po::value<std::string>()->default_value("planefitting"),
          "Algorithm for computing surfel normal. Possible values:\n"
-         "  planefitting ")
+         "  planefitting \n"
+         "  batchedplanefitting - plane fitting on blocks of surfels with a closed-form eigen solver")
 
          ("radius-computation-algo",
          po::value<std::string>()->default_value("averagedistance"),
@@ -325,6 +326,8 @@ int main(int argc, const char *argv[])
 
         if (normal_computation_algo == "planefitting")
             desc.normal_computation_algo      = lamure::pre::normal_computation_algorithm::plane_fitting;
+        else if (normal_computation_algo == "batchedplanefitting")
+            desc.normal_computation_algo      = lamure::pre::normal_computation_algorithm::batched_plane_fitting;
         else {
             std::cerr << "Unknown algorithm for computing surfel normal" << details_msg;
             return EXIT_FAILURE;
@@ -15,6 +15,7 @@
 #include <lamure/pvs/visibility_test_id_histogram_renderer.h>
 #include <lamure/pvs/visibility_test_id_histogram_renderer_corners.h>
 #include <lamure/pvs/visibility_test_simple_randomized_id_histogram_renderer.h>
+#include <lamure/pvs/visibility_test_software_renderer.h>
 
 #include <lamure/pvs/grid.h>
 #include <lamure/pvs/grid_octree.h>
@@ -70,7 +71,7 @@ int main(int argc, char** argv)
                                "Allowed Options");
     desc.add_options()
       ("pvs-file,p", po::value<std::string>(&pvs_output_file_path), "specify output file of calculated pvs data (.pvs)")
-      ("vistest", po::value<std::string>(&visibility_test_type)->default_value("hrc"), "specify type of visibility test to be used. Default is histogram renderer with corners. (histogram renderer 'hr', histogram renderer with corners 'hrc', simple randomized histogram renderer 'srhr')")
+      ("vistest", po::value<std::string>(&visibility_test_type)->default_value("hrc"), "specify type of visibility test to be used. Default is histogram renderer with corners. (histogram renderer 'hr', histogram renderer with corners 'hrc', simple randomized histogram renderer 'srhr', software renderer without OpenGL 'swr')")
       ("gridtype", po::value<std::string>(&grid_type)->default_value("irregular_compressed"), "specify type of grid to store visibility data. Default is irregular compressed grid. ('regular', 'regular_compressed', 'irregular', 'irregular_compressed', octree', 'octree_compressed', octree_hierarchical', 'octree_hierarchical_v2', 'octree_hierarchical_v3')")
       ("gridsize", po::value<unsigned int>(&grid_size)->default_value(1), "specify size/depth of the grid used for the visibility test (depends on chosen grid type)")
       ("oversize", po::value<double>(&oversize_factor)->default_value(1.5), "factor the grid bounds will be scaled by. Default is 1.5 (so grid bounds will exceed scene bounds by factor of 1.5)")
@@ -106,6 +107,10 @@ int main(int argc, char** argv)
     {
         vt = new lamure::pvs::visibility_test_simple_randomized_id_histogram_renderer();
     }
+    else if(visibility_test_type == "swr")
+    {
+        vt = new lamure::pvs::visibility_test_software_renderer();
+    }
     else
     {
         std::cout << "Invalid visibility test: " << visibility_test_type << ".\n" << desc;
@@ -470,7 +470,7 @@ render_one_pass_LQ(lamure::context_t context_id,
             size_t surfels_per_node_of_model = bvh->get_primitives_per_node();
             //store culling result and push it back for second pass#
 
-            std::vector<scm::gl::boxf>const & bounding_box_vector = bvh->get_bounding_boxes();
+            auto const & bounding_box_vector = bvh->get_bounding_boxes();
 
             upload_transformation_matrices(camera, model_id, RenderPass::ONE_PASS_LQ);
 
@@ -619,7 +619,7 @@ render_one_pass_HQ(lamure::context_t context_id,
         std::vector<cut::node_slot_aggregate> renderable = cut.complete_set();
         scm::math::mat4 inv_m_matrix = (  (( (camera.get_view_matrix()) ) * mat4(model_transformations_[model_id]) ) );
 
-        std::vector<scm::gl::boxf>const & bounding_box_vector = bvh->get_bounding_boxes();
+        auto const & bounding_box_vector = bvh->get_bounding_boxes();
         std::sort(renderable.begin(), renderable.end(), [&](cut::node_slot_aggregate const & lhs,
                                                             cut::node_slot_aggregate const & rhs)
                                                             {  
@@ -814,7 +814,7 @@ render_two_pass_HQ(lamure::context_t context_id,
             size_t surfels_per_node_of_model = bvh->get_primitives_per_node();
             //store culling result and push it back for second pass#
 
-            std::vector<scm::gl::boxf>const & bounding_box_vector = bvh->get_bounding_boxes();
+            auto const & bounding_box_vector = bvh->get_bounding_boxes();
 
             upload_transformation_matrices(camera, model_id, RenderPass::DEPTH);
 
@@ -1122,7 +1122,7 @@ render(lamure::context_t context_id, lamure::ren::camera const& camera, const la
                
                size_t surfels_per_node_of_model = bvh->get_primitives_per_node();
 
-               std::vector<scm::gl::boxf>const & bounding_box_vector = bvh->get_bounding_boxes();
+               auto const & bounding_box_vector = bvh->get_bounding_boxes();
 
                scm::gl::frustum frustum_by_model = camera.get_frustum_by_model(model_transformations_[model_id]);
 
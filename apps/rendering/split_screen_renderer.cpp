@@ -292,7 +292,7 @@ render(lamure::context_t context_id, lamure::ren::camera const& camera, const la
                             uint32_t surfels_per_node_of_model = bvh->get_primitives_per_node();
                             //store culling result and push it back for second pass#
 
-                            std::vector<scm::gl::boxf>const & bounding_box_vector = bvh->get_bounding_boxes();
+                            auto const & bounding_box_vector = bvh->get_bounding_boxes();
 
 
                             upload_transformation_matrices(camera, model_id, 1);
@@ -1162,7 +1162,7 @@ void draw_resources(const lamure::context_t context_id, const lamure::view_t vie
         scm::math::mat4d model_matrix = model_transformations_[model_id];
         vis_line_shader_->uniform("model_matrix", scm::math::mat4f(model_matrix));
         
-        std::vector<scm::gl::boxf>const & bounding_box_vector = bvh->get_bounding_boxes();
+        auto const & bounding_box_vector = bvh->get_bounding_boxes();
         scm::gl::frustum frustum_by_model = camera_->get_frustum_by_model(scm::math::mat4f(model_matrix));
         
 
@@ -1277,7 +1277,7 @@ void draw_all_models(const lamure::context_t context_id, const lamure::view_t vi
     shader->uniform("model_radius_scale", 1.f);
 
     size_t surfels_per_node = database->get_primitives_per_node();
-    std::vector<scm::gl::boxf>const & bounding_box_vector = bvh->get_bounding_boxes();
+    auto const & bounding_box_vector = bvh->get_bounding_boxes();
     
     scm::gl::frustum frustum_by_model = camera_->get_frustum_by_model(scm::math::mat4f(model_matrix));
     
@@ -0,0 +1,232 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group 
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+// Measures the throughput of the mip pyramid generation of the virtual
+// texturing preprocessor, once for the 2x2 box filter alone and once for
+// complete preprocessor runs with different thread counts.
+
+#include <lamure/vt/pre/Bitmap.h>
+#include <lamure/vt/pre/Preprocessor.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace vt::pre;
+
+namespace
+{
+
+Bitmap::PIXEL_FORMAT parsePixelFormat(const std::string &formatStr)
+{
+    if (formatStr == "r") {
+        return Bitmap::PIXEL_FORMAT::R8;
+    }
+    else if (formatStr == "rgb") {
+        return Bitmap::PIXEL_FORMAT::RGB8;
+    }
+    else if (formatStr == "rgba") {
+        return Bitmap::PIXEL_FORMAT::RGBA8;
+    }
+
+    throw std::runtime_error("Invalid pixel format given.");
+}
+
+void writeSyntheticImage(const std::string &fileName, size_t width, size_t height, Bitmap::PIXEL_FORMAT pxFormat)
+{
+    std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open File \"" + fileName + "\".");
+    }
+
+    std::mt19937 rng(42);
+    std::vector<uint8_t> row(width * Bitmap::pixelSize(pxFormat));
+
+    for (size_t y = 0; y < height; ++y) {
+        for (auto &byte : row) {
+            byte = (uint8_t)(rng() & 0xff);
+        }
+
+        file.write((char *)row.data(), row.size());
+    }
+}
+
+// box filter throughput in source megapixels per second
+double benchmarkBoxFilter(Bitmap::PIXEL_FORMAT pxFormat, size_t tileSize, size_t padding, size_t iterations)
+{
+    Bitmap src(tileSize, tileSize, pxFormat);
+    Bitmap dest(tileSize, tileSize, pxFormat);
+
+    std::mt19937 rng(7);
+
+    for (size_t i = 0; i < src.getByteSize(); ++i) {
+        src.getData()[i] = (uint8_t)(rng() & 0xff);
+    }
+
+    size_t inner = tileSize - (padding << 1);
+    size_t half = inner >> 1;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < iterations; ++i) {
+        // the four children of a tile, as deflated by the preprocessor
+        dest.deflateRectFrom(src, padding, padding, padding + half, padding + half, inner, inner);
+        dest.deflateRectFrom(src, padding, padding, padding, padding + half, inner, inner);
+        dest.deflateRectFrom(src, padding, padding, padding + half, padding, inner, inner);
+        dest.deflateRectFrom(src, padding, padding, padding, padding, inner, inner);
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return (double)iterations * 4 * inner * inner / seconds / 1e6;
+}
+
+bool filesEqual(const std::string &fileName0, const std::string &fileName1)
+{
+    std::ifstream file0(fileName0, std::ios::binary);
+    std::ifstream file1(fileName1, std::ios::binary);
+
+    std::vector<char> buffer0(1 << 20);
+    std::vector<char> buffer1(1 << 20);
+
+    while (file0 && file1) {
+        file0.read(buffer0.data(), buffer0.size());
+        file1.read(buffer1.data(), buffer1.size());
+
+        if (file0.gcount() != file1.gcount() || std::memcmp(buffer0.data(), buffer1.data(), (size_t)file0.gcount()) != 0) {
+            return false;
+        }
+    }
+
+    return !file0 && !file1;
+}
+
+}
+
+int main(int argc, const char **argv)
+{
+    namespace po = boost::program_options;
+    namespace fs = boost::filesystem;
+
+    std::string inputFile;
+    std::string workingDir;
+    std::string formatStr;
+    size_t width;
+    size_t height;
+    size_t tileSize;
+    size_t padding;
+    size_t memoryMB;
+    size_t filterIterations;
+    std::vector<size_t> threadCounts;
+
+    po::options_description desc("Usage: " + std::string(argv[0]) + " [OPTION]\n\nAllowed Options");
+    desc.add_options()
+      ("help,h", "print help message")
+      ("input,f", po::value<std::string>(&inputFile), "raw input image, a synthetic image is generated if omitted")
+      ("working-dir,o", po::value<std::string>(&workingDir)->default_value(fs::temp_directory_path().string()), "directory for the generated image and atlases")
+      ("format", po::value<std::string>(&formatStr)->default_value("rgb"), "pixel format of input and output (r, rgb, rgba)")
+      ("width", po::value<size_t>(&width)->default_value(8192), "image width in pixels")
+      ("height", po::value<size_t>(&height)->default_value(8192), "image height in pixels")
+      ("tile-size", po::value<size_t>(&tileSize)->default_value(256), "tile edge length in pixels")
+      ("padding", po::value<size_t>(&padding)->default_value(1), "tile padding in pixels")
+      ("memory", po::value<size_t>(&memoryMB)->default_value(1024), "memory budget of the preprocessor in MB")
+      ("filter-iterations", po::value<size_t>(&filterIterations)->default_value(500), "tiles filtered in the box filter benchmark")
+      ("threads", po::value<std::vector<size_t>>(&threadCounts)->multitoken(), "thread counts of the preprocessor runs, default 1 and all cores");
+
+    po::variables_map vm;
+
+    try {
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+        po::notify(vm);
+
+        if (vm.count("help")) {
+            std::cout << desc;
+            return 0;
+        }
+    }
+    catch (std::exception &e) {
+        std::cout << "Warning: " << e.what() << std::endl << desc;
+        return 1;
+    }
+
+    Bitmap::PIXEL_FORMAT pxFormat = parsePixelFormat(formatStr);
+
+    if (threadCounts.empty()) {
+        threadCounts.push_back(1);
+
+        if (std::thread::hardware_concurrency() > 1) {
+            threadCounts.push_back(std::thread::hardware_concurrency());
+        }
+    }
+
+    std::cout << "box filter (" << tileSize << " px tiles):" << std::endl;
+    std::cout << "\tr    : " << benchmarkBoxFilter(Bitmap::PIXEL_FORMAT::R8, tileSize, padding, filterIterations) << " MPixel/s" << std::endl;
+    std::cout << "\trgb  : " << benchmarkBoxFilter(Bitmap::PIXEL_FORMAT::RGB8, tileSize, padding, filterIterations) << " MPixel/s" << std::endl;
+    std::cout << "\trgba : " << benchmarkBoxFilter(Bitmap::PIXEL_FORMAT::RGBA8, tileSize, padding, filterIterations) << " MPixel/s" << std::endl << std::endl;
+
+    bool syntheticInput = inputFile.empty();
+
+    if (syntheticInput) {
+        inputFile = (fs::path(workingDir) / "vt_pyramid_benchmark.raw").string();
+
+        std::cout << "generating " << width << " x " << height << " px image \"" << inputFile << "\"" << std::endl << std::endl;
+        writeSyntheticImage(inputFile, width, height, pxFormat);
+    }
+
+    std::cout << "preprocessor (" << width << " x " << height << " px, " << memoryMB << " MB):" << std::endl;
+
+    std::string referenceAtlas;
+    bool identical = true;
+
+    for (size_t threadCount : threadCounts) {
+        std::string destFileName = (fs::path(workingDir) / ("vt_pyramid_benchmark_" + std::to_string(threadCount))).string();
+
+        auto start = std::chrono::steady_clock::now();
+
+        {
+            Preprocessor pre(inputFile, pxFormat, width, height);
+            pre.setOutput(destFileName, pxFormat, AtlasFile::LAYOUT::PACKED, tileSize, tileSize, padding);
+            pre.setThreadCount(threadCount);
+            pre.run(memoryMB * 1024 * 1024);
+        }
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << "\t" << threadCount << " threads: " << seconds << " s, " << (double)width * height / seconds / 1e6 << " MPixel/s" << std::endl;
+
+        std::string atlasFileName = destFileName + ".atlas";
+
+        if (referenceAtlas.empty()) {
+            referenceAtlas = atlasFileName;
+        }
+        else {
+            identical = identical && filesEqual(referenceAtlas, atlasFileName);
+            fs::remove(atlasFileName);
+        }
+    }
+
+    fs::remove(referenceAtlas);
+
+    if (syntheticInput) {
+        fs::remove(inputFile);
+    }
+
+    if (threadCounts.size() > 1) {
+        std::cout << std::endl << "atlases " << (identical ? "identical" : "DIFFER") << " across thread counts" << std::endl;
+    }
+
+    return identical ? 0 : 1;
+}
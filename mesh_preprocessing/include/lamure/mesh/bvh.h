@@ -25,7 +25,7 @@ class bvh : public lamure::ren::bvh
 
     void write_lod_file(const std::string& lod_filename);
 
-    std::vector<Triangle_Chartid>& get_triangles(uint32_t node_id) { return triangles_map_[node_id]; }
+    std::vector<Triangle_Chartid>& get_triangles(uint32_t node_id) { return triangles_[node_id]; }
 
   protected:
     struct bvh_node
@@ -41,8 +41,8 @@ class bvh : public lamure::ren::bvh
 
     void simplify(std::vector<Triangle_Chartid>& left_child_tris, std::vector<Triangle_Chartid>& right_child_tris, std::vector<Triangle_Chartid>& output_tris, bool contrain_edges);
 
-    // node_id -> triangles
-    std::map<uint32_t, std::vector<Triangle_Chartid>> triangles_map_;
+    // triangles per node, indexed by node id and sized before the nodes are filled concurrently
+    std::vector<std::vector<Triangle_Chartid>> triangles_;
 
 
 #ifdef FLUSH_APP_STATE
@@ -54,7 +54,7 @@ class bvh : public lamure::ren::bvh
     template <class Archive>
     void serialize(Archive& ar, const unsigned int version)
     {
-        ar& triangles_map_;
+        ar& triangles_;
         ar& num_nodes_;
         ar& fan_factor_;
         ar& depth_;
@@ -5,9 +5,10 @@
 #include <lamure/mesh/tools.h>
 
 #include <limits>
-#include <queue>
 #include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <thread>
 
 #include <CGAL/IO/print_wavefront.h>
 
@@ -68,102 +69,77 @@ void bvh::create_hierarchy(std::vector<Triangle_Chartid>& triangles)
             max.z = centroid.z;
     }
 
-    std::queue<bvh_node> q;
-    bvh_node root{
+    // the hierarchy is a complete binary tree, the leaf level is the first one
+    // on which no node holds more than primitives_per_node_ triangles
+    depth_ = 1;
+    while((triangles.size() + get_length_of_depth(depth_) - 1) / get_length_of_depth(depth_) > primitives_per_node_)
+    {
+        ++depth_;
+    }
+
+    // nodes are stored by node id, so nodes of one depth can be processed in parallel
+    std::vector<bvh_node> nodes(get_first_node_id_of_depth(depth_ + 1));
+    nodes[0] = bvh_node{
         0, // depth
         min,
         max,
         0,               // begin
         triangles.size() // end
     };
-    q.push(root);
-
-    std::vector<bvh_node> nodes;
 
-    // remember the root
-    nodes.push_back(root);
+    uint32_t num_threads = std::max(1u, std::thread::hardware_concurrency());
 
-    while(q.size() > 0)
+    for(uint32_t d = 0; d < depth_; ++d)
     {
-        bvh_node node = q.front(); // get the first element
-        q.pop();                   // remove the first element
+        uint32_t first_node = get_first_node_id_of_depth(d);
+        uint32_t num_of_nodes = get_length_of_depth(d);
 
-        // Determine longest  axis of the node
-        vec3f extend = node.max_ - node.min_;
-        int32_t axis = 0; // 0 = x axis, 1 = y axis, 2 = z axis
-        if(extend.y > extend.x)
-        {
-            axis = 1;
-            if(extend.z > extend.y)
-            {
-                axis = 2;
-            }
-        }
-        else if(extend.z > extend.x)
-        {
-            axis = 2;
-        }
+        auto lambda_split = [&](uint64_t i, uint32_t id) -> void {
+            uint32_t node_id = first_node + i;
+            const bvh_node& node = nodes[node_id];
 
-        // Sort all tris (of current node) by their centroid along the longest axis
-        std::sort(triangles.begin() + node.begin_, triangles.begin() + node.end_, [&](const Triangle_Chartid& a, const Triangle_Chartid& b) {
-            if(axis == 0)
-            {
-                return a.get_centroid().x < b.get_centroid().x;
-            }
-            else if(axis == 1)
+            // Determine longest  axis of the node
+            vec3f extend = node.max_ - node.min_;
+            int32_t axis = 0; // 0 = x axis, 1 = y axis, 2 = z axis
+            if(extend.y > extend.x)
             {
-                return a.get_centroid().y < b.get_centroid().y;
+                axis = 1;
+                if(extend.z > extend.y)
+                {
+                    axis = 2;
+                }
             }
-            else if(axis == 2)
+            else if(extend.z > extend.x)
             {
-                return a.get_centroid().z < b.get_centroid().z;
+                axis = 2;
             }
 
-            return true;
-        });
-
-        // determine split
-        uint64_t split_id = (node.begin_ + node.end_) / 2;
-
-        // first create the children
+            // determine split
+            uint64_t split_id = (node.begin_ + node.end_) / 2;
 
-        bvh_node left_child{node.depth_ + 1, node.min_, node.max_, node.begin_, split_id};
-
-        bvh_node right_child{node.depth_ + 1, node.min_, node.max_, split_id, node.end_};
-
-        // determine bounds of both children
-        if(axis == 0)
-        {
-            left_child.max_.x = triangles[split_id].get_centroid().x;
-            right_child.min_.x = triangles[split_id + 1].get_centroid().x;
-        }
-        else if(axis == 1)
-        {
-            left_child.max_.y = triangles[split_id].get_centroid().y;
-            right_child.min_.y = triangles[split_id + 1].get_centroid().y;
-        }
-        else if(axis == 2)
-        {
-            left_child.max_.z = triangles[split_id].get_centroid().z;
-            right_child.min_.z = triangles[split_id + 1].get_centroid().z;
-        }
+            bvh_node left_child{node.depth_ + 1, node.min_, node.max_, node.begin_, split_id};
+            bvh_node right_child{node.depth_ + 1, node.min_, node.max_, split_id, node.end_};
 
-        if(left_child.end_ - left_child.begin_ > primitives_per_node_ || right_child.end_ - right_child.begin_ > primitives_per_node_)
-        {
-            q.push(left_child);
-            q.push(right_child);
-        }
+            if(split_id < node.end_)
+            {
+                // only the median has to be in place, the tris of the node are partitioned around it
+                std::nth_element(triangles.begin() + node.begin_, triangles.begin() + split_id, triangles.begin() + node.end_,
+                                 [axis](const Triangle_Chartid& a, const Triangle_Chartid& b) { return a.get_centroid()[axis] < b.get_centroid()[axis]; });
+
+                // determine bounds of both children
+                float split_value = triangles[split_id].get_centroid()[axis];
+                left_child.max_[axis] = split_value;
+                right_child.min_[axis] = split_value;
+            }
 
-        nodes.push_back(left_child);
-        nodes.push_back(right_child);
+            nodes[get_child_id(node_id, 0)] = left_child;
+            nodes[get_child_id(node_id, 1)] = right_child;
+        };
 
-        if(left_child.depth_ > depth_)
-        {
-            std::cout << "depth: " << left_child.depth_ << " (+" << get_length_of_depth(left_child.depth_) << " nodes)" << std::endl;
-        }
-        depth_ = std::max(left_child.depth_, depth_);
+        lamure::mesh::parallel_for(schedule_t::DYNAMIC, num_threads, num_of_nodes, lambda_split, false);
 
-    } // end of while
+        std::cout << "depth: " << d + 1 << " (+" << get_length_of_depth(d + 1) << " nodes)" << std::endl;
+    }
 
     std::cout << "Downsweep done" << std::endl;
     std::cout << "hierarchy depth: " << depth_ << std::endl;
@@ -171,7 +147,10 @@ void bvh::create_hierarchy(std::vector<Triangle_Chartid>& triangles)
     std::cout << "hierarchy min: " << nodes[0].min_ << std::endl;
     std::cout << "hierarchy max: " << nodes[0].max_ << std::endl;
 
-    // populate the triangles map (but only from the leaf level)
+    triangles_.clear();
+    triangles_.resize(nodes.size());
+
+    // populate the triangles of the nodes (but only from the leaf level)
     {
         uint32_t first_node = get_first_node_id_of_depth(depth_);
         uint32_t num_of_nodes = get_length_of_depth(depth_);
@@ -186,16 +165,14 @@ void bvh::create_hierarchy(std::vector<Triangle_Chartid>& triangles)
 
         std::cout << "actual triangles per node " << primitives_per_node_ << std::endl;
 
-        for(uint32_t node_id = first_node; node_id < first_node + num_of_nodes; ++node_id)
-        {
+        auto lambda_copy = [&](uint64_t i, uint32_t id) -> void {
+            uint32_t node_id = first_node + i;
             bvh_node& node = nodes[node_id];
 
-            // copy triangles to triangle map
-            for(uint64_t tri = node.begin_; tri < node.end_; ++tri)
-            {
-                triangles_map_[node_id].push_back(triangles[tri]);
-            }
-        }
+            triangles_[node_id].assign(triangles.begin() + node.begin_, triangles.begin() + node.end_);
+        };
+
+        lamure::mesh::parallel_for(schedule_t::STATIC, num_threads, num_of_nodes, lambda_copy, false);
     }
 
     std::cout << "triangles map populated" << std::endl;
@@ -205,34 +182,29 @@ void bvh::create_hierarchy(std::vector<Triangle_Chartid>& triangles)
     //  for each node at that depth
     //    take all triangles from the two children
     //    simplify these (half the number of triangles)
+    // nodes of one depth only read their children and write their own triangles
 
     uint32_t num_nodes_todo = 0;
     for(int d = depth_ - 1; d >= 0; d--)
     {
         num_nodes_todo += get_length_of_depth(d);
     }
-    uint32_t num_nodes_done = 0;
-    int prev_percent = -1;
+    std::atomic<uint32_t> num_nodes_done(0);
+    std::atomic<int> prev_percent(-1);
 
     for(int d = depth_ - 1; d >= 0; d--)
     {
         uint32_t first_node = get_first_node_id_of_depth(d);
         uint32_t num_of_nodes = get_length_of_depth(d);
 
-        std::vector<uint32_t> nodes_todo;
-        for(uint32_t i = first_node; i < first_node + num_of_nodes; ++i)
-        {
-            nodes_todo.push_back(i);
-        }
-
         // lambda for parallel version
         auto lambda_simplify = [&](uint64_t i, uint32_t id) -> void {
-            uint32_t node_id = nodes_todo[i];
+            uint32_t node_id = first_node + i;
 
             int percent = (int)(((float)num_nodes_done / (float)num_nodes_todo) * 100.f);
-            if(percent != prev_percent)
+            int prev = prev_percent.load();
+            if(percent > prev && prev_percent.compare_exchange_strong(prev, percent))
             {
-                prev_percent = percent;
                 std::cout << "Simplification: " << percent << " %" << std::endl;
             }
 
@@ -243,30 +215,26 @@ void bvh::create_hierarchy(std::vector<Triangle_Chartid>& triangles)
 
             // std::cout << "simplifying node " << node_id << " with constraint\n";
             // try simplification with edge constraint
-            simplify(triangles_map_[left_child], triangles_map_[right_child], triangles_map_[node_id], true);
+            simplify(triangles_[left_child], triangles_[right_child], triangles_[node_id], true);
 
-            if(triangles_map_[node_id].size() > primitives_per_node_)
+            if(triangles_[node_id].size() > primitives_per_node_)
             {
                 // simplify without constraint
                 std::cout << "simplifying node " << node_id << " without constraint\n";
 
-                triangles_map_[node_id].clear();
-                simplify(triangles_map_[left_child], triangles_map_[right_child], triangles_map_[node_id], false);
+                triangles_[node_id].clear();
+                simplify(triangles_[left_child], triangles_[right_child], triangles_[node_id], false);
             }
 
-            if(triangles_map_[node_id].size() > primitives_per_node_)
+            if(triangles_[node_id].size() > primitives_per_node_)
             {
-                std::cout << "WARNING! @node_id " << node_id << " : simplified: " << triangles_map_[node_id].size() << " / desired: " << primitives_per_node_ << std::endl;
+                std::cout << "WARNING! @node_id " << node_id << " : simplified: " << triangles_[node_id].size() << " / desired: " << primitives_per_node_ << std::endl;
             }
 
-            num_nodes_done++;
+            ++num_nodes_done;
         };
-#ifdef PARALLEL_EXECUTION
-        uint32_t num_threads = std::min((size_t)24, nodes_todo.size());
-        lamure::mesh::parallel_for(num_threads, nodes_todo.size(), lambda_simplify);
-#else
-        lamure::mesh::parallel_for(1, nodes_todo.size(), lambda_simplify);
-#endif
+
+        lamure::mesh::parallel_for(schedule_t::DYNAMIC, num_threads, num_of_nodes, lambda_simplify);
     }
 
     std::cout << "Upsweep done." << std::endl;
@@ -275,18 +243,18 @@ void bvh::create_hierarchy(std::vector<Triangle_Chartid>& triangles)
     {
         auto& node = nodes[node_id];
 
-        if(triangles_map_[node_id].size() > primitives_per_node_)
+        if(triangles_[node_id].size() > primitives_per_node_)
         {
-            std::cout << "WARNING: (" << node_id << ": " << triangles_map_[node_id].size() << ") removing \
-      " << triangles_map_[node_id].size() - primitives_per_node_
+            std::cout << "WARNING: (" << node_id << ": " << triangles_[node_id].size() << ") removing \
+      " << triangles_[node_id].size() - primitives_per_node_
                       << " triangles manually to stay on budget: " << primitives_per_node_ << std::endl;
             min_lod_depth_ = std::max(min_lod_depth_, get_depth_of_node(node_id));
         }
 
         // if we have too many, remove some
-        while(triangles_map_[node_id].size() > primitives_per_node_)
+        while(triangles_[node_id].size() > primitives_per_node_)
         {
-            triangles_map_[node_id].pop_back();
+            triangles_[node_id].pop_back();
         }
 
         visibility_.push_back(node_visibility::NODE_VISIBLE);
@@ -298,7 +266,7 @@ void bvh::create_hierarchy(std::vector<Triangle_Chartid>& triangles)
         node.min_ = scm::math::vec3f(std::numeric_limits<float>::max());
         node.max_ = scm::math::vec3f(std::numeric_limits<float>::lowest());
 
-        for(auto& tri : triangles_map_[node_id])
+        for(auto& tri : triangles_[node_id])
         {
             avg_primitive_extent += tri.get_area();
             max_primitive_extent_deviation = std::max(tri.get_area(), max_primitive_extent_deviation);
@@ -355,14 +323,14 @@ void bvh::create_hierarchy(std::vector<Triangle_Chartid>& triangles)
 
         centroids_.push_back(vec3f(node.min_ + node.max_) * 0.5f);
 
-        avg_primitive_extent /= (float)triangles_map_[node_id].size();
+        avg_primitive_extent /= (float)triangles_[node_id].size();
         avg_primitive_extent_.push_back(std::max((1.f / (get_depth_of_node(node_id) + 1)) * 0.1f, 10.f * avg_primitive_extent));
         max_primitive_extent_deviation_.push_back(max_primitive_extent_deviation);
 
         // if the number of triangles was not divisible by two, add another tri for padding
-        while(triangles_map_[node_id].size() < primitives_per_node_)
+        while(triangles_[node_id].size() < primitives_per_node_)
         {
-            triangles_map_[node_id].push_back(Triangle_Chartid());
+            triangles_[node_id].push_back(Triangle_Chartid());
         }
     }
 
@@ -502,30 +470,23 @@ void bvh::simplify(std::vector<Triangle_Chartid>& left_child_tris, std::vector<T
 
 void bvh::write_lod_file(const std::string& lod_filename)
 {
-    // convert triangle map with chart id to trianglke map without chart id
-    std::map<uint32_t, std::vector<triangle_t>> simple_triangles_map;
+    auto lod = std::make_shared<lamure::ren::lod_stream>();
+    lod->open_for_writing(lod_filename);
 
-    for(auto& node_tri_list : triangles_map_) // for each node
+    for(uint32_t node_id = 0; node_id < num_nodes_; ++node_id)
     {
-        std::vector<triangle_t> tris; // container for new tris
+        // convert triangles with chart id to triangles without chart id
+        std::vector<triangle_t> tris;
+        tris.reserve(triangles_[node_id].size());
 
-        for(auto& t : node_tri_list.second) // for each triangle
+        for(auto& t : triangles_[node_id]) // for each triangle
         {
-            lamure::mesh::triangle_t new_tri = t.get_basic_triangle();
-
-            tris.push_back(new_tri);
+            tris.push_back(t.get_basic_triangle());
         }
-        simple_triangles_map[node_tri_list.first] = tris;
-    }
 
-    auto lod = std::make_shared<lamure::ren::lod_stream>();
-    lod->open_for_writing(lod_filename);
-
-    for(uint32_t node_id = 0; node_id < num_nodes_; ++node_id)
-    {
         size_t length_in_bytes = primitives_per_node_ * sizeof(vertex);
         size_t start_in_file = node_id * length_in_bytes;
-        lod->write((char*)&simple_triangles_map[node_id][0], start_in_file, length_in_bytes);
+        lod->write((char*)&tris[0], start_in_file, length_in_bytes);
     }
 
     lod->close();
@@ -13,6 +13,7 @@
 #include <lamure/pre/common.h>
 #include <lamure/pre/io/file.h>
 #include <lamure/pre/logger.h>
+#include <lamure/pre/neighbour_index.h>
 #include <lamure/pre/node_serializer.h>
 #include <lamure/pre/normal_computation_strategy.h>
 #include <lamure/pre/platform.h>
@@ -117,7 +118,11 @@ class PREPROCESSING_DLL bvh
                  bool recompute_leaf_level = true, bool resample = false);
     void resample();
 
-    surfel_vector remove_outliers_statistically(uint32_t num_outliers, uint16_t num_neighbours);
+    /* removes the surfels with the largest average neighbour distance from the
+     * leaves of the downsweep and rebalances the affected subtrees in place.
+     * returns the number of removed surfels
+     */
+    size_t remove_outliers_statistically(uint32_t num_outliers, uint16_t num_neighbours);
 
     void serialize_tree_to_file(const std::string &output_file, bool write_intermediate_data);
 
@@ -144,23 +149,26 @@ class PREPROCESSING_DLL bvh
     void set_first_leaf(const node_id_type first_leaf) { first_leaf_ = first_leaf; };
     void set_state(const state_type state) { state_ = state; };
 
-    void spawn_create_lod_jobs(const uint32_t first_node_of_level, const uint32_t last_node_of_level, const reduction_strategy &reduction_strgy, const bool resample);
     void spawn_compute_attribute_jobs(const uint32_t first_node_of_level, const uint32_t last_node_of_level, const normal_computation_strategy &normal_strategy,
                                       const radius_computation_strategy &radius_strategy, const bool is_leaf_level);
     void spawn_compute_bounding_boxes_downsweep_jobs(const uint32_t slice_left, const uint32_t slice_right);
-    void spawn_compute_bounding_boxes_upsweep_jobs(const uint32_t first_node_of_level, const uint32_t last_node_of_level, const int32_t level);
     void spawn_split_node_jobs(size_t &slice_left, size_t &slice_right, size_t &new_slice_left, size_t &new_slice_right, const uint32_t level);
+    void spawn_build_neighbour_index_jobs(const uint32_t first_node_of_level, const uint32_t last_node_of_level);
 
     void thread_remove_outlier_jobs(const uint32_t start_marker, const uint32_t end_marker, const uint32_t num_outliers, const uint16_t num_neighbours,
                                     std::vector<std::pair<surfel_id_t, real>> &intermediate_outliers_for_thread);
     void thread_compute_attributes(const uint32_t start_marker, const uint32_t end_marker, const bool update_percentage, const normal_computation_strategy &normal_strategy,
                                    const radius_computation_strategy &radius_strategy, const bool is_leaf_level);
-    void thread_create_lod(const uint32_t start_marker, const uint32_t end_marker, const bool update_percentage, const reduction_strategy &reduction_strgy, const bool resample);
     void thread_compute_bounding_boxes_downsweep(const uint32_t slice_left, const uint32_t slice_right, const bool update_percentage, const uint32_t num_threads);
-    void thread_compute_bounding_boxes_upsweep(const uint32_t start_marker, const uint32_t end_marker, const bool update_percentage, const int32_t level, const uint32_t num_threads);
     void thread_split_node_jobs(size_t &slice_left, size_t &slice_right, size_t &new_slice_left, size_t &new_slice_right, const bool update_percentage, const int32_t level,
                                 const uint32_t num_threads);
     void thread_resample(const uint32_t start_marker, const uint32_t end_marker, const bool update_percentage);
+    void thread_build_neighbour_index(const uint32_t start_marker, const uint32_t end_marker);
+
+    void create_lod(const node_id_type node_id, const reduction_strategy &reduction_strgy, const bool resample);
+
+    // dataflow scheduling of the upsweep, see bvh.cpp
+    class upsweep_scheduler;
 
   private:
     surfel_vector resampled_leaf_level_;
@@ -171,6 +179,7 @@ class PREPROCESSING_DLL bvh
     state_type state_ = state_type::null;
 
     std::vector<bvh_node> nodes_;
+    std::vector<neighbour_index> neighbour_indices_; ///< per node, built for the level that is processed
     uint8_t fan_factor_ = 0;
 
     uint32_t depth_ = 0; ///< number of the last tree layer
@@ -191,6 +200,10 @@ class PREPROCESSING_DLL bvh
 
     void downsweep_subtree_in_core(const bvh_node &node, size_t &disk_leaf_destination, uint32_t &processed_nodes, uint8_t &percent_processed, 
         shared_surfel_file leaf_level_access, shared_prov_file prov_leaf_level_access);
+    void rebalance_subtree_in_core(const node_id_type root_id, std::vector<char> &modified_leaves);
+
+    void get_nearest_neighbours_in_node(const node_id_type node_id, const vec3r &center, const uint32_t number_of_neighbours, const surfel_id_t &excluded_surfel,
+                                        std::vector<std::pair<surfel_id_t, real>> &candidates) const;
 
     void get_descendant_leaves(const node_id_type node, std::vector<node_id_type> &result, const node_id_type first_leaf, const std::unordered_set<size_t> &excluded_leaves) const;
     void get_descendant_nodes(const node_id_type node, std::vector<node_id_type> &result, const node_id_type desired_depth, const std::unordered_set<size_t> &excluded_nodes) const;
@@ -488,6 +488,143 @@ protected:
 
     };
 
+    //node attributes of a version 2 file, one array per attribute. These files
+    //are written by the rendering library, which maps the arrays in place
+    class bvh_node_array_seg: public bvh_serializable
+    {
+    public:
+        bvh_node_array_seg()
+            : bvh_serializable()
+        {};
+        ~bvh_node_array_seg()
+        {};
+
+        uint32_t segment_id_;
+        uint32_t num_nodes_;
+        uint64_t reserved_;
+
+        //byte offsets relative to the start of the segment data, multiples of 32
+        uint64_t bounding_boxes_offset_;
+        uint64_t centroids_offset_;
+        uint64_t avg_surfel_radii_offset_;
+        uint64_t max_surfel_radius_deviations_offset_;
+        uint64_t visibilities_offset_;
+
+        std::vector<bvh_bounding_box> bounding_boxes_;
+        std::vector<bvh_vector> centroids_;
+        std::vector<float> avg_surfel_radii_;
+        std::vector<float> max_surfel_radius_deviations_;
+        std::vector<uint32_t> visibilities_;
+
+        static size_t aligned(const size_t size)
+        {
+            return (size + 31) & ~size_t(31);
+        }
+        void compute_offsets()
+        {
+            bounding_boxes_offset_ = aligned(header_size());
+            centroids_offset_ = bounding_boxes_offset_ + aligned(num_nodes_ * sizeof(bvh_bounding_box));
+            avg_surfel_radii_offset_ = centroids_offset_ + aligned(num_nodes_ * sizeof(bvh_vector));
+            max_surfel_radius_deviations_offset_ = avg_surfel_radii_offset_ + aligned(num_nodes_ * sizeof(float));
+            visibilities_offset_ = max_surfel_radius_deviations_offset_ + aligned(num_nodes_ * sizeof(float));
+        }
+
+    protected:
+        friend class bvh_stream;
+        static size_t header_size()
+        {
+            return 4 * sizeof(uint32_t) + 5 * sizeof(uint64_t);
+        }
+        const size_t size() const
+        {
+            return visibilities_offset_ + num_nodes_ * sizeof(uint32_t);
+        };
+        void signature(char *signature)
+        {
+            signature[0] = 'B';
+            signature[1] = 'V';
+            signature[2] = 'H';
+            signature[3] = 'X';
+            signature[4] = 'N';
+            signature[5] = 'A';
+            signature[6] = 'R';
+            signature[7] = 'R';
+        }
+        void write_array(std::fstream &file, size_t &position, const uint64_t offset, const void *data, const size_t size)
+        {
+            while (position < offset) {
+                char c = 0;
+                file.write(&c, 1);
+                ++position;
+            }
+            file.write((const char*)data, size);
+            position += size;
+        }
+        void read_array(std::fstream &file, const size_t start, const uint64_t offset, void *data, const size_t size)
+        {
+            file.seekg(start + offset, std::ios::beg);
+            file.read((char*)data, size);
+            if (!file) {
+                throw std::runtime_error(
+                    "PLOD: bvh_stream::Stream corrupt -- Node arrays exceed the file");
+            }
+        }
+        void serialize(std::fstream &file)
+        {
+            if (!file.is_open()) {
+                throw std::runtime_error(
+                    "PLOD: bvh_stream::Unable to serialize");
+            }
+
+            file.write((char*)&segment_id_, 4);
+            file.write((char*)&num_nodes_, 4);
+            file.write((char*)&reserved_, 8);
+            file.write((char*)&bounding_boxes_offset_, 8);
+            file.write((char*)&centroids_offset_, 8);
+            file.write((char*)&avg_surfel_radii_offset_, 8);
+            file.write((char*)&max_surfel_radius_deviations_offset_, 8);
+            file.write((char*)&visibilities_offset_, 8);
+
+            size_t position = header_size();
+            write_array(file, position, bounding_boxes_offset_, bounding_boxes_.data(), num_nodes_ * sizeof(bvh_bounding_box));
+            write_array(file, position, centroids_offset_, centroids_.data(), num_nodes_ * sizeof(bvh_vector));
+            write_array(file, position, avg_surfel_radii_offset_, avg_surfel_radii_.data(), num_nodes_ * sizeof(float));
+            write_array(file, position, max_surfel_radius_deviations_offset_, max_surfel_radius_deviations_.data(), num_nodes_ * sizeof(float));
+            write_array(file, position, visibilities_offset_, visibilities_.data(), num_nodes_ * sizeof(uint32_t));
+        }
+        void deserialize(std::fstream &file)
+        {
+            if (!file.is_open()) {
+                throw std::runtime_error(
+                    "PLOD: bvh_stream::Unable to deserialize");
+            }
+
+            const size_t start = (size_t) file.tellg();
+
+            file.read((char*)&segment_id_, 4);
+            file.read((char*)&num_nodes_, 4);
+            file.read((char*)&reserved_, 8);
+            file.read((char*)&bounding_boxes_offset_, 8);
+            file.read((char*)&centroids_offset_, 8);
+            file.read((char*)&avg_surfel_radii_offset_, 8);
+            file.read((char*)&max_surfel_radius_deviations_offset_, 8);
+            file.read((char*)&visibilities_offset_, 8);
+
+            bounding_boxes_.resize(num_nodes_);
+            centroids_.resize(num_nodes_);
+            avg_surfel_radii_.resize(num_nodes_);
+            max_surfel_radius_deviations_.resize(num_nodes_);
+            visibilities_.resize(num_nodes_);
+
+            read_array(file, start, bounding_boxes_offset_, bounding_boxes_.data(), num_nodes_ * sizeof(bvh_bounding_box));
+            read_array(file, start, centroids_offset_, centroids_.data(), num_nodes_ * sizeof(bvh_vector));
+            read_array(file, start, avg_surfel_radii_offset_, avg_surfel_radii_.data(), num_nodes_ * sizeof(float));
+            read_array(file, start, max_surfel_radius_deviations_offset_, max_surfel_radius_deviations_.data(), num_nodes_ * sizeof(float));
+            read_array(file, start, visibilities_offset_, visibilities_.data(), num_nodes_ * sizeof(uint32_t));
+        }
+
+    };
+
     class bvh_tree_extension_seg: public bvh_serializable
     {
     public:
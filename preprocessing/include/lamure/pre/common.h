@@ -22,7 +22,8 @@ enum class rep_radius_algorithm
 
 enum class normal_computation_algorithm
 {
-    plane_fitting = 0
+    plane_fitting = 0,
+    batched_plane_fitting = 1
 };
 
 enum class radius_computation_algorithm
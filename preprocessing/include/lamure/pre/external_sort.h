@@ -25,73 +25,40 @@ public:
                      const size_t memory_limit,
                      const surfel::compare_function &compare);
 
+    /**
+     * Sorts by position along the given axis. The comparison is resolved
+     * at compile time, which makes run creation and merging considerably
+     * cheaper than with a generic compare function.
+     */
+    static void sort(surfel_disk_array &array,
+                     const size_t memory_limit,
+                     const uint8_t axis);
+
 private:
-    explicit external_sort(const size_t memory_limit,
-                           const surfel::compare_function &compare);
+    explicit external_sort(const size_t memory_limit);
     external_sort(const external_sort &) = delete;
     external_sort &operator=(const external_sort &) = delete;
 
-    class buffer
-    {
-    public:
-        surfel_disk_array run;
-        surfel_vector data;
-        size_t size;
-        size_t candidate_pos;
-        size_t file_offset;
-
-        buffer(const surfel_disk_array &array, const size_t buffer_size)
-            : run(array)
-        {
-            size = buffer_size;
-            candidate_pos = size;
-            file_offset = 0;
-            data = surfel_vector(size);
-        }
-
-        bool front(surfel &s)
-        {
-            invalidate();
-            if (size > 0) {
-                s = data[candidate_pos];
-                return true;
-            }
-            else
-                return false;
-        }
-
-        void pop_front()
-        {
-            assert(size > 0);
-            candidate_pos++;
-        }
-
-    private:
-        void invalidate()
-        {
-            if (size > 0 && candidate_pos >= size) {
-                if (file_offset >= run.length()) {
-                    size = 0;
-                    return;
-                }
-
-                size = std::min(size, run.length() - file_offset);
-                run.get_file()->read(&data, 0, run.offset() + file_offset, size);
-                file_offset += size;
-                candidate_pos = 0;
-            }
-        }
-    };
+    // runs are sorted and merged in the layout of the surfel file,
+    // which is more compact than surfel if enabled
+    using record = surfel_file::record_type;
+    using record_vector = std::vector<record>;
 
+    template <class Less>
+    void sort_records(surfel_disk_array &array, const Less &less);
+
+    template <class Less>
     void create_runs(surfel_disk_array &array,
                      const size_t run_length,
-                     const uint32_t runs_count);
-    void merge(surfel_disk_array &array, const size_t buffer_size);
+                     const uint32_t runs_count,
+                     const Less &less);
 
-    size_t memory_limit_;
+    template <class Less>
+    void merge(surfel_disk_array &array,
+               const size_t buffer_size,
+               const Less &less);
 
-    surfel::compare_function
-        compare_;
+    size_t memory_limit_;
 
     shared_surfel_file runs_file_;
 
@@ -0,0 +1,54 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group 
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#ifndef PRE_ASCII_CHUNK_READER_H_
+#define PRE_ASCII_CHUNK_READER_H_
+
+#include <lamure/pre/platform.h>
+#include <lamure/pre/io/format_abstract.h>
+
+#include <string>
+
+namespace lamure
+{
+namespace pre
+{
+
+/**
+ * Parallel reader for line based ascii point formats.
+ *
+ * The input file is memory-mapped and split into chunks at newline
+ * boundaries. Chunks are parsed concurrently, the resulting surfels are
+ * passed to the callback in file order, so the output does not depend on
+ * the number of threads.
+ */
+class PREPROCESSING_DLL ascii_chunk_reader
+{
+public:
+    /**
+     * Parses a single line [begin, end) without the newline character.
+     * Returns false if the line does not describe a surfel.
+     */
+    typedef bool (*line_parser_function)(const char *begin, const char *end, surfel &s);
+
+    ascii_chunk_reader() = delete;
+
+    static void read(const std::string &filename,
+                     line_parser_function parser,
+                     const format_abstract::surfel_callback_funtion &callback);
+
+    // token parsers, advance begin past the parsed token
+    static bool parse_real(const char *&begin, const char *end, real &value);
+    static bool parse_float(const char *&begin, const char *end, float &value);
+    static bool parse_uint(const char *&begin, const char *end, unsigned int &value);
+
+};
+
+} // namespace pre
+} // namespace lamure
+
+#endif // PRE_ASCII_CHUNK_READER_H_
@@ -10,6 +10,7 @@
 
 #include <lamure/pre/platform.h>
 #include <lamure/pre/surfel.h>
+#include <lamure/pre/serialized_surfel.h>
 #include <lamure/pre/prov.h>
 
 #include <mutex>
@@ -21,10 +22,40 @@
 namespace lamure {
 namespace pre {
 
+/**
+ * Layout of T on disk. Types are stored as they are in memory unless a
+ * specialization provides a different record type and the conversion.
+ */
+template<typename T>
+struct file_record_traits
+{
+    using record_type = T;
+
+    static void encode(const T &value, record_type &record) { record = value; }
+    static void decode(const record_type &record, T &value) { value = record; }
+};
+
+#ifdef LAMURE_USE_COMPACT_SURFEL_FILES
+// 32 byte float records instead of 48 byte surfels, halves the I/O of
+// the intermediate files and the memory of external sort runs
+template<>
+struct file_record_traits<surfel>
+{
+    using record_type = serialized_surfel;
+
+    static void encode(const surfel &value, record_type &record) { record.set_surfel(value); }
+    static void decode(const record_type &record, surfel &value) { value = record.get_surfel(); }
+};
+#endif
+
 template<typename T>
 class PREPROCESSING_DLL file
 {
 public:
+    using record_type = typename file_record_traits<T>::record_type;
+
+    static const size_t record_size = sizeof(record_type);
+
     file() {}
     file(const file &) = delete;
     file &operator=(const file &) = delete;
@@ -55,14 +86,28 @@ public:
               const size_t length) const;
     const T read(const size_t pos_in_file) const;
 
+    // access to the records as stored, without conversion
+    void read_records(std::vector<record_type> *data,
+                      const size_t offset_in_mem,
+                      const size_t offset_in_file,
+                      const size_t length) const;
+    void write_records(const std::vector<record_type> *data,
+                       const size_t offset_in_mem,
+                       const size_t offset_in_file,
+                       const size_t length);
+    void append_records(const std::vector<record_type> *data);
+
 private:
 
     mutable std::mutex read_write_mutex_;
     mutable std::fstream stream_;
     std::string file_name_;
 
-    void write_data(char *data, const size_t offset_in_file, const size_t length);
-    void read_data(char *data, const size_t offset_in_file, const size_t length) const;
+    void write_data(const T *data, const size_t offset_in_file, const size_t length, const bool append = false);
+    void read_data(T *data, const size_t offset_in_file, const size_t length) const;
+
+    void write_raw(const char *data, const size_t offset_in_file, const size_t length, const bool append);
+    void read_raw(char *data, const size_t offset_in_file, const size_t length) const;
 
 };
 
@@ -8,13 +8,13 @@
 #include <stdexcept>
 #include <cstdio>
 #include <cstring>
+#include <type_traits>
 
 #include <lamure/pre/logger.h>
 
 namespace lamure {
 namespace pre {
-#ifdef _WIN32
-#if defined(LAMURE_PREPROCESSING_LIBRARY)
+#if !defined(_WIN32) || defined(LAMURE_PREPROCESSING_LIBRARY)
 template<typename T>
 file<T>::~file()
 {
@@ -97,7 +97,7 @@ get_size() const
         LOGGER_ERROR("get_size failed. file: \"" << file_name_ <<
                                                  "\". " << strerror(errno));
     }
-    return len / sizeof(T);
+    return len / record_size;
 }
 
 template<typename T>
@@ -106,23 +106,10 @@ append(const std::vector<T> *data,
        const size_t offset_in_mem,
        const size_t length)
 {
-    std::lock_guard<std::mutex> lock(read_write_mutex_);
-
-    assert(is_open());
     assert(length > 0);
     assert(offset_in_mem + length <= data->size());
 
-    stream_.seekp(0, stream_.end);
-    stream_.write(reinterpret_cast<char *>(
-                      const_cast<T *>(&(*data)[offset_in_mem])),
-                  length * sizeof(T));
-
-    if (stream_.fail() || stream_.bad()) {
-        LOGGER_ERROR("append failed. file: \"" << file_name_ <<
-                                               "\". (mem offset: " << offset_in_mem <<
-                                               ", len: " << length << "). " << strerror(errno));
-    }
-    stream_.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    write_data(&(*data)[offset_in_mem], 0, length, true);
 }
 
 template<typename T>
@@ -142,17 +129,14 @@ write(const std::vector<T> *data,
     assert(length > 0);
     assert(offset_in_mem + length <= data->size());
 
-    write_data(reinterpret_cast<char *>(
-                   const_cast<T *>(&(*data)[offset_in_mem])),
-               offset_in_file, length);
+    write_data(&(*data)[offset_in_mem], offset_in_file, length);
 }
 
 template<typename T>
 void file<T>::
 write(const T &srfl, const size_t pos_in_file)
 {
-    write_data(reinterpret_cast<char *>(const_cast<T *>(&srfl)),
-               pos_in_file, 1);
+    write_data(&srfl, pos_in_file, 1);
 }
 
 template<typename T>
@@ -165,8 +149,7 @@ read(std::vector<T> *data,
     assert(length > 0);
     assert(offset_in_mem + length <= data->size());
 
-    read_data(reinterpret_cast<char *>(&(*data)[offset_in_mem]),
-              offset_in_file, length);
+    read_data(&(*data)[offset_in_mem], offset_in_file, length);
 }
 
 template<typename T>
@@ -174,222 +157,95 @@ const T file<T>::
 read(const size_t pos_in_file) const
 {
     T s;
-    read_data(reinterpret_cast<char *>(&s), pos_in_file, 1);
+    read_data(&s, pos_in_file, 1);
     return s;
 }
 
 template<typename T>
 void file<T>::
-write_data(char *data, const size_t offset_in_file, const size_t length)
+read_records(std::vector<record_type> *data,
+             const size_t offset_in_mem,
+             const size_t offset_in_file,
+             const size_t length) const
 {
-    assert(is_open());
-
-    std::lock_guard<std::mutex> lock(read_write_mutex_);
-    stream_.seekp(offset_in_file * sizeof(T));
-    stream_.write(data, length * sizeof(T));
+    assert(length > 0);
+    assert(offset_in_mem + length <= data->size());
 
-    if (stream_.fail() || stream_.bad()) {
-        LOGGER_ERROR("write failed. file: \"" << file_name_ <<
-                                              "\". (offset: " << offset_in_file <<
-                                              ", len: " << length << "). " << strerror(errno));
-    }
-    stream_.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    read_raw(reinterpret_cast<char *>(&(*data)[offset_in_mem]),
+             offset_in_file, length);
 }
 
 template<typename T>
 void file<T>::
-read_data(char *data, const size_t offset_in_file, const size_t length) const
+write_records(const std::vector<record_type> *data,
+              const size_t offset_in_mem,
+              const size_t offset_in_file,
+              const size_t length)
 {
-    assert(is_open());
-
-    std::lock_guard<std::mutex> lock(read_write_mutex_);
-    stream_.seekg(offset_in_file * sizeof(T));
-    stream_.read(data, length * sizeof(T));
+    assert(length > 0);
+    assert(offset_in_mem + length <= data->size());
 
-    if (stream_.fail() || stream_.bad()) {
-        LOGGER_ERROR("read failed. file: \"" << file_name_ <<
-                                             "\". (offset: " << offset_in_file <<
-                                             ", len: " << length << "). " << strerror(errno));
-    }
-    stream_.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-}
-#endif
-#else
-template<typename T>
-file<T>::~file()
-{
-    try {
-        close();
-    }
-    catch (...) {}
+    write_raw(reinterpret_cast<const char *>(&(*data)[offset_in_mem]),
+              offset_in_file, length, false);
 }
 
 template<typename T>
 void file<T>::
-open(const std::string &file_name, const bool truncate)
+append_records(const std::vector<record_type> *data)
 {
-    if (is_open()) {
-        LOGGER_ERROR("Attempt to open file when the instance of "
-                         "pre::file is already in open state. "
-                         "file: \"" << file_name << "\" "
-            "opened file: \"" << file_name_ << "\"");
-        exit(1);
-    }
+    assert(data->size() > 0);
 
-    file_name_ = file_name;
-    std::ios::openmode mode = std::ios::in |
-        std::ios::out |
-        std::ios::binary;
-    if (truncate)
-        mode |= std::ios::trunc;
-
-
-    stream_.open(file_name_, mode);
-
-    if (!is_open()) {
-        LOGGER_ERROR("Failed to open file: \"" << file_name_ <<
-                                               "\". " << strerror(errno));
-    }
-    stream_.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    write_raw(reinterpret_cast<const char *>(data->data()),
+              0, data->size(), true);
 }
 
 template<typename T>
 void file<T>::
-close(const bool remove)
+write_data(const T *data, const size_t offset_in_file, const size_t length, const bool append)
 {
-    if (is_open()) {
-        stream_.flush();
-        stream_.close();
-        if (stream_.fail()) {
-            LOGGER_ERROR("Failed to close file: \"" << file_name_ <<
-                                                    "\". " << strerror(errno));
-        }
-        stream_.exceptions(std::ifstream::failbit);
-
-        if (remove)
-            if (std::remove(file_name_.c_str())) {
-                LOGGER_WARN("Unable to delete file: \"" << file_name_ <<
-                                                        "\". " << strerror(errno));
-            }
-        file_name_ = "";
+    if (std::is_same<T, record_type>::value) {
+        write_raw(reinterpret_cast<const char *>(data), offset_in_file, length, append);
+        return;
     }
-}
 
-template<typename T>
-const bool file<T>::
-is_open() const
-{
-    return stream_.is_open();
-}
-
-template<typename T>
-const size_t file<T>::
-get_size() const
-{
-    std::lock_guard<std::mutex> lock(read_write_mutex_);
-
-    assert(is_open());
-    stream_.seekg(0, stream_.end);
-    size_t len = stream_.tellg();
-    stream_.seekg(0, stream_.beg);
+    std::vector<record_type> records(length);
+    for (size_t i = 0; i < length; ++i)
+        file_record_traits<T>::encode(data[i], records[i]);
 
-    if (stream_.fail() || stream_.bad()) {
-        LOGGER_ERROR("get_size failed. file: \"" << file_name_ <<
-                                                 "\". " << strerror(errno));
-    }
-    return len / sizeof(T);
+    write_raw(reinterpret_cast<const char *>(records.data()), offset_in_file, length, append);
 }
 
 template<typename T>
 void file<T>::
-append(const std::vector<T> *data,
-       const size_t offset_in_mem,
-       const size_t length)
+read_data(T *data, const size_t offset_in_file, const size_t length) const
 {
-    std::lock_guard<std::mutex> lock(read_write_mutex_);
-
-    assert(is_open());
-    assert(length > 0);
-    assert(offset_in_mem + length <= data->size());
-
-    stream_.seekp(0, stream_.end);
-    stream_.write(reinterpret_cast<char *>(
-                      const_cast<T *>(&(*data)[offset_in_mem])),
-                  length * sizeof(T));
-
-    if (stream_.fail() || stream_.bad()) {
-        LOGGER_ERROR("append failed. file: \"" << file_name_ <<
-                                               "\". (mem offset: " << offset_in_mem <<
-                                               ", len: " << length << "). " << strerror(errno));
+    if (std::is_same<T, record_type>::value) {
+        read_raw(reinterpret_cast<char *>(data), offset_in_file, length);
+        return;
     }
-    stream_.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-}
 
-template<typename T>
-void file<T>::
-append(const std::vector<T> *data)
-{
-    append(data, 0, data->size());
-}
-
-template<typename T>
-void file<T>::
-write(const std::vector<T> *data,
-      const size_t offset_in_mem,
-      const size_t offset_in_file,
-      const size_t length)
-{
-    assert(length > 0);
-    assert(offset_in_mem + length <= data->size());
-
-    write_data(reinterpret_cast<char *>(
-                   const_cast<T *>(&(*data)[offset_in_mem])),
-               offset_in_file, length);
-}
-
-template<typename T>
-void file<T>::
-write(const T &srfl, const size_t pos_in_file)
-{
-    write_data(reinterpret_cast<char *>(const_cast<T *>(&srfl)),
-               pos_in_file, 1);
-}
+    std::vector<record_type> records(length);
+    read_raw(reinterpret_cast<char *>(records.data()), offset_in_file, length);
 
-template<typename T>
-void file<T>::
-read(std::vector<T> *data,
-     const size_t offset_in_mem,
-     const size_t offset_in_file,
-     const size_t length) const
-{
-    assert(length > 0);
-    assert(offset_in_mem + length <= data->size());
-
-    read_data(reinterpret_cast<char *>(&(*data)[offset_in_mem]),
-              offset_in_file, length);
-}
-
-template<typename T>
-const T file<T>::
-read(const size_t pos_in_file) const
-{
-    T s;
-    read_data(reinterpret_cast<char *>(&s), pos_in_file, 1);
-    return s;
+    for (size_t i = 0; i < length; ++i)
+        file_record_traits<T>::decode(records[i], data[i]);
 }
 
 template<typename T>
 void file<T>::
-write_data(char *data, const size_t offset_in_file, const size_t length)
+write_raw(const char *data, const size_t offset_in_file, const size_t length, const bool append)
 {
     assert(is_open());
 
     std::lock_guard<std::mutex> lock(read_write_mutex_);
-    stream_.seekp(offset_in_file * sizeof(T));
-    stream_.write(data, length * sizeof(T));
+    if (append)
+        stream_.seekp(0, stream_.end);
+    else
+        stream_.seekp(offset_in_file * record_size);
+    stream_.write(data, length * record_size);
 
     if (stream_.fail() || stream_.bad()) {
-        LOGGER_ERROR("write failed. file: \"" << file_name_ <<
+        LOGGER_ERROR((append ? "append" : "write") << " failed. file: \"" << file_name_ <<
                                               "\". (offset: " << offset_in_file <<
                                               ", len: " << length << "). " << strerror(errno));
     }
@@ -398,13 +254,13 @@ write_data(char *data, const size_t offset_in_file, const size_t length)
 
 template<typename T>
 void file<T>::
-read_data(char *data, const size_t offset_in_file, const size_t length) const
+read_raw(char *data, const size_t offset_in_file, const size_t length) const
 {
     assert(is_open());
 
     std::lock_guard<std::mutex> lock(read_write_mutex_);
-    stream_.seekg(offset_in_file * sizeof(T));
-    stream_.read(data, length * sizeof(T));
+    stream_.seekg(offset_in_file * record_size);
+    stream_.read(data, length * record_size);
 
     if (stream_.fail() || stream_.bad()) {
         LOGGER_ERROR("read failed. file: \"" << file_name_ <<
@@ -416,4 +272,3 @@ read_data(char *data, const size_t offset_in_file, const size_t length) const
 #endif
 }
 } // namespace lamure
-
@@ -0,0 +1,102 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group 
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#ifndef NATURAL_NEIGHBOUR_COORDINATES_H_
+#define NATURAL_NEIGHBOUR_COORDINATES_H_
+
+#include <lamure/pre/platform.h>
+#include <lamure/types.h>
+
+namespace lamure
+{
+namespace pre
+{
+
+/**
+ * Sibson coordinates of a point with respect to a small set of neighbours.
+ *
+ * The neighbours are projected to their best fit plane. The Voronoi cell
+ * the point would get when inserted into their Voronoi diagram is built by
+ * clipping a square with the bisectors to all neighbours. The neighbours
+ * contributing an edge to the cell are the natural neighbours, the
+ * coordinate of each one is the share of the cell taken from its own
+ * Voronoi cell. All buffers have a fixed size, nothing is allocated.
+ */
+class PREPROCESSING_DLL natural_neighbour_coordinates
+{
+public:
+    // neighbours beyond this number are ignored
+    static const uint32_t max_neighbours = 24;
+
+    // convex polygon, edge i runs from vertex i to vertex i + 1 and lies on the
+    // bisector to neighbour generators[i], or on the initial square if it is -1
+    struct cell_polygon
+    {
+        // every clip adds at most one vertex: the square, the bisectors of the
+        // cell and the bisectors between natural neighbours
+        static const uint32_t max_vertices = 2 * max_neighbours + 4;
+
+        vec2r vertices[max_vertices];
+        int32_t generators[max_vertices];
+        uint32_t num_vertices;
+    };
+
+    // buffers of a single query, callers computing many queries keep one
+    // workspace and pass it to all of them
+    struct workspace
+    {
+        vec2r projected_positions[max_neighbours];
+        cell_polygon polygons[2];
+        cell_polygon stolen[2];
+    };
+
+    /**
+     * \param[in]  point_of_interest  Point to compute the coordinates for
+     * \param[in]  positions          Neighbour positions
+     * \param[in]  num_positions      Number of neighbour positions
+     * \param[out] ids                Indices into positions of the natural
+     *                                neighbours, at least max_neighbours entries
+     * \param[out] weights            Sibson coordinates of the natural
+     *                                neighbours, at least max_neighbours entries
+     * \return                        Number of natural neighbours. Zero if
+     *                                the projected point is not inside the
+     *                                convex hull of the projected neighbours
+     *                                or if the projection is degenerate.
+     */
+    static uint32_t compute(const vec3r &point_of_interest,
+                            const vec3r *positions,
+                            const uint32_t num_positions,
+                            uint32_t *ids,
+                            real *weights);
+
+    static uint32_t compute(const vec3r &point_of_interest,
+                            const vec3r *positions,
+                            const uint32_t num_positions,
+                            uint32_t *ids,
+                            real *weights,
+                            workspace &buffers);
+
+    /**
+     * Same as above for points that are already projected, the point of
+     * interest is the origin.
+     */
+    static uint32_t compute(const vec2r *projected_positions,
+                            const uint32_t num_positions,
+                            uint32_t *ids,
+                            real *weights);
+
+    static uint32_t compute(const vec2r *projected_positions,
+                            const uint32_t num_positions,
+                            uint32_t *ids,
+                            real *weights,
+                            workspace &buffers);
+};
+
+}// namespace pre
+}// namespace lamure
+
+#endif // NATURAL_NEIGHBOUR_COORDINATES_H_
@@ -0,0 +1,111 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group 
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#ifndef PRE_NEIGHBOUR_INDEX_H_
+#define PRE_NEIGHBOUR_INDEX_H_
+
+#include <lamure/pre/platform.h>
+#include <lamure/pre/surfel_mem_array.h>
+#include <lamure/types.h>
+
+#include <utility>
+#include <vector>
+
+namespace lamure
+{
+namespace pre
+{
+
+/**
+ * Compact kd-tree over the surfel positions of a single node.
+ *
+ * Positions are copied in leaf order, so a query touches contiguous memory
+ * instead of the (much larger) surfels of the node. The index does not
+ * track changes of the indexed array and has to be rebuilt whenever surfel
+ * positions change.
+ */
+class PREPROCESSING_DLL neighbour_index
+{
+public:
+    using candidate = std::pair<surfel_id_t, real>;
+
+    neighbour_index() {}
+
+    void build(const surfel_mem_array &sa);
+    void build(const std::vector<vec3r> &positions);
+    void clear();
+
+    const bool is_built() const { return !nodes_.empty(); }
+    const size_t size() const { return positions_.size(); }
+
+    /**
+     * Merges the nearest indexed points of center into a candidate list.
+     *
+     * \param[in] center           Query position
+     * \param[in] num_neighbours   Max number of candidates to keep
+     * \param[in] node_id          Node id that is written to the candidates
+     * \param[in] excluded_idx     Index in the indexed array to skip
+     * \param[in,out] candidates   Max-heap on squared distance (see push_candidate)
+     */
+    void search_nearest(const vec3r &center,
+                        const uint32_t num_neighbours,
+                        const node_id_type node_id,
+                        const size_t excluded_idx,
+                        std::vector<candidate> &candidates) const;
+
+    /**
+     * Appends the indices of all points within radius of center.
+     */
+    void search_radius(const vec3r &center,
+                       const real radius,
+                       std::vector<size_t> &result) const;
+
+    /**
+     * Offers a candidate to a bounded max-heap of nearest neighbours. Use
+     * sort_candidates to turn the heap into a list sorted by distance.
+     */
+    static void push_candidate(std::vector<candidate> &candidates,
+                               const uint32_t num_neighbours,
+                               const surfel_id_t &id,
+                               const real distance);
+
+    static void sort_candidates(std::vector<candidate> &candidates);
+
+private:
+    struct kd_node
+    {
+        real split;
+        uint32_t begin;
+        uint32_t end;
+        uint32_t left;   // right child is left + 1, 0 for leaves
+        uint8_t axis;
+    };
+
+    void build_recursive(const uint32_t node_idx,
+                         const std::vector<vec3r> &source);
+
+    void search_nearest_recursive(const uint32_t node_idx,
+                                  const vec3r &center,
+                                  const uint32_t num_neighbours,
+                                  const node_id_type node_id,
+                                  const size_t excluded_idx,
+                                  std::vector<candidate> &candidates) const;
+
+    void search_radius_recursive(const uint32_t node_idx,
+                                 const vec3r &center,
+                                 const real radius_sqr,
+                                 std::vector<size_t> &result) const;
+
+    std::vector<kd_node> nodes_;
+    std::vector<vec3r> positions_;   // in leaf order
+    std::vector<uint32_t> indices_;  // leaf order -> index in indexed array
+};
+
+} // namespace pre
+} // namespace lamure
+
+#endif // PRE_NEIGHBOUR_INDEX_H_
@@ -0,0 +1,76 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group 
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+
+#ifndef  NORMAL_COMPUTATION_BATCHED_PLANE_FITTING_H_
+#define  NORMAL_COMPUTATION_BATCHED_PLANE_FITTING_H_
+
+#include <lamure/pre/normal_computation_strategy.h>
+
+#include <vector>
+
+namespace lamure
+{
+namespace pre
+{
+
+class bvh;
+
+/**
+ * Plane fitting on blocks of surfels. Neighbour positions are gathered
+ * into SoA arrays (one lane per surfel) so that the covariance sums
+ * vectorize, the plane normal is taken from a closed-form solution of the
+ * symmetric 3x3 eigen problem instead of jacobi iterations.
+ */
+class normal_computation_batched_plane_fitting: public normal_computation_strategy
+{
+public:
+    // number of surfels processed together
+    static const size_t batch_size = 64;
+
+    explicit normal_computation_batched_plane_fitting(const uint16_t number_of_neighbours)
+    {
+        // base class attribute
+        number_of_neighbours_ = number_of_neighbours;
+    }
+
+    vec3f compute_normal(const bvh &tree,
+                         const surfel_id_t surfel,
+                         std::vector<std::pair<surfel_id_t, real>> const &nearest_neighbours) const override;
+
+    void compute_normals(const bvh &tree,
+                         std::vector<surfel_id_t> const &surfels,
+                         std::vector<std::vector<std::pair<surfel_id_t, real>>> const &nearest_neighbours,
+                         std::vector<vec3f> &normals) const override;
+
+    /**
+     * Fits planes to up to batch_size neighbourhoods. Neighbour j of
+     * surfel i is stored at index j * batch_size + i, positions should be
+     * relative to the surfel. Unused entries must be zero.
+     *
+     * \param[in]  x, y, z          Neighbour coordinates
+     * \param[in]  counts           Number of neighbours per surfel
+     * \param[in]  max_neighbours   Number of rows in x, y, z
+     * \param[out] normals          batch_size normals, zero if there are
+     *                              less than 3 neighbours
+     */
+    static void fit_planes(const real *x, const real *y, const real *z,
+                           const uint32_t *counts,
+                           const size_t max_neighbours,
+                           vec3f *normals);
+
+    /**
+     * Eigenvector of the smallest eigenvalue of a symmetric 3x3 matrix
+     * given as (xx, xy, xz, yy, yz, zz).
+     */
+    static vec3f smallest_eigenvector(const real *covariance);
+};
+
+}// namespace pre
+}// namespace lamure
+
+#endif // NORMAL_COMPUTATION_BATCHED_PLANE_FITTING_H_
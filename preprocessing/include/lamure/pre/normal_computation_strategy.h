@@ -12,6 +12,8 @@
 // #include <lamure/pre/bvh.h>
 #include <lamure/pre/surfel.h>
 
+#include <vector>
+
 namespace lamure
 {
 namespace pre
@@ -27,6 +29,20 @@ public:
     virtual vec3f compute_normal(const bvh &tree,
                                  const surfel_id_t surfel,
                                  std::vector<std::pair<surfel_id_t, real>> const &nearest_neighbours) const = 0;
+
+    // computes the normals of a whole block of surfels, strategies that
+    // profit from batching override this
+    virtual void compute_normals(const bvh &tree,
+                                 std::vector<surfel_id_t> const &surfels,
+                                 std::vector<std::vector<std::pair<surfel_id_t, real>>> const &nearest_neighbours,
+                                 std::vector<vec3f> &normals) const
+    {
+        normals.resize(surfels.size());
+        for (size_t i = 0; i < surfels.size(); ++i) {
+            normals[i] = compute_normal(tree, surfels[i], nearest_neighbours[i]);
+        }
+    }
+
     uint16_t const number_of_neighbours() const
     { return number_of_neighbours_; }
 
@@ -36,6 +36,13 @@ public:
                         const surfel_id_t surfel,
                         std::vector<std::pair<surfel_id_t, real>> const &nearest_neighbours) const override;
 
+    // gathers the neighbour positions of the whole block once, the sibson
+    // coordinates of all surfels share one set of clipping buffers
+    void compute_radii(const bvh &tree,
+                       std::vector<surfel_id_t> const &surfels,
+                       std::vector<std::vector<std::pair<surfel_id_t, real>>> const &nearest_neighbours,
+                       std::vector<real> &radii) const override;
+
 
 private:
     const uint16_t min_num_nearest_neighbours_;
@@ -11,6 +11,8 @@
 
 #include <lamure/pre/surfel.h>
 
+#include <vector>
+
 namespace lamure
 {
 namespace pre
@@ -27,6 +29,19 @@ public:
                                 const surfel_id_t surfel,
                                 std::vector<std::pair<surfel_id_t, real>> const &nearest_neighbours) const = 0;
 
+    // computes the radii of a whole block of surfels, strategies that
+    // profit from batching override this
+    virtual void compute_radii(const bvh &tree,
+                               std::vector<surfel_id_t> const &surfels,
+                               std::vector<std::vector<std::pair<surfel_id_t, real>>> const &nearest_neighbours,
+                               std::vector<real> &radii) const
+    {
+        radii.resize(surfels.size());
+        for (size_t i = 0; i < surfels.size(); ++i) {
+            radii[i] = compute_radius(tree, surfels[i], nearest_neighbours[i]);
+        }
+    }
+
     uint16_t const number_of_neighbours() const
     { return number_of_neighbours_; }
 
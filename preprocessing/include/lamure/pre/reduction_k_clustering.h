@@ -10,6 +10,7 @@
 #ifndef PRE_REDUCTION_K_CLUSTERING_
 #define PRE_REDUCTION_K_CLUSTERING_
 
+#include <lamure/pre/neighbour_index.h>
 #include <lamure/pre/reduction_strategy.h>
 
 #include <lamure/pre/surfel.h>
@@ -174,7 +175,9 @@ private:
     vec3f compute_avg_normal(shared_cluster_surfel_vector const &input_surfels) const;
 
     void assign_locally_overlapping_neighbours(shared_cluster_surfel current_surfel_ptr,
-                                               shared_cluster_surfel_vector &input_surfel_ptr_array) const; //functionality taken from entropy reduction strategy
+                                               shared_cluster_surfel_vector &input_surfel_ptr_array,
+                                               neighbour_index const &input_index,
+                                               real const max_input_radius) const; //functionality taken from entropy reduction strategy
 
     void compute_overlap(shared_cluster_surfel current_surfel_ptr, bool look_in_M) const; //use distance to neighbours to compute overlap
 
@@ -13,7 +13,6 @@
 
 #include <lamure/bounding_box.h>
 #include <vector>
-#include <list>
 
 namespace lamure {
 namespace pre{
@@ -34,23 +33,38 @@ private:
 
     using value_index_pair = std::pair<real, uint16_t>;
 
+    // a cluster is a range of the bucket sorted surfels of the scratch space
     struct surfel_cluster_with_error {
-        std::list<surfel>* cluster;
+        uint32_t begin;
+        uint32_t size;
         float merge_treshold;
     };
 
     struct order_by_size {
         bool operator() (const surfel_cluster_with_error& left, 
                          const surfel_cluster_with_error& right) {
-            return left.cluster->size() < right.cluster->size();
+            return left.size < right.size;
         }
     };
 
+    // buffers reused by all nodes reduced on a thread
+    struct scratch_space {
+        std::vector<vec3r> positions;
+        std::vector<uint8_t> occupied_cells;
+        std::vector<uint32_t> cell_ids;
+        std::vector<uint32_t> cell_offsets;
+        std::vector<surfel> surfels;
+        std::vector<surfel_cluster_with_error> clusters;
+        std::vector<surfel> surfels_to_merge;
+        std::vector<surfel> output_cluster;
+    };
+
     static surfel create_representative(const std::vector<surfel>& input);
     
-    std::pair<vec3ui, vec3b> compute_grid_dimensions(const std::vector<surfel_mem_array*>& input,
-                                                     const bounding_box& bounding_box,
-                                                     const uint32_t surfels_per_node) const;
+    std::pair<vec3ui, vec3b> compute_grid_dimensions(const std::vector<vec3r>& positions,
+                                                     const vec3r& bb_dimensions,
+                                                     const uint32_t surfels_per_node,
+                                                     std::vector<uint8_t>& occupied_cells) const;
 
     static bool comp (const value_index_pair& l, const value_index_pair& r) {
         return l.first < r.first;
@@ -42,6 +42,8 @@ public:
                                 const uint32_t surfels_per_node,
                                 const bvh &tree,
                                 const size_t start_node_id) const override;
+
+    bool requires_complete_child_level() const override { return true; }
 private:
 
     real
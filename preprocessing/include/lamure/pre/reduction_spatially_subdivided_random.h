@@ -31,6 +31,8 @@ public:
                                 const bvh &tree,
                                 const size_t start_node_id) const override;
 
+    bool requires_complete_child_level() const override { return true; }
+
 };
 
 } // namespace pre
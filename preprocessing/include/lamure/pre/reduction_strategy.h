@@ -24,6 +24,11 @@ class reduction_strategy
 
     virtual surfel_mem_array create_lod(real &reduction_error, const std::vector<surfel_mem_array *> &input, const uint32_t surfels_per_node, const bvh &tree, const size_t start_node_id) const = 0;
 
+    // true if create_lod reads tree data of the child level beyond its input
+    // arrays, e.g. neighbourhoods or bounding boxes of other nodes. the upsweep
+    // then finishes the whole child level before creating the parent level.
+    virtual bool requires_complete_child_level() const { return false; }
+
     void interpolate_approx_natural_neighbours(surfel &surfel_to_update, std::vector<surfel> const &input_surfels, const bvh &tree, size_t const num_nearest_neighbours = 24) const;
 };
 
@@ -69,6 +69,11 @@ public:
                       vec3f(data_.nx, data_.ny, data_.nz));
     }
 
+    vec3r pos() const
+    {
+        return vec3r(data_.x, data_.y, data_.z);
+    }
+
     void serialize(char *data)
     {
         std::memcpy(data, raw_data_, get_size());
@@ -261,7 +261,6 @@ sort_and_split(surfel_mem_array& sa,
   split_surfel_array<surfel_mem_array>(sa, out, box, split_axis, fan_factor);
 }
 
-/*
 void basic_algorithms::
 sort_and_split(surfel_disk_array& sa,
              splitted_array<surfel_disk_array>& out,
@@ -270,10 +269,12 @@ sort_and_split(surfel_disk_array& sa,
              const uint8_t fan_factor,
              const size_t memory_limit)
 {
-    external_sort::sort(sa, memory_limit, surfel::compare(split_axis));
+    assert(!sa.is_empty());
+    assert(sa.length() > 0);
+
+    external_sort::sort(sa, memory_limit, split_axis);
     split_surfel_array<surfel_disk_array>(sa, out, box, split_axis, fan_factor);
 }
-*/
 
 template <class T>
 void basic_algorithms::
@@ -286,17 +287,18 @@ split_surfel_array(T& sa,
     using Traits = array_traits<T>;
     static_assert(Traits::is_in_core || Traits::is_out_of_core, "Wrong type");
 
-    const uint32_t child_size = (int)sa.length() / fan_factor;
-    uint32_t remainder = sa.length() % fan_factor;
+    // offsets are 64 bit, out-of-core arrays may exceed 2^32 surfels
+    const size_t child_size = sa.length() / fan_factor;
+    size_t remainder = sa.length() % fan_factor;
 
     for (uint32_t i = 0; i < fan_factor; ++i) {
-        uint32_t child_first;
+        size_t child_first;
         if (i == 0)
             child_first = sa.offset();
         else
             child_first = out[i-1].first.length()+out[i-1].first.offset();
 
-        uint32_t child_last = child_first+child_size;
+        size_t child_last = child_first+child_size;
         if (remainder > 0) {
             ++child_last;
             --remainder;
@@ -21,6 +21,7 @@
 #include <lamure/pre/io/format_xyz_prov.h>
 
 #include <lamure/pre/normal_computation_plane_fitting.h>
+#include <lamure/pre/normal_computation_batched_plane_fitting.h>
 #include <lamure/pre/radius_computation_average_distance.h>
 #include <lamure/pre/radius_computation_natural_neighbours.h>
 #include <lamure/pre/reduction_normal_deviation_clustering.h>
@@ -112,6 +113,7 @@ normal_computation_strategy *builder::get_normal_strategy(normal_computation_alg
 {
     switch (algo) {
         case normal_computation_algorithm::plane_fitting:return new normal_computation_plane_fitting(desc_.number_of_neighbours);
+        case normal_computation_algorithm::batched_plane_fitting:return new normal_computation_batched_plane_fitting(desc_.number_of_neighbours);
         default:LOGGER_ERROR("Non-implemented normal computation algorithm");
             return nullptr;
     };
@@ -178,104 +180,60 @@ boost::filesystem::path builder::convert_to_binary(std::string const& input_file
 
 boost::filesystem::path builder::downsweep(boost::filesystem::path input_file, uint16_t start_stage) const
 {
-    bool performed_outlier_removal = false;
-    do {
-        std::string status_suffix = "";
-        if (true == performed_outlier_removal) {
-            status_suffix = " (after outlier removal)";
-        }
-
-        std::cout << std::endl;
-        std::cout << "--------------------------------" << std::endl;
-        std::cout << "bvh properties" << status_suffix << std::endl;
-        std::cout << "--------------------------------" << std::endl;
-
-        lamure::pre::bvh bvh(memory_limit_, desc_.buffer_size, desc_.rep_radius_algo);
-
-        bvh.init_tree(input_file.string(),
-                      desc_.max_fan_factor,
-                      desc_.surfels_per_node,
-                      base_path_);
-
-        bvh.print_tree_properties();
-        std::cout << std::endl;
-
-        std::cout << "--------------------------------" << std::endl;
-        std::cout << "downsweep" << status_suffix << std::endl;
-        std::cout << "--------------------------------" << std::endl;
-        LOGGER_TRACE("downsweep stage");
-
-        CPU_TIMER;
-        bvh.downsweep(desc_.translate_to_origin, input_file.string(), desc_.prov_file);
-
-        auto bvhd_file = add_to_path(base_path_, ".bvhd");
-
-        bvh.serialize_tree_to_file(bvhd_file.string(), true);
-
-        if ((!desc_.keep_intermediate_files) && (start_stage < 1)) {
-            // do not remove input file
-            std::remove(input_file.string().c_str());
-        }
-
-        input_file = bvhd_file;
-
-        // LOGGER_DEBUG("Used memory: " << GetProcessUsedMemory() / 1024 / 1024 << " MiB");
-
-        if (3 <= start_stage) {
-            break;
-        }
-
-        if (performed_outlier_removal) {
-            break;
-        }
-
-        if (start_stage <= 2) {
-
-            if (desc_.outlier_ratio != 0.0) {
-
-                size_t num_outliers = desc_.outlier_ratio * (bvh.nodes().size() - bvh.first_leaf()) * bvh.max_surfels_per_node();
-
-                size_t num_all_surfels = std::max(size_t((bvh.nodes().size() - bvh.first_leaf()) * bvh.max_surfels_per_node()), size_t(1));
-                num_outliers = std::min(std::max(num_outliers, size_t(1)), num_all_surfels); // remove at least 1 surfel, for any given ratio != 0.0
+    std::cout << std::endl;
+    std::cout << "--------------------------------" << std::endl;
+    std::cout << "bvh properties" << std::endl;
+    std::cout << "--------------------------------" << std::endl;
 
+    lamure::pre::bvh bvh(memory_limit_, desc_.buffer_size, desc_.rep_radius_algo);
 
-                std::cout << std::endl;
-                std::cout << "--------------------------------" << std::endl;
-                std::cout << "outlier removal ( " << int(desc_.outlier_ratio * 100) << " percent = " << num_outliers << " surfels)" << std::endl;
-                std::cout << "--------------------------------" << std::endl;
-                LOGGER_TRACE("outlier removal stage");
+    bvh.init_tree(input_file.string(),
+                  desc_.max_fan_factor,
+                  desc_.surfels_per_node,
+                  base_path_);
 
-                surfel_vector kept_surfels = bvh.remove_outliers_statistically(num_outliers, desc_.number_of_outlier_neighbours);
+    bvh.print_tree_properties();
+    std::cout << std::endl;
 
-                format_bin format_out;
+    std::cout << "--------------------------------" << std::endl;
+    std::cout << "downsweep" << std::endl;
+    std::cout << "--------------------------------" << std::endl;
+    LOGGER_TRACE("downsweep stage");
 
-                std::unique_ptr<format_abstract> dummy_format_in{new format_xyz()};
+    CPU_TIMER;
+    bvh.downsweep(desc_.translate_to_origin, input_file.string(), desc_.prov_file);
 
-                converter conv(*dummy_format_in, format_out, desc_.buffer_size);
+    // outliers are removed from the leaf level of the tree, only the subtrees
+    // which lost surfels are rebalanced
+    if (start_stage <= 2 && desc_.outlier_ratio != 0.0) {
 
-                conv.set_surfel_callback([](surfel &s, bool &keep)
-                                         { if (s.pos() == vec3r(0.0, 0.0, 0.0)) keep = false; });
+        size_t num_outliers = desc_.outlier_ratio * (bvh.nodes().size() - bvh.first_leaf()) * bvh.max_surfels_per_node();
 
-                auto binary_outlier_removed_file = add_to_path(base_path_, ".bin_wo_outlier");
+        size_t num_all_surfels = std::max(size_t((bvh.nodes().size() - bvh.first_leaf()) * bvh.max_surfels_per_node()), size_t(1));
+        num_outliers = std::min(std::max(num_outliers, size_t(1)), num_all_surfels); // remove at least 1 surfel, for any given ratio != 0.0
 
-                conv.write_in_core_surfels_out(kept_surfels, binary_outlier_removed_file.string());
 
-                bvh.reset_nodes();
+        std::cout << std::endl;
+        std::cout << "--------------------------------" << std::endl;
+        std::cout << "outlier removal ( " << int(desc_.outlier_ratio * 100) << " percent = " << num_outliers << " surfels)" << std::endl;
+        std::cout << "--------------------------------" << std::endl;
+        LOGGER_TRACE("outlier removal stage");
 
-                input_file = fs::canonical(binary_outlier_removed_file);
+        bvh.remove_outliers_statistically(num_outliers, desc_.number_of_outlier_neighbours);
+    }
 
-                performed_outlier_removal = true;
-            }
-            else {
-                break;
-            }
+    auto bvhd_file = add_to_path(base_path_, ".bvhd");
 
-        }
+    bvh.serialize_tree_to_file(bvhd_file.string(), true);
 
+    if ((!desc_.keep_intermediate_files) && (start_stage < 1)) {
+        // do not remove input file
+        std::remove(input_file.string().c_str());
     }
-    while (true);
 
-    return input_file;
+    // LOGGER_DEBUG("Used memory: " << GetProcessUsedMemory() / 1024 / 1024 << " MiB");
+
+    return bvhd_file;
 }
 
 boost::filesystem::path builder::upsweep(boost::filesystem::path input_file,
@@ -411,7 +369,7 @@ size_t builder::calculate_memory_limit() const
         return false;
     }
     LOGGER_INFO("Precision for storing coordinates and radii: " << std::string((sizeof(real) == 8) ? "double" : "single"));
-    return desc_.memory_budget;
+    return memory_budget;
 }
 
 bool builder::resample()
@@ -513,7 +471,7 @@ construct()
         if (desc_.reduction_algo == lamure::pre::reduction_algorithm::ndc_prov) {
             //create a dummy prov_file
             std::ifstream surfel_bin_file(input_file.string().c_str(), std::ios::binary | std::ios::ate);
-            uint64_t num_surfels = surfel_bin_file.tellg() / sizeof(surfel);
+            uint64_t num_surfels = surfel_bin_file.tellg() / surfel_file::record_size;
             surfel_bin_file.close();
             desc_.prov_file = input_file.string() + ".bin_prov";
             std::ofstream dummy_file(desc_.prov_file.c_str(), std::ios::out | std::ios::binary);
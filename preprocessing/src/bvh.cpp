@@ -7,16 +7,12 @@
 
 #include <lamure/config.h>
 
-#ifdef LAMURE_USE_CGAL_FOR_NNI
-#include <CGAL/Delaunay_triangulation_2.h>
-#include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
-#include <CGAL/natural_neighbor_coordinates_2.h>
-#endif
-
 #include <lamure/atomic_counter.h>
 #include <lamure/pre/basic_algorithms.h>
 #include <lamure/pre/bvh.h>
 #include <lamure/pre/bvh_stream.h>
+#include <lamure/pre/natural_neighbour_coordinates.h>
+#include <lamure/pre/neighbour_index.h>
 #include <lamure/pre/plane.h>
 #include <lamure/pre/serialized_surfel.h>
 #include <lamure/sphere.h>
@@ -25,16 +21,23 @@
 #include <lamure/pre/normal_computation_plane_fitting.h>
 #include <lamure/pre/radius_computation_average_distance.h>
 
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <exception>
 #include <fstream>
 #include <iostream>
 #include <limits>
+#include <list>
 #include <map>
 #include <math.h>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <stdio.h>
 #include <stdlib.h>
 #include <thread>
+#include <unordered_map>
 #include <unordered_set>
 
 #if WIN32
@@ -57,13 +60,6 @@ namespace pre
 
 class reduction_strategy;
 
-#ifdef LAMURE_USE_CGAL_FOR_NNI
-using K = CGAL::Exact_predicates_inexact_constructions_kernel;
-using Point2 = K::Point_2;
-using Vector2 = K::Vector_2;
-using Dh2 = CGAL::Delaunay_triangulation_2<K>;
-#endif
-
 struct nni_sample_t
 {
     scm::math::vec2f xy_;
@@ -212,6 +208,44 @@ void bvh::downsweep(
     std::string file_extension = ".lv" + std::to_string(depth_);
     leaf_level_access->open(add_to_path(base_path_, file_extension).string(), true);
 
+    // compute depth at which we can switch to in-core
+    const size_t num_input_surfels = input_file_disk_access->get_size();
+    uint32_t final_depth = std::max(0.0, std::ceil(std::log(num_input_surfels / double(in_core_surfel_capacity)) / std::log(double(fan_factor_))));
+
+    if(final_depth > depth_)
+    {
+        LOGGER_WARN("Leaf nodes do not fit in the specified memory budget. Use flag -m and choose more gigabytes");
+        final_depth = depth_;
+    }
+
+    if(final_depth != 0 && prov_input_file != "")
+    {
+        LOGGER_ERROR("Out-of-core downsweep does not support provenance data. Use flag -m and choose more gigabytes");
+        exit(1);
+    }
+
+    // the out-of-core levels sort and translate the surfels in place, so they
+    // operate on a temporary copy of the input file
+    shared_surfel_file working_file_disk_access;
+    if(final_depth != 0)
+    {
+        auto working_file = add_to_path(base_path_, ".bin_ooc");
+        LOGGER_TRACE("Copy input to out-of-core working file \"" << working_file.string() << "\"");
+
+        working_file_disk_access = std::make_shared<surfel_file>();
+        working_file_disk_access->open(working_file.string(), true);
+
+        const size_t surfels_in_buffer = std::max(buffer_size_ / sizeof(surfel), size_t(1));
+        surfel_vector buffer;
+        for(size_t i = 0; i < num_input_surfels; i += surfels_in_buffer)
+        {
+            const size_t len = std::min(surfels_in_buffer, num_input_surfels - i);
+            buffer.resize(len);
+            input_file_disk_access->read(&buffer, 0, i, len);
+            working_file_disk_access->append(&buffer, 0, len);
+        }
+    }
+
     // instantiate root surfel array
     surfel_disk_array input;
     shared_prov_file prov_file_disk_access;
@@ -219,12 +253,17 @@ void bvh::downsweep(
     // provenance extension
     shared_prov_file prov_leaf_level_access = std::make_shared<prov_file>();
     if (prov_input_file == "") {
-      input = surfel_disk_array(input_file_disk_access, 0, input_file_disk_access->get_size());
+      if (working_file_disk_access) {
+        input = surfel_disk_array(working_file_disk_access, 0, num_input_surfels);
+      }
+      else {
+        input = surfel_disk_array(input_file_disk_access, 0, num_input_surfels);
+      }
     }
     else {
       prov_file_disk_access = std::make_shared<prov_file>();
       prov_file_disk_access->open(prov_input_file);
-      if (input_file_disk_access->get_size() != prov_file_disk_access->get_size()) {
+      if (num_input_surfels != prov_file_disk_access->get_size()) {
         LOGGER_ERROR("Num provenance data and num surfels must match!");
       }
       input = surfel_disk_array(input_file_disk_access, prov_file_disk_access, 0, prov_file_disk_access->get_size());
@@ -236,16 +275,7 @@ void bvh::downsweep(
 
 
     LOGGER_INFO("Total number of surfels: " << input.length());
-
-    // compute depth at which we can switch to in-core
-    uint32_t final_depth = std::max(0.0, std::ceil(std::log(input.length() / double(in_core_surfel_capacity)) / std::log(double(fan_factor_))));
-
-    assert(final_depth <= depth_);
-    if (final_depth != 0) {
-      LOGGER_ERROR("The dataset does not fit in the specified memory budget. Use flag -m and choose more gigabytes");
-    }
-
-    //LOGGER_INFO("Tree depth to switch in-core: " << final_depth);
+    LOGGER_INFO("Tree depth to switch in-core: " << final_depth);
 
     // construct root node
     nodes_[0] = bvh_node(0, 0, bounding_box(), input);
@@ -260,8 +290,8 @@ void bvh::downsweep(
     }
     else
     {
-        LOGGER_ERROR("Compute root bounding box out-of-core NOT SUPPORTED");
-        //input_bb = basic_algorithms::compute_aabb(nodes_[0].disk_array(), buffer_size_);
+        LOGGER_TRACE("Compute root bounding box out-of-core");
+        input_bb = basic_algorithms::compute_aabb(nodes_[0].disk_array(), buffer_size_);
     }
     LOGGER_TRACE("Root AABB: " << input_bb.min() << " - " << input_bb.max());
 
@@ -301,10 +331,8 @@ void bvh::downsweep(
     uint32_t processed_nodes = 0;
     uint8_t percent_processed = 0;
 
-    if (final_depth != 0) {
-        LOGGER_ERROR("out-of-core NOT SUPPORTED");
-    }
-    /*
+    const uint32_t num_out_of_core_nodes = get_first_node_id_of_depth(final_depth);
+
     for(uint32_t level = 0; level < final_depth; ++level)
     {
         LOGGER_TRACE("Process out-of-core level: " << level);
@@ -337,11 +365,11 @@ void bvh::downsweep(
 
             // percent counter
             ++processed_nodes;
-            uint8_t new_percent_processed = (uint8_t)((float)(processed_nodes / first_leaf_ * 100));
+            uint8_t new_percent_processed = (uint8_t)(processed_nodes * 100.f / num_out_of_core_nodes);
             if(percent_processed != new_percent_processed)
             {
                 percent_processed = new_percent_processed;
-                // std::cout << "\r" << (uint8_t)percent_processed << "% processed" << std::flush;
+                LOGGER_TRACE(int(percent_processed) << "% of out-of-core nodes processed");
             }
         }
 
@@ -349,7 +377,7 @@ void bvh::downsweep(
         slice_left = new_slice_left;
         slice_right = new_slice_right;
     }
-*/
+
     // construct next level in-core
     for(size_t nid = slice_left; nid <= slice_right; ++nid)
     {
@@ -368,6 +396,9 @@ void bvh::downsweep(
     // std::cout << std::endl << std::endl;
 
     input_file_disk_access->close();
+    if (working_file_disk_access) {
+        working_file_disk_access->close(true);
+    }
     if (prov_file_disk_access && prov_file_disk_access->is_open()) {
         prov_file_disk_access->close();
     }
@@ -422,27 +453,38 @@ void bvh::downsweep_subtree_in_core(const bvh_node &node, size_t &disk_leaf_dest
 
 void bvh::compute_normal_and_radius(const bvh_node *source_node, const normal_computation_strategy &normal_computation_strategy, const radius_computation_strategy &radius_computation_strategy)
 {
-    for(size_t k = 0; k < max_surfels_per_node_; ++k)
+    const size_t num_surfels = std::min(max_surfels_per_node_, size_t(source_node->mem_array().length()));
+    uint16_t num_nearest_neighbours_to_search = std::max(radius_computation_strategy.number_of_neighbours(), normal_computation_strategy.number_of_neighbours());
+
+    // gather the neighbourhoods of the whole node, so that the normal
+    // strategy can process them in batches
+    std::vector<surfel_id_t> surfel_ids;
+    std::vector<std::vector<std::pair<surfel_id_t, real>>> nearest_neighbours(num_surfels);
+    surfel_ids.reserve(num_surfels);
+
+    for(size_t k = 0; k < num_surfels; ++k)
     {
-        if(k < source_node->mem_array().length())
-        {
-            // read surfel
-            surfel surf = source_node->mem_array().read_surfel(k);
+        surfel_ids.emplace_back(source_node->node_id(), k);
+        nearest_neighbours[k] = get_nearest_neighbours(surfel_ids.back(), num_nearest_neighbours_to_search);
+    }
 
-            uint16_t num_nearest_neighbours_to_search = std::max(radius_computation_strategy.number_of_neighbours(), normal_computation_strategy.number_of_neighbours());
+    // compute normals
+    std::vector<vec3f> normals;
+    normal_computation_strategy.compute_normals(*this, surfel_ids, nearest_neighbours, normals);
 
-            auto const &max_nearest_neighbours = get_nearest_neighbours(surfel_id_t(source_node->node_id(), k), num_nearest_neighbours_to_search);
-            // compute radius
-            real radius = radius_computation_strategy.compute_radius(*this, surfel_id_t(source_node->node_id(), k), max_nearest_neighbours);
+    // compute radii
+    std::vector<real> radii;
+    radius_computation_strategy.compute_radii(*this, surfel_ids, nearest_neighbours, radii);
 
-            // compute normal
-            vec3f normal = normal_computation_strategy.compute_normal(*this, surfel_id_t(source_node->node_id(), k), max_nearest_neighbours);
+    for(size_t k = 0; k < num_surfels; ++k)
+    {
+        // read surfel
+        surfel surf = source_node->mem_array().read_surfel(k);
 
-            // write surfel
-            surf.radius() = radius;
-            surf.normal() = normal;
-            source_node->mem_array().write_surfel(surf, k);
-        }
+        // write surfel
+        surf.radius() = radii[k];
+        surf.normal() = normals[k];
+        source_node->mem_array().write_surfel(surf, k);
     }
 }
 
@@ -484,108 +526,91 @@ void bvh::get_descendant_nodes(const node_id_type node, std::vector<node_id_type
     }
 }
 
-std::vector<std::pair<surfel_id_t, real>> bvh::get_nearest_neighbours(surfel_id_t const target_surfel, uint32_t const number_of_neighbours, bool const do_local_search) const
+void bvh::get_nearest_neighbours_in_node(const node_id_type node_id, const vec3r &center, const uint32_t number_of_neighbours, const surfel_id_t &excluded_surfel,
+                                         std::vector<std::pair<surfel_id_t, real>> &candidates) const
 {
-    node_id_type current_node = target_surfel.node_idx;
-    std::unordered_set<size_t> processed_nodes;
-    vec3r center = nodes_[target_surfel.node_idx].mem_array().read_surfel_ref(target_surfel.surfel_idx).pos();
+    const surfel_mem_array &mem_array = nodes_[node_id].mem_array();
+    const size_t excluded_idx = (node_id == excluded_surfel.node_idx) ? excluded_surfel.surfel_idx : std::numeric_limits<size_t>::max();
 
-    std::vector<std::pair<surfel_id_t, real>> candidates;
-    real max_candidate_distance = std::numeric_limits<real>::max();
+    if(node_id < neighbour_indices_.size() && neighbour_indices_[node_id].is_built() && neighbour_indices_[node_id].size() == mem_array.length())
+    {
+        neighbour_indices_[node_id].search_nearest(center, number_of_neighbours, node_id, excluded_idx, candidates);
+        return;
+    }
 
-    // check own node
-    for(size_t i = 0; i < nodes_[current_node].mem_array().length(); ++i)
+    // no index available, e.g. for nodes that are currently being reduced
+    for(size_t i = 0; i < mem_array.length(); ++i)
     {
-        if(i != target_surfel.surfel_idx)
+        if(i != excluded_idx)
         {
-            surfel const& current_surfel = nodes_[current_node].mem_array().read_surfel_ref(i);
-            real distance_to_center = scm::math::length_sqr(center - current_surfel.pos());
+            real distance_to_center = scm::math::length_sqr(center - mem_array.read_surfel_ref(i).pos());
+            neighbour_index::push_candidate(candidates, number_of_neighbours, surfel_id_t{node_id, i}, distance_to_center);
+        }
+    }
+}
 
-            if(candidates.size() < number_of_neighbours || (distance_to_center < max_candidate_distance))
-            {
-                // we found a neighbor which is closer than our most distant neighbor 
-                if(candidates.size() == number_of_neighbours) {
-                    candidates.pop_back();
-                }
+std::vector<std::pair<surfel_id_t, real>> bvh::get_nearest_neighbours(surfel_id_t const target_surfel, uint32_t const number_of_neighbours, bool const do_local_search) const
+{
+    node_id_type current_node = target_surfel.node_idx;
+    vec3r center = nodes_[target_surfel.node_idx].mem_array().read_surfel_ref(target_surfel.surfel_idx).pos();
 
-                candidates.emplace_back(surfel_id_t{current_node, i}, distance_to_center);
+    // max-heap on the squared distance, sorted before returning
+    std::vector<std::pair<surfel_id_t, real>> candidates;
+    candidates.reserve(number_of_neighbours);
 
-                for(uint16_t k = candidates.size() - 1; k > 0; --k)
-                {
-                    if(candidates[k].second < candidates[k - 1].second)
-                    {
-                        std::swap(candidates[k], candidates[k - 1]);
-                    }
-                    else
-                        break;
-                }
+    auto max_candidate_distance = [&]() {
+        return candidates.size() < number_of_neighbours ? std::numeric_limits<real>::max() : candidates.front().second;
+    };
 
-                max_candidate_distance = candidates.back().second;
-            }
-        }
-    }
+    // check own node
+    get_nearest_neighbours_in_node(current_node, center, number_of_neighbours, target_surfel, candidates);
 
     if(do_local_search)
     {
+        neighbour_index::sort_candidates(candidates);
         return candidates;
     }
 
-    processed_nodes.insert(current_node);
-
     // check rest of kd-bvh
-    sphere candidates_sphere = sphere(center, sqrt(max_candidate_distance));
+    const uint32_t target_depth = nodes_[target_surfel.node_idx].depth();
+    uint32_t current_depth = target_depth;
+    sphere candidates_sphere = sphere(center, sqrt(max_candidate_distance()));
 
     while((!nodes_[current_node].get_bounding_box().contains(candidates_sphere)) && (current_node != 0))
     {
+        const node_id_type processed_node = current_node;
         current_node = get_parent_id(current_node);
+        --current_depth;
 
-        std::vector<node_id_type> unvisited_descendant_nodes;
-
-        get_descendant_nodes(current_node, unvisited_descendant_nodes, nodes_[target_surfel.node_idx].depth(), processed_nodes);
-
-        for(auto adjacent_node : unvisited_descendant_nodes)
+        // the subtree of processed_node has been visited already, the nodes of
+        // the target depth below each sibling form a contiguous range of ids
+        for(uint16_t c = 0; c < fan_factor_; ++c)
         {
-            if(candidates_sphere.intersects_or_contains(nodes_[adjacent_node].get_bounding_box()))
+            const node_id_type sibling = get_child_id(current_node, c);
+            if(sibling == processed_node)
             {
-                // assert(nodes_[adjacent_node].is_out_of_core());
+                continue;
+            }
 
-                for(size_t i = 0; i < nodes_[adjacent_node].mem_array().length(); ++i)
-                {
-                    if(!(adjacent_node == target_surfel.node_idx && i == target_surfel.surfel_idx))
-                    {
-                        const surfel &current_surfel = nodes_[adjacent_node].mem_array().read_surfel_ref(i);
-                        real distance_to_center = scm::math::length_sqr(center - current_surfel.pos());
+            node_id_type first_adjacent_node = sibling, last_adjacent_node = sibling;
+            for(uint32_t d = current_depth + 1; d < target_depth; ++d)
+            {
+                first_adjacent_node = first_adjacent_node * fan_factor_ + 1;
+                last_adjacent_node = last_adjacent_node * fan_factor_ + fan_factor_;
+            }
 
-                        if(candidates.size() < number_of_neighbours || (distance_to_center < max_candidate_distance))
-                        {
-                            // we found a neighbor which is closer than our most distant neighbor 
-                            if(candidates.size() == number_of_neighbours) {
-                                candidates.pop_back();
-                            }
-
-                            candidates.emplace_back(surfel_id_t{adjacent_node, i}, distance_to_center);
-
-                            for(uint16_t k = candidates.size() - 1; k > 0; --k)
-                            {
-                                if(candidates[k].second < candidates[k - 1].second)
-                                {
-                                    std::swap(candidates[k], candidates[k - 1]);
-                                }
-                                else
-                                    break;
-                            }
-
-                            max_candidate_distance = candidates.back().second;
-                        }
-                    }
+            for(node_id_type adjacent_node = first_adjacent_node; adjacent_node <= last_adjacent_node; ++adjacent_node)
+            {
+                if(candidates_sphere.intersects_or_contains(nodes_[adjacent_node].get_bounding_box()))
+                {
+                    get_nearest_neighbours_in_node(adjacent_node, center, number_of_neighbours, target_surfel, candidates);
+                    candidates_sphere = sphere(center, sqrt(max_candidate_distance()));
                 }
-
-                processed_nodes.insert(adjacent_node);
-                candidates_sphere = sphere(center, sqrt(max_candidate_distance));
             }
         }
     }
 
+    neighbour_index::sort_candidates(candidates);
     return candidates;
 }
 
@@ -596,186 +621,110 @@ std::vector<std::pair<surfel_id_t, real>> bvh::get_nearest_neighbours_in_nodes(c
     vec3r center = nodes_[target_surfel.node_idx].mem_array().read_surfel_ref(target_surfel.surfel_idx).pos();
 
     std::vector<std::pair<surfel_id_t, real>> candidates;
-    real max_candidate_distance = std::numeric_limits<real>::infinity();
-
-    // check own node
-    for(size_t i = 0; i < nodes_[current_node].mem_array().length(); ++i)
-    {
-        if(i != target_surfel.surfel_idx)
-        {
-            const surfel &current_surfel = nodes_[current_node].mem_array().read_surfel_ref(i);
-            real distance_to_center = scm::math::length_sqr(center - current_surfel.pos());
-
-            if(candidates.size() < number_of_neighbours || (distance_to_center < max_candidate_distance))
-            {
-                if(candidates.size() == number_of_neighbours)
-                    candidates.pop_back();
+    candidates.reserve(number_of_neighbours);
 
-                candidates.emplace_back(surfel_id_t{current_node, i}, distance_to_center);
-
-                for(uint16_t k = candidates.size() - 1; k > 0; --k)
-                {
-                    if(candidates[k].second < candidates[k - 1].second)
-                    {
-                        std::swap(candidates[k], candidates[k - 1]);
-                    }
-                    else
-                        break;
-                }
+    auto max_candidate_distance = [&]() {
+        return candidates.size() < number_of_neighbours ? std::numeric_limits<real>::infinity() : candidates.front().second;
+    };
 
-                max_candidate_distance = candidates.back().second;
-            }
-        }
-    }
+    // check own node
+    get_nearest_neighbours_in_node(current_node, center, number_of_neighbours, target_surfel, candidates);
 
     // check remaining nodes in vector
-    sphere candidates_sphere = sphere(center, sqrt(max_candidate_distance));
+    sphere candidates_sphere = sphere(center, sqrt(max_candidate_distance()));
     for(auto adjacent_node : target_nodes)
     {
         if(adjacent_node != current_node)
         {
             if(candidates_sphere.intersects_or_contains(nodes_[adjacent_node].get_bounding_box()))
             {
-                // assert(nodes_[adjacent_node].is_out_of_core());
-
-                for(size_t i = 0; i < nodes_[adjacent_node].mem_array().length(); ++i)
-                {
-                    if(!(adjacent_node == target_surfel.node_idx && i == target_surfel.surfel_idx))
-                    {
-                        const surfel &current_surfel = nodes_[adjacent_node].mem_array().read_surfel_ref(i);
-                        real distance_to_center = scm::math::length_sqr(center - current_surfel.pos());
-
-                        if(candidates.size() < number_of_neighbours || (distance_to_center < max_candidate_distance))
-                        {
-                            if(candidates.size() == number_of_neighbours)
-                                candidates.pop_back();
-
-                            candidates.emplace_back(surfel_id_t{adjacent_node, i}, distance_to_center);
-
-                            for(uint16_t k = candidates.size() - 1; k > 0; --k)
-                            {
-                                if(candidates[k].second < candidates[k - 1].second)
-                                {
-                                    std::swap(candidates[k], candidates[k - 1]);
-                                }
-                                else
-                                    break;
-                            }
-
-                            max_candidate_distance = candidates.back().second;
-                        }
-                    }
-                }
+                get_nearest_neighbours_in_node(adjacent_node, center, number_of_neighbours, target_surfel, candidates);
             }
 
-            candidates_sphere = sphere(center, sqrt(max_candidate_distance));
+            candidates_sphere = sphere(center, sqrt(max_candidate_distance()));
         }
     }
+
+    neighbour_index::sort_candidates(candidates);
     return candidates;
 }
 
-std::vector<std::pair<surfel_id_t, real>> bvh::get_natural_neighbours(surfel_id_t const &target_surfel, std::vector<std::pair<surfel_id_t, real>> const &all_nearest_neighbours) const
+void bvh::spawn_build_neighbour_index_jobs(const uint32_t first_node_of_level, const uint32_t last_node_of_level)
 {
-    // limit to 24 closest neighbours
-    const uint32_t NUM_NATURAL_NEIGHBOURS = 24;
-    auto nearest_neighbours = all_nearest_neighbours;
-    nearest_neighbours.resize(NUM_NATURAL_NEIGHBOURS);
-    std::random_shuffle(nearest_neighbours.begin(), nearest_neighbours.end());
-
-    std::vector<vec3r> nn_positions(NUM_NATURAL_NEIGHBOURS);
-
-    std::size_t point_num = 0;
-    for(auto const &near_neighbour : nearest_neighbours)
+    if(neighbour_indices_.size() < nodes_.size())
     {
-        nn_positions[point_num] = nodes_[near_neighbour.first.node_idx].mem_array().read_surfel_ref(near_neighbour.first.surfel_idx).pos();
-        ++point_num;
+        neighbour_indices_.resize(nodes_.size());
     }
 
-    auto natural_neighbour_ids = extract_approximate_natural_neighbours(nodes_[target_surfel.node_idx].mem_array().read_surfel_ref(target_surfel.surfel_idx).pos(), nn_positions);
+    uint32_t const num_threads = std::thread::hardware_concurrency();
+    working_queue_head_counter_.initialize(first_node_of_level); // let the threads fetch a node idx
+    std::vector<std::thread> threads;
 
-    std::vector<std::pair<surfel_id_t, real>> natural_neighbours{};
-    natural_neighbours.reserve(NUM_NATURAL_NEIGHBOURS);
-    for(auto const &natural_neighbour_id : natural_neighbour_ids)
+    for(uint32_t thread_idx = 0; thread_idx < num_threads; ++thread_idx)
     {
-        natural_neighbours.emplace_back(nearest_neighbours[natural_neighbour_id.first].first, natural_neighbour_id.second);
+        threads.push_back(std::thread(&bvh::thread_build_neighbour_index, this, first_node_of_level, last_node_of_level));
     }
 
-    nn_positions.clear();
-    return natural_neighbours;
+    for(auto &thread : threads)
+    {
+        thread.join();
+    }
 }
 
-#ifdef LAMURE_USE_CGAL_FOR_NNI
-std::vector<std::pair<uint32_t, real>> bvh::extract_approximate_natural_neighbours(vec3r const &point_of_interest, std::vector<vec3r> const &nn_positions) const
+void bvh::thread_build_neighbour_index(const uint32_t start_marker, const uint32_t end_marker)
 {
-    std::vector<std::pair<uint32_t, real>> natural_neighbour_ids;
-    uint32_t num_input_neighbours = nn_positions.size();
-    // compute best fit plane
-    plane_t plane;
-    plane_t::fit_plane(nn_positions, plane);
-
-    std::vector<scm::math::vec2f> projected_neighbours(num_input_neighbours);
-    vec3r plane_right = plane.get_right();
-    vec3r plane_up = plane.get_up();
-    // cgal delaunay triangluation
-    Dh2 delaunay_triangulation;
+    uint32_t node_index = working_queue_head_counter_.increment_head();
 
-    // project all points to the plane
-    for(uint32_t i = 0; i < num_input_neighbours; ++i)
+    while(node_index < end_marker)
     {
-        projected_neighbours[i] = plane_t::project(plane, plane_right, plane_up, nn_positions[i]);
-        // projection invalid
-        if(projected_neighbours[i][0] != projected_neighbours[i][0] || projected_neighbours[i][1] != projected_neighbours[i][1])
-        { // is nan?
-            return natural_neighbour_ids;
-        }
-        delaunay_triangulation.insert(Point2{projected_neighbours[i].x, projected_neighbours[i].y});
+        neighbour_indices_[node_index].build(nodes_[node_index].mem_array());
+        node_index = working_queue_head_counter_.increment_head();
     }
+}
 
-    // project point of interest
-    vec2r projected_poi = plane_t::project(plane, plane_right, plane_up, point_of_interest);
-
-    std::vector<std::pair<K::Point_2, K::FT>> sibson_coords{};
-    CGAL::Triple<std::back_insert_iterator<std::vector<std::pair<K::Point_2, K::FT>>>, K::FT, bool> result =
-        natural_neighbor_coordinates_2(delaunay_triangulation, Point2{projected_poi.x, projected_poi.y}, std::back_inserter(sibson_coords));
+std::vector<std::pair<surfel_id_t, real>> bvh::get_natural_neighbours(surfel_id_t const &target_surfel, std::vector<std::pair<surfel_id_t, real>> const &all_nearest_neighbours) const
+{
+    // limit to the closest neighbours
+    const uint32_t num_neighbours = std::min(uint32_t(all_nearest_neighbours.size()), natural_neighbour_coordinates::max_neighbours);
 
-    if(!result.third)
+    vec3r nn_positions[natural_neighbour_coordinates::max_neighbours];
+    for(uint32_t i = 0; i < num_neighbours; ++i)
     {
-        return natural_neighbour_ids;
+        auto const &near_neighbour = all_nearest_neighbours[i];
+        nn_positions[i] = nodes_[near_neighbour.first.node_idx].mem_array().read_surfel_ref(near_neighbour.first.surfel_idx).pos();
     }
 
-    for(const auto &sibs_coord_instance : sibson_coords)
-    {
-        scm::math::vec2d coord_position{sibs_coord_instance.first.x(), sibs_coord_instance.first.y()};
-        uint32_t closest_neighbour_id = std::numeric_limits<uint32_t>::max();
-        double min_distance = std::numeric_limits<double>::max();
-
-        for(uint32_t i = 0; i < num_input_neighbours; ++i)
-        {
-            double current_distance = scm::math::length_sqr(projected_neighbours[i] - coord_position);
-            if(current_distance < min_distance)
-            {
-                min_distance = current_distance;
-                closest_neighbour_id = i;
-            }
-        }
+    uint32_t natural_neighbour_ids[natural_neighbour_coordinates::max_neighbours];
+    real natural_neighbour_weights[natural_neighbour_coordinates::max_neighbours];
+    const uint32_t num_natural_neighbours = natural_neighbour_coordinates::compute(nodes_[target_surfel.node_idx].mem_array().read_surfel_ref(target_surfel.surfel_idx).pos(), nn_positions,
+                                                                                   num_neighbours, natural_neighbour_ids, natural_neighbour_weights);
 
-        natural_neighbour_ids.emplace_back(closest_neighbour_id, (double)sibs_coord_instance.second);
-        // invalidate the 2d coord pair by putting ridiculously large 2d coords that the model is unlikely to contain
-        projected_neighbours[closest_neighbour_id] = scm::math::vec2f(std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest());
+    std::vector<std::pair<surfel_id_t, real>> natural_neighbours{};
+    natural_neighbours.reserve(num_natural_neighbours);
+    for(uint32_t i = 0; i < num_natural_neighbours; ++i)
+    {
+        natural_neighbours.emplace_back(all_nearest_neighbours[natural_neighbour_ids[i]].first, natural_neighbour_weights[i]);
     }
 
-    // nn_positions.clear();
-    projected_neighbours.clear();
-    sibson_coords.clear();
-
-    return natural_neighbour_ids;
+    return natural_neighbours;
 }
-#else
+
 std::vector<std::pair<uint32_t, real>> bvh::extract_approximate_natural_neighbours(vec3r const &point_of_interest, std::vector<vec3r> const &nn_positions) const
 {
-    throw std::runtime_error("to implement without CGAL.");
+    uint32_t natural_neighbour_ids[natural_neighbour_coordinates::max_neighbours];
+    real natural_neighbour_weights[natural_neighbour_coordinates::max_neighbours];
+    const uint32_t num_natural_neighbours = natural_neighbour_coordinates::compute(point_of_interest, nn_positions.data(), nn_positions.size(),
+                                                                                   natural_neighbour_ids, natural_neighbour_weights);
+
+    std::vector<std::pair<uint32_t, real>> natural_neighbour_ids_weights;
+    natural_neighbour_ids_weights.reserve(num_natural_neighbours);
+    for(uint32_t i = 0; i < num_natural_neighbours; ++i)
+    {
+        natural_neighbour_ids_weights.emplace_back(natural_neighbour_ids[i], natural_neighbour_weights[i]);
+    }
+
+    return natural_neighbour_ids_weights;
 }
-#endif
 
 std::vector<std::pair<surfel, real>> bvh::get_locally_natural_neighbours(std::vector<surfel> const &potential_neighbour_vec, vec3r const &poi, uint32_t num_nearest_neighbours) const
 {
@@ -834,25 +783,6 @@ std::vector<std::pair<surfel, real>> bvh::get_locally_natural_neighbours(std::ve
     return nni_weight_pairs;
 }
 
-void bvh::spawn_create_lod_jobs(const uint32_t first_node_of_level, const uint32_t last_node_of_level, const reduction_strategy &reduction_strgy, const bool resample)
-{
-    uint32_t const num_threads = std::thread::hardware_concurrency();
-
-    working_queue_head_counter_.initialize(first_node_of_level); // let the threads fetch a node idx
-    std::vector<std::thread> threads;
-
-    for(uint32_t thread_idx = 0; thread_idx < num_threads; ++thread_idx)
-    {
-        bool update_percentage = (0 == thread_idx);
-        threads.push_back(std::thread(&bvh::thread_create_lod, this, first_node_of_level, last_node_of_level, update_percentage, std::cref(reduction_strgy), resample));
-    }
-
-    for(auto &thread : threads)
-    {
-        thread.join();
-    }
-}
-
 void bvh::spawn_compute_attribute_jobs(const uint32_t first_node_of_level, const uint32_t last_node_of_level, const normal_computation_strategy &normal_strategy,
                                        const radius_computation_strategy &radius_strategy, const bool is_leaf_level)
 {
@@ -1019,24 +949,6 @@ std::vector<surfel_id_t> bvh::find_resample_candidates(const uint32_t node_idx)
     return surfel_id_vector;
 }
 
-void bvh::spawn_compute_bounding_boxes_upsweep_jobs(const uint32_t first_node_of_level, const uint32_t last_node_of_level, const int32_t level)
-{
-    uint32_t const num_threads = std::thread::hardware_concurrency();
-    working_queue_head_counter_.initialize(0); // let the threads fetch a local thread idx
-    std::vector<std::thread> threads;
-
-    for(uint32_t thread_idx = 0; thread_idx < num_threads; ++thread_idx)
-    {
-        bool update_percentage = (0 == thread_idx);
-        threads.push_back(std::thread(&bvh::thread_compute_bounding_boxes_upsweep, this, first_node_of_level, last_node_of_level, update_percentage, level, num_threads));
-    }
-
-    for(auto &thread : threads)
-    {
-        thread.join();
-    }
-}
-
 void bvh::spawn_split_node_jobs(size_t &slice_left, size_t &slice_right, size_t &new_slice_left, size_t &new_slice_right, const uint32_t level)
 {
     uint32_t const num_threads = std::thread::hardware_concurrency();
@@ -1056,94 +968,69 @@ void bvh::spawn_split_node_jobs(size_t &slice_left, size_t &slice_right, size_t
     }
 }
 
-void bvh::thread_create_lod(const uint32_t start_marker, const uint32_t end_marker, const bool update_percentage, const reduction_strategy &reduction_strgy, const bool do_resample)
+void bvh::create_lod(const node_id_type node_id, const reduction_strategy &reduction_strgy, const bool do_resample)
 {
-    uint32_t node_index = working_queue_head_counter_.increment_head();
-
-    while(node_index < end_marker)
-    {
-        bvh_node *current_node = &nodes_.at(node_index);
-        // If a node has no data yet, calculate it based on child nodes.
-        if(!current_node->is_in_core() && !current_node->is_out_of_core())
-        {
-            std::vector<surfel_mem_array> resampled_arrays;
-            std::vector<surfel_mem_array *> input_mem_arrays;
+    bvh_node *current_node = &nodes_.at(node_id);
 
-            // simplified data will be stored here
-            surfel_mem_array reduction_result = surfel_mem_array(std::make_shared<surfel_vector>(surfel_vector()), 0, 0);
-
-            if(do_resample)
-            {
-                if (current_node->has_provenance()) {
-                    throw std::runtime_error("resampling not supported for PROVENANCE");
-                }
-                for(uint8_t child_index = 0; child_index < fan_factor_; ++child_index)
-                {
-                    size_t child_id = this->get_child_id(current_node->node_id(), child_index);
-                    resampled_arrays.push_back(resample_node(child_id));
-                }
-                for(uint8_t child_index = 0; child_index < fan_factor_; ++child_index)
-                {
-                    input_mem_arrays.push_back(&resampled_arrays[child_index]);
-                }
-            }
-            else
-            {
-                bool child_has_provenance = false;
-                for(uint8_t child_index = 0; child_index < fan_factor_; ++child_index)
-                {
-                    size_t child_id = this->get_child_id(current_node->node_id(), child_index);
-                    bvh_node *child_node = &nodes_.at(child_id);
-
-                    input_mem_arrays.push_back(&child_node->mem_array());
-                    child_has_provenance = child_node->has_provenance();
-                }                
-                if (child_has_provenance) {
-                    reduction_result = surfel_mem_array(
-                        std::make_shared<surfel_vector>(surfel_vector()),
-                        std::make_shared<prov_vector>(prov_vector()), 0, 0);
-                }
-            }
+    std::vector<surfel_mem_array> resampled_arrays;
+    std::vector<surfel_mem_array *> input_mem_arrays;
 
-            real reduction_error;
+    // simplified data will be stored here
+    surfel_mem_array reduction_result = surfel_mem_array(std::make_shared<surfel_vector>(surfel_vector()), 0, 0);
 
-            reduction_strategy *p_reduction_strgy = (reduction_strategy *)&reduction_strgy;
-            if(reduction_strategy_provenance *cast = dynamic_cast<reduction_strategy_provenance *>(p_reduction_strgy))
-            {
-                std::vector<reduction_strategy_provenance::LoDMetaData> deviations;
-                reduction_result = cast->create_lod(reduction_error, input_mem_arrays, deviations, max_surfels_per_node_, (*this), get_child_id(current_node->node_id(), 0));
-                //cast->output_lod(deviations, node_index);
-            }
-            else
-            {
-                if (reduction_result.has_provenance()) {
-                    std::cout << "ERROR: Only reduction_strategy_provenance supported for PROVENANCE" << std::endl;
-                    throw std::runtime_error("Only reduction_strategy_provenance supported for PROVENANCE");
-                }
-                reduction_result = reduction_strgy.create_lod(reduction_error, input_mem_arrays, max_surfels_per_node_, (*this), get_child_id(current_node->node_id(), 0));
-            }
+    if(do_resample)
+    {
+        if (current_node->has_provenance()) {
+            throw std::runtime_error("resampling not supported for PROVENANCE");
+        }
+        for(uint8_t child_index = 0; child_index < fan_factor_; ++child_index)
+        {
+            size_t child_id = this->get_child_id(current_node->node_id(), child_index);
+            resampled_arrays.push_back(resample_node(child_id));
+        }
+        for(uint8_t child_index = 0; child_index < fan_factor_; ++child_index)
+        {
+            input_mem_arrays.push_back(&resampled_arrays[child_index]);
+        }
+    }
+    else
+    {
+        bool child_has_provenance = false;
+        for(uint8_t child_index = 0; child_index < fan_factor_; ++child_index)
+        {
+            size_t child_id = this->get_child_id(current_node->node_id(), child_index);
+            bvh_node *child_node = &nodes_.at(child_id);
 
-            current_node->reset(reduction_result);
-            current_node->set_reduction_error(reduction_error);
+            input_mem_arrays.push_back(&child_node->mem_array());
+            child_has_provenance = child_node->has_provenance();
+        }
+        if (child_has_provenance) {
+            reduction_result = surfel_mem_array(
+                std::make_shared<surfel_vector>(surfel_vector()),
+                std::make_shared<prov_vector>(prov_vector()), 0, 0);
+        }
+    }
 
-            // Unload all child nodes, if not in leaf level
-            if(get_depth_of_node(current_node->node_id()) != depth())
-            {
-                for(uint8_t child_index = 0; child_index < fan_factor_; ++child_index)
-                {
-                    size_t child_id = get_child_id(current_node->node_id(), child_index);
-                    bvh_node &child_node = nodes_.at(child_id);
+    real reduction_error;
 
-                    if(child_node.is_in_core())
-                    {
-                        child_node.mem_array().reset();
-                    }
-                }
-            }
+    reduction_strategy *p_reduction_strgy = (reduction_strategy *)&reduction_strgy;
+    if(reduction_strategy_provenance *cast = dynamic_cast<reduction_strategy_provenance *>(p_reduction_strgy))
+    {
+        std::vector<reduction_strategy_provenance::LoDMetaData> deviations;
+        reduction_result = cast->create_lod(reduction_error, input_mem_arrays, deviations, max_surfels_per_node_, (*this), get_child_id(current_node->node_id(), 0));
+        //cast->output_lod(deviations, node_id);
+    }
+    else
+    {
+        if (reduction_result.has_provenance()) {
+            std::cout << "ERROR: Only reduction_strategy_provenance supported for PROVENANCE" << std::endl;
+            throw std::runtime_error("Only reduction_strategy_provenance supported for PROVENANCE");
         }
-
-        node_index = working_queue_head_counter_.increment_head();
+        reduction_result = reduction_strgy.create_lod(reduction_error, input_mem_arrays, max_surfels_per_node_, (*this), get_child_id(current_node->node_id(), 0));
     }
+
+    current_node->reset(reduction_result);
+    current_node->set_reduction_error(reduction_error);
 }
 
 surfel_mem_array bvh::resample_node(uint32_t node_index) const
@@ -1254,106 +1141,45 @@ void bvh::thread_compute_bounding_boxes_downsweep(const uint32_t slice_left, con
     }
 }
 
-void bvh::thread_compute_bounding_boxes_upsweep(const uint32_t start_marker, const uint32_t end_marker, const bool update_percentage, const int32_t level, const uint32_t num_threads)
+void bvh::thread_remove_outlier_jobs(const uint32_t start_marker, const uint32_t end_marker, const uint32_t num_outliers, const uint16_t num_neighbours,
+                                     std::vector<std::pair<surfel_id_t, real>> &intermediate_outliers_for_thread)
 {
-    uint32_t thread_idx = working_queue_head_counter_.increment_head();
+    // bounded min-heap on the average neighbour distance, the front is the
+    // weakest candidate and the first one to be replaced
+    auto const greater_distance = [](std::pair<surfel_id_t, real> const &lhs, std::pair<surfel_id_t, real> const &rhs) { return lhs.second > rhs.second; };
 
-    uint32_t total_num_nodes = (end_marker - start_marker) + 1;
-    uint32_t num_nodes_per_thread = std::ceil(float(total_num_nodes) / num_threads);
-
-    uint32_t local_start_index = start_marker + thread_idx * num_nodes_per_thread;
-    uint32_t local_end_index = start_marker + (thread_idx + 1) * num_nodes_per_thread;
+    uint32_t node_idx = working_queue_head_counter_.increment_head();
 
-    for(uint32_t node_index = local_start_index; node_index < local_end_index; ++node_index)
+    while(node_idx < end_marker)
     {
-        // early termination if number of nodes could not be evenly divided
-        if(node_index >= end_marker)
-        {
-            break;
-        }
-
-        bvh_node *current_node = &nodes_.at(node_index);
-
-        basic_algorithms::surfel_group_properties props = basic_algorithms::compute_properties(current_node->mem_array(), rep_radius_algo_);
+        bvh_node *current_node = &nodes_.at(node_idx);
 
-        current_node->set_max_surfel_radius_deviation(props.max_radius_deviation);
+        for(size_t surfel_idx = 0; surfel_idx < current_node->mem_array().length(); ++surfel_idx)
+        {
+            std::vector<std::pair<surfel_id_t, real>> const nearest_neighbour_vector = get_nearest_neighbours(surfel_id_t(node_idx, surfel_idx), num_neighbours);
 
-        bounding_box node_bounding_box;
-        node_bounding_box.expand(props.bbox);
+            double avg_dist = 0.0;
 
-        if(level < int32_t(depth_))
-        {
-            for(int32_t child_index = 0; child_index < fan_factor_; ++child_index)
+            if(nearest_neighbour_vector.size())
             {
-                uint32_t child_id = this->get_child_id(current_node->node_id(), child_index);
-                bvh_node *child_node = &nodes_.at(child_id);
+                for(auto const& nearest_neighbour_pair : nearest_neighbour_vector)
+                {
+                    avg_dist += nearest_neighbour_pair.second;
+                }
 
-                node_bounding_box.expand(child_node->get_bounding_box());
+                avg_dist /= nearest_neighbour_vector.size();
             }
-        }
-
-        current_node->set_avg_surfel_radius(props.rep_radius);
-        current_node->set_centroid(props.centroid);
 
-        current_node->set_bounding_box(node_bounding_box);
-        current_node->calculate_statistics();
-
-        if (node_index == 0) {
-            std::cout << "min: " << node_bounding_box.min() << std::endl;
-            std::cout << "max: " << node_bounding_box.max() << std::endl;
-        }
-    }
-}
-
-void bvh::thread_remove_outlier_jobs(const uint32_t start_marker, const uint32_t end_marker, const uint32_t num_outliers, const uint16_t num_neighbours,
-                                     std::vector<std::pair<surfel_id_t, real>> &intermediate_outliers_for_thread)
-{
-    uint32_t node_idx = working_queue_head_counter_.increment_head();
-
-    while(node_idx < end_marker)
-    {
-        bvh_node *current_node = &nodes_.at(node_idx);
-
-        for(size_t surfel_idx = 0; surfel_idx < current_node->mem_array().length(); ++surfel_idx)
-        {
-            std::vector<std::pair<surfel_id_t, real>> const nearest_neighbour_vector = get_nearest_neighbours(surfel_id_t(node_idx, surfel_idx), num_neighbours);
-
-            double avg_dist = 0.0;
-
-            if(nearest_neighbour_vector.size())
-            {
-                for(auto const& nearest_neighbour_pair : nearest_neighbour_vector)
-                {
-                    avg_dist += nearest_neighbour_pair.second;
-                }
-
-                avg_dist /= nearest_neighbour_vector.size();
-            }
-
-            bool insert_element = false;
             if(intermediate_outliers_for_thread.size() < num_outliers)
             {
-                insert_element = true;
+                intermediate_outliers_for_thread.emplace_back(surfel_id_t(node_idx, surfel_idx), avg_dist);
+                std::push_heap(intermediate_outliers_for_thread.begin(), intermediate_outliers_for_thread.end(), greater_distance);
             }
-            else if(avg_dist > intermediate_outliers_for_thread.back().second)
+            else if(avg_dist > intermediate_outliers_for_thread.front().second)
             {
-                intermediate_outliers_for_thread.pop_back();
-                insert_element = true;
-            }
-
-            if(insert_element)
-            {
-                intermediate_outliers_for_thread.emplace_back(surfel_id_t{node_idx, surfel_idx}, avg_dist);
-
-                for(uint32_t k = intermediate_outliers_for_thread.size() - 1; k > 0; --k)
-                {
-                    if(intermediate_outliers_for_thread[k].second > intermediate_outliers_for_thread[k - 1].second)
-                    {
-                        std::swap(intermediate_outliers_for_thread[k], intermediate_outliers_for_thread[k - 1]);
-                    }
-                    else
-                        break;
-                }
+                std::pop_heap(intermediate_outliers_for_thread.begin(), intermediate_outliers_for_thread.end(), greater_distance);
+                intermediate_outliers_for_thread.back() = std::make_pair(surfel_id_t(node_idx, surfel_idx), real(avg_dist));
+                std::push_heap(intermediate_outliers_for_thread.begin(), intermediate_outliers_for_thread.end(), greater_distance);
             }
         }
 
@@ -1407,6 +1233,595 @@ void bvh::thread_split_node_jobs(size_t &slice_left, size_t &slice_right, size_t
     }
 }
 
+/**
+ * Schedules the upsweep as a task graph on a fixed set of worker threads.
+ *
+ * The LOD of a node is created as soon as its children are finished. The
+ * attributes of a node are computed as soon as all nodes of its level which
+ * its neighbour queries can reach have their LOD. These are the nodes of the
+ * same level below the lowest ancestor whose bounding box contains every
+ * search sphere of the node. Finished nodes are flushed to the level files
+ * and evicted in LRU order when the memory limit is exceeded. Evicted nodes
+ * are loaded again if a later neighbour query needs them.
+ *
+ * Neighbour queries of a level have to see the bounding boxes from the
+ * downsweep, the new bounding boxes of a level are therefore kept aside and
+ * assigned to the nodes when the whole level is finished.
+ */
+class bvh::upsweep_scheduler
+{
+  public:
+    upsweep_scheduler(bvh &tree, const reduction_strategy &reduction_strgy, const normal_computation_strategy &normal_strategy, const radius_computation_strategy &radius_strategy,
+                      const bool recompute_leaf_level, const bool resample, const std::vector<shared_surfel_file> &level_files, const std::vector<shared_prov_file> &prov_level_files);
+
+    void run();
+
+  private:
+    struct task
+    {
+        bool compute_attributes;
+        node_id_type node_id;
+        node_id_type search_root;
+    };
+
+    void worker();
+
+    void create_lod(const node_id_type node_id);
+    void compute_attributes(const node_id_type node_id, const node_id_type search_root);
+    void finalize(const node_id_type node_id);
+
+    bool has_attributes(const uint32_t level) const { return level != tree_.depth_ || recompute_leaf_level_; }
+    uint32_t level_of(const node_id_type node_id) const { return tree_.nodes_[node_id].depth(); }
+    node_id_type find_search_root(const node_id_type node_id) const;
+    std::pair<node_id_type, node_id_type> nodes_below(const node_id_type node_id, const uint32_t level) const;
+    size_t node_memory(const node_id_type node_id) const;
+    void ensure_in_core(const node_id_type node_id);
+
+    // the following require mutex_ to be locked
+    void push(const task &t);
+    void make_resident(const node_id_type node_id);
+    void pin(const node_id_type first, const node_id_type last);
+    void unpin(const node_id_type first, const node_id_type last);
+    bool is_evictable(const node_id_type node_id) const;
+    void update_lru(const node_id_type node_id);
+    void enforce_memory_limit();
+
+    bvh &tree_;
+    const reduction_strategy &reduction_strgy_;
+    const normal_computation_strategy &normal_strategy_;
+    const radius_computation_strategy &radius_strategy_;
+    const bool recompute_leaf_level_;
+    const bool resample_;
+    const bool complete_child_level_;
+    const uint16_t number_of_neighbours_;
+    const std::vector<shared_surfel_file> &level_files_;
+    const std::vector<shared_prov_file> &prov_level_files_;
+
+    std::mutex mutex_;
+    std::condition_variable ready_condition_;
+    std::vector<task> ready_; ///< used as stack, so that subtrees are finished first
+    std::exception_ptr error_;
+
+    std::vector<uint8_t> lod_done_;
+    std::vector<uint8_t> finalized_;
+    std::vector<uint8_t> resident_;
+    std::vector<uint32_t> pins_;
+    std::vector<size_t> memory_;
+    std::vector<uint32_t> children_pending_;
+    std::vector<bounding_box> bounding_boxes_;
+
+    std::vector<size_t> lod_pending_;      ///< per level
+    std::vector<size_t> finalize_pending_; ///< per level
+    std::vector<real> radius_sd_sum_;      ///< per level
+    size_t num_finalized_ = 0;
+    uint16_t percentage_ = 0;
+
+    // per level and ancestor: number of nodes of the level below the
+    // ancestor without LOD, and the nodes waiting for it to become zero
+    std::vector<std::vector<size_t>> lod_pending_below_;
+    std::vector<std::unordered_map<node_id_type, std::vector<node_id_type>>> waiting_;
+
+    std::list<node_id_type> lru_;
+    std::vector<std::list<node_id_type>::iterator> lru_positions_;
+    std::vector<uint8_t> in_lru_;
+    size_t resident_memory_ = 0;
+
+    std::array<std::mutex, 64> load_mutexes_;
+};
+
+bvh::upsweep_scheduler::upsweep_scheduler(bvh &tree, const reduction_strategy &reduction_strgy, const normal_computation_strategy &normal_strategy,
+                                          const radius_computation_strategy &radius_strategy, const bool recompute_leaf_level, const bool resample,
+                                          const std::vector<shared_surfel_file> &level_files, const std::vector<shared_prov_file> &prov_level_files)
+    : tree_(tree), reduction_strgy_(reduction_strgy), normal_strategy_(normal_strategy), radius_strategy_(radius_strategy), recompute_leaf_level_(recompute_leaf_level), resample_(resample),
+      complete_child_level_(reduction_strgy.requires_complete_child_level()),
+      number_of_neighbours_(std::max(normal_strategy.number_of_neighbours(), radius_strategy.number_of_neighbours())), level_files_(level_files), prov_level_files_(prov_level_files)
+{
+    const size_t num_nodes = tree_.nodes_.size();
+    const uint32_t depth = tree_.depth_;
+
+    lod_done_.assign(num_nodes, false);
+    finalized_.assign(num_nodes, false);
+    resident_.assign(num_nodes, false);
+    pins_.assign(num_nodes, 0);
+    memory_.assign(num_nodes, 0);
+    children_pending_.assign(num_nodes, tree_.fan_factor_);
+    bounding_boxes_.resize(num_nodes);
+    lru_positions_.resize(num_nodes);
+    in_lru_.assign(num_nodes, false);
+
+    lod_pending_.resize(depth + 1);
+    finalize_pending_.resize(depth + 1);
+    radius_sd_sum_.assign(depth + 1, 0.0);
+    lod_pending_below_.resize(depth + 1);
+    waiting_.resize(depth + 1);
+
+    for(uint32_t level = 0; level <= depth; ++level)
+    {
+        lod_pending_[level] = tree_.get_length_of_depth(level);
+        finalize_pending_[level] = tree_.get_length_of_depth(level);
+
+        if(!has_attributes(level))
+        {
+            continue;
+        }
+
+        lod_pending_below_[level].resize(tree_.get_first_node_id_of_depth(level));
+        for(uint32_t ancestor_level = 0; ancestor_level < level; ++ancestor_level)
+        {
+            const size_t nodes_below = tree_.get_length_of_depth(level - ancestor_level);
+            const node_id_type first = tree_.get_first_node_id_of_depth(ancestor_level);
+            std::fill(lod_pending_below_[level].begin() + first, lod_pending_below_[level].begin() + first + tree_.get_length_of_depth(ancestor_level), nodes_below);
+        }
+    }
+
+    tree_.neighbour_indices_.clear();
+    tree_.neighbour_indices_.resize(num_nodes);
+
+    // leaves are ready, in reverse order to start with the first subtree
+    const node_id_type first_leaf = tree_.get_first_node_id_of_depth(depth);
+    for(node_id_type node_id = num_nodes; node_id > first_leaf; --node_id)
+    {
+        ready_.push_back(task{false, node_id - 1, 0});
+    }
+}
+
+void bvh::upsweep_scheduler::run()
+{
+    const uint32_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> threads;
+
+    for(uint32_t thread_idx = 0; thread_idx < num_threads; ++thread_idx)
+    {
+        threads.push_back(std::thread(&upsweep_scheduler::worker, this));
+    }
+
+    for(auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    std::cout << std::endl;
+
+    if(error_)
+    {
+        std::rethrow_exception(error_);
+    }
+}
+
+void bvh::upsweep_scheduler::worker()
+{
+    for(;;)
+    {
+        task current_task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            ready_condition_.wait(lock, [&] { return !ready_.empty() || error_ || num_finalized_ == tree_.nodes_.size(); });
+
+            if(error_ || ready_.empty())
+            {
+                return;
+            }
+            current_task = ready_.back();
+            ready_.pop_back();
+        }
+
+        try
+        {
+            if(current_task.compute_attributes)
+            {
+                compute_attributes(current_task.node_id, current_task.search_root);
+            }
+            else
+            {
+                create_lod(current_task.node_id);
+            }
+        }
+        catch(...)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if(!error_)
+            {
+                error_ = std::current_exception();
+            }
+            ready_condition_.notify_all();
+            return;
+        }
+    }
+}
+
+void bvh::upsweep_scheduler::create_lod(const node_id_type node_id)
+{
+    bvh_node &node = tree_.nodes_[node_id];
+    const uint32_t level = level_of(node_id);
+
+    if(level == tree_.depth_ || node.is_in_core() || node.is_out_of_core())
+    {
+        // leaves and nodes with existing data are loaded
+        if(!node.is_in_core())
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                make_resident(node_id);
+            }
+            node.load_from_disk();
+        }
+    }
+    else
+    {
+        tree_.create_lod(node_id, reduction_strgy_, resample_);
+    }
+
+    // neighbour queries of the attribute computation run against the final surfels of the level
+    tree_.neighbour_indices_[node_id].build(node.mem_array());
+
+    node_id_type search_root = node_id;
+    if(has_attributes(level))
+    {
+        search_root = find_search_root(node_id);
+    }
+
+    bool attributes_ready = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        make_resident(node_id);
+        lod_done_[node_id] = true;
+        --lod_pending_[level];
+
+        if(level < tree_.depth_)
+        {
+            // the children are not needed for this node anymore
+            for(uint8_t child_index = 0; child_index < tree_.fan_factor_; ++child_index)
+            {
+                update_lru(tree_.get_child_id(node_id, child_index));
+            }
+
+            if(complete_child_level_ && lod_pending_[level] == 0)
+            {
+                const node_id_type first_child = tree_.get_first_node_id_of_depth(level + 1);
+                for(node_id_type child_id = first_child; child_id < first_child + tree_.get_length_of_depth(level + 1); ++child_id)
+                {
+                    update_lru(child_id);
+                }
+            }
+        }
+
+        if(has_attributes(level))
+        {
+            node_id_type ancestor = node_id;
+            while(ancestor != 0)
+            {
+                ancestor = tree_.get_parent_id(ancestor);
+                if(--lod_pending_below_[level][ancestor] == 0)
+                {
+                    auto waiting = waiting_[level].find(ancestor);
+                    if(waiting != waiting_[level].end())
+                    {
+                        for(const node_id_type waiting_node : waiting->second)
+                        {
+                            push(task{true, waiting_node, ancestor});
+                        }
+                        waiting_[level].erase(waiting);
+                    }
+                }
+            }
+
+            attributes_ready = search_root == node_id || lod_pending_below_[level][search_root] == 0;
+            if(!attributes_ready)
+            {
+                waiting_[level][search_root].push_back(node_id);
+            }
+        }
+
+        enforce_memory_limit();
+    }
+
+    if(!has_attributes(level))
+    {
+        finalize(node_id);
+    }
+    else if(attributes_ready)
+    {
+        compute_attributes(node_id, search_root);
+    }
+}
+
+void bvh::upsweep_scheduler::compute_attributes(const node_id_type node_id, const node_id_type search_root)
+{
+    const auto range = nodes_below(search_root, level_of(node_id));
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pin(range.first, range.second);
+    }
+
+    for(node_id_type neighbour_id = range.first; neighbour_id <= range.second; ++neighbour_id)
+    {
+        ensure_in_core(neighbour_id);
+    }
+
+    tree_.compute_normal_and_radius(&tree_.nodes_[node_id], normal_strategy_, radius_strategy_);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        unpin(range.first, range.second);
+        enforce_memory_limit();
+    }
+
+    finalize(node_id);
+}
+
+void bvh::upsweep_scheduler::finalize(const node_id_type node_id)
+{
+    bvh_node &node = tree_.nodes_[node_id];
+    const uint32_t level = level_of(node_id);
+
+    basic_algorithms::surfel_group_properties props = basic_algorithms::compute_properties(node.mem_array(), tree_.rep_radius_algo_);
+
+    node.set_max_surfel_radius_deviation(props.max_radius_deviation);
+
+    bounding_box node_bounding_box;
+    node_bounding_box.expand(props.bbox);
+
+    if(level < tree_.depth_)
+    {
+        for(uint8_t child_index = 0; child_index < tree_.fan_factor_; ++child_index)
+        {
+            node_bounding_box.expand(bounding_boxes_[tree_.get_child_id(node_id, child_index)]);
+        }
+    }
+
+    node.set_avg_surfel_radius(props.rep_radius);
+    node.set_centroid(props.centroid);
+    node.calculate_statistics();
+    bounding_boxes_[node_id] = node_bounding_box;
+
+    if(node_id == 0)
+    {
+        std::cout << std::endl;
+        std::cout << "min: " << node_bounding_box.min() << std::endl;
+        std::cout << "max: " << node_bounding_box.max() << std::endl;
+    }
+
+    // save computed node to disk. the downsweep stores the leaves densely
+    // packed in the leaf level file, so the slot of a leaf overlaps leaves
+    // that might not be loaded yet. leaves are written back in place instead
+    size_t offset_in_file = (node_id - tree_.get_first_node_id_of_depth(level)) * tree_.max_surfels_per_node_;
+    if(level == tree_.depth_ && !node.disk_array().is_empty())
+    {
+        offset_in_file = node.disk_array().offset();
+    }
+
+    if(node.has_provenance())
+    {
+        node.flush_to_disk(level_files_[level], prov_level_files_[level], offset_in_file, false);
+    }
+    else
+    {
+        node.flush_to_disk(level_files_[level], offset_in_file, false);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    finalized_[node_id] = true;
+    radius_sd_sum_[level] += node.node_stats().radius_sd();
+    update_lru(node_id);
+
+    ++num_finalized_;
+    uint16_t new_percentage = uint16_t(num_finalized_ * 100 / tree_.nodes_.size());
+    if(percentage_ < new_percentage)
+    {
+        percentage_ = new_percentage;
+        std::cout << "\r" << percentage_ << "% processed" << std::flush;
+    }
+
+    if(--finalize_pending_[level] == 0)
+    {
+        // no neighbour query of the level is left, the new bounding boxes can be set
+        const node_id_type first_node_of_level = tree_.get_first_node_id_of_depth(level);
+        const node_id_type last_node_of_level = first_node_of_level + tree_.get_length_of_depth(level);
+        for(node_id_type level_node_id = first_node_of_level; level_node_id < last_node_of_level; ++level_node_id)
+        {
+            tree_.nodes_[level_node_id].set_bounding_box(bounding_boxes_[level_node_id]);
+        }
+
+        LOGGER_TRACE("Finished level: " << level);
+        std::cout << std::endl << "average radius deviation pro level: " << radius_sd_sum_[level] / (tree_.get_length_of_depth(level) + 1) << "\n";
+
+        if(level > 0 && complete_child_level_)
+        {
+            const node_id_type first_parent = tree_.get_first_node_id_of_depth(level - 1);
+            for(node_id_type parent_id = first_parent; parent_id < first_node_of_level; ++parent_id)
+            {
+                push(task{false, parent_id, 0});
+            }
+        }
+    }
+
+    if(node_id != 0 && !complete_child_level_)
+    {
+        const node_id_type parent_id = tree_.get_parent_id(node_id);
+        if(--children_pending_[parent_id] == 0)
+        {
+            push(task{false, parent_id, 0});
+        }
+    }
+
+    if(num_finalized_ == tree_.nodes_.size())
+    {
+        ready_condition_.notify_all();
+    }
+}
+
+node_id_type bvh::upsweep_scheduler::find_search_root(const node_id_type node_id) const
+{
+    const surfel_mem_array &mem_array = tree_.nodes_[node_id].mem_array();
+
+    // without enough surfels in the node, the search starts with an infinite sphere
+    if(mem_array.length() <= number_of_neighbours_)
+    {
+        return 0;
+    }
+
+    bounding_box surfels_bounding_box;
+    for(size_t i = 0; i < mem_array.length(); ++i)
+    {
+        const vec3r &pos = mem_array.read_surfel_ref(i).pos();
+        if(i == 0)
+        {
+            surfels_bounding_box = bounding_box(pos, pos);
+        }
+        surfels_bounding_box.expand(pos);
+    }
+
+    // the initial sphere of each search is centered at a surfel and has the
+    // distance to one of the node's surfels as radius
+    const real radius = scm::math::length(surfels_bounding_box.max() - surfels_bounding_box.min());
+    const bounding_box search_bounding_box(surfels_bounding_box.min() - vec3r(radius), surfels_bounding_box.max() + vec3r(radius));
+
+    node_id_type search_root = node_id;
+    while(search_root != 0 && !tree_.nodes_[search_root].get_bounding_box().contains(search_bounding_box))
+    {
+        search_root = tree_.get_parent_id(search_root);
+    }
+    return search_root;
+}
+
+std::pair<node_id_type, node_id_type> bvh::upsweep_scheduler::nodes_below(const node_id_type node_id, const uint32_t level) const
+{
+    node_id_type first = node_id, last = node_id;
+    for(uint32_t d = level_of(node_id); d < level; ++d)
+    {
+        first = first * tree_.fan_factor_ + 1;
+        last = last * tree_.fan_factor_ + tree_.fan_factor_;
+    }
+    return std::make_pair(first, last);
+}
+
+size_t bvh::upsweep_scheduler::node_memory(const node_id_type node_id) const
+{
+    const bvh_node &node = tree_.nodes_[node_id];
+    const size_t length = node.is_in_core() ? node.mem_array().length() : node.disk_array().length();
+
+    // surfels and positions of the neighbour index
+    size_t memory = length * (sizeof(surfel) + sizeof(vec3r));
+    if(node.has_provenance())
+    {
+        memory += length * sizeof(prov_data);
+    }
+    return memory;
+}
+
+void bvh::upsweep_scheduler::ensure_in_core(const node_id_type node_id)
+{
+    std::lock_guard<std::mutex> lock(load_mutexes_[node_id % load_mutexes_.size()]);
+
+    bvh_node &node = tree_.nodes_[node_id];
+    if(!node.is_in_core())
+    {
+        node.load_from_disk();
+        tree_.neighbour_indices_[node_id].build(node.mem_array());
+    }
+}
+
+void bvh::upsweep_scheduler::push(const task &t)
+{
+    ready_.push_back(t);
+    ready_condition_.notify_one();
+}
+
+void bvh::upsweep_scheduler::make_resident(const node_id_type node_id)
+{
+    if(!resident_[node_id])
+    {
+        resident_[node_id] = true;
+        memory_[node_id] = node_memory(node_id);
+        resident_memory_ += memory_[node_id];
+    }
+}
+
+void bvh::upsweep_scheduler::pin(const node_id_type first, const node_id_type last)
+{
+    for(node_id_type node_id = first; node_id <= last; ++node_id)
+    {
+        if(pins_[node_id]++ == 0 && in_lru_[node_id])
+        {
+            lru_.erase(lru_positions_[node_id]);
+            in_lru_[node_id] = false;
+        }
+        make_resident(node_id);
+    }
+}
+
+void bvh::upsweep_scheduler::unpin(const node_id_type first, const node_id_type last)
+{
+    for(node_id_type node_id = first; node_id <= last; ++node_id)
+    {
+        --pins_[node_id];
+        update_lru(node_id);
+    }
+}
+
+bool bvh::upsweep_scheduler::is_evictable(const node_id_type node_id) const
+{
+    if(!finalized_[node_id] || !resident_[node_id] || pins_[node_id] > 0)
+    {
+        return false;
+    }
+    if(node_id == 0)
+    {
+        return true;
+    }
+
+    // the parent's LOD reads the node, or the whole level
+    const uint32_t level = level_of(node_id);
+    return lod_done_[tree_.get_parent_id(node_id)] && (!complete_child_level_ || lod_pending_[level - 1] == 0);
+}
+
+void bvh::upsweep_scheduler::update_lru(const node_id_type node_id)
+{
+    if(!in_lru_[node_id] && is_evictable(node_id))
+    {
+        lru_positions_[node_id] = lru_.insert(lru_.end(), node_id);
+        in_lru_[node_id] = true;
+    }
+}
+
+void bvh::upsweep_scheduler::enforce_memory_limit()
+{
+    while(resident_memory_ > tree_.memory_limit_ && !lru_.empty())
+    {
+        const node_id_type node_id = lru_.front();
+        lru_.pop_front();
+        in_lru_[node_id] = false;
+
+        // the node is flushed to its level file and can be loaded from there
+        tree_.nodes_[node_id].mem_array().reset();
+        tree_.neighbour_indices_[node_id].clear();
+        resident_[node_id] = false;
+        resident_memory_ -= memory_[node_id];
+    }
+}
+
 void bvh::upsweep(const reduction_strategy &reduction_strgy, const normal_computation_strategy &normal_strategy, const radius_computation_strategy &radius_strategy, bool recompute_leaf_level,
                   bool resample)
 {
@@ -1443,69 +1858,10 @@ void bvh::upsweep(const reduction_strategy &reduction_strgy, const normal_comput
     }
 
 
-    // Start at bottom level and move up towards root.
-    for(int32_t level = depth_; level >= 0; --level)
-    {
-        LOGGER_TRACE("Entering level: " << level);
-
-        uint32_t first_node_of_level = get_first_node_id_of_depth(level);
-        uint32_t last_node_of_level = get_first_node_id_of_depth(level) + get_length_of_depth(level);
-
-
-        // Loading is not thread-safe, so load everything before starting parallel operations.
-        for(uint32_t node_index = first_node_of_level; node_index < last_node_of_level; ++node_index)
-        {
-            bvh_node *current_node = &nodes_.at(node_index);
-            // if necessary, load leaf-level nodes from disk
-            if(level == int32_t(depth_) && current_node->is_out_of_core())
-            {
-                current_node->load_from_disk();   
-            }
-        }
-
-        // Iterate over nodes of current tree level.
-        // First apply reduction strategy, since calculation of attributes might depend on surfel data of nodes in same level.
-        if(level != int32_t(depth_))
-        {
-            spawn_create_lod_jobs(first_node_of_level, last_node_of_level, reduction_strgy, resample);
-        }
-
-        // skip the leaf level attribute computation if it was not requested or necessary
-        if((level != int32_t(depth_) || recompute_leaf_level))
-        {
-            spawn_compute_attribute_jobs(first_node_of_level, last_node_of_level, normal_strategy, radius_strategy, false);
-        }
-
-        spawn_compute_bounding_boxes_upsweep_jobs(first_node_of_level, last_node_of_level, level);
-
-        std::cout << std::endl;
-
-        real mean_radius_sd = 0.0;
-        unsigned counter = 1;
-        for(uint32_t node_index = first_node_of_level; node_index < last_node_of_level; ++node_index)
-        {
-            bvh_node *current_node = &nodes_.at(node_index);
-
-            mean_radius_sd = mean_radius_sd + (*current_node).node_stats().radius_sd();
-            counter++;
+    upsweep_scheduler scheduler(*this, reduction_strgy, normal_strategy, radius_strategy, recompute_leaf_level, resample, level_temp_files, prov_temp_files);
+    scheduler.run();
 
-            // compute node offset in file
-            int32_t nid = current_node->node_id();
-            for(uint32_t write_level = 0; write_level < uint32_t(level); ++write_level)
-                nid -= uint32_t(pow(fan_factor_, write_level));
-            nid = std::max(0, nid);
-
-            // save computed node to disk
-            if (current_node->has_provenance()) {
-                current_node->flush_to_disk(level_temp_files[level], prov_temp_files[level], size_t(nid) * max_surfels_per_node_, false);
-            }
-            else {
-                current_node->flush_to_disk(level_temp_files[level], size_t(nid) * max_surfels_per_node_, false);
-            }
-        }
-        mean_radius_sd = mean_radius_sd / counter;
-        std::cout << "average radius deviation pro level: " << mean_radius_sd << "\n";
-    }
+    neighbour_indices_.clear();
 
     // TODO: Inject a call to provenance method, collecting level data into one file
     /*
@@ -1610,13 +1966,31 @@ void bvh::resample()
     state_ = state_type::after_upsweep;
 }
 
-surfel_vector bvh::remove_outliers_statistically(uint32_t num_outliers, uint16_t num_neighbours)
+size_t bvh::remove_outliers_statistically(uint32_t num_outliers, uint16_t num_neighbours)
 {
+    assert(state_type::after_downsweep == state_);
+
+    const size_t num_leaves = nodes_.size() - first_leaf_;
+
+    size_t num_leaf_surfels = 0;
+    for(uint32_t node_idx = first_leaf_; node_idx < nodes_.size(); ++node_idx)
+    {
+        bvh_node const &current_node = nodes_[node_idx];
+        num_leaf_surfels += current_node.is_in_core() ? current_node.mem_array().length() : current_node.disk_array().length();
+    }
+
+    // every leaf has to keep at least one surfel, otherwise the leaves cannot be rebalanced
+    num_outliers = std::min(size_t(num_outliers), num_leaf_surfels > num_leaves ? num_leaf_surfels - num_leaves : size_t(0));
+
+    if(0 == num_outliers)
+    {
+        return 0;
+    }
+
     std::vector<std::vector<std::pair<surfel_id_t, real>>> intermediate_outliers;
 
     uint32_t const num_threads = std::thread::hardware_concurrency();
     intermediate_outliers.resize(num_threads);
-    // already_resized.resize(omp_get_max_threads())
 
     for(uint32_t node_idx = first_leaf_; node_idx < nodes_.size(); ++node_idx)
     {
@@ -1628,6 +2002,8 @@ surfel_vector bvh::remove_outliers_statistically(uint32_t num_outliers, uint16_t
         }
     }
 
+    spawn_build_neighbour_index_jobs(first_leaf_, nodes_.size());
+
     working_queue_head_counter_.initialize(first_leaf_);
     std::vector<std::thread> threads;
 
@@ -1644,71 +2020,232 @@ surfel_vector bvh::remove_outliers_statistically(uint32_t num_outliers, uint16_t
         thread.join();
     }
 
+    // the global outliers are among the candidates of the threads
     std::vector<std::pair<surfel_id_t, real>> final_outliers;
 
     for(auto const& ve : intermediate_outliers)
     {
-        for(auto const& element : ve)
+        final_outliers.insert(final_outliers.end(), ve.begin(), ve.end());
+    }
+
+    intermediate_outliers.clear();
+    neighbour_indices_.clear();
+
+    if(final_outliers.size() > num_outliers)
+    {
+        std::nth_element(final_outliers.begin(), final_outliers.begin() + num_outliers, final_outliers.end(),
+                         [](std::pair<surfel_id_t, real> const &lhs, std::pair<surfel_id_t, real> const &rhs) { return lhs.second > rhs.second; });
+        final_outliers.resize(num_outliers);
+    }
+
+    std::sort(final_outliers.begin(), final_outliers.end(),
+              [](std::pair<surfel_id_t, real> const &lhs, std::pair<surfel_id_t, real> const &rhs) { return lhs.first < rhs.first; });
+
+    // the leaves are written back to the file they were flushed to by the downsweep
+    shared_surfel_file leaf_level_access = nodes_[first_leaf_].disk_array().get_file();
+    shared_prov_file prov_leaf_level_access = nodes_[first_leaf_].disk_array().get_prov_file();
+    const bool provenance = nodes_[first_leaf_].has_provenance();
+
+    // remove the outliers from their leaves in place
+    std::vector<char> modified_leaves(num_leaves, false);
+    std::vector<node_id_type> subtree_roots;
+
+    for(auto outlier_it = final_outliers.begin(); outlier_it != final_outliers.end();)
+    {
+        const node_id_type node_idx = outlier_it->first.node_idx;
+        surfel_mem_array &mem_array = nodes_[node_idx].mem_array();
+
+        size_t num_kept_surfels = 0;
+        for(size_t surfel_idx = 0; surfel_idx < mem_array.length(); ++surfel_idx)
         {
-            bool insert_element = false;
-            if(final_outliers.size() < num_outliers)
+            if(outlier_it != final_outliers.end() && outlier_it->first == surfel_id_t(node_idx, surfel_idx))
             {
-                insert_element = true;
+                ++outlier_it;
+                continue;
             }
-            else if(element.second > final_outliers.back().second)
+
+            if(num_kept_surfels != surfel_idx)
             {
-                final_outliers.pop_back();
-                insert_element = true;
+                mem_array.write_surfel(mem_array.read_surfel_ref(surfel_idx), num_kept_surfels);
+                if(mem_array.has_provenance())
+                {
+                    mem_array.write_prov(mem_array.read_prov_ref(surfel_idx), num_kept_surfels);
+                }
             }
+            ++num_kept_surfels;
+        }
+
+        mem_array.set_length(num_kept_surfels);
+        modified_leaves[node_idx - first_leaf_] = true;
+        subtree_roots.push_back(get_parent_id(node_idx));
+    }
+
+    // a sibling group is rebalanced below its parent. if the parent is left
+    // with less surfels than leaves, the closest ancestor with enough surfels is used
+    std::sort(subtree_roots.begin(), subtree_roots.end());
+    subtree_roots.erase(std::unique(subtree_roots.begin(), subtree_roots.end()), subtree_roots.end());
+
+    for(auto &root_id : subtree_roots)
+    {
+        while(root_id > 0)
+        {
+            std::vector<node_id_type> leaf_ids;
+            get_descendant_leaves(root_id, leaf_ids, first_leaf_, std::unordered_set<size_t>());
 
-            if(insert_element)
+            size_t num_subtree_surfels = 0;
+            for(auto const leaf_id : leaf_ids)
             {
-                final_outliers.push_back(element);
+                num_subtree_surfels += nodes_[leaf_id].mem_array().length();
+            }
 
-                for(uint32_t k = final_outliers.size() - 1; k > 0; --k)
-                {
-                    if(final_outliers[k].second > final_outliers[k - 1].second)
-                    {
-                        std::swap(final_outliers[k], final_outliers[k - 1]);
-                    }
-                    else
-                        break;
-                }
+            if(num_subtree_surfels >= leaf_ids.size())
+            {
+                break;
             }
+            root_id = get_parent_id(root_id);
         }
     }
 
-    intermediate_outliers.clear();
+    std::sort(subtree_roots.begin(), subtree_roots.end());
+    subtree_roots.erase(std::unique(subtree_roots.begin(), subtree_roots.end()), subtree_roots.end());
+
+    std::set<node_id_type> const root_set(subtree_roots.begin(), subtree_roots.end());
+    subtree_roots.erase(std::remove_if(subtree_roots.begin(), subtree_roots.end(),
+                                       [&](const node_id_type root_id)
+                                       {
+                                           for(node_id_type ancestor_id = root_id; ancestor_id > 0;)
+                                           {
+                                               ancestor_id = get_parent_id(ancestor_id);
+                                               if(root_set.count(ancestor_id))
+                                               {
+                                                   return true;
+                                               }
+                                           }
+                                           return false;
+                                       }),
+                        subtree_roots.end());
+
+    LOGGER_TRACE("Rebalance " << subtree_roots.size() << " subtrees");
 
-    std::set<surfel_id_t> outlier_ids;
-    for(auto const &el : final_outliers)
+    // the subtrees are disjoint and can be rebalanced independently
+    std::atomic<size_t> next_subtree(0);
+    threads.clear();
+
+    for(uint32_t thread_idx = 0; thread_idx < std::min(size_t(num_threads), subtree_roots.size()); ++thread_idx)
     {
-        outlier_ids.insert(el.first);
+        threads.push_back(std::thread([&]()
+                                      {
+                                          for(size_t subtree_idx = next_subtree++; subtree_idx < subtree_roots.size(); subtree_idx = next_subtree++)
+                                          {
+                                              rebalance_subtree_in_core(subtree_roots[subtree_idx], modified_leaves);
+                                          }
+                                      }));
     }
 
-    surfel_vector cleaned_surfels;
+    for(auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    // leaves keep their order in the leaf level file and only move towards its
+    // beginning. leaves in front of the first modified one stay where they are
+    size_t disk_leaf_destination = 0;
 
     for(uint32_t node_idx = first_leaf_; node_idx < nodes_.size(); ++node_idx)
     {
-        bvh_node *current_node = &nodes_.at(node_idx);
+        bvh_node &current_node = nodes_[node_idx];
 
-        if(current_node->is_out_of_core())
+        if(!modified_leaves[node_idx - first_leaf_] && current_node.disk_array().offset() == disk_leaf_destination)
         {
-            current_node->load_from_disk();
+            current_node.mem_array().reset();
         }
+        else if(provenance)
+        {
+            current_node.flush_to_disk(leaf_level_access, prov_leaf_level_access, disk_leaf_destination, true);
+        }
+        else
+        {
+            current_node.flush_to_disk(leaf_level_access, disk_leaf_destination, true);
+        }
+        disk_leaf_destination += current_node.disk_array().length();
+    }
 
-        for(uint32_t surfel_idx = 0; surfel_idx < current_node->mem_array().length(); ++surfel_idx)
+    LOGGER_INFO("Removed " << final_outliers.size() << " outliers, " << disk_leaf_destination << " surfels left in the leaf level");
+
+    return final_outliers.size();
+}
+
+void bvh::rebalance_subtree_in_core(const node_id_type root_id, std::vector<char> &modified_leaves)
+{
+    std::vector<node_id_type> leaf_ids;
+    get_descendant_leaves(root_id, leaf_ids, first_leaf_, std::unordered_set<size_t>());
+
+    // gather the surfels left in the leaves of the subtree
+    const bool provenance = nodes_[leaf_ids.front()].mem_array().has_provenance();
+    auto surfels = std::make_shared<surfel_vector>();
+    auto provs = std::make_shared<std::vector<prov_data>>();
+
+    for(auto const leaf_id : leaf_ids)
+    {
+        surfel_mem_array const &leaf_array = nodes_[leaf_id].mem_array();
+
+        surfels->insert(surfels->end(), leaf_array.surfel_mem_data()->begin() + leaf_array.offset(),
+                        leaf_array.surfel_mem_data()->begin() + leaf_array.offset() + leaf_array.length());
+        if(provenance)
         {
-            if(outlier_ids.end() == outlier_ids.find(surfel_id_t(node_idx, surfel_idx)))
-            {
-                auto current_untranslated_surfel = current_node->mem_array().read_surfel(surfel_idx);
-                current_untranslated_surfel.pos() = current_untranslated_surfel.pos() + translation_;
-                cleaned_surfels.emplace_back(current_untranslated_surfel);
-            }
+            provs->insert(provs->end(), leaf_array.prov_mem_data()->begin() + leaf_array.offset(),
+                          leaf_array.prov_mem_data()->begin() + leaf_array.offset() + leaf_array.length());
+        }
+    }
+
+    // split the subtree level by level like the in-core downsweep
+    basic_algorithms::splitted_array<surfel_mem_array> level_arrays;
+    if(provenance)
+    {
+        level_arrays.push_back(std::make_pair(surfel_mem_array(surfels, provs, 0, surfels->size()), nodes_[root_id].get_bounding_box()));
+    }
+    else
+    {
+        level_arrays.push_back(std::make_pair(surfel_mem_array(surfels, 0, surfels->size()), nodes_[root_id].get_bounding_box()));
+    }
+
+    node_id_type first_node_of_level = root_id;
+
+    for(uint32_t level = get_depth_of_node(root_id); level < depth_; ++level)
+    {
+        basic_algorithms::splitted_array<surfel_mem_array> next_level_arrays;
+
+        for(auto &level_array : level_arrays)
+        {
+            basic_algorithms::splitted_array<surfel_mem_array> surfel_arrays;
+            basic_algorithms::sort_and_split(level_array.first, surfel_arrays, level_array.second, level_array.second.get_longest_axis(), fan_factor_, false);
+            next_level_arrays.insert(next_level_arrays.end(), surfel_arrays.begin(), surfel_arrays.end());
         }
+
+        first_node_of_level = get_child_id(first_node_of_level, 0);
+        for(size_t i = 0; i < next_level_arrays.size() && level + 1 < depth_; ++i)
+        {
+            nodes_[first_node_of_level + i].set_bounding_box(next_level_arrays[i].second);
+        }
+
+        level_arrays.swap(next_level_arrays);
     }
 
-    return cleaned_surfels;
+    for(size_t i = 0; i < level_arrays.size(); ++i)
+    {
+        const node_id_type leaf_id = first_node_of_level + i;
+
+        bvh_node &current_node = nodes_[leaf_id];
+        current_node = bvh_node(leaf_id, depth_, level_arrays[i].second, level_arrays[i].first);
+
+        auto props = basic_algorithms::compute_properties(current_node.mem_array(), rep_radius_algo_, false);
+        current_node.set_avg_surfel_radius(props.rep_radius);
+        current_node.set_centroid(props.centroid);
+        current_node.set_bounding_box(props.bbox);
+        current_node.set_max_surfel_radius_deviation(props.max_radius_deviation);
+
+        modified_leaves[leaf_id - first_leaf_] = true;
+    }
 }
 
 void bvh::serialize_tree_to_file(const std::string &output_file, bool write_intermediate_data)
@@ -1741,6 +2278,7 @@ void bvh::serialize_surfels_to_file(const std::string &lod_output_file, const st
 
 void bvh::reset_nodes()
 {
+    neighbour_indices_.clear();
     for(auto &n : nodes_)
     {
         if(n.is_out_of_core() && n.disk_array().get_file().use_count() == 1)
@@ -143,14 +143,17 @@ read_bvh(const std::string &filename, bvh &bvh)
 
     num_segments_ = 0;
 
+    bvh_file_seg file_seg;
     bvh_tree_seg tree;
     bvh_tree_extension_seg tree_ext;
+    bvh_node_array_seg node_arrays;
     std::vector<bvh_node_seg> nodes;
     std::vector<bvh_node_extension_seg> nodes_ext;
     uint32_t tree_id = 0;
     uint32_t tree_ext_id = 0;
     uint32_t node_id = 0;
     uint32_t node_ext_id = 0;
+    uint32_t node_arrays_id = 0;
 
 
     //go through entire stream and fetch the segments
@@ -170,8 +173,7 @@ read_bvh(const std::string &filename, bvh &bvh)
         switch (sig.signature_[4]) {
 
             case 'F': { //"BVHXFILE"
-                bvh_file_seg seg;
-                seg.deserialize(file_);
+                file_seg.deserialize(file_);
                 break;
             }
             case 'T': {
@@ -218,6 +220,11 @@ read_bvh(const std::string &filename, bvh &bvh)
                         ++node_ext_id;
                         break;
                     }
+                    case 'A': { //"BVHXNARR"
+                        node_arrays.deserialize(file_);
+                        ++node_arrays_id;
+                        break;
+                    }
                     default: {
                         throw std::runtime_error(
                             "PLOD: bvh_stream::Stream corrupt -- Invalid segment encountered");
@@ -254,8 +261,47 @@ read_bvh(const std::string &filename, bvh &bvh)
             "PLOD: bvh_stream::Stream corrupt -- Invalid number of bvh extensions");
     }
 
+    if (node_arrays_id > 1 || (node_arrays_id == 1 && file_seg.major_version_ < 2)) {
+        throw std::runtime_error(
+            "PLOD: bvh_stream::Stream corrupt -- Invalid number of node array segments");
+    }
+
     //Note: This is the preprocessing library version of the file reader!
 
+    if (node_arrays_id == 1) {
+        //version 2 files are only written for serialized trees
+        if (node_id != 0 || tree_ext_id != 0 || tree.num_nodes_ != node_arrays.num_nodes_) {
+            throw std::runtime_error(
+                "PLOD: bvh_stream::Stream corrupt -- Invalid number of nodes in node arrays");
+        }
+
+        //the depth is implied by the node id, the reduction error is not stored
+        uint32_t depth = 0;
+        uint64_t nodes_in_depth = 1;
+        uint64_t first_node_below = 1;
+
+        nodes.resize(tree.num_nodes_);
+        for (uint32_t i = 0; i < tree.num_nodes_; ++i) {
+            while (i >= first_node_below) {
+                ++depth;
+                nodes_in_depth *= tree.fan_factor_;
+                first_node_below += nodes_in_depth;
+            }
+
+            bvh_node_seg& node = nodes[i];
+            node.segment_id_ = node_arrays.segment_id_;
+            node.node_id_ = i;
+            node.centroid_ = node_arrays.centroids_[i];
+            node.depth_ = depth;
+            node.reduction_error_ = 0.f;
+            node.avg_surfel_radius_ = node_arrays.avg_surfel_radii_[i];
+            node.visibility_ = (bvh_node_visibility)node_arrays.visibilities_[i];
+            node.max_surfel_radius_deviation_ = node_arrays.max_surfel_radius_deviations_[i];
+            node.bounding_box_ = node_arrays.bounding_boxes_[i];
+        }
+        node_id = tree.num_nodes_;
+    }
+
     //setup bvh
     bvh.set_depth(tree.depth_);
     bvh.set_fan_factor(tree.fan_factor_);
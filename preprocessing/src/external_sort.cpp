@@ -13,6 +13,8 @@
 #include <parallel/algorithm>
 #endif
 
+#include <future>
+#include <memory>
 #include <numeric>
 
 namespace lamure
@@ -26,11 +28,270 @@ const size_t MIN_MERGE_BUFFER_SIZE = 3;
 
 const std::string TEMP_FILE_EXT = ".runs";
 
+namespace
+{
+
+using record = surfel_file::record_type;
+using record_vector = std::vector<record>;
+
+inline const surfel &to_surfel(const surfel &s)
+{
+    return s;
+}
+
+inline surfel to_surfel(const serialized_surfel &s)
+{
+    return s.get_surfel();
+}
+
+class compare_function_less
+{
+public:
+    explicit compare_function_less(const surfel::compare_function &compare)
+        : compare_(compare) {}
+
+    bool operator()(const record &left, const record &right) const
+    {
+        return compare_(to_surfel(left), to_surfel(right));
+    }
+
+private:
+    const surfel::compare_function &compare_;
+};
+
+template <uint8_t axis>
+class axis_less
+{
+public:
+    bool operator()(const record &left, const record &right) const
+    {
+        return key(left.pos()) < key(right.pos());
+    }
+
+private:
+    static real key(const vec3r &pos)
+    {
+        return axis == 0 ? pos.x : (axis == 1 ? pos.y : pos.z);
+    }
+};
+
+/**
+ * Streams a sorted run from disk. While the front buffer is consumed
+ * by the merge, the next part of the run is read into the back buffer.
+ */
+class run_reader
+{
+public:
+    run_reader(const surfel_disk_array &run, const size_t buffer_size)
+        : run_(run),
+          buffer_size_(buffer_size),
+          file_offset_(0),
+          pos_(0)
+    {
+        front_.reserve(buffer_size_);
+        back_.reserve(buffer_size_);
+        prefetch();
+        swap_buffers();
+    }
+
+    run_reader(const run_reader &) = delete;
+    run_reader &operator=(const run_reader &) = delete;
+
+    // nullptr if the run is exhausted
+    const record *current() const
+    {
+        return pos_ < front_.size() ? &front_[pos_] : nullptr;
+    }
+
+    void advance()
+    {
+        if (++pos_ >= front_.size())
+            swap_buffers();
+    }
+
+private:
+    void prefetch()
+    {
+        if (file_offset_ >= run_.length())
+            return;
+
+        const size_t count = std::min(buffer_size_, run_.length() - file_offset_);
+        const size_t offset = run_.offset() + file_offset_;
+        file_offset_ += count;
+
+        back_.resize(count);
+        pending_ = std::async(std::launch::async, [this, offset, count]
+        {
+            run_.get_file()->read_records(&back_, 0, offset, count);
+        });
+    }
+
+    void swap_buffers()
+    {
+        pos_ = 0;
+        if (!pending_.valid()) {
+            front_.clear();
+            return;
+        }
+        pending_.get();
+        std::swap(front_, back_);
+        prefetch();
+    }
+
+    surfel_disk_array run_;
+    const size_t buffer_size_;
+    size_t file_offset_;
+
+    record_vector front_;
+    record_vector back_;
+    size_t pos_;
+
+    std::future<void> pending_;
+};
+
+/**
+ * Collects the merged records and writes full buffers to the output
+ * array in the background.
+ */
+class output_writer
+{
+public:
+    output_writer(surfel_disk_array &array, const size_t buffer_size)
+        : array_(array),
+          buffer_size_(buffer_size),
+          file_offset_(0)
+    {
+        front_.reserve(buffer_size_);
+        back_.reserve(buffer_size_);
+    }
+
+    output_writer(const output_writer &) = delete;
+    output_writer &operator=(const output_writer &) = delete;
+
+    void push(const record &r)
+    {
+        front_.push_back(r);
+        if (front_.size() >= buffer_size_)
+            flush();
+    }
+
+    // returns the number of records written
+    size_t finish()
+    {
+        flush();
+        if (pending_.valid())
+            pending_.get();
+        return file_offset_;
+    }
+
+private:
+    void flush()
+    {
+        if (pending_.valid())
+            pending_.get();
+        if (front_.empty())
+            return;
+
+        std::swap(front_, back_);
+        front_.clear();
+
+        const size_t offset = array_.offset() + file_offset_;
+        const size_t count = back_.size();
+        file_offset_ += count;
+
+        pending_ = std::async(std::launch::async, [this, offset, count]
+        {
+            array_.get_file()->write_records(&back_, 0, offset, count);
+        });
+    }
+
+    surfel_disk_array &array_;
+    const size_t buffer_size_;
+    size_t file_offset_;
+
+    record_vector front_;
+    record_vector back_;
+
+    std::future<void> pending_;
+};
+
+/**
+ * Tournament tree over the current records of the runs. Inner nodes
+ * keep the loser of their match, so replacing the winner needs a
+ * single comparison per level. Exhausted runs lose every match.
+ */
+template <class Less>
+class loser_tree
+{
+public:
+    loser_tree(const std::vector<std::unique_ptr<run_reader>> &readers, const Less &less)
+        : readers_(readers),
+          less_(less),
+          tree_(readers.size())
+    {
+        const size_t k = readers_.size();
+        if (k == 1) {
+            tree_[0] = 0;
+            return;
+        }
+
+        // leaf i is node k + i, the parent of node n is n / 2
+        std::vector<size_t> winners(2 * k);
+        for (size_t i = 0; i < k; ++i)
+            winners[k + i] = i;
+
+        for (size_t n = k - 1; n > 0; --n) {
+            const size_t a = winners[2 * n];
+            const size_t b = winners[2 * n + 1];
+            if (beats(a, b)) {
+                winners[n] = a;
+                tree_[n] = b;
+            }
+            else {
+                winners[n] = b;
+                tree_[n] = a;
+            }
+        }
+        tree_[0] = winners[1];
+    }
+
+    size_t winner() const
+    { return tree_[0]; }
+
+    // to be called after the winning run has advanced
+    void replay()
+    {
+        const size_t k = readers_.size();
+        size_t candidate = tree_[0];
+        for (size_t n = (candidate + k) / 2; n > 0; n /= 2) {
+            if (beats(tree_[n], candidate))
+                std::swap(tree_[n], candidate);
+        }
+        tree_[0] = candidate;
+    }
+
+private:
+    bool beats(const size_t a, const size_t b) const
+    {
+        const record *ra = readers_[a]->current();
+        const record *rb = readers_[b]->current();
+        if (ra == nullptr)
+            return false;
+        if (rb == nullptr)
+            return true;
+        return less_(*ra, *rb);
+    }
+
+    const std::vector<std::unique_ptr<run_reader>> &readers_;
+    const Less &less_;
+    std::vector<size_t> tree_;
+};
+
+}
+
 external_sort::
-external_sort(const size_t memory_limit,
-              const surfel::compare_function &compare)
+external_sort(const size_t memory_limit)
     : memory_limit_(memory_limit),
-      compare_(compare),
       runs_file_(std::make_shared<surfel_file>())
 {}
 
@@ -38,6 +299,32 @@ void external_sort::
 sort(surfel_disk_array &array,
      const size_t memory_limit,
      const surfel::compare_function &compare)
+{
+    external_sort es(memory_limit);
+    es.sort_records(array, compare_function_less(compare));
+}
+
+void external_sort::
+sort(surfel_disk_array &array,
+     const size_t memory_limit,
+     const uint8_t axis)
+{
+    assert(axis <= 2);
+    external_sort es(memory_limit);
+
+    switch (axis) {
+        case 0: es.sort_records(array, axis_less<0>());
+            break;
+        case 1: es.sort_records(array, axis_less<1>());
+            break;
+        case 2: es.sort_records(array, axis_less<2>());
+            break;
+    }
+}
+
+template <class Less>
+void external_sort::
+sort_records(surfel_disk_array &array, const Less &less)
 {
     assert(!array.is_empty());
     assert(array.get_file());
@@ -45,12 +332,11 @@ sort(surfel_disk_array &array,
     if (!array.length())
         return;
 
-    external_sort es(memory_limit, compare);
-
-    // compute sort parameters
-    const size_t run_length = memory_limit / sizeof(surfel) / 3u;
+    // compute sort parameters. while merging, every run and the output
+    // hold two buffers, one being processed and one in flight
+    const size_t run_length = memory_limit_ / sizeof(record) / 3u;
     const uint32_t runs_count = std::ceil(array.length() / double(run_length));
-    const size_t merge_buffer_size = memory_limit / sizeof(surfel) / (runs_count + 1u);
+    const size_t merge_buffer_size = memory_limit_ / sizeof(record) / (2u * (runs_count + 1u));
 
     LOGGER_INFO("External sort. Length: " << array.length());
     LOGGER_INFO("Max run length: " << run_length <<
@@ -72,31 +358,34 @@ sort(surfel_disk_array &array,
 
     if (runs_count > 1u) {
         // external sort
-        es.runs_file_->open(array.get_file()->file_name() + TEMP_FILE_EXT, true);
+        runs_file_->open(array.get_file()->file_name() + TEMP_FILE_EXT, true);
         LOGGER_TRACE("create runs");
-        es.create_runs(array, run_length, runs_count);
+        create_runs(array, run_length, runs_count, less);
         LOGGER_TRACE("merge");
-        es.merge(array, merge_buffer_size);
-        es.runs_file_->close(true);
-        es.runs_.clear();
+        merge(array, std::max(merge_buffer_size, size_t(1)), less);
+        runs_file_->close(true);
+        runs_.clear();
     }
     else {
         // internal sort for a single run
-        shared_surfel_vector data = array.read_all();
+        record_vector data(array.length());
+        array.get_file()->read_records(&data, 0, array.offset(), array.length());
 
 #if WIN32
-        Concurrency::parallel_sort(data->begin(), data->end(), es.compare_);
+        Concurrency::parallel_sort(data.begin(), data.end(), less);
 #else
-        __gnu_parallel::sort(data->begin(), data->end(), es.compare_);
+        __gnu_parallel::sort(data.begin(), data.end(), less);
 #endif
-        array.write_all(data, 0);
+        array.get_file()->write_records(&data, 0, array.offset(), array.length());
     }
 }
 
+template <class Less>
 void external_sort::
 create_runs(surfel_disk_array &array,
             const size_t run_length,
-            const uint32_t runs_count)
+            const uint32_t runs_count,
+            const Less &less)
 {
     // construct runs' surfel_disk_arrays
     size_t offset = 0;
@@ -107,17 +396,23 @@ create_runs(surfel_disk_array &array,
     runs_.push_back(surfel_disk_array(array, array.offset() + offset,
                                       array.length() - offset));
 
-    assert(std::accumulate(runs_.begin(), runs_.end(), 0u,
+    assert(std::accumulate(runs_.begin(), runs_.end(), size_t(0),
                            [](const size_t &a,
                               const surfel_disk_array &b)
                            { return a + b.length(); }) ==
         array.length());
     // sort the runs
-    shared_surfel_vector next_data;
+    auto read_run = [](const surfel_disk_array &run) {
+        auto data = std::make_shared<record_vector>(run.length());
+        run.get_file()->read_records(data.get(), 0, run.offset(), run.length());
+        return data;
+    };
+
+    std::shared_ptr<record_vector> next_data;
 
     for (uint32_t i = 0; i < runs_.size(); ++i) {
 
-        shared_surfel_vector data;
+        std::shared_ptr<record_vector> data;
 
         if (next_data) {
             data = next_data;
@@ -125,7 +420,7 @@ create_runs(surfel_disk_array &array,
         }
         else {
             LOGGER_TRACE("read run " << i);
-            data = runs_[i].read_all();
+            data = read_run(runs_[i]);
         }
 
 #pragma omp parallel sections
@@ -133,73 +428,54 @@ create_runs(surfel_disk_array &array,
             {
                 LOGGER_TRACE("sort run " << i);
 #if WIN32
-                Concurrency::parallel_sort(data->begin(), data->end(), compare_);
+                Concurrency::parallel_sort(data->begin(), data->end(), less);
 #else
-                __gnu_parallel::sort(data->begin(), data->end(), compare_);
+                __gnu_parallel::sort(data->begin(), data->end(), less);
 #endif
             }
 #pragma omp section
             {
                 if (i + 1 < runs_.size()) {
                     LOGGER_TRACE("read run " << i + 1);
-                    next_data = runs_[i + 1].read_all();
+                    next_data = read_run(runs_[i + 1]);
                 }
             }
         }
         LOGGER_TRACE("Save run " << i);
-        runs_file_->append(&(*data));
+        runs_file_->append_records(data.get());
         runs_[i].reset(runs_file_, runs_[i].offset() - array.offset(),
                        runs_[i].length());
     }
 }
 
+template <class Less>
 void external_sort::
-merge(surfel_disk_array &array, const size_t buffer_size)
+merge(surfel_disk_array &array,
+      const size_t buffer_size,
+      const Less &less)
 {
-    size_t file_offset = 0;
-    surfel_vector output;
-    output.reserve(buffer_size);
-
-    std::vector<buffer> buffers;
-    for (auto r: runs_)
-        buffers.push_back(buffer(r, buffer_size));
-
-    surfel least;
-    int least_idx;
-
-    do {
-        least_idx = -1;
-        for (size_t i = 0; i < buffers.size(); ++i) {
-            surfel current_surfel;
-
-            if (buffers[i].front(current_surfel) && (least_idx == -1 ||
-                compare_(current_surfel, least))) {
-                least = current_surfel;
-                least_idx = i;
-            }
-        }
-        if (least_idx != -1) {
-            buffers[least_idx].pop_front();
-            output.push_back(least);
-            if (output.size() >= buffer_size) {
-                array.get_file()->write(&output, 0, array.offset() + file_offset,
-                                    output.size());
-                file_offset += output.size();
-                output.clear();
-            }
-        }
+    std::vector<std::unique_ptr<run_reader>> readers;
+    for (const auto &r: runs_)
+        readers.emplace_back(new run_reader(r, buffer_size));
+
+    output_writer output(array, buffer_size);
+    loser_tree<Less> tree(readers, less);
+
+    for (;;) {
+        run_reader &reader = *readers[tree.winner()];
+        const record *least = reader.current();
+        if (least == nullptr)
+            break;
+
+        output.push(*least);
+        reader.advance();
+        tree.replay();
     }
-    while (least_idx != -1);
 
-    if (output.size() > 0) {
-        array.get_file()->write(&output, 0, array.offset() + file_offset,
-                            output.size());
-        file_offset += output.size();
-        output.clear();
-    }
-    assert(file_offset == array.length());
+    const size_t written = output.finish();
+    assert(written == array.length());
+    (void) written;
 }
 
 }
 } // namespace lamure
-
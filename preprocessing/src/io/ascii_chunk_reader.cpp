@@ -0,0 +1,295 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group 
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#include <lamure/pre/io/ascii_chunk_reader.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+namespace lamure
+{
+namespace pre
+{
+
+namespace
+{
+
+// bytes of text parsed by one thread before the results are emitted
+const size_t CHUNK_SIZE = 16 * 1024 * 1024;
+
+const double POW10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                        1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                        1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+// Mantissa and power of ten that are both exactly representable, so that a
+// single multiplication or division yields the correctly rounded result
+// (Clinger's fast path). Everything else is handed to strtod/strtof, which
+// keeps the results identical to the former stream based parsing.
+template<typename T> struct fast_path_limits;
+
+template<> struct fast_path_limits<double>
+{
+    static const uint64_t max_mantissa = uint64_t(1) << 53;
+    static const int max_exponent = 22;
+    static double fallback(const char *s, char **end) { return std::strtod(s, end); }
+};
+
+template<> struct fast_path_limits<float>
+{
+    static const uint64_t max_mantissa = uint64_t(1) << 24;
+    static const int max_exponent = 10;
+    static float fallback(const char *s, char **end) { return std::strtof(s, end); }
+};
+
+inline bool is_space(const char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+inline bool is_digit(const char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+inline void next_token(const char *&begin, const char *end, const char *&token, const char *&token_end)
+{
+    while (begin != end && is_space(*begin))
+        ++begin;
+    token = begin;
+    while (begin != end && !is_space(*begin))
+        ++begin;
+    token_end = begin;
+}
+
+template<typename T>
+bool parse_floating_point(const char *&begin, const char *end, T &value)
+{
+    const char *token, *token_end;
+    next_token(begin, end, token, token_end);
+    if (token == token_end)
+        return false;
+
+    const char *c = token;
+    bool negative = false;
+    if (*c == '-' || *c == '+') {
+        negative = (*c == '-');
+        ++c;
+    }
+
+    uint64_t mantissa = 0;
+    int num_digits = 0;
+    int exponent = 0;
+    bool has_digits = false;
+    bool fast_path = true;
+
+    auto accumulate = [&](const char d) {
+        has_digits = true;
+        if (mantissa == 0 && d == '0')
+            return;
+        if (num_digits < 19) {
+            mantissa = mantissa * 10 + uint64_t(d - '0');
+            ++num_digits;
+        }
+        else
+            fast_path = false;
+    };
+
+    for (; c != token_end && is_digit(*c); ++c)
+        accumulate(*c);
+
+    if (c != token_end && *c == '.') {
+        for (++c; c != token_end && is_digit(*c); ++c) {
+            accumulate(*c);
+            --exponent;
+        }
+    }
+
+    if (c != token_end && (*c == 'e' || *c == 'E')) {
+        ++c;
+        bool negative_exponent = false;
+        if (c != token_end && (*c == '-' || *c == '+')) {
+            negative_exponent = (*c == '-');
+            ++c;
+        }
+        int e = 0;
+        bool has_exponent_digits = false;
+        for (; c != token_end && is_digit(*c); ++c) {
+            if (e < 100000)
+                e = e * 10 + (*c - '0');
+            has_exponent_digits = true;
+        }
+        if (!has_exponent_digits)
+            fast_path = false;
+        exponent += negative_exponent ? -e : e;
+    }
+
+    if (!has_digits || c != token_end)
+        fast_path = false;
+
+    if (fast_path &&
+        mantissa <= fast_path_limits<T>::max_mantissa &&
+        exponent >= -fast_path_limits<T>::max_exponent &&
+        exponent <= fast_path_limits<T>::max_exponent) {
+
+        T v = T(mantissa);
+        if (exponent < 0)
+            v /= T(POW10[-exponent]);
+        else
+            v *= T(POW10[exponent]);
+        value = negative ? -v : v;
+        return true;
+    }
+
+    // slow path for long mantissas, large exponents, inf, nan, ...
+    std::string token_str(token, token_end);
+    char *parsed_end = nullptr;
+    value = fast_path_limits<T>::fallback(token_str.c_str(), &parsed_end);
+    return parsed_end != token_str.c_str();
+}
+
+bool is_blank(const char *begin, const char *end)
+{
+    for (; begin != end; ++begin)
+        if (!is_space(*begin))
+            return false;
+    return true;
+}
+
+}
+
+bool ascii_chunk_reader::
+parse_real(const char *&begin, const char *end, real &value)
+{
+    return parse_floating_point<real>(begin, end, value);
+}
+
+bool ascii_chunk_reader::
+parse_float(const char *&begin, const char *end, float &value)
+{
+    return parse_floating_point<float>(begin, end, value);
+}
+
+bool ascii_chunk_reader::
+parse_uint(const char *&begin, const char *end, unsigned int &value)
+{
+    const char *token, *token_end;
+    next_token(begin, end, token, token_end);
+    if (token == token_end)
+        return false;
+
+    uint64_t v = 0;
+    for (const char *c = token; c != token_end; ++c) {
+        if (!is_digit(*c) || v > std::numeric_limits<unsigned int>::max())
+            return false;
+        v = v * 10 + uint64_t(*c - '0');
+    }
+    if (v > std::numeric_limits<unsigned int>::max())
+        return false;
+
+    value = static_cast<unsigned int>(v);
+    return true;
+}
+
+void ascii_chunk_reader::
+read(const std::string &filename,
+     line_parser_function parser,
+     const format_abstract::surfel_callback_funtion &callback)
+{
+    if (!boost::filesystem::exists(filename))
+        throw std::runtime_error("Unable to open file: " +
+            filename);
+
+    const size_t file_size = boost::filesystem::file_size(filename);
+    if (file_size == 0)
+        return;
+
+    boost::iostreams::mapped_file_source mapped_file;
+    try {
+        mapped_file.open(filename);
+    }
+    catch (const std::exception &e) {
+        throw std::runtime_error("Unable to map file: " +
+            filename + " (" + e.what() + ")");
+    }
+    const char *data = mapped_file.data();
+
+    // moves pos to the beginning of the next line, unless it already is
+    auto align_to_line = [&](const size_t pos) -> size_t
+    {
+        if (pos >= file_size)
+            return file_size;
+        if (pos == 0 || data[pos - 1] == '\n')
+            return pos;
+        const char *newline = static_cast<const char *>(std::memchr(data + pos, '\n', file_size - pos));
+        return newline ? size_t(newline - data) + 1 : file_size;
+    };
+
+    const int num_threads = std::max(1u, std::thread::hardware_concurrency());
+    const size_t batch_size = num_threads * CHUNK_SIZE;
+
+    std::vector<surfel_vector> chunk_surfels(num_threads);
+    std::vector<size_t> chunk_skipped_lines(num_threads);
+    size_t num_skipped_lines = 0;
+    uint8_t percent_processed = 0;
+
+    for (size_t batch_begin = 0; batch_begin < file_size; batch_begin += batch_size) {
+
+        #pragma omp parallel for schedule(dynamic, 1) num_threads(num_threads)
+        for (int i = 0; i < num_threads; ++i) {
+            const char *p = data + align_to_line(batch_begin + i * CHUNK_SIZE);
+            const char *chunk_end = data + align_to_line(batch_begin + (i + 1) * CHUNK_SIZE);
+
+            surfel_vector &surfels = chunk_surfels[i];
+            surfels.clear();
+            chunk_skipped_lines[i] = 0;
+
+            while (p < chunk_end) {
+                const char *line_end = static_cast<const char *>(std::memchr(p, '\n', chunk_end - p));
+                if (!line_end)
+                    line_end = chunk_end;
+
+                surfel s;
+                if (parser(p, line_end, s))
+                    surfels.push_back(s);
+                else if (!is_blank(p, line_end))
+                    ++chunk_skipped_lines[i];
+
+                p = line_end + 1;
+            }
+        }
+
+        // emit in file order
+        for (int i = 0; i < num_threads; ++i) {
+            for (const auto &s : chunk_surfels[i])
+                callback(s);
+            num_skipped_lines += chunk_skipped_lines[i];
+        }
+
+        uint8_t new_percent_processed = std::min(batch_begin + batch_size, file_size) * 100 / file_size;
+        if (percent_processed != new_percent_processed) {
+            percent_processed = new_percent_processed;
+            std::cout << "\r" << (int) percent_processed << "% processed" << std::flush;
+        }
+    }
+
+    mapped_file.close();
+
+    if (num_skipped_lines > 0) {
+        LOGGER_WARN("Skipped " << num_skipped_lines << " malformed lines in \"" << filename << "\"");
+    }
+}
+
+} // namespace pre
+} // namespace lamure
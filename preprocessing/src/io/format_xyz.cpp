@@ -6,10 +6,11 @@
 // http://www.uni-weimar.de/medien/vr
 
 #include <lamure/pre/io/format_xyz.h>
+#include <lamure/pre/io/ascii_chunk_reader.h>
 
 #include <stdexcept>
 #include <fstream>
-#include <sstream>
+#include <iomanip>
 #include <iostream>
 
 namespace lamure
@@ -17,49 +18,33 @@ namespace lamure
 namespace pre
 {
 
-void format_xyz::
-read(const std::string &filename, surfel_callback_funtion callback)
+namespace
 {
-    std::ifstream xyz_file_stream(filename);
-
-    if (!xyz_file_stream.is_open())
-        throw std::runtime_error("Unable to open file: " +
-            filename);
-
-    std::string line;
 
+bool parse_line(const char *begin, const char *end, surfel &s)
+{
     real pos[3];
     unsigned int color[3];
 
-    xyz_file_stream.seekg(0, std::ios::end);
-    std::streampos end_pos = xyz_file_stream.tellg();
-    xyz_file_stream.seekg(0, std::ios::beg);
-    uint8_t percent_processed = 0;
-
-    while (getline(xyz_file_stream, line)) {
-
-        uint8_t new_percent_processed = (xyz_file_stream.tellg() / float(end_pos)) * 100;
-        if (percent_processed + 1 == new_percent_processed) {
-            percent_processed = new_percent_processed;
-            std::cout << "\r" << (int) percent_processed << "% processed" << std::flush;
-        }
-
-        std::stringstream sstream;
-
-        sstream << line;
-
-        sstream >> std::setprecision(LAMURE_STREAM_PRECISION) >> pos[0];
-        sstream >> std::setprecision(LAMURE_STREAM_PRECISION) >> pos[1];
-        sstream >> std::setprecision(LAMURE_STREAM_PRECISION) >> pos[2];
-        sstream >> color[0];
-        sstream >> color[1];
-        sstream >> color[2];
+    if (!ascii_chunk_reader::parse_real(begin, end, pos[0]) ||
+        !ascii_chunk_reader::parse_real(begin, end, pos[1]) ||
+        !ascii_chunk_reader::parse_real(begin, end, pos[2]) ||
+        !ascii_chunk_reader::parse_uint(begin, end, color[0]) ||
+        !ascii_chunk_reader::parse_uint(begin, end, color[1]) ||
+        !ascii_chunk_reader::parse_uint(begin, end, color[2]))
+        return false;
+
+    s = surfel(vec3r(pos[0], pos[1], pos[2]),
+               vec3b(color[0], color[1], color[2]));
+    return true;
+}
 
-        callback(surfel(vec3r(pos[0], pos[1], pos[2]),
-                        vec3b(color[0], color[1], color[2])));
-    }
+}
 
-    xyz_file_stream.close();
+void format_xyz::
+read(const std::string &filename, surfel_callback_funtion callback)
+{
+    ascii_chunk_reader::read(filename, &parse_line, callback);
 }
 
 void format_xyz::
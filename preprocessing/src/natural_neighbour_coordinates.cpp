@@ -0,0 +1,266 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group 
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#include <lamure/pre/natural_neighbour_coordinates.h>
+#include <lamure/pre/normal_computation_batched_plane_fitting.h>
+#include <lamure/pre/plane.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace lamure
+{
+namespace pre
+{
+
+namespace
+{
+
+using cell_polygon = natural_neighbour_coordinates::cell_polygon;
+
+inline real dot(const vec2r &a, const vec2r &b)
+{
+    return a.x * b.x + a.y * b.y;
+}
+
+// keeps the part of the polygon with dot(x, normal) <= offset
+void clip(const cell_polygon &in,
+          const vec2r &normal,
+          const real offset,
+          const int32_t generator,
+          cell_polygon &out)
+{
+    out.num_vertices = 0;
+
+    for (uint32_t i = 0; i < in.num_vertices; ++i) {
+        const vec2r &current = in.vertices[i];
+        const vec2r &next = in.vertices[(i + 1) % in.num_vertices];
+        const real d_current = dot(current, normal) - offset;
+        const real d_next = dot(next, normal) - offset;
+
+        if (d_current <= 0.0) {
+            out.vertices[out.num_vertices] = current;
+            out.generators[out.num_vertices] = in.generators[i];
+            ++out.num_vertices;
+
+            if (d_next > 0.0) {
+                // leaves the half plane, the new edge starts here
+                out.vertices[out.num_vertices] = current + (next - current) * (d_current / (d_current - d_next));
+                out.generators[out.num_vertices] = generator;
+                ++out.num_vertices;
+            }
+        }
+        else if (d_next <= 0.0) {
+            // enters the half plane, the rest of the edge is kept
+            out.vertices[out.num_vertices] = current + (next - current) * (d_current / (d_current - d_next));
+            out.generators[out.num_vertices] = in.generators[i];
+            ++out.num_vertices;
+        }
+    }
+}
+
+real area(const cell_polygon &polygon)
+{
+    real twice_area = 0.0;
+    for (uint32_t i = 0; i < polygon.num_vertices; ++i) {
+        const vec2r &current = polygon.vertices[i];
+        const vec2r &next = polygon.vertices[(i + 1) % polygon.num_vertices];
+        twice_area += current.x * next.y - next.x * current.y;
+    }
+    return 0.5 * twice_area;
+}
+
+}
+
+uint32_t natural_neighbour_coordinates::
+compute(const vec2r *projected_positions,
+        const uint32_t num_positions,
+        uint32_t *ids,
+        real *weights)
+{
+    workspace buffers;
+    return compute(projected_positions, num_positions, ids, weights, buffers);
+}
+
+uint32_t natural_neighbour_coordinates::
+compute(const vec2r *projected_positions,
+        const uint32_t num_positions,
+        uint32_t *ids,
+        real *weights,
+        workspace &buffers)
+{
+    const uint32_t num_neighbours = std::min(num_positions, max_neighbours);
+
+    if (num_neighbours < 3) {
+        return 0;
+    }
+
+    real max_distance_sqr = 0.0;
+    for (uint32_t i = 0; i < num_neighbours; ++i) {
+        max_distance_sqr = std::max(max_distance_sqr, dot(projected_positions[i], projected_positions[i]));
+    }
+
+    if (max_distance_sqr <= 0.0 || !std::isfinite(max_distance_sqr)) {
+        return 0;
+    }
+
+    // the point of interest is one of the neighbours
+    for (uint32_t i = 0; i < num_neighbours; ++i) {
+        if (dot(projected_positions[i], projected_positions[i]) <= 1e-12 * max_distance_sqr) {
+            ids[0] = i;
+            weights[0] = 1.0;
+            return 1;
+        }
+    }
+
+    cell_polygon *polygons = buffers.polygons;
+    uint32_t current = 0;
+
+    // a cell reaching the square is unbounded or too close to it
+    const real extent = 64.0 * std::sqrt(max_distance_sqr);
+    polygons[current].vertices[0] = vec2r(-extent, -extent);
+    polygons[current].vertices[1] = vec2r(extent, -extent);
+    polygons[current].vertices[2] = vec2r(extent, extent);
+    polygons[current].vertices[3] = vec2r(-extent, extent);
+    std::fill(polygons[current].generators, polygons[current].generators + 4, -1);
+    polygons[current].num_vertices = 4;
+
+    // voronoi cell of the point of interest
+    for (uint32_t i = 0; i < num_neighbours; ++i) {
+        const vec2r &p = projected_positions[i];
+        clip(polygons[current], p, 0.5 * dot(p, p), i, polygons[1 - current]);
+        current = 1 - current;
+    }
+
+    const cell_polygon &cell = polygons[current];
+
+    if (cell.num_vertices < 3) {
+        return 0;
+    }
+
+    uint32_t num_natural_neighbours = 0;
+    for (uint32_t i = 0; i < cell.num_vertices; ++i) {
+        if (cell.generators[i] < 0) {
+            return 0;
+        }
+        if (std::find(ids, ids + num_natural_neighbours, uint32_t(cell.generators[i])) == ids + num_natural_neighbours) {
+            ids[num_natural_neighbours++] = cell.generators[i];
+        }
+    }
+
+    // the part of the cell closest to a natural neighbour was taken from its
+    // voronoi cell, the other neighbours cannot be closest inside the cell
+    cell_polygon *stolen = buffers.stolen;
+    real total_area = 0.0;
+
+    for (uint32_t n = 0; n < num_natural_neighbours; ++n) {
+        const vec2r &p = projected_positions[ids[n]];
+        const real p_sqr = dot(p, p);
+
+        uint32_t stolen_current = 0;
+        stolen[stolen_current] = cell;
+
+        for (uint32_t other = 0; other < num_natural_neighbours && stolen[stolen_current].num_vertices > 0; ++other) {
+            if (other == n) {
+                continue;
+            }
+            const vec2r &q = projected_positions[ids[other]];
+            clip(stolen[stolen_current], q - p, 0.5 * (dot(q, q) - p_sqr), -1, stolen[1 - stolen_current]);
+            stolen_current = 1 - stolen_current;
+        }
+
+        weights[n] = stolen[stolen_current].num_vertices < 3 ? 0.0 : std::max(real(0.0), area(stolen[stolen_current]));
+        total_area += weights[n];
+    }
+
+    if (total_area <= 0.0) {
+        return 0;
+    }
+
+    // drop neighbours that only touch the cell
+    uint32_t num_weighted_neighbours = 0;
+    for (uint32_t n = 0; n < num_natural_neighbours; ++n) {
+        if (weights[n] > 0.0) {
+            ids[num_weighted_neighbours] = ids[n];
+            weights[num_weighted_neighbours] = weights[n] / total_area;
+            ++num_weighted_neighbours;
+        }
+    }
+
+    return num_weighted_neighbours;
+}
+
+uint32_t natural_neighbour_coordinates::
+compute(const vec3r &point_of_interest,
+        const vec3r *positions,
+        const uint32_t num_positions,
+        uint32_t *ids,
+        real *weights)
+{
+    workspace buffers;
+    return compute(point_of_interest, positions, num_positions, ids, weights, buffers);
+}
+
+uint32_t natural_neighbour_coordinates::
+compute(const vec3r &point_of_interest,
+        const vec3r *positions,
+        const uint32_t num_positions,
+        uint32_t *ids,
+        real *weights,
+        workspace &buffers)
+{
+    const uint32_t num_neighbours = std::min(num_positions, max_neighbours);
+
+    if (num_neighbours < 3) {
+        return 0;
+    }
+
+    // best fit plane
+    vec3r centroid(0.0);
+    for (uint32_t i = 0; i < num_neighbours; ++i) {
+        centroid += positions[i];
+    }
+    centroid /= real(num_neighbours);
+
+    real covariance[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+    for (uint32_t i = 0; i < num_neighbours; ++i) {
+        const vec3r d = positions[i] - centroid;
+        covariance[0] += d.x * d.x;
+        covariance[1] += d.x * d.y;
+        covariance[2] += d.x * d.z;
+        covariance[3] += d.y * d.y;
+        covariance[4] += d.y * d.z;
+        covariance[5] += d.z * d.z;
+    }
+
+    const vec3f normal = normal_computation_batched_plane_fitting::smallest_eigenvector(covariance);
+
+    if (normal.x == 0.0f && normal.y == 0.0f && normal.z == 0.0f) {
+        return 0;
+    }
+
+    const plane_t plane(vec3r(normal), centroid);
+    const vec3r plane_right = plane.get_right();
+    const vec3r plane_up = plane.get_up();
+
+    // project relative to the point of interest
+    const vec2r projected_poi = plane_t::project(plane, plane_right, plane_up, point_of_interest);
+
+    vec2r *projected_positions = buffers.projected_positions;
+    for (uint32_t i = 0; i < num_neighbours; ++i) {
+        projected_positions[i] = plane_t::project(plane, plane_right, plane_up, positions[i]) - projected_poi;
+
+        if (!std::isfinite(projected_positions[i].x) || !std::isfinite(projected_positions[i].y)) {
+            return 0;
+        }
+    }
+
+    return compute(projected_positions, num_neighbours, ids, weights, buffers);
+}
+
+}// namespace pre
+}// namespace lamure
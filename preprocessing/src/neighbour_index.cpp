@@ -0,0 +1,218 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group 
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#include <lamure/pre/neighbour_index.h>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+namespace lamure
+{
+namespace pre
+{
+
+namespace
+{
+const uint32_t MAX_POINTS_PER_LEAF = 16;
+
+bool compare_candidate_distance(const neighbour_index::candidate &left,
+                                const neighbour_index::candidate &right)
+{
+    return left.second < right.second;
+}
+}
+
+void neighbour_index::
+build(const surfel_mem_array &sa)
+{
+    std::vector<vec3r> positions(sa.length());
+    for (size_t i = 0; i < sa.length(); ++i) {
+        positions[i] = sa.read_surfel_ref(i).pos();
+    }
+    build(positions);
+}
+
+void neighbour_index::
+build(const std::vector<vec3r> &positions)
+{
+    clear();
+
+    indices_.resize(positions.size());
+    std::iota(indices_.begin(), indices_.end(), 0u);
+
+    nodes_.reserve(2 * (positions.size() / MAX_POINTS_PER_LEAF + 1));
+    nodes_.push_back(kd_node{0.0, 0, uint32_t(positions.size()), 0, 0});
+    build_recursive(0, positions);
+
+    positions_.resize(positions.size());
+    for (size_t i = 0; i < indices_.size(); ++i) {
+        positions_[i] = positions[indices_[i]];
+    }
+}
+
+void neighbour_index::
+clear()
+{
+    nodes_.clear();
+    positions_.clear();
+    indices_.clear();
+    nodes_.shrink_to_fit();
+    positions_.shrink_to_fit();
+    indices_.shrink_to_fit();
+}
+
+void neighbour_index::
+build_recursive(const uint32_t node_idx,
+                const std::vector<vec3r> &source)
+{
+    const uint32_t begin = nodes_[node_idx].begin;
+    const uint32_t end = nodes_[node_idx].end;
+
+    if (end - begin <= MAX_POINTS_PER_LEAF) {
+        return;
+    }
+
+    // split at the median of the axis with the largest extent
+    vec3r min = source[indices_[begin]];
+    vec3r max = min;
+    for (uint32_t i = begin + 1; i < end; ++i) {
+        const vec3r &p = source[indices_[i]];
+        for (uint8_t a = 0; a < 3; ++a) {
+            if (p[a] < min[a]) min[a] = p[a];
+            if (p[a] > max[a]) max[a] = p[a];
+        }
+    }
+
+    uint8_t axis = 0;
+    if (max[1] - min[1] > max[axis] - min[axis]) axis = 1;
+    if (max[2] - min[2] > max[axis] - min[axis]) axis = 2;
+
+    const uint32_t mid = begin + (end - begin) / 2;
+    std::nth_element(indices_.begin() + begin, indices_.begin() + mid, indices_.begin() + end,
+                     [&](const uint32_t l, const uint32_t r) { return source[l][axis] < source[r][axis]; });
+
+    const uint32_t left = nodes_.size();
+    nodes_[node_idx].split = source[indices_[mid]][axis];
+    nodes_[node_idx].axis = axis;
+    nodes_[node_idx].left = left;
+
+    nodes_.push_back(kd_node{0.0, begin, mid, 0, 0});
+    nodes_.push_back(kd_node{0.0, mid, end, 0, 0});
+
+    build_recursive(left, source);
+    build_recursive(left + 1, source);
+}
+
+void neighbour_index::
+search_nearest(const vec3r &center,
+               const uint32_t num_neighbours,
+               const node_id_type node_id,
+               const size_t excluded_idx,
+               std::vector<candidate> &candidates) const
+{
+    if (num_neighbours == 0 || positions_.empty()) {
+        return;
+    }
+    search_nearest_recursive(0, center, num_neighbours, node_id, excluded_idx, candidates);
+}
+
+void neighbour_index::
+search_nearest_recursive(const uint32_t node_idx,
+                         const vec3r &center,
+                         const uint32_t num_neighbours,
+                         const node_id_type node_id,
+                         const size_t excluded_idx,
+                         std::vector<candidate> &candidates) const
+{
+    const kd_node &node = nodes_[node_idx];
+
+    if (node.left == 0) {
+        for (uint32_t i = node.begin; i < node.end; ++i) {
+            if (indices_[i] == excluded_idx)
+                continue;
+            push_candidate(candidates, num_neighbours, surfel_id_t(node_id, indices_[i]),
+                           scm::math::length_sqr(center - positions_[i]));
+        }
+        return;
+    }
+
+    const real diff = center[node.axis] - node.split;
+    const uint32_t near_child = diff < 0.0 ? node.left : node.left + 1;
+    const uint32_t far_child = diff < 0.0 ? node.left + 1 : node.left;
+
+    search_nearest_recursive(near_child, center, num_neighbours, node_id, excluded_idx, candidates);
+
+    if (candidates.size() < num_neighbours || diff * diff < candidates.front().second) {
+        search_nearest_recursive(far_child, center, num_neighbours, node_id, excluded_idx, candidates);
+    }
+}
+
+void neighbour_index::
+search_radius(const vec3r &center,
+              const real radius,
+              std::vector<size_t> &result) const
+{
+    if (positions_.empty()) {
+        return;
+    }
+    search_radius_recursive(0, center, radius * radius, result);
+}
+
+void neighbour_index::
+search_radius_recursive(const uint32_t node_idx,
+                        const vec3r &center,
+                        const real radius_sqr,
+                        std::vector<size_t> &result) const
+{
+    const kd_node &node = nodes_[node_idx];
+
+    if (node.left == 0) {
+        for (uint32_t i = node.begin; i < node.end; ++i) {
+            if (scm::math::length_sqr(center - positions_[i]) <= radius_sqr) {
+                result.push_back(indices_[i]);
+            }
+        }
+        return;
+    }
+
+    const real diff = center[node.axis] - node.split;
+
+    if (diff <= 0.0 || diff * diff <= radius_sqr) {
+        search_radius_recursive(node.left, center, radius_sqr, result);
+    }
+    if (diff >= 0.0 || diff * diff <= radius_sqr) {
+        search_radius_recursive(node.left + 1, center, radius_sqr, result);
+    }
+}
+
+void neighbour_index::
+push_candidate(std::vector<candidate> &candidates,
+               const uint32_t num_neighbours,
+               const surfel_id_t &id,
+               const real distance)
+{
+    if (candidates.size() < num_neighbours) {
+        candidates.emplace_back(id, distance);
+        std::push_heap(candidates.begin(), candidates.end(), compare_candidate_distance);
+    }
+    else if (num_neighbours > 0 && distance < candidates.front().second) {
+        // replace the most distant candidate
+        std::pop_heap(candidates.begin(), candidates.end(), compare_candidate_distance);
+        candidates.back() = candidate(id, distance);
+        std::push_heap(candidates.begin(), candidates.end(), compare_candidate_distance);
+    }
+}
+
+void neighbour_index::
+sort_candidates(std::vector<candidate> &candidates)
+{
+    std::sort_heap(candidates.begin(), candidates.end(), compare_candidate_distance);
+}
+
+} // namespace pre
+} // namespace lamure
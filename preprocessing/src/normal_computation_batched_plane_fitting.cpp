@@ -0,0 +1,261 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group 
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#include <lamure/pre/bvh.h>
+#include <lamure/pre/normal_computation_batched_plane_fitting.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace lamure
+{
+namespace pre
+{
+
+namespace
+{
+
+inline vec3r cross(const vec3r &a, const vec3r &b)
+{
+    return vec3r(a.y * b.z - a.z * b.y,
+                 a.z * b.x - a.x * b.z,
+                 a.x * b.y - a.y * b.x);
+}
+
+inline real length_sqr(const vec3r &v)
+{
+    return v.x * v.x + v.y * v.y + v.z * v.z;
+}
+
+// eigenvector of a simple eigenvalue: the rows of (A - eigenvalue * I) span
+// the orthogonal complement, so their largest cross product is the vector
+bool eigenvector(const real a00, const real a01, const real a02,
+                 const real a11, const real a12, const real a22,
+                 const real eigenvalue, vec3r &result)
+{
+    const vec3r r0(a00 - eigenvalue, a01, a02);
+    const vec3r r1(a01, a11 - eigenvalue, a12);
+    const vec3r r2(a02, a12, a22 - eigenvalue);
+
+    const vec3r c01 = cross(r0, r1);
+    const vec3r c02 = cross(r0, r2);
+    const vec3r c12 = cross(r1, r2);
+
+    const real d01 = length_sqr(c01);
+    const real d02 = length_sqr(c02);
+    const real d12 = length_sqr(c12);
+
+    real d_max = d01;
+    result = c01;
+    if (d02 > d_max) {
+        d_max = d02;
+        result = c02;
+    }
+    if (d12 > d_max) {
+        d_max = d12;
+        result = c12;
+    }
+
+    // the eigenvalue is (numerically) a double one
+    if (d_max <= 1e-20) {
+        return false;
+    }
+
+    result *= real(1.0) / std::sqrt(d_max);
+    return true;
+}
+
+}
+
+vec3f normal_computation_batched_plane_fitting::
+smallest_eigenvector(const real *covariance)
+{
+    real max_abs = 0.0;
+    for (int i = 0; i < 6; ++i) {
+        max_abs = std::max(max_abs, std::abs(covariance[i]));
+    }
+    if (max_abs <= 0.0 || !std::isfinite(max_abs)) {
+        return vec3f(0.0f, 0.0f, 0.0f);
+    }
+
+    // scale to [-1, 1] to keep the cubic well conditioned
+    const real scale = real(1.0) / max_abs;
+    const real a00 = covariance[0] * scale;
+    const real a01 = covariance[1] * scale;
+    const real a02 = covariance[2] * scale;
+    const real a11 = covariance[3] * scale;
+    const real a12 = covariance[4] * scale;
+    const real a22 = covariance[5] * scale;
+
+    // closed form for symmetric 3x3 matrices, eigenvalues are
+    // q + 2p * cos(phi + 2k * pi / 3) with B = (A - qI) / p, det(B) = 2cos(3 phi)
+    const real q = (a00 + a11 + a22) / real(3.0);
+    const real b00 = a00 - q;
+    const real b11 = a11 - q;
+    const real b22 = a22 - q;
+    const real p1 = a01 * a01 + a02 * a02 + a12 * a12;
+    const real p2 = b00 * b00 + b11 * b11 + b22 * b22 + real(2.0) * p1;
+
+    // A is a multiple of the identity, no preferred direction
+    if (p2 <= 1e-30) {
+        return vec3f(0.0f, 0.0f, 0.0f);
+    }
+
+    const real p = std::sqrt(p2 / real(6.0));
+    const real det = b00 * (b11 * b22 - a12 * a12)
+                   - a01 * (a01 * b22 - a12 * a02)
+                   + a02 * (a01 * a12 - b11 * a02);
+
+    const real r = std::max(real(-1.0), std::min(real(1.0), det / (real(2.0) * p * p * p)));
+    const real phi = std::acos(r) / real(3.0);
+
+    const real eigenvalue_max = q + real(2.0) * p * std::cos(phi);
+    const real eigenvalue_min = q + real(2.0) * p * std::cos(phi + real(2.0 * M_PI / 3.0));
+
+    vec3r normal;
+    if (eigenvector(a00, a01, a02, a11, a12, a22, eigenvalue_min, normal)) {
+        return vec3f(normal);
+    }
+
+    // smallest eigenvalue is a double one (points on a line), any
+    // vector orthogonal to the main axis is a valid plane normal
+    vec3r axis;
+    if (!eigenvector(a00, a01, a02, a11, a12, a22, eigenvalue_max, axis)) {
+        return vec3f(0.0f, 0.0f, 0.0f);
+    }
+
+    const vec3r helper = std::abs(axis.x) < real(0.9) ? vec3r(1.0, 0.0, 0.0) : vec3r(0.0, 1.0, 0.0);
+    normal = cross(axis, helper);
+    normal *= real(1.0) / std::sqrt(length_sqr(normal));
+    return vec3f(normal);
+}
+
+void normal_computation_batched_plane_fitting::
+fit_planes(const real *x, const real *y, const real *z,
+           const uint32_t *counts,
+           const size_t max_neighbours,
+           vec3f *normals)
+{
+    alignas(64) real sx[batch_size] = {}, sy[batch_size] = {}, sz[batch_size] = {};
+    alignas(64) real sxx[batch_size] = {}, sxy[batch_size] = {}, sxz[batch_size] = {};
+    alignas(64) real syy[batch_size] = {}, syz[batch_size] = {}, szz[batch_size] = {};
+
+    // one lane per surfel, unused entries are zero and do not contribute
+    for (size_t j = 0; j < max_neighbours; ++j) {
+        const real *xj = x + j * batch_size;
+        const real *yj = y + j * batch_size;
+        const real *zj = z + j * batch_size;
+
+        #pragma omp simd
+        for (size_t i = 0; i < batch_size; ++i) {
+            sx[i] += xj[i];
+            sy[i] += yj[i];
+            sz[i] += zj[i];
+            sxx[i] += xj[i] * xj[i];
+            sxy[i] += xj[i] * yj[i];
+            sxz[i] += xj[i] * zj[i];
+            syy[i] += yj[i] * yj[i];
+            syz[i] += yj[i] * zj[i];
+            szz[i] += zj[i] * zj[i];
+        }
+    }
+
+    for (size_t i = 0; i < batch_size; ++i) {
+        if (counts[i] < 3) {
+            normals[i] = vec3f(0.0f, 0.0f, 0.0f);
+            continue;
+        }
+
+        const real inv_n = real(1.0) / counts[i];
+        const real covariance[6] = {
+            sxx[i] - sx[i] * sx[i] * inv_n,
+            sxy[i] - sx[i] * sy[i] * inv_n,
+            sxz[i] - sx[i] * sz[i] * inv_n,
+            syy[i] - sy[i] * sy[i] * inv_n,
+            syz[i] - sy[i] * sz[i] * inv_n,
+            szz[i] - sz[i] * sz[i] * inv_n};
+
+        normals[i] = smallest_eigenvector(covariance);
+    }
+}
+
+void normal_computation_batched_plane_fitting::
+compute_normals(const bvh &tree,
+                std::vector<surfel_id_t> const &surfels,
+                std::vector<std::vector<std::pair<surfel_id_t, real>>> const &nearest_neighbours,
+                std::vector<vec3f> &normals) const
+{
+    auto &bvh_nodes = tree.nodes();
+    const size_t max_neighbours = number_of_neighbours_;
+
+    normals.resize(surfels.size());
+
+    std::vector<real> x(max_neighbours * batch_size, 0.0);
+    std::vector<real> y(max_neighbours * batch_size, 0.0);
+    std::vector<real> z(max_neighbours * batch_size, 0.0);
+    uint32_t counts[batch_size];
+    vec3f batch_normals[batch_size];
+
+    for (size_t batch_begin = 0; batch_begin < surfels.size(); batch_begin += batch_size) {
+        const size_t batch_end = std::min(batch_begin + batch_size, surfels.size());
+        size_t rows_used = 0;
+
+        std::fill(counts, counts + batch_size, 0);
+
+        // gather neighbour positions relative to the surfel
+        for (size_t s = batch_begin; s < batch_end; ++s) {
+            const size_t lane = s - batch_begin;
+            const vec3r poi = bvh_nodes[surfels[s].node_idx].mem_array().read_surfel_ref(surfels[s].surfel_idx).pos();
+
+            uint32_t count = 0;
+            const size_t num_neighbours = std::min(max_neighbours, nearest_neighbours[s].size());
+            for (size_t n = 0; n < num_neighbours; ++n) {
+                const surfel_id_t &neighbour = nearest_neighbours[s][n].first;
+                const vec3r neighbour_pos = bvh_nodes[neighbour.node_idx].mem_array().read_surfel_ref(neighbour.surfel_idx).pos();
+                if (neighbour_pos == poi) {
+                    continue;
+                }
+
+                const vec3r offset = neighbour_pos - poi;
+                x[count * batch_size + lane] = offset.x;
+                y[count * batch_size + lane] = offset.y;
+                z[count * batch_size + lane] = offset.z;
+                ++count;
+            }
+
+            counts[lane] = count;
+            rows_used = std::max(rows_used, size_t(count));
+        }
+
+        fit_planes(x.data(), y.data(), z.data(), counts, rows_used, batch_normals);
+
+        for (size_t s = batch_begin; s < batch_end; ++s) {
+            const size_t lane = s - batch_begin;
+            normals[s] = batch_normals[lane];
+
+            // leave the rows zeroed for the next batch
+            for (size_t n = 0; n < counts[lane]; ++n) {
+                x[n * batch_size + lane] = 0.0;
+                y[n * batch_size + lane] = 0.0;
+                z[n * batch_size + lane] = 0.0;
+            }
+        }
+    }
+}
+
+vec3f normal_computation_batched_plane_fitting::
+compute_normal(const bvh &tree,
+               const surfel_id_t target_surfel,
+               std::vector<std::pair<surfel_id_t, real>> const &nearest_neighbours) const
+{
+    std::vector<vec3f> normals;
+    compute_normals(tree, {target_surfel}, {nearest_neighbours}, normals);
+    return normals.front();
+}
+
+}// namespace pre
+}// namespace lamure
@@ -6,63 +6,133 @@
 // http://www.uni-weimar.de/medien/vr
 
 #include <lamure/pre/bvh.h>
+#include <lamure/pre/natural_neighbour_coordinates.h>
 #include <lamure/pre/radius_computation_natural_neighbours.h>
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 
 namespace lamure
 {
 namespace pre
 {
 
+namespace
+{
 
-real radius_computation_natural_neighbours::
-compute_radius(const bvh &tree,
-               const surfel_id_t target_surfel,
-               std::vector<std::pair<surfel_id_t, real>> const &nearest_neighbours) const
+// gathers the positions of up to max_neighbours nearest neighbours,
+// returns their number
+uint32_t gather_neighbour_positions(const bvh &tree,
+                                    std::vector<std::pair<surfel_id_t, real>> const &nearest_neighbours,
+                                    vec3r *positions)
 {
+    auto const &bvh_nodes = tree.nodes();
+    const uint32_t num_neighbours = std::min(uint32_t(nearest_neighbours.size()), natural_neighbour_coordinates::max_neighbours);
 
-    if (nearest_neighbours.size() < min_num_nearest_neighbours_) {
-        return 0.0f;
+    for (uint32_t i = 0; i < num_neighbours; ++i) {
+        auto const &neighbour_id = nearest_neighbours[i].first;
+        positions[i] = bvh_nodes[neighbour_id.node_idx].mem_array().read_surfel_ref(neighbour_id.surfel_idx).pos();
     }
 
-    auto const natural_neighbour_ids = tree.get_natural_neighbours(target_surfel, nearest_neighbours);
-
-    if (natural_neighbour_ids.size() < min_num_natural_neighbours_) {
-        return 0.0;
-    }
+    return num_neighbours;
+}
 
-    std::vector<surfel> natural_neighbours;
+// sibson coordinates and clipping polygons, reused by all surfels of a block
+struct natural_neighbour_buffers
+{
+    uint32_t ids[natural_neighbour_coordinates::max_neighbours];
+    real weights[natural_neighbour_coordinates::max_neighbours];
+    natural_neighbour_coordinates::workspace clipping;
+};
 
-    for (auto const &surf_id_pair : natural_neighbour_ids) {
+// half the distance to the most distant natural neighbour
+real natural_neighbour_radius(const vec3r &point_of_interest,
+                              const vec3r *positions,
+                              const uint32_t num_neighbours,
+                              const uint16_t min_num_natural_neighbours,
+                              natural_neighbour_buffers &buffers)
+{
+    const uint32_t *natural_neighbour_ids = buffers.ids;
+    const uint32_t num_natural_neighbours = natural_neighbour_coordinates::compute(point_of_interest, positions, num_neighbours,
+                                                                                   buffers.ids, buffers.weights, buffers.clipping);
 
-        auto const &current_node = tree.nodes()[surf_id_pair.first.node_idx];
-        natural_neighbours.emplace_back(current_node.mem_array().read_surfel_ref(surf_id_pair.first.surfel_idx).pos());
+    if (num_natural_neighbours < min_num_natural_neighbours) {
+        return 0.0;
     }
 
-    vec3r point_of_interest = ((tree.nodes()[target_surfel.node_idx]).mem_array().read_surfel_ref(target_surfel.surfel_idx)).pos();
-
     //determine most distant natural neighbour
     real max_distance = 0.f;
-    for (const auto &nn : natural_neighbours) {
-
-        auto const &surfel_pos = nn.pos();
-        real new_dist = scm::math::length_sqr(point_of_interest - surfel_pos);
+    for (uint32_t i = 0; i < num_natural_neighbours; ++i) {
+        real new_dist = scm::math::length_sqr(point_of_interest - positions[natural_neighbour_ids[i]]);
         max_distance = std::max(max_distance, new_dist);
     }
 
     if (max_distance >= std::numeric_limits<real>::min()) {
         max_distance = scm::math::sqrt(max_distance);
         return 0.5 * max_distance;
-
     }
     else {
         return 0.0;
     }
+}
 
-    natural_neighbours.clear();
+}
 
-};
+real radius_computation_natural_neighbours::
+compute_radius(const bvh &tree,
+               const surfel_id_t target_surfel,
+               std::vector<std::pair<surfel_id_t, real>> const &nearest_neighbours) const
+{
+    if (nearest_neighbours.size() < min_num_nearest_neighbours_) {
+        return 0.0f;
+    }
+
+    vec3r positions[natural_neighbour_coordinates::max_neighbours];
+    const uint32_t num_neighbours = gather_neighbour_positions(tree, nearest_neighbours, positions);
+
+    vec3r point_of_interest = tree.nodes()[target_surfel.node_idx].mem_array().read_surfel_ref(target_surfel.surfel_idx).pos();
+
+    natural_neighbour_buffers buffers;
+    return natural_neighbour_radius(point_of_interest, positions, num_neighbours, min_num_natural_neighbours_, buffers);
+}
+
+void radius_computation_natural_neighbours::
+compute_radii(const bvh &tree,
+              std::vector<surfel_id_t> const &surfels,
+              std::vector<std::vector<std::pair<surfel_id_t, real>>> const &nearest_neighbours,
+              std::vector<real> &radii) const
+{
+    auto const &bvh_nodes = tree.nodes();
+    const uint32_t stride = natural_neighbour_coordinates::max_neighbours;
+
+    radii.resize(surfels.size());
+
+    // gather the positions of the whole block first, one row of
+    // max_neighbours entries per surfel
+    std::vector<vec3r> points_of_interest(surfels.size());
+    std::vector<vec3r> positions(surfels.size() * stride);
+    std::vector<uint32_t> num_neighbours(surfels.size(), 0);
+
+    for (size_t i = 0; i < surfels.size(); ++i) {
+        if (nearest_neighbours[i].size() < min_num_nearest_neighbours_) {
+            continue;
+        }
+        points_of_interest[i] = bvh_nodes[surfels[i].node_idx].mem_array().read_surfel_ref(surfels[i].surfel_idx).pos();
+        num_neighbours[i] = gather_neighbour_positions(tree, nearest_neighbours[i], positions.data() + i * stride);
+    }
+
+    natural_neighbour_buffers buffers;
+
+    for (size_t i = 0; i < surfels.size(); ++i) {
+        if (nearest_neighbours[i].size() < min_num_nearest_neighbours_) {
+            radii[i] = 0.0;
+        }
+        else {
+            radii[i] = natural_neighbour_radius(points_of_interest[i], positions.data() + i * stride, num_neighbours[i], min_num_natural_neighbours_, buffers);
+        }
+    }
+}
 
 }// namespace pre
-}// namespace lamure
\ No newline at end of file
+}// namespace lamure
@@ -125,14 +125,21 @@ compute_avg_normal(shared_cluster_surfel_vector const &input_surfels) const
 
 void reduction_k_clustering:: //functionality taken from entropy reduction strategy
 assign_locally_overlapping_neighbours(shared_cluster_surfel current_surfel_ptr,
-                                      shared_cluster_surfel_vector &input_surfel_ptr_array) const
+                                      shared_cluster_surfel_vector &input_surfel_ptr_array,
+                                      neighbour_index const &input_index,
+                                      real const max_input_radius) const
 {
+    shared_surfel target_surfel = current_surfel_ptr->contained_surfel;
 
+    // surfels can only intersect if their centers are closer than the sum of their radii
+    std::vector<size_t> candidate_indices;
+    input_index.search_radius(target_surfel->pos(), target_surfel->radius() + max_input_radius, candidate_indices);
 
-    shared_cluster_surfel_vector neighbours_found;
-    shared_surfel target_surfel = current_surfel_ptr->contained_surfel;
+    // keep the order of the input array
+    std::sort(candidate_indices.begin(), candidate_indices.end());
 
-    for (auto const &input_sufrel_ptr : input_surfel_ptr_array) {
+    for (auto const candidate_idx : candidate_indices) {
+        auto const &input_sufrel_ptr = input_surfel_ptr_array[candidate_idx];
 
         // avoid overlaps with the surfel itself
         if (current_surfel_ptr->surfel_id != input_sufrel_ptr->surfel_id ||
@@ -141,13 +148,10 @@ assign_locally_overlapping_neighbours(shared_cluster_surfel current_surfel_ptr,
             shared_surfel contained_surfel_ptr = input_sufrel_ptr->contained_surfel;
 
             if (surfel::intersect(*target_surfel, *contained_surfel_ptr)) {
-                neighbours_found.push_back(input_sufrel_ptr);
+                current_surfel_ptr->neighbours.push_back(input_sufrel_ptr);
             }
         }
     }
-
-    current_surfel_ptr->neighbours.insert(current_surfel_ptr->neighbours.end(),
-                                          neighbours_found.begin(), neighbours_found.end());
 }
 
 void reduction_k_clustering::
@@ -491,9 +495,21 @@ create_lod(real &reduction_error,
         }
     }
 
+    //index positions once instead of testing every pair of surfels
+    std::vector<vec3r> cluster_surfel_positions;
+    cluster_surfel_positions.reserve(cluster_surfel_array.size());
+    real max_cluster_surfel_radius = 0.0;
+    for (auto const &target_surfel : cluster_surfel_array) {
+        cluster_surfel_positions.push_back(target_surfel->contained_surfel->pos());
+        max_cluster_surfel_radius = std::max(max_cluster_surfel_radius, target_surfel->contained_surfel->radius());
+    }
+
+    neighbour_index cluster_surfel_index;
+    cluster_surfel_index.build(cluster_surfel_positions);
+
     //define basic features for every cluster_surfel   
     for (auto const &target_surfel : cluster_surfel_array) {
-        assign_locally_overlapping_neighbours(target_surfel, cluster_surfel_array);
+        assign_locally_overlapping_neighbours(target_surfel, cluster_surfel_array, cluster_surfel_index, max_cluster_surfel_radius);
         compute_overlap(target_surfel, false);
         compute_deviation(target_surfel);
     }
@@ -10,7 +10,7 @@
 #include <lamure/pre/basic_algorithms.h>
 #include <lamure/utils.h>
 
-#include <queue>
+#include <algorithm>
 
 #if WIN32
   #include <ppl.h>
@@ -21,6 +21,49 @@
 namespace lamure {
 namespace pre {
 
+namespace {
+
+// flat index of the grid cell a surfel position (relative to the
+// bounding box minimum) falls into, cells are ordered x-major
+uint32_t cell_id(const vec3r& surfel_pos,
+                 const vec3r& cell_size,
+                 const vec3ui& grid_dimensions,
+                 const vec3b& locked_grid_dimensions)
+{
+    vec3ui index;
+
+    if (locked_grid_dimensions[0]) {
+        index[0] = 0;
+    } else {
+        index[0] = floor(surfel_pos[0]/cell_size[0]);
+    }
+
+    if (locked_grid_dimensions[1]) {
+        index[1] = 0;
+    } else {
+        index[1] = floor(surfel_pos[1]/cell_size[1]);
+    }
+
+    if (locked_grid_dimensions[2]) {
+        index[2] = 0;
+    } else {
+         index[2] = floor(surfel_pos[2]/cell_size[2]);
+    }
+
+    if ((index[0] != 0) && (index[0] == grid_dimensions[0]))
+        index[0] = grid_dimensions[0]-1;
+
+    if ((index[1] != 0) && (index[1] == grid_dimensions[1]))
+        index[1] = grid_dimensions[1]-1;
+
+    if ((index[2] != 0) && (index[2] == grid_dimensions[2]))
+        index[2] = grid_dimensions[2]-1;
+
+    return (index[0] * grid_dimensions[1] + index[1]) * grid_dimensions[2] + index[2];
+}
+
+}
+
 surfel reduction_normal_deviation_clustering::
 create_representative(const std::vector<surfel>& input)
 {
@@ -61,15 +104,14 @@ create_representative(const std::vector<surfel>& input)
 }
 
 std::pair<vec3ui, vec3b> reduction_normal_deviation_clustering::
-compute_grid_dimensions(const std::vector<surfel_mem_array*>& input,
-                        const bounding_box& bounding_box,
-                        const uint32_t surfels_per_node) const
+compute_grid_dimensions(const std::vector<vec3r>& positions,
+                        const vec3r& bb_dimensions,
+                        const uint32_t surfels_per_node,
+                        std::vector<uint8_t>& occupied_cells) const
 {
 
     uint16_t max_axis_ratio = 1000;
 
-    vec3r bb_dimensions = bounding_box.get_dimensions();
-
     // find axis relations
     // mark axes where every surfel has the same position as locked
     // sort bb_axes by size to make code readable
@@ -190,87 +232,24 @@ compute_grid_dimensions(const std::vector<surfel_mem_array*>& input,
                 break;
             }
 
-            // create grid
-            std::vector<std::vector<std::vector<bool>>> grid(grid_dimensions[0],
-                                                             std::vector<std::vector<bool>>(grid_dimensions[1], 
-                                                                                            std::vector<bool>(grid_dimensions[2])));
-
-            for (uint32_t i = 0; i < grid_dimensions[0]; ++i)
-            {
-                for (uint32_t j = 0; j < grid_dimensions[1]; ++j)
-                {
-                    for (uint32_t k = 0; k < grid_dimensions[2]; ++k)
-                    {
-                        grid[i][j][k] = false;
-                    }
-                }
-            }
+            // mark the occupied cells
+            occupied_cells.assign(grid_dimensions[0]*grid_dimensions[1]*grid_dimensions[2], 0);
 
-            // check which cell a surfel occupies
             vec3r cell_size = vec3r(fabs(bb_dimensions[0]/grid_dimensions[0]),
                                     fabs(bb_dimensions[1]/grid_dimensions[1]),
                                     fabs(bb_dimensions[2]/grid_dimensions[2]));
 
-            for (uint32_t i = 0; i < input.size(); ++i)
-            {
-                for (uint32_t j = 0; j < input[i]->length(); ++j)
-                {
-                    vec3r surfel_pos = input[i]->read_surfel_ref(j).pos() - bounding_box.min();
-                    if (surfel_pos.x < 0.f) surfel_pos.x = 0.f;
-                    if (surfel_pos.y < 0.f) surfel_pos.y = 0.f;
-                    if (surfel_pos.z < 0.f) surfel_pos.z = 0.f;
-
-                    vec3ui index;
-
-                    if (locked_grid_dimensions[0]) {
-                        index[0] = 0;
-                    } else {
-                        index[0] = floor(surfel_pos[0]/cell_size[0]);
-                    }
-
-                    if (locked_grid_dimensions[1]) {
-                        index[1] = 0;
-                    } else {
-                        index[1] = floor(surfel_pos[1]/cell_size[1]);
-                    }
-
-                    if (locked_grid_dimensions[2]) {
-                        index[2] = 0;
-                    } else {
-                         index[2] = floor(surfel_pos[2]/cell_size[2]);
-                    }
-
-                    if ((index[0] != 0) && (index[0] == grid_dimensions[0]))
-                        index[0] = grid_dimensions[0]-1;
-
-                    if ((index[1] != 0) && (index[1] == grid_dimensions[1]))
-                        index[1] = grid_dimensions[1]-1;
-
-                    if ((index[2] != 0) && (index[2] == grid_dimensions[2]))
-                        index[2] = grid_dimensions[2]-1;
+            uint32_t occupied_cells_count = 0;
 
-                    grid[index[0]][index[1]][index[2]] = true;
-
-                }
-            }
-
-            // count occupied cells
-            uint32_t occupied_cells = 0;
-
-            for (uint32_t i = 0; i < grid_dimensions[0]; ++i)
+            for (const auto& surfel_pos : positions)
             {
-                for (uint32_t j = 0; j < grid_dimensions[1]; ++j)
-                {
-                    for (uint32_t k = 0; k < grid_dimensions[2]; ++k)
-                    {
-                        if (grid[i][j][k])
-                            ++occupied_cells;
-                    }
-                }
+                uint8_t& cell = occupied_cells[cell_id(surfel_pos, cell_size, grid_dimensions, locked_grid_dimensions)];
+                occupied_cells_count += 1 - cell;
+                cell = 1;
             }
 
             // check if finished
-            if ((occupied_cells > surfels_per_node) || (grid_dimensions[0]*grid_dimensions[1]*grid_dimensions[2] > 100000))  {
+            if ((occupied_cells_count > surfels_per_node) || (grid_dimensions[0]*grid_dimensions[1]*grid_dimensions[2] > 100000))  {
 
                 if (grid_dimensions[0] != 1)
                     grid_dimensions[0] = grid_dimensions[0]-1;
@@ -323,94 +302,78 @@ create_lod(real& reduction_error,
 
     vec3r bb_dimensions = bbox.get_dimensions();
 
-    // compute grid dimensions
-    std::pair<vec3ui, vec3b> grid_data = compute_grid_dimensions(input, bbox, surfels_per_node);
-    vec3ui grid_dimensions = grid_data.first;
-    vec3b locked_grid_dimensions = grid_data.second;
-
-    // create grid
-    std::vector<std::vector<std::vector<std::list<surfel>*>>> grid(grid_dimensions[0],std::vector<std::vector<std::list<surfel>*>>(grid_dimensions[1], std::vector<std::list<surfel>*>(grid_dimensions[2])));
+    static thread_local scratch_space scratch;
 
-    for (uint32_t i = 0; i < grid_dimensions[0]; ++i)
+    // surfel positions relative to the bounding box
+    scratch.positions.clear();
+    for (const auto& child_surfels : input)
     {
-        for (uint32_t j = 0; j < grid_dimensions[1]; ++j)
+        for (uint32_t j = 0; j < child_surfels->length(); ++j)
         {
-            for (uint32_t k = 0; k < grid_dimensions[2]; ++k)
-            {
-                grid[i][j][k] = new std::list<surfel>;
-            }
-        }
-    }
-
-    // sort surfels into grid
-    vec3r cell_size = vec3r(fabs(bb_dimensions[0]/grid_dimensions[0]),fabs(bb_dimensions[1]/grid_dimensions[1]),fabs(bb_dimensions[2]/grid_dimensions[2]));
-
-    for (uint32_t i = 0; i < input.size(); ++i)
-    {
-        for (uint32_t j = 0; j < input[i]->length(); ++j)
-        {
-            vec3r surfel_pos =  input[i]->read_surfel_ref(j).pos() - bbox.min();
+            vec3r surfel_pos = child_surfels->read_surfel_ref(j).pos() - bbox.min();
             if (surfel_pos.x < 0.f) surfel_pos.x = 0.f;
             if (surfel_pos.y < 0.f) surfel_pos.y = 0.f;
             if (surfel_pos.z < 0.f) surfel_pos.z = 0.f;
+            scratch.positions.push_back(surfel_pos);
+        }
+    }
 
-            vec3ui index;
-
-            if (locked_grid_dimensions[0]) {
-                index[0] = 0;
-            } else {
-                index[0] = floor(surfel_pos[0]/cell_size[0]);
-            }
-
-            if (locked_grid_dimensions[1]) {
-                index[1] = 0;
-            } else {
-                index[1] = floor(surfel_pos[1]/cell_size[1]);
-            }
-
-            if (locked_grid_dimensions[2]) {
-                index[2] = 0;
-            } else {
-                 index[2] = floor(surfel_pos[2]/cell_size[2]);
-            }
+    // compute grid dimensions
+    std::pair<vec3ui, vec3b> grid_data = compute_grid_dimensions(scratch.positions, bb_dimensions, surfels_per_node, scratch.occupied_cells);
+    vec3ui grid_dimensions = grid_data.first;
+    vec3b locked_grid_dimensions = grid_data.second;
 
-            if ((index[0] != 0) && (index[0] == grid_dimensions[0]))
-                index[0] = grid_dimensions[0]-1;
+    // sort surfels into grid: counting sort by cell, which keeps the input
+    // order within each cell
+    vec3r cell_size = vec3r(fabs(bb_dimensions[0]/grid_dimensions[0]),fabs(bb_dimensions[1]/grid_dimensions[1]),fabs(bb_dimensions[2]/grid_dimensions[2]));
+    const uint32_t num_cells = grid_dimensions[0]*grid_dimensions[1]*grid_dimensions[2];
 
-            if ((index[1] != 0) && (index[1] == grid_dimensions[1]))
-                index[1] = grid_dimensions[1]-1;
+    scratch.cell_ids.resize(scratch.positions.size());
+    scratch.cell_offsets.assign(num_cells + 1, 0);
 
-            if ((index[2] != 0) && (index[2] == grid_dimensions[2]))
-                index[2] = grid_dimensions[2]-1;
+    for (size_t i = 0; i < scratch.positions.size(); ++i)
+    {
+        scratch.cell_ids[i] = cell_id(scratch.positions[i], cell_size, grid_dimensions, locked_grid_dimensions);
+        ++scratch.cell_offsets[scratch.cell_ids[i] + 1];
+    }
 
-            grid[index[0]][index[1]][index[2]]->push_back(input[i]->read_surfel_ref(j));
+    for (uint32_t cell = 0; cell < num_cells; ++cell)
+    {
+        scratch.cell_offsets[cell + 1] += scratch.cell_offsets[cell];
+    }
 
+    scratch.surfels.resize(scratch.positions.size());
+    size_t surfel_index = 0;
+    for (const auto& child_surfels : input)
+    {
+        for (uint32_t j = 0; j < child_surfels->length(); ++j)
+        {
+            scratch.surfels[scratch.cell_offsets[scratch.cell_ids[surfel_index++]]++] = child_surfels->read_surfel_ref(j);
         }
     }
 
+    // move grid cells into priority queue, the offsets point to the cell ends now
 
-    // move grid cells into priority queue
-
-    std::priority_queue<surfel_cluster_with_error, std::vector<surfel_cluster_with_error>, order_by_size> cell_pq;
+    auto& cell_pq = scratch.clusters;
+    cell_pq.clear();
     uint32_t surfel_count = 0;
 
-    for (uint32_t i = 0; i < grid_dimensions[0]; ++i)
+    for (uint32_t cell = 0; cell < num_cells; ++cell)
     {
-        for (uint32_t j = 0; j < grid_dimensions[1]; ++j)
-        {
-            for (uint32_t k = 0; k < grid_dimensions[2]; ++k)
-            {
-                cell_pq.push({grid[i][j][k], 0.1f});
-                surfel_count += grid[i][j][k]->size();
-                grid[i][j][k] = 0;
-            }
-        }
+        const uint32_t cell_begin = cell == 0 ? 0 : scratch.cell_offsets[cell - 1];
+        const uint32_t cell_size = scratch.cell_offsets[cell] - cell_begin;
+        cell_pq.push_back({cell_begin, cell_size, 0.1f});
+        std::push_heap(cell_pq.begin(), cell_pq.end(), order_by_size());
+        surfel_count += cell_size;
     }
 
     size_t termination_ctr = 0;
 
     // merge surfels
 
+    auto& surfels_to_merge = scratch.surfels_to_merge;
+    auto& output_cluster = scratch.output_cluster;
+
     while (surfel_count > surfels_per_node)
     {
         // safety check
@@ -420,41 +383,31 @@ create_lod(real& reduction_error,
             break;
         }
 
-        std::list<surfel>* input_cluster = cell_pq.top().cluster;
-        float merge_treshold = cell_pq.top().merge_treshold;
-        cell_pq.pop();
+        std::pop_heap(cell_pq.begin(), cell_pq.end(), order_by_size());
+        surfel_cluster_with_error input_cluster = cell_pq.back();
+        cell_pq.pop_back();
+        float merge_treshold = input_cluster.merge_treshold;
 
-        uint32_t input_cluster_size = input_cluster->size();
+        uint32_t input_cluster_size = input_cluster.size;
         surfel_count -= input_cluster_size;
         bool early_termination = false;
 
-        real min_radius = input_cluster->begin()->radius();
-        real max_radius = input_cluster->begin()->radius();
-
-        auto start = input_cluster->begin();
-        std::advance(start, 1);
+        output_cluster.clear();
 
-        for (auto surfel = start; surfel != input_cluster->end(); ++surfel) {
-            if (surfel->radius() < min_radius)
-                min_radius = surfel->radius();
-            else if (surfel->radius() > max_radius)
-                max_radius = surfel->radius();
-        }
+        // the surfels not merged yet are compacted to [front, back)
+        surfel* front = scratch.surfels.data() + input_cluster.begin;
+        surfel* back = front + input_cluster.size;
 
-        //real radius_range = max_radius - min_radius;
-
-        std::list<surfel>* output_cluster = new std::list<surfel>;
-
-        while(input_cluster->size() != 0)
+        while(front != back)
         {
+            surfels_to_merge.clear();
+            surfels_to_merge.push_back(*front);
+            ++front;
 
-            std::vector<surfel> surfels_to_merge;
-            surfels_to_merge.push_back(input_cluster->front());
-            input_cluster->pop_front();
-
-            std::list<surfel>::iterator surfel_to_compare = input_cluster->begin();
+            surfel* kept = front;
+            surfel* surfel_to_compare = front;
 
-            while(surfel_to_compare != input_cluster->end())
+            while(surfel_to_compare != back)
             {
                 // angle
                 vec3f normal1 = surfels_to_merge.front().normal();
@@ -476,28 +429,6 @@ create_lod(real& reduction_error,
                 float angle = acos(dot_product);
                 float angle_normalized = angle/(0.5*M_PI);
 
-                // color difference
-                /*
-                auto color1 = surfels_to_merge.front().color();
-                auto color2 = (*surfel_to_compare).color();
-
-                float color1_normalized = (color1[0] + color1[1] + color1[2])/255*3.0;
-                float color2_normalized = (color2[0] + color2[1] + color2[2])/255*3.0;
-
-                float color_difference_normalized = std::abs(color1_normalized - color2_normalized);
-                */
-
-                // radius
-                /*
-                real radius1 = surfels_to_merge.front().radius();
-                real radius2 = (*surfel_to_compare).radius();
-
-                real radius_weight_normalized = 0;
-
-                if (radius_range != 0)
-                    radius_weight_normalized = ((radius1 - min_radius) + (radius2 - min_radius)) / (2.0*radius_range);
-                */
-
                 if(angle_normalized <= merge_treshold)
                 {
                     if (flip_normal) {
@@ -505,52 +436,55 @@ create_lod(real& reduction_error,
                     }
 
                     surfels_to_merge.push_back(*surfel_to_compare);
-                    surfel_to_compare = input_cluster->erase(surfel_to_compare);
+                    ++surfel_to_compare;
 
-                    if (( surfel_count + input_cluster->size() + output_cluster->size() + 1) <= surfels_per_node) {
+                    size_t remaining = (kept - front) + (back - surfel_to_compare);
+                    if (( surfel_count + remaining + output_cluster.size() + 1) <= surfels_per_node) {
                         early_termination = true;
                         break;
                     }
 
                 } else {
-                    std::advance(surfel_to_compare,1);
+                    *kept++ = *surfel_to_compare++;
                 }
             }
-            output_cluster->push_back(create_representative(surfels_to_merge));
+            output_cluster.push_back(create_representative(surfels_to_merge));
 
             if (early_termination) {
-                output_cluster->insert(output_cluster->end(), input_cluster->begin(), input_cluster->end());
+                output_cluster.insert(output_cluster.end(), front, kept);
+                output_cluster.insert(output_cluster.end(), surfel_to_compare, back);
                 break;
             }
 
+            back = kept;
         }
 
-        surfel_count += output_cluster->size();
+        surfel_count += output_cluster.size();
 
-        if (input_cluster_size == output_cluster->size()) {
+        if (input_cluster_size == output_cluster.size()) {
             merge_treshold += 0.1;
 
         }
 
-        delete input_cluster;
-        input_cluster = output_cluster;
-        cell_pq.push({input_cluster, merge_treshold});
+        // the merged cluster is never larger, so it replaces the input in place
+        std::copy(output_cluster.begin(), output_cluster.end(), scratch.surfels.begin() + input_cluster.begin);
+        cell_pq.push_back({input_cluster.begin, uint32_t(output_cluster.size()), merge_treshold});
+        std::push_heap(cell_pq.begin(), cell_pq.end(), order_by_size());
 
     }
 
     surfel_mem_array mem_array(std::make_shared<surfel_vector>(surfel_vector()), 0, 0);
+    mem_array.surfel_mem_data()->reserve(surfel_count);
 
     while (!cell_pq.empty())
     {
-        std::list<surfel>* cluster = cell_pq.top().cluster;
-        cell_pq.pop();
-
-        for(std::list<surfel>::iterator surfel = cluster->begin(); surfel != cluster->end(); ++surfel)
-        {
-            mem_array.surfel_mem_data()->push_back(*surfel);
-        }
+        std::pop_heap(cell_pq.begin(), cell_pq.end(), order_by_size());
+        const surfel_cluster_with_error& cluster = cell_pq.back();
 
-        delete cluster;
+        mem_array.surfel_mem_data()->insert(mem_array.surfel_mem_data()->end(),
+                                            scratch.surfels.begin() + cluster.begin,
+                                            scratch.surfels.begin() + cluster.begin + cluster.size);
+        cell_pq.pop_back();
     }
 
     mem_array.set_length(mem_array.surfel_mem_data()->size());
@@ -96,9 +96,11 @@ read_all() const
         exit(1);
     }
 
-    std::vector<surfel> data(length_);
-    surfel_file_->read(&data, 0, offset_, length_);
-    return std::make_shared<std::vector<surfel>>(data);
+    // read straight into the shared vector, a temporary copy would double
+    // the peak memory when loading large out-of-core nodes
+    auto data = std::make_shared<std::vector<surfel>>(length_);
+    surfel_file_->read(data.get(), 0, offset_, length_);
+    return data;
 }
 
 std::shared_ptr<std::vector<prov_data>> surfel_disk_array::
@@ -109,9 +111,9 @@ read_all_prov() const
         exit(1);
     }
 
-    std::vector<prov_data> data(length_);
-    prov_file_->read(&data, 0, offset_, length_);
-    return std::make_shared<std::vector<prov_data>>(data);
+    auto data = std::make_shared<std::vector<prov_data>>(length_);
+    prov_file_->read(data.get(), 0, offset_, length_);
+    return data;
 }
 
 
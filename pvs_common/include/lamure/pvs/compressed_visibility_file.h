@@ -0,0 +1,75 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group 
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#ifndef LAMURE_PVS_COMPRESSED_VISIBILITY_FILE_H
+#define LAMURE_PVS_COMPRESSED_VISIBILITY_FILE_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <lamure/pvs/pvs.h>
+#include <lamure/types.h>
+#include "lamure/pvs/view_cell.h"
+
+#include <boost/iostreams/device/mapped_file.hpp>
+
+namespace lamure
+{
+namespace pvs
+{
+
+// Read access to the visibility files written by the compressed grids.
+// The file starts with one 64 bit block size per view cell, followed by one gzip block per view cell.
+// Each block holds one bit per node, models stored one after another and padded to full bytes.
+class PVS_COMMON_DLL compressed_visibility_file
+{
+public:
+	compressed_visibility_file();
+	~compressed_visibility_file();
+
+	compressed_visibility_file(const compressed_visibility_file&) = delete;
+	compressed_visibility_file& operator=(const compressed_visibility_file&) = delete;
+
+	// If memory mapped, blocks stay in the file and are only touched once a cell is decoded.
+	// Otherwise all compressed blocks are read into memory at once.
+	bool open(const std::string& file_path, const size_t& num_cells, const bool& memory_mapped);
+	void close();
+
+	bool is_open() const;
+	bool is_memory_mapped() const;
+	const std::string& get_file_path() const;
+
+	// Maps a cell index of the grid to its view cell.
+	typedef std::function<view_cell*(const size_t&)> cell_accessor;
+
+	// Reads the whole file and decodes all cells in parallel. The file is closed afterwards.
+	bool load_all_cells(const std::string& file_path, const size_t& num_cells, const std::vector<node_t>& ids, const cell_accessor& get_cell);
+
+	// Decodes a single cell. The file is mapped on first access and stays open for further cells.
+	bool load_cell(const std::string& file_path, const size_t& num_cells, const size_t& cell_index, const std::vector<node_t>& ids, view_cell* cell);
+
+private:
+	// Decompresses the block of a single cell straight into the visibility bitsets of the cell.
+	// Safe to call concurrently for different cells.
+	bool decode_cell(const size_t& cell_index, const std::vector<node_t>& ids, view_cell* cell) const;
+
+	std::string file_path_;
+	bool is_memory_mapped_;
+
+	// Offsets of the blocks relative to the first block, one additional entry marks the end of the last block.
+	std::vector<uint64_t> block_offsets_;
+
+	std::vector<char> block_data_;
+	boost::iostreams::mapped_file_source mapped_file_;
+	const char* blocks_;
+};
+
+}
+}
+
+#endif
@@ -10,6 +10,7 @@
 
 #include <lamure/pvs/pvs.h>
 #include "lamure/pvs/grid_irregular.h"
+#include "lamure/pvs/compressed_visibility_file.h"
 
 namespace lamure
 {
@@ -35,7 +36,7 @@ public:
 	virtual bool load_cell_visibility_from_file(const std::string& file_path, const size_t& cell_index);
 
 protected:
-	std::vector<uint64_t> visibility_block_sizes_;
+	compressed_visibility_file visibility_file_;
 };
 
 }
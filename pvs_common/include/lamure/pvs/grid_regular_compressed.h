@@ -10,6 +10,7 @@
 
 #include <lamure/pvs/pvs.h>
 #include "lamure/pvs/grid_regular.h"
+#include "lamure/pvs/compressed_visibility_file.h"
 
 namespace lamure
 {
@@ -37,7 +38,7 @@ public:
 protected:
 	void create_grid(const size_t& num_cells, const double& cell_size, const scm::math::vec3d& position_center);
 
-	std::vector<uint64_t> visibility_block_sizes_;
+	compressed_visibility_file visibility_file_;
 };
 
 }
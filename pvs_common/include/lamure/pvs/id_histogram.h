@@ -32,7 +32,14 @@ public:
 	std::map<model_t, std::map<node_t, size_t>> get_histogram() const;
 
 private:
-	std::map<model_t, std::map<node_t, size_t>> histogram_;			// first key is model ID, second key is node ID, final value is amount of visible pixels
+	// Visible pixels per ID, sorted by ID. The ID holds the model ID in the upper 8 bits and the node ID in the lower 24 bits.
+	typedef std::pair<uint32_t, size_t> id_count;
+
+	static void collect_runs(const uint32_t* pixels, const size_t& numPixels, std::vector<id_count>& runs);
+	static void sort_and_combine(std::vector<id_count>& counts, std::vector<id_count>& buffer);
+	static void merge(const std::vector<id_count>& left, const std::vector<id_count>& right, std::vector<id_count>& result);
+
+	std::vector<id_count> counts_;
 };
 
 }
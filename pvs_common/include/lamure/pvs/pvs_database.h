@@ -45,6 +45,11 @@ public:
 	void activate(const bool& act);
 	bool is_activated() const;
 
+	// If set, only the view cell the viewer enters is loaded instead of its whole neighbourhood.
+	// Meant for compressed grids, which keep the visibility file mapped and decode single cells on demand.
+	void set_load_viewer_cell_only(const bool& viewer_cell_only);
+	bool is_loading_viewer_cell_only() const;
+
 	const grid* get_visibility_grid() const;
 	const grid* get_bounding_grid() const;
 	void clear_visibility_grid();
@@ -76,6 +81,7 @@ private:
 	// If true, the complete visibility data will be loaded on initialization.
 	// If false, visibilibity of view cells will be loaded depending on the necessity to do so (e.g. if the user enters a view cell).
 	bool do_preload_;
+	bool load_viewer_cell_only_;
 	bool shutdown_;
 	std::string pvs_file_path_;
 
@@ -46,6 +46,7 @@ public:
 
 	virtual boost::dynamic_bitset<> get_bitset(const model_t& object_id) const;
 	virtual void set_bitset(const model_t& object_id, const boost::dynamic_bitset<>& bitset);
+	void set_bitset(const model_t& object_id, boost::dynamic_bitset<>&& bitset);
 
 private:
 	double cell_size_;
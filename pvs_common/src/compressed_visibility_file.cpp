@@ -0,0 +1,279 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group 
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#include "lamure/pvs/compressed_visibility_file.h"
+#include "lamure/pvs/view_cell_regular.h"
+
+#include <algorithm>
+#include <fstream>
+#include <climits>
+#include <utility>
+
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+
+namespace lamure
+{
+namespace pvs
+{
+
+compressed_visibility_file::
+compressed_visibility_file()
+{
+	is_memory_mapped_ = false;
+	blocks_ = nullptr;
+}
+
+compressed_visibility_file::
+~compressed_visibility_file()
+{
+	close();
+}
+
+bool compressed_visibility_file::
+open(const std::string& file_path, const size_t& num_cells, const bool& memory_mapped)
+{
+	close();
+
+	std::fstream file_in;
+	file_in.open(file_path, std::ios::in | std::ios::binary);
+
+	if(!file_in.is_open())
+	{
+		return false;
+	}
+
+	// Read access points to data blocks.
+	std::vector<uint64_t> block_sizes(num_cells);
+	file_in.read(reinterpret_cast<char*>(block_sizes.data()), num_cells * sizeof(uint64_t));
+
+	if(!file_in)
+	{
+		return false;
+	}
+
+	block_offsets_.resize(num_cells + 1);
+	block_offsets_[0] = 0;
+
+	for(size_t cell_index = 0; cell_index < num_cells; ++cell_index)
+	{
+		block_offsets_[cell_index + 1] = block_offsets_[cell_index] + block_sizes[cell_index];
+	}
+
+	const size_t header_size = num_cells * sizeof(uint64_t);
+
+	if(memory_mapped)
+	{
+		file_in.close();
+
+		if(block_offsets_[num_cells] == 0)
+		{
+			// Nothing to map.
+			blocks_ = nullptr;
+		}
+		else
+		{
+			try
+			{
+				mapped_file_.open(file_path);
+			}
+			catch(const std::exception&)
+			{
+				block_offsets_.clear();
+				return false;
+			}
+
+			if(!mapped_file_.is_open() || mapped_file_.size() < header_size + block_offsets_[num_cells])
+			{
+				close();
+				return false;
+			}
+
+			blocks_ = mapped_file_.data() + header_size;
+		}
+	}
+	else
+	{
+		// Read all compressed data blocks with a single read.
+		block_data_.resize(block_offsets_[num_cells]);
+		file_in.read(block_data_.data(), block_data_.size());
+
+		if(!file_in)
+		{
+			close();
+			return false;
+		}
+
+		file_in.close();
+		blocks_ = block_data_.data();
+	}
+
+	file_path_ = file_path;
+	is_memory_mapped_ = memory_mapped;
+	return true;
+}
+
+void compressed_visibility_file::
+close()
+{
+	if(mapped_file_.is_open())
+	{
+		mapped_file_.close();
+	}
+
+	std::vector<char>().swap(block_data_);
+	block_offsets_.clear();
+	blocks_ = nullptr;
+
+	file_path_ = "";
+	is_memory_mapped_ = false;
+}
+
+bool compressed_visibility_file::
+is_open() const
+{
+	return block_offsets_.size() > 0;
+}
+
+bool compressed_visibility_file::
+is_memory_mapped() const
+{
+	return is_memory_mapped_;
+}
+
+const std::string& compressed_visibility_file::
+get_file_path() const
+{
+	return file_path_;
+}
+
+bool compressed_visibility_file::
+decode_cell(const size_t& cell_index, const std::vector<node_t>& ids, view_cell* cell) const
+{
+	typedef boost::dynamic_bitset<>::block_type block_type;
+	const size_t bytes_per_block = sizeof(block_type);
+
+	if(cell_index + 1 >= block_offsets_.size())
+	{
+		return false;
+	}
+
+	// Size of the uncompressed data is known from the number of nodes per model.
+	size_t cell_data_size = 0;
+	for(model_t model_index = 0; model_index < ids.size(); ++model_index)
+	{
+		cell_data_size += ids[model_index] / CHAR_BIT + (ids[model_index] % CHAR_BIT == 0 ? 0 : 1);
+	}
+
+	// Decompress.
+	std::vector<char> cell_data(cell_data_size);
+	{
+		const char* block_begin = blocks_ + block_offsets_[cell_index];
+		const size_t block_size = block_offsets_[cell_index + 1] - block_offsets_[cell_index];
+
+		boost::iostreams::filtering_istream stream_uncompressed;
+		stream_uncompressed.push(boost::iostreams::gzip_decompressor());
+		stream_uncompressed.push(boost::iostreams::array_source(block_begin, block_size));
+		stream_uncompressed.read(cell_data.data(), cell_data_size);
+
+		if((size_t)stream_uncompressed.gcount() != cell_data_size)
+		{
+			return false;
+		}
+	}
+
+	view_cell_regular* regular_cell = dynamic_cast<view_cell_regular*>(cell);
+
+	// Apply visibility data. The bytes of a line are assembled into bitset blocks a word at a time.
+	size_t line_offset = 0;
+
+	for(model_t model_index = 0; model_index < ids.size(); ++model_index)
+	{
+		node_t num_nodes = ids[model_index];
+		size_t line_length = num_nodes / CHAR_BIT + (num_nodes % CHAR_BIT == 0 ? 0 : 1);
+		const unsigned char* line_data = reinterpret_cast<const unsigned char*>(cell_data.data() + line_offset);
+
+		std::vector<block_type> blocks((line_length + bytes_per_block - 1) / bytes_per_block, 0);
+
+		for(size_t block_index = 0; block_index < blocks.size(); ++block_index)
+		{
+			size_t first_byte = block_index * bytes_per_block;
+			size_t num_bytes = std::min(bytes_per_block, line_length - first_byte);
+
+			block_type current_block = 0;
+			for(size_t byte_index = 0; byte_index < num_bytes; ++byte_index)
+			{
+				current_block |= block_type(line_data[first_byte + byte_index]) << (CHAR_BIT * byte_index);
+			}
+
+			blocks[block_index] = current_block;
+		}
+
+		boost::dynamic_bitset<> node_visibility(blocks.begin(), blocks.end());
+		node_visibility.resize(num_nodes);
+
+		if(regular_cell != nullptr)
+		{
+			regular_cell->set_bitset(model_index, std::move(node_visibility));
+		}
+		else
+		{
+			// Used to avoid continuing resize within visibility data.
+			cell->set_visibility(model_index, num_nodes - 1, false);
+
+			for(size_t node_index = node_visibility.find_first(); node_index != boost::dynamic_bitset<>::npos; node_index = node_visibility.find_next(node_index))
+			{
+				cell->set_visibility(model_index, node_index, true);
+			}
+		}
+
+		line_offset += line_length;
+	}
+
+	return true;
+}
+
+bool compressed_visibility_file::
+load_all_cells(const std::string& file_path, const size_t& num_cells, const std::vector<node_t>& ids, const cell_accessor& get_cell)
+{
+	if(!open(file_path, num_cells, false))
+	{
+		return false;
+	}
+
+	// Blocks are decompressed in parallel, straight into the bitsets of the view cells.
+	bool success = true;
+
+	#pragma omp parallel for schedule(dynamic) reduction(&&:success)
+	for(int64_t cell_index = 0; cell_index < (int64_t)num_cells; ++cell_index)
+	{
+		success = decode_cell(cell_index, ids, get_cell(cell_index)) && success;
+	}
+
+	// Everything is decoded, so the compressed blocks are not required anymore.
+	close();
+	return success;
+}
+
+bool compressed_visibility_file::
+load_cell(const std::string& file_path, const size_t& num_cells, const size_t& cell_index, const std::vector<node_t>& ids, view_cell* cell)
+{
+	// Only the block of the requested cell is touched, the rest of the file stays on disk.
+	if(!is_memory_mapped() || get_file_path() != file_path)
+	{
+		if(!open(file_path, num_cells, true))
+		{
+			return false;
+		}
+	}
+
+	return decode_cell(cell_index, ids, cell);
+}
+
+}
+}
@@ -145,78 +145,7 @@ load_visibility_from_file(const std::string& file_path)
 {
 	std::lock_guard<std::mutex> lock(mutex_);
 
-	std::fstream file_in;
-	file_in.open(file_path, std::ios::in | std::ios::binary);
-
-	if(!file_in.is_open())
-	{
-		return false;
-	}
-
-	// Read access points to data blocks.
-	visibility_block_sizes_.clear();
-
-	for(size_t current_block_index = 0; current_block_index < this->get_cell_count(); ++current_block_index)
-	{
-		uint64_t block_size;
-		file_in.read(reinterpret_cast<char*>(&block_size), sizeof(block_size));
-		visibility_block_sizes_.push_back(block_size);
-	}
-
-	// Read compressed data blocks.
-	std::vector<std::string> compressed_data_blocks;
-
-	for(size_t current_block_index = 0; current_block_index < this->get_cell_count(); ++current_block_index)
-	{
-		size_t block_size = visibility_block_sizes_[current_block_index];
-
-    std::vector<char> current_block_data(block_size);
-		file_in.read(&current_block_data[0], block_size);
-
-		std::string current_block(&current_block_data[0], block_size);
-		compressed_data_blocks.push_back(current_block);
-	}
-
-	for(size_t cell_index = 0; cell_index < cells_by_indices_.size(); ++cell_index)
-	{
-		view_cell* current_cell = cells_by_indices_[cell_index];
-
-		// Decompress.
-		std::stringstream stream_uncompressed, stream_compressed;
-		stream_compressed << compressed_data_blocks[cell_index];
-
-		boost::iostreams::filtering_streambuf<boost::iostreams::input> inbuf;
-		inbuf.push(boost::iostreams::gzip_decompressor());
-		inbuf.push(stream_compressed);
-		boost::iostreams::copy(inbuf, stream_uncompressed);
-
-		// Apply visibility data.
-		for(model_t model_index = 0; model_index < ids_.size(); ++model_index)
-		{
-			node_t num_nodes = ids_.at(model_index);
-			size_t line_length = num_nodes / CHAR_BIT + (num_nodes % CHAR_BIT == 0 ? 0 : 1);
-			std::vector<char> current_line_data(line_length);
-
-			stream_uncompressed.read(&current_line_data[0], line_length);
-
-			// Used to avoid continuing resize within visibility data.
-			current_cell->set_visibility(model_index, num_nodes - 1, false);
-
-			for(node_t character_index = 0; character_index < line_length; ++character_index)
-			{
-				char current_byte = current_line_data[character_index];
-				
-				for(unsigned short bit_index = 0; bit_index < CHAR_BIT; ++bit_index)
-				{
-					bool visible = ((current_byte >> bit_index) & 1) == 0x01;
-					current_cell->set_visibility(model_index, (character_index * CHAR_BIT) + bit_index, visible);
-				}
-			}
-		}
-	}
-
-	file_in.close();
-	return true;
+	return visibility_file_.load_all_cells(file_path, cells_by_indices_.size(), ids_, [this](const size_t& cell_index) -> view_cell* { return cells_by_indices_[cell_index]; });
 }
 
 bool grid_irregular_compressed::
@@ -232,76 +161,7 @@ load_cell_visibility_from_file(const std::string& file_path, const size_t& cell_
 		return true;
 	}
 
-	// If no visibility data exists, open the file and load them.
-	std::fstream file_in;
-	file_in.open(file_path, std::ios::in | std::ios::binary);
-
-	if(!file_in.is_open())
-	{
-		return false;
-	}
-
-	if(visibility_block_sizes_.size() == 0)
-	{
-		// Read access points to data blocks.
-		for(size_t current_block_index = 0; current_block_index < this->get_cell_count(); ++current_block_index)
-		{
-			uint64_t block_size;
-			file_in.read(reinterpret_cast<char*>(&block_size), sizeof(block_size));
-			visibility_block_sizes_.push_back(block_size);
-		}
-	}
-
-	// Read compressed data block.
-	size_t block_size = visibility_block_sizes_[cell_index];
-  std::vector<char> current_block_data(block_size);
-
-	// Find proper position in file. First data is compresses block sizes (one 64 bit integer per view cell).
-	size_t file_position = visibility_block_sizes_.size() * sizeof(uint64_t);
-	for(size_t visibility_cell_index = 0; visibility_cell_index < cell_index; ++visibility_cell_index)
-	{
-		file_position += visibility_block_sizes_[visibility_cell_index];
-	}
-
-	file_in.seekg(file_position);
-	file_in.read(&current_block_data[0], block_size);
-	std::string compressed_data_block(&current_block_data[0], block_size);
-
-	// Decompress.
-	std::stringstream stream_uncompressed, stream_compressed;
-	stream_compressed << compressed_data_block;
-
-	boost::iostreams::filtering_streambuf<boost::iostreams::input> inbuf;
-	inbuf.push(boost::iostreams::gzip_decompressor());
-	inbuf.push(stream_compressed);
-	boost::iostreams::copy(inbuf, stream_uncompressed);
-
-	// Apply visibility data.
-	for(model_t model_index = 0; model_index < ids_.size(); ++model_index)
-	{
-		node_t num_nodes = ids_.at(model_index);
-		size_t line_length = num_nodes / CHAR_BIT + (num_nodes % CHAR_BIT == 0 ? 0 : 1);
-    std::vector<char> current_line_data(line_length);
-
-		stream_uncompressed.read(&current_line_data[0], line_length);
-
-		// Used to avoid continuing resize within visibility data.
-		current_cell->set_visibility(model_index, num_nodes - 1, false);
-
-		for(node_t character_index = 0; character_index < line_length; ++character_index)
-		{
-			char current_byte = current_line_data[character_index];
-			
-			for(unsigned short bit_index = 0; bit_index < CHAR_BIT; ++bit_index)
-			{
-				bool visible = ((current_byte >> bit_index) & 1) == 0x01;
-				current_cell->set_visibility(model_index, (character_index * CHAR_BIT) + bit_index, visible);
-			}
-		}
-	}
-
-	file_in.close();
-	return true;
+	return visibility_file_.load_cell(file_path, cells_by_indices_.size(), cell_index, ids_, current_cell);
 }
 
 }
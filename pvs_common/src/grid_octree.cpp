@@ -613,13 +613,13 @@ load_cell_visibility_from_file(const std::string& file_path, const size_t& cell_
 void grid_octree::
 clear_cell_visibility(const size_t& cell_index)
 {
-	if(this->get_num_models() <= cell_index)
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	if(cells_by_indices_.size() <= cell_index)
 	{
 		return;
 	}
 
-	std::lock_guard<std::mutex> lock(mutex_);
-
 	cells_by_indices_[cell_index]->clear_visibility_data();
 }
 
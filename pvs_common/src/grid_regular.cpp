@@ -354,13 +354,13 @@ load_visibility_from_file(const std::string& file_path)
 void grid_regular::
 clear_cell_visibility(const size_t& cell_index)
 {
-	if(this->get_num_models() <= cell_index)
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	if(cells_.size() <= cell_index)
 	{
 		return;
 	}
 
-	std::lock_guard<std::mutex> lock(mutex_);
-
 	cells_[cell_index]->clear_visibility_data();
 }
 
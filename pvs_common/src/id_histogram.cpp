@@ -9,6 +9,7 @@
 #include <iostream>
 #include <fstream>
 #include <bitset>
+#include <algorithm>
 
 namespace lamure
 {
@@ -23,25 +24,207 @@ id_histogram::~id_histogram()
 {
 }
 
+namespace
+{
+
+// Pixels with model ID 255 (alpha 0) do not show any node.
+const uint32_t background_id = 0xFF000000;
+
+// Pixels are handled in independent chunks which are merged afterwards.
+const size_t pixels_per_chunk = 1 << 16;
+
+}
+
 void id_histogram::
 create(const void* pixelData, const size_t& numPixels)
 {
-	histogram_.clear();
-	const unsigned int* pixelDataInt = (unsigned int*)pixelData;
+	counts_.clear();
+	const uint32_t* pixelDataInt = (const uint32_t*)pixelData;
+
+	const int num_chunks = (int)((numPixels + pixels_per_chunk - 1) / pixels_per_chunk);
+	if(num_chunks == 0)
+	{
+		return;
+	}
+
+	std::vector<std::vector<id_count>> chunk_counts(num_chunks);
+
+	#pragma omp parallel for schedule(dynamic)
+	for(int chunk_index = 0; chunk_index < num_chunks; ++chunk_index)
+	{
+		size_t first_pixel = chunk_index * pixels_per_chunk;
+		size_t chunk_pixels = std::min(pixels_per_chunk, numPixels - first_pixel);
+
+		std::vector<id_count> buffer;
+		collect_runs(pixelDataInt + first_pixel, chunk_pixels, chunk_counts[chunk_index]);
+		sort_and_combine(chunk_counts[chunk_index], buffer);
+	}
+
+	// Merge the sorted chunk histograms pairwise.
+	for(int step = 1; step < num_chunks; step *= 2)
+	{
+		#pragma omp parallel for schedule(dynamic)
+		for(int chunk_index = 0; chunk_index < num_chunks - step; chunk_index += 2 * step)
+		{
+			std::vector<id_count> merged;
+			merge(chunk_counts[chunk_index], chunk_counts[chunk_index + step], merged);
+			chunk_counts[chunk_index].swap(merged);
+			std::vector<id_count>().swap(chunk_counts[chunk_index + step]);
+		}
+	}
+
+	counts_.swap(chunk_counts[0]);
+}
+
+void id_histogram::
+collect_runs(const uint32_t* pixels, const size_t& numPixels, std::vector<id_count>& runs)
+{
+	// RGBA-value is written in order AGBR, so the alpha channel holds the model ID and the first 24 bits are the node ID.
+	// The model ID is stored as 255 - alpha (helps to create a more visible object by starting at higher alpha values),
+	// so flipping the alpha bits gives an ID which sorts like (model ID, node ID).
+	const uint32_t flip_model_bits = 0xFF000000;
+	const size_t block_size = 16;
+
+	// ID buffers are coherent, so neighbouring pixels are collapsed into runs first.
+	uint32_t current_id = background_id;
+	size_t current_count = 0;
+
+	auto add_pixel = [&](const uint32_t id)
+	{
+		if(id == current_id)
+		{
+			++current_count;
+			return;
+		}
+
+		if(current_id < background_id && current_count > 0)
+		{
+			runs.push_back(id_count(current_id, current_count));
+		}
+		current_id = id;
+		current_count = 1;
+	};
+
+	size_t index = 0;
+	for(; index + block_size <= numPixels; index += block_size)
+	{
+		uint32_t differences = 0;
+
+		#pragma omp simd reduction(|:differences)
+		for(size_t block_index = 0; block_index < block_size; ++block_index)
+		{
+			differences |= (pixels[index + block_index] ^ flip_model_bits) ^ current_id;
+		}
+
+		// Whole block continues the current run.
+		if(differences == 0)
+		{
+			current_count += block_size;
+			continue;
+		}
+
+		for(size_t block_index = 0; block_index < block_size; ++block_index)
+		{
+			add_pixel(pixels[index + block_index] ^ flip_model_bits);
+		}
+	}
+
+	for(; index < numPixels; ++index)
+	{
+		add_pixel(pixels[index] ^ flip_model_bits);
+	}
+
+	if(current_id < background_id && current_count > 0)
+	{
+		runs.push_back(id_count(current_id, current_count));
+	}
+}
+
+void id_histogram::
+sort_and_combine(std::vector<id_count>& counts, std::vector<id_count>& buffer)
+{
+	// LSD radix sort over the bytes of the ID. Bytes which are the same for all IDs (usually the model ID) are skipped.
+	buffer.resize(counts.size());
 
-	for(size_t index = 0; index < numPixels; ++index)
+	for(unsigned int shift = 0; shift < 32; shift += 8)
 	{
-		unsigned int pixelValue = pixelDataInt[index];
-		model_t modelID = (pixelValue >> 24) & 0xFF;					// RGBA-value is written in order AGBR, so skip 24 bits to get to model ID within alpha channel.
+		size_t offsets[257] = {0};
+		for(const id_count& entry : counts)
+		{
+			++offsets[((entry.first >> shift) & 0xFF) + 1];
+		}
+
+		bool single_bucket = false;
+		for(size_t bucket = 1; bucket <= 256; ++bucket)
+		{
+			if(offsets[bucket] == counts.size())
+			{
+				single_bucket = true;
+			}
+			offsets[bucket] += offsets[bucket - 1];
+		}
+
+		if(single_bucket)
+		{
+			continue;
+		}
 
-		modelID = 255 - modelID;										// Debug thingie. Helps to create a more visible object by starting at higher alpha values.
+		for(const id_count& entry : counts)
+		{
+			buffer[offsets[(entry.first >> shift) & 0xFF]++] = entry;
+		}
+		counts.swap(buffer);
+	}
 
-		if(modelID != 255)
+	// Sum up the runs of equal IDs.
+	size_t last = 0;
+	for(size_t index = 1; index < counts.size(); ++index)
+	{
+		if(counts[index].first == counts[last].first)
 		{
-			node_t nodeID = pixelValue & 0xFFFFFF;						// RGBA-value is written in order AGBR, so first 24 bits are node ID.
-			histogram_[modelID][nodeID]++;
+			counts[last].second += counts[index].second;
+		}
+		else
+		{
+			counts[++last] = counts[index];
 		}
 	}
+
+	if(!counts.empty())
+	{
+		counts.resize(last + 1);
+	}
+}
+
+void id_histogram::
+merge(const std::vector<id_count>& left, const std::vector<id_count>& right, std::vector<id_count>& result)
+{
+	result.clear();
+	result.reserve(left.size() + right.size());
+
+	std::vector<id_count>::const_iterator left_iter = left.begin();
+	std::vector<id_count>::const_iterator right_iter = right.begin();
+
+	while(left_iter != left.end() && right_iter != right.end())
+	{
+		if(left_iter->first < right_iter->first)
+		{
+			result.push_back(*left_iter++);
+		}
+		else if(right_iter->first < left_iter->first)
+		{
+			result.push_back(*right_iter++);
+		}
+		else
+		{
+			result.push_back(id_count(left_iter->first, left_iter->second + right_iter->second));
+			++left_iter;
+			++right_iter;
+		}
+	}
+
+	result.insert(result.end(), left_iter, left.end());
+	result.insert(result.end(), right_iter, right.end());
 }
 
 std::map<model_t, std::vector<node_t>> id_histogram::
@@ -49,14 +232,13 @@ get_visible_nodes(const size_t& numPixels, const float& visibilityThreshold) con
 {
 	std::map<model_t, std::vector<node_t>> visibleNodes;
 
-	for(std::map<model_t, std::map<node_t, size_t>>::const_iterator modelIter = histogram_.begin(); modelIter != histogram_.end(); ++modelIter)
+	for(const id_count& entry : counts_)
 	{
-		for(std::map<node_t, size_t>::const_iterator nodeIter = modelIter->second.begin(); nodeIter != modelIter->second.end(); ++nodeIter)
+		if(((float)entry.second / (float)numPixels) * 100.0f >= visibilityThreshold)
 		{
-			if(((float)nodeIter->second / (float)numPixels) * 100.0f >= visibilityThreshold)
-			{
-				visibleNodes[modelIter->first].push_back(nodeIter->first);
-			}
+			model_t modelID = entry.first >> 24;
+			node_t nodeID = entry.first & 0xFFFFFF;
+			visibleNodes[modelID].push_back(nodeID);
 		}
 	}
 
@@ -66,7 +248,15 @@ get_visible_nodes(const size_t& numPixels, const float& visibilityThreshold) con
 std::map<model_t, std::map<node_t, size_t>> id_histogram::
 get_histogram() const
 {
-	return histogram_;
+	std::map<model_t, std::map<node_t, size_t>> histogram;			// first key is model ID, second key is node ID, final value is amount of visible pixels
+
+	for(const id_count& entry : counts_)
+	{
+		std::map<node_t, size_t>& nodes = histogram[entry.first >> 24];
+		nodes.emplace_hint(nodes.end(), entry.first & 0xFFFFFF, entry.second);
+	}
+
+	return histogram;
 }
 
 }
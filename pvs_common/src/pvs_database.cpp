@@ -37,6 +37,7 @@ pvs_database()
 	viewer_cell_ = nullptr;
 	activated_ = true;
 	do_preload_ = false;
+	load_viewer_cell_only_ = false;
 	shutdown_ = false;
 	
 	//configure semaphore
@@ -393,19 +394,26 @@ load_visibility_data_async(uint64_t cell_index)
 
 	std::set<size_t> cell_indices_to_load;
 
-	for(double z = -1.0; z < 1.5; z += 1.0)
+	if(load_viewer_cell_only_)
 	{
-		for(double y = -1.0; y < 1.5; y += 1.0)
+		cell_indices_to_load.insert(cell_index);
+	}
+	else
+	{
+		for(double z = -1.0; z < 1.5; z += 1.0)
 		{
-			for(double x = -1.0; x < 1.5; x += 1.0)
+			for(double y = -1.0; y < 1.5; y += 1.0)
 			{
-				size_t local_cell_index = 0;
-				scm::math::vec3d direction = smallest_cell_size_ * scm::math::vec3d(x, y, z);
-				const view_cell* local_view_cell_at_position = visibility_grid_->get_cell_at_position(center + direction, &local_cell_index);
-
-				if(local_view_cell_at_position != nullptr)
+				for(double x = -1.0; x < 1.5; x += 1.0)
 				{
-					cell_indices_to_load.insert(local_cell_index);
+					size_t local_cell_index = 0;
+					scm::math::vec3d direction = smallest_cell_size_ * scm::math::vec3d(x, y, z);
+					const view_cell* local_view_cell_at_position = visibility_grid_->get_cell_at_position(center + direction, &local_cell_index);
+
+					if(local_view_cell_at_position != nullptr)
+					{
+						cell_indices_to_load.insert(local_cell_index);
+					}
 				}
 			}
 		}
@@ -461,6 +469,20 @@ is_activated() const
 	return activated_;
 }
 
+void pvs_database::
+set_load_viewer_cell_only(const bool& viewer_cell_only)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	load_viewer_cell_only_ = viewer_cell_only;
+}
+
+bool pvs_database::
+is_loading_viewer_cell_only() const
+{
+	return load_viewer_cell_only_;
+}
+
 const grid* pvs_database::
 get_visibility_grid() const
 {
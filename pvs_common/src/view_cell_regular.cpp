@@ -146,5 +146,16 @@ set_bitset(const model_t& object_id, const boost::dynamic_bitset<>& bitset)
 	visibility_[object_id] = boost::dynamic_bitset<>(bitset);
 }
 
+void view_cell_regular::
+set_bitset(const model_t& object_id, boost::dynamic_bitset<>&& bitset)
+{
+	if(visibility_.size() <= object_id)
+	{
+		visibility_.resize(object_id + 1);
+	}
+
+	visibility_[object_id].swap(bitset);
+}
+
 }
 }
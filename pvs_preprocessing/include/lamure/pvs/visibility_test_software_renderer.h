@@ -0,0 +1,80 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group 
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#ifndef LAMURE_PVS_VISIBILITY_TEST_SOFTWARE_RENDERER_H
+#define LAMURE_PVS_VISIBILITY_TEST_SOFTWARE_RENDERER_H
+
+#include <vector>
+
+#include <lamure/pvs/pvs_preprocessing.h>
+#include <lamure/types.h>
+#include "lamure/pvs/visibility_test.h"
+#include "lamure/pvs/grid.h"
+
+namespace lamure
+{
+namespace pvs
+{
+
+// Renders node ID images on the CPU by ray casting the surfel splats of a single LOD level per model.
+// Needs no OpenGL context, view cells are processed in parallel.
+class PVS_PREPROCESSING_DLL visibility_test_software_renderer : public visibility_test
+{
+public:
+	visibility_test_software_renderer();
+	virtual ~visibility_test_software_renderer();
+
+	virtual int initialize(int& argc, char** argv);
+	virtual void test_visibility(grid* visibility_grid);
+	virtual void shutdown();
+
+	virtual bounding_box get_scene_bounds() const;
+
+private:
+	struct splat
+	{
+		vec3f position;
+		float radius;
+		vec3f normal;
+		uint32_t id;			// Same encoding as the pixels of the GL ID renderer (255 - model ID in the upper 8 bits).
+	};
+
+	struct splat_node
+	{
+		vec3f min_vertex;
+		vec3f max_vertex;
+		size_t first_splat;
+		size_t num_splats;
+		model_t model_id;
+		node_t node_id;
+	};
+
+	void load_splats(const model_t& model_id, const mat4f& transformation, const uint32_t& depth);
+	void render_view(const scm::math::vec3d& eye, const unsigned short& direction, const float& near_plane,
+					std::vector<float>& depth_buffer, std::vector<uint32_t>& id_buffer) const;
+	void propagate_visibility(const model_t& model_id, std::vector<char>& visible_nodes) const;
+
+	int resolution_x_;
+	int resolution_y_;
+	unsigned int main_memory_budget_;
+	int lod_depth_;
+
+	float visibility_threshold_;
+	float far_plane_;
+	bool is_initialized_;
+
+	// Splats of all models, grouped by the node they belong to.
+	std::vector<splat> splats_;
+	std::vector<splat_node> nodes_;
+
+	bounding_box scene_bounds_;
+};
+
+}
+}
+
+#endif
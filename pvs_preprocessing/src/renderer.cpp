@@ -203,7 +203,7 @@ render_depth(lamure::context_t context_id,
             }
 
             size_t surfels_per_node_of_model = bvh->get_primitives_per_node();
-            std::vector<scm::gl::boxf>const & bounding_box_vector = bvh->get_bounding_boxes();
+            auto const & bounding_box_vector = bvh->get_bounding_boxes();
 
 
             upload_transformation_matrices(camera, model_id, RenderPass::VISIBLE_NODE);
@@ -0,0 +1,617 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group 
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#include "lamure/pvs/visibility_test_software_renderer.h"
+#include "lamure/pvs/utils.h"
+#include "lamure/pvs/pvs_database.h"
+#include "lamure/pvs/id_histogram.h"
+
+#include "lamure/ren/model_database.h"
+#include "lamure/ren/controller.h"
+#include "lamure/ren/lod_stream.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <boost/program_options.hpp>
+
+namespace lamure
+{
+namespace pvs
+{
+
+namespace
+{
+
+// Camera setup per direction, same as the one used by the GL ID renderer.
+const scm::math::vec3f look_directions[6] = {
+	scm::math::vec3f(1.0f, 0.0f, 0.0f), scm::math::vec3f(-1.0f, 0.0f, 0.0f),
+	scm::math::vec3f(0.0f, 1.0f, 0.0f), scm::math::vec3f(0.0f, -1.0f, 0.0f),
+	scm::math::vec3f(0.0f, 0.0f, 1.0f), scm::math::vec3f(0.0f, 0.0f, -1.0f) };
+
+const scm::math::vec3f up_directions[6] = {
+	scm::math::vec3f(0.0f, 1.0f, 0.0f), scm::math::vec3f(0.0f, 1.0f, 0.0f),
+	scm::math::vec3f(0.0f, 0.0f, 1.0f), scm::math::vec3f(0.0f, 0.0f, 1.0f),
+	scm::math::vec3f(0.0f, 1.0f, 0.0f), scm::math::vec3f(0.0f, 1.0f, 0.0f) };
+
+// Range of dot(p - eye, axis) for all points p inside the box.
+void project_box(const vec3f& min_vertex, const vec3f& max_vertex, const scm::math::vec3f& eye, const scm::math::vec3f& axis, float& range_min, float& range_max)
+{
+	range_min = 0.0f;
+	range_max = 0.0f;
+
+	for(int dim = 0; dim < 3; ++dim)
+	{
+		float low = axis[dim] * (min_vertex[dim] - eye[dim]);
+		float high = axis[dim] * (max_vertex[dim] - eye[dim]);
+		range_min += std::min(low, high);
+		range_max += std::max(low, high);
+	}
+}
+
+// Projected range of the interval [value - radius, value + radius] at depths between depth_min and depth_max (both positive).
+void project_interval(const float& value, const float& radius, const float& depth_min, const float& depth_max, float& ndc_min, float& ndc_max)
+{
+	float low = value - radius;
+	float high = value + radius;
+	ndc_min = low >= 0.0f ? low / depth_max : low / depth_min;
+	ndc_max = high >= 0.0f ? high / depth_min : high / depth_max;
+}
+
+}
+
+visibility_test_software_renderer::
+visibility_test_software_renderer()
+{
+	resolution_x_ = 1024;
+	resolution_y_ = 1024;
+	main_memory_budget_ = 4096;
+	lod_depth_ = -1;
+
+	visibility_threshold_ = 0.0001f;
+	far_plane_ = 1000.0f;
+	is_initialized_ = false;
+}
+
+visibility_test_software_renderer::
+~visibility_test_software_renderer()
+{
+	shutdown();
+}
+
+int visibility_test_software_renderer::
+initialize(int& argc, char** argv)
+{
+	namespace po = boost::program_options;
+	namespace fs = boost::filesystem;
+
+	const std::string exec_name = (argc > 0) ? fs::basename(argv[0]) : "";
+
+	std::string resource_file_path = "";
+
+	// These value are read, but not used. Yet ignoring them in the terminal parameters would lead to misinterpretation.
+	std::string pvs_output_file_path = "";
+	std::string visibility_test_type = "";
+	std::string grid_type = "";
+	unsigned int grid_size = 1;
+	unsigned int num_steps = 11;
+	double oversize_factor = 1.5;
+	float optimization_threshold = 1.0f;
+
+	po::options_description desc("Usage: " + exec_name + " [OPTION]... INPUT\n\n"
+							"Allowed Options");
+	desc.add_options()
+	  ("help", "print help message")
+	  ("width,w", po::value<int>(&resolution_x_)->default_value(1024), "specify width of the rendered ID images (default=1024)")
+	  ("height,h", po::value<int>(&resolution_y_)->default_value(1024), "specify height of the rendered ID images (default=1024)")
+	  ("resource-file,f", po::value<std::string>(&resource_file_path), "specify resource input-file")
+	  ("mem,m", po::value<unsigned>(&main_memory_budget_)->default_value(4096), "specify main memory budget for the splats in MB, used to choose the rendered LOD level (default=4096)")
+	  ("lod-depth", po::value<int>(&lod_depth_)->default_value(-1), "specify the depth of the LOD level which is rendered. Negative values choose the deepest level that fits the memory budget (default=-1)")
+	// The following parameters are used by the main app only, yet must be identified nonetheless since otherwise they are dealt with as file paths.
+	  ("pvs-file,p", po::value<std::string>(&pvs_output_file_path), "specify output file of calculated pvs data")
+	  ("vistest", po::value<std::string>(&visibility_test_type)->default_value("swr"), "specify type of visibility test to be used.")
+	  ("gridtype", po::value<std::string>(&grid_type)->default_value("octree"), "specify type of grid to store visibility data ('regular', 'octree', 'hierarchical')")
+	  ("gridsize", po::value<unsigned int>(&grid_size)->default_value(1), "specify size/depth of the grid used for the visibility test (depends on chosen grid type)")
+	  ("oversize", po::value<double>(&oversize_factor)->default_value(1.5), "factor the grid bounds will be scaled by, default is 1.5 (grid bounds will exceed scene bounds by factor of 1.5)")
+	  ("optithresh", po::value<float>(&optimization_threshold)->default_value(1.0f), "specify the threshold at which common data are converged. Default is 1.0, which means data must be 100 percent equal.")
+	  ("numsteps,n", po::value<unsigned int>(&num_steps)->default_value(11), "specify the number of intervals the occlusion values will be split into (visibility analysis only)");
+	  ;
+
+	po::variables_map vm;
+
+	try
+	{
+		auto parsed_options = po::command_line_parser(argc, argv).options(desc).allow_unregistered().run();
+		po::store(parsed_options, vm);
+		po::notify(vm);
+
+		std::vector<std::string> to_pass_further = po::collect_unrecognized(parsed_options.options, po::include_positional);
+		bool no_input = !vm.count("input") && to_pass_further.empty();
+
+		if (resource_file_path == "")
+		{
+			if (vm.count("help") || no_input)
+			{
+				std::cout << desc;
+				return 0;
+			}
+		}
+
+		// no explicit input -> use unknown options
+		if (!vm.count("input") && resource_file_path == "")
+		{
+			resource_file_path = "auto_generated.rsc";
+			std::fstream ofstr(resource_file_path, std::ios::out);
+			if (ofstr.good())
+			{
+				for (auto argument : to_pass_further)
+				{
+					ofstr << argument << std::endl;
+				}
+			}
+			else
+			{
+				throw std::runtime_error("Cannot open file");
+			}
+			ofstr.close();
+		}
+	}
+	catch (std::exception& e)
+	{
+		std::cout << "Warning: No input file specified. \n" << desc;
+		return 0;
+	}
+
+	std::pair< std::vector<std::string>, std::vector<scm::math::mat4f> > model_attributes;
+	std::set<lamure::model_t> visible_set;
+	std::set<lamure::model_t> invisible_set;
+	model_attributes = read_model_string(resource_file_path, &visible_set, &invisible_set);
+
+	std::vector<scm::math::mat4f>& model_transformations = model_attributes.second;
+	std::vector<std::string> const& model_filenames = model_attributes.first;
+
+	lamure::ren::model_database* database = lamure::ren::model_database::get_instance();
+
+	model_t num_models = 0;
+	for (const auto& filename : model_filenames)
+	{
+		database->add_model(filename, std::to_string(num_models));
+		++num_models;
+	}
+
+	is_initialized_ = true;
+
+	if(num_models == 0)
+	{
+		return 0;
+	}
+
+	// Choose far plane like the GL renderer does so the ID images cover the same depth range.
+	float scene_diameter = far_plane_;
+	for(model_t model_id = 0; model_id < num_models; ++model_id)
+	{
+		const lamure::ren::bvh* bvh = database->get_model(model_id)->get_bvh();
+		const scm::gl::boxf& box_model_root = bvh->get_bounding_boxes()[0];
+		scene_diameter = std::max(scm::math::length(box_model_root.max_vertex() - box_model_root.min_vertex()), scene_diameter);
+
+		// Calculate bounding box of whole scene.
+		vec3r min_vertex(box_model_root.min_vertex() + bvh->get_translation());
+		vec3r max_vertex(box_model_root.max_vertex() + bvh->get_translation());
+		bounding_box model_root_box(min_vertex, max_vertex);
+
+		if(model_id == 0)
+		{
+			scene_bounds_ = bounding_box(model_root_box);
+		}
+		else
+		{
+			scene_bounds_.expand(model_root_box);
+		}
+	}
+	far_plane_ = 2.0f * scene_diameter;
+
+	// Load one LOD level per model, either the requested one or the deepest one fitting the memory budget.
+	const size_t memory_budget_per_model = ((size_t)main_memory_budget_ * 1024 * 1024) / num_models;
+
+	for(model_t model_id = 0; model_id < num_models; ++model_id)
+	{
+		const lamure::ren::bvh* bvh = database->get_model(model_id)->get_bvh();
+
+		if(bvh->get_primitive() != lamure::ren::bvh::primitive_type::POINTCLOUD)
+		{
+			std::cout << "Skipping model " << model_id << ": only uncompressed point clouds are supported by the software renderer." << std::endl;
+			continue;
+		}
+
+		uint32_t depth = bvh->get_depth();
+		if(lod_depth_ >= 0)
+		{
+			depth = std::min((uint32_t)lod_depth_, depth);
+		}
+		else
+		{
+			while(depth > 0 && (size_t)bvh->get_length_of_depth(depth) * bvh->get_primitives_per_node() * sizeof(splat) > memory_budget_per_model)
+			{
+				--depth;
+			}
+		}
+
+		scm::math::mat4f transformation = model_transformations[model_id] * scm::math::make_translation(bvh->get_translation());
+		load_splats(model_id, transformation, depth);
+
+		std::cout << "model " << model_id << ": rendering depth " << depth << " (" << splats_.size() << " splats loaded in total)" << std::endl;
+	}
+
+	return 0;
+}
+
+void visibility_test_software_renderer::
+load_splats(const model_t& model_id, const mat4f& transformation, const uint32_t& depth)
+{
+	typedef lamure::ren::dataset::serialized_surfel serialized_surfel;
+
+	const lamure::ren::bvh* bvh = lamure::ren::model_database::get_instance()->get_model(model_id)->get_bvh();
+
+	std::string lod_file_path = bvh->get_filename();
+	lod_file_path = lod_file_path.substr(0, lod_file_path.size() - 3) + "lod";
+
+	lamure::ren::lod_stream lod_access;
+	lod_access.open(lod_file_path);
+
+	const node_t first_node_id = bvh->get_first_node_id_of_depth(depth);
+	const int num_nodes = (int)bvh->get_length_of_depth(depth);
+	const size_t surfels_per_node = bvh->get_primitives_per_node();
+	const size_t node_size_in_bytes = surfels_per_node * sizeof(serialized_surfel);
+
+	// Radii are scaled the same way as in the GL renderer, normals are transformed by the inverse transpose.
+	const float radius_scale = scm::math::length(transformation * scm::math::vec4f(1.0f, 0.0f, 0.0f, 0.0f));
+	const scm::math::mat4f normal_transformation = scm::math::transpose(scm::math::inverse(transformation));
+
+	std::vector<std::vector<splat>> node_splats(num_nodes);
+
+	// Positional reads of the LOD file are only thread-safe on POSIX systems.
+#ifndef _WIN32
+	#pragma omp parallel for schedule(dynamic)
+#endif
+	for(int node_index = 0; node_index < num_nodes; ++node_index)
+	{
+		const node_t node_id = first_node_id + node_index;
+
+		std::vector<serialized_surfel> surfels(surfels_per_node);
+		lod_access.read((char*)surfels.data(), node_id * node_size_in_bytes, node_size_in_bytes);
+
+		std::vector<splat>& current_splats = node_splats[node_index];
+		current_splats.reserve(surfels_per_node);
+
+		for(const serialized_surfel& surfel : surfels)
+		{
+			// Nodes are padded with surfels of zero size.
+			if(surfel.size <= 0.0f)
+			{
+				continue;
+			}
+
+			scm::math::vec4f position = transformation * scm::math::vec4f(surfel.x, surfel.y, surfel.z, 1.0f);
+			scm::math::vec4f normal = normal_transformation * scm::math::vec4f(surfel.nx, surfel.ny, surfel.nz, 0.0f);
+
+			splat current_splat;
+			current_splat.position = vec3f(position.x, position.y, position.z);
+			current_splat.radius = surfel.size * radius_scale;
+			current_splat.normal = vec3f(normal.x, normal.y, normal.z);
+			current_splat.id = ((255 - model_id) << 24) | (node_id & 0xFFFFFF);
+
+			float normal_length = scm::math::length(current_splat.normal);
+			if(normal_length > 0.0f)
+			{
+				current_splat.normal /= normal_length;
+			}
+
+			current_splats.push_back(current_splat);
+		}
+	}
+
+	lod_access.close();
+
+	for(int node_index = 0; node_index < num_nodes; ++node_index)
+	{
+		const std::vector<splat>& current_splats = node_splats[node_index];
+		if(current_splats.empty())
+		{
+			continue;
+		}
+
+		splat_node node;
+		node.min_vertex = vec3f(std::numeric_limits<float>::max());
+		node.max_vertex = vec3f(std::numeric_limits<float>::lowest());
+		node.first_splat = splats_.size();
+		node.num_splats = current_splats.size();
+		node.model_id = model_id;
+		node.node_id = first_node_id + node_index;
+
+		for(const splat& current_splat : current_splats)
+		{
+			for(int dim = 0; dim < 3; ++dim)
+			{
+				node.min_vertex[dim] = std::min(node.min_vertex[dim], current_splat.position[dim] - current_splat.radius);
+				node.max_vertex[dim] = std::max(node.max_vertex[dim], current_splat.position[dim] + current_splat.radius);
+			}
+		}
+
+		nodes_.push_back(node);
+		splats_.insert(splats_.end(), current_splats.begin(), current_splats.end());
+	}
+}
+
+void visibility_test_software_renderer::
+render_view(const scm::math::vec3d& eye, const unsigned short& direction, const float& near_plane,
+			std::vector<float>& depth_buffer, std::vector<uint32_t>& id_buffer) const
+{
+	std::fill(depth_buffer.begin(), depth_buffer.end(), far_plane_);
+	std::fill(id_buffer.begin(), id_buffer.end(), 0);
+
+	// Orthonormal camera basis. The projection uses an opening angle of 90 degrees and an aspect ratio of 1
+	// like the GL renderer, so a view space point (x, y, z) lands at ndc (x / z, y / z).
+	const scm::math::vec3f forward = look_directions[direction];
+	const scm::math::vec3f right = scm::math::cross(forward, up_directions[direction]);
+	const scm::math::vec3f up = scm::math::cross(right, forward);
+	const scm::math::vec3f eye_position(eye);
+
+	const float pixel_size_x = 2.0f / resolution_x_;
+	const float pixel_size_y = 2.0f / resolution_y_;
+
+	for(const splat_node& node : nodes_)
+	{
+		// Cull node bounds against the view frustum.
+		float depth_min, depth_max, x_min, x_max, y_min, y_max;
+		project_box(node.min_vertex, node.max_vertex, eye_position, forward, depth_min, depth_max);
+		if(depth_max <= near_plane || depth_min >= far_plane_)
+		{
+			continue;
+		}
+
+		project_box(node.min_vertex, node.max_vertex, eye_position, right, x_min, x_max);
+		project_box(node.min_vertex, node.max_vertex, eye_position, up, y_min, y_max);
+		if(x_min > depth_max || x_max < -depth_max || y_min > depth_max || y_max < -depth_max)
+		{
+			continue;
+		}
+
+		for(size_t splat_index = node.first_splat; splat_index < node.first_splat + node.num_splats; ++splat_index)
+		{
+			const splat& current_splat = splats_[splat_index];
+			const scm::math::vec3f relative_position = current_splat.position - eye_position;
+			const float radius = current_splat.radius;
+
+			const float z = scm::math::dot(relative_position, forward);
+			if(z + radius <= near_plane || z - radius >= far_plane_)
+			{
+				continue;
+			}
+
+			const float x = scm::math::dot(relative_position, right);
+			const float y = scm::math::dot(relative_position, up);
+
+			// Conservative screen space bounds of the bounding sphere of the splat.
+			const float splat_depth_min = std::max(z - radius, near_plane);
+			const float splat_depth_max = z + radius;
+			float ndc_x_min, ndc_x_max, ndc_y_min, ndc_y_max;
+			project_interval(x, radius, splat_depth_min, splat_depth_max, ndc_x_min, ndc_x_max);
+			project_interval(y, radius, splat_depth_min, splat_depth_max, ndc_y_min, ndc_y_max);
+
+			if(ndc_x_max < -1.0f || ndc_x_min > 1.0f || ndc_y_max < -1.0f || ndc_y_min > 1.0f)
+			{
+				continue;
+			}
+
+			const int pixel_x_min = std::max(0, (int)std::floor((ndc_x_min + 1.0f) / pixel_size_x - 0.5f));
+			const int pixel_x_max = std::min(resolution_x_ - 1, (int)std::ceil((ndc_x_max + 1.0f) / pixel_size_x - 0.5f));
+			const int pixel_y_min = std::max(0, (int)std::floor((ndc_y_min + 1.0f) / pixel_size_y - 0.5f));
+			const int pixel_y_max = std::min(resolution_y_ - 1, (int)std::ceil((ndc_y_max + 1.0f) / pixel_size_y - 0.5f));
+
+			// Splat normal in view space. Splats without normal face the camera.
+			float normal_x = scm::math::dot(current_splat.normal, right);
+			float normal_y = scm::math::dot(current_splat.normal, up);
+			float normal_z = scm::math::dot(current_splat.normal, forward);
+			if(normal_x == 0.0f && normal_y == 0.0f && normal_z == 0.0f)
+			{
+				normal_x = x;
+				normal_y = y;
+				normal_z = z;
+			}
+
+			const float plane_distance = normal_x * x + normal_y * y + normal_z * z;
+			const float squared_radius = radius * radius;
+
+			for(int pixel_y = pixel_y_min; pixel_y <= pixel_y_max; ++pixel_y)
+			{
+				const float ndc_y = (pixel_y + 0.5f) * pixel_size_y - 1.0f;
+				size_t pixel_index = (size_t)pixel_y * resolution_x_ + pixel_x_min;
+
+				for(int pixel_x = pixel_x_min; pixel_x <= pixel_x_max; ++pixel_x, ++pixel_index)
+				{
+					const float ndc_x = (pixel_x + 0.5f) * pixel_size_x - 1.0f;
+
+					// Intersect the view ray (ndc_x, ndc_y, 1) with the splat plane, t is the view space depth of the hit.
+					const float denominator = normal_x * ndc_x + normal_y * ndc_y + normal_z;
+					if(std::abs(denominator) < 1e-6f)
+					{
+						continue;
+					}
+
+					const float t = plane_distance / denominator;
+					if(t < near_plane || t >= depth_buffer[pixel_index])
+					{
+						continue;
+					}
+
+					const float offset_x = ndc_x * t - x;
+					const float offset_y = ndc_y * t - y;
+					const float offset_z = t - z;
+					if(offset_x * offset_x + offset_y * offset_y + offset_z * offset_z > squared_radius)
+					{
+						continue;
+					}
+
+					depth_buffer[pixel_index] = t;
+					id_buffer[pixel_index] = current_splat.id;
+				}
+			}
+		}
+	}
+}
+
+void visibility_test_software_renderer::
+propagate_visibility(const model_t& model_id, std::vector<char>& visible_nodes) const
+{
+	// Set children and parents of visible nodes visible, too. Parents always have smaller IDs than their children,
+	// so a single pass in each direction reaches all ancestors and descendants.
+	const lamure::ren::bvh* bvh = lamure::ren::model_database::get_instance()->get_model(model_id)->get_bvh();
+	std::vector<char> visible_ancestors(visible_nodes);
+
+	for(node_t node_id = (node_t)visible_nodes.size() - 1; node_id > 0; --node_id)
+	{
+		if(visible_ancestors[node_id])
+		{
+			visible_ancestors[bvh->get_parent_id(node_id)] = 1;
+		}
+	}
+
+	for(node_t node_id = 1; node_id < visible_nodes.size(); ++node_id)
+	{
+		if(visible_nodes[bvh->get_parent_id(node_id)])
+		{
+			visible_nodes[node_id] = 1;
+		}
+	}
+
+	for(node_t node_id = 0; node_id < visible_nodes.size(); ++node_id)
+	{
+		visible_nodes[node_id] |= visible_ancestors[node_id];
+	}
+}
+
+void visibility_test_software_renderer::
+test_visibility(grid* visibility_grid)
+{
+	lamure::ren::model_database* database = lamure::ren::model_database::get_instance();
+	const model_t num_models = database->num_models();
+	const size_t num_pixels = (size_t)resolution_x_ * resolution_y_;
+	const size_t num_cells = visibility_grid->get_cell_count();
+
+	// Hardcoded heresy. This grid type applies visibility propagation at runtime.
+	const bool propagate = visibility_grid->get_grid_type() != "octree_hierarchical_v3";
+
+	size_t cells_finished = 0;
+
+	#pragma omp parallel
+	{
+		std::vector<float> depth_buffer(num_pixels);
+		std::vector<uint32_t> id_buffer(num_pixels);
+		std::vector<std::vector<char>> visible_nodes(num_models);
+
+		#pragma omp for schedule(dynamic)
+		for(size_t cell_index = 0; cell_index < num_cells; ++cell_index)
+		{
+			const view_cell* current_cell = visibility_grid->get_cell_at_index(cell_index);
+			const scm::math::vec3d cell_center = current_cell->get_position_center();
+			const scm::math::vec3d cell_size = current_cell->get_size();
+
+			for(model_t model_id = 0; model_id < num_models; ++model_id)
+			{
+				visible_nodes[model_id].assign(database->get_model(model_id)->get_bvh()->get_num_nodes(), 0);
+			}
+
+			for(unsigned short direction = 0; direction < 6; ++direction)
+			{
+				const float near_plane = cell_size[direction / 2] * 0.5f;
+				render_view(cell_center, direction, near_plane, depth_buffer, id_buffer);
+
+				id_histogram hist;
+				hist.create(id_buffer.data(), num_pixels);
+				std::map<model_t, std::vector<node_t>> visible_ids = hist.get_visible_nodes(num_pixels, visibility_threshold_);
+
+				for(std::map<model_t, std::vector<node_t>>::const_iterator iter = visible_ids.begin(); iter != visible_ids.end(); ++iter)
+				{
+					for(node_t node_id : iter->second)
+					{
+						visible_nodes[iter->first][node_id] = 1;
+					}
+				}
+			}
+
+			// Nodes inside the view cell are visible regardless of the rendered images.
+			const vec3f cell_min_vertex(cell_center - cell_size * 0.5);
+			const vec3f cell_max_vertex(cell_center + cell_size * 0.5);
+
+			for(const splat_node& node : nodes_)
+			{
+				if(node.min_vertex.x <= cell_max_vertex.x && node.max_vertex.x >= cell_min_vertex.x &&
+					node.min_vertex.y <= cell_max_vertex.y && node.max_vertex.y >= cell_min_vertex.y &&
+					node.min_vertex.z <= cell_max_vertex.z && node.max_vertex.z >= cell_min_vertex.z)
+				{
+					visible_nodes[node.model_id][node.node_id] = 1;
+				}
+			}
+
+			if(propagate)
+			{
+				for(model_t model_id = 0; model_id < num_models; ++model_id)
+				{
+					propagate_visibility(model_id, visible_nodes[model_id]);
+				}
+			}
+
+			// Grids are not thread-safe.
+			#pragma omp critical
+			{
+				for(model_t model_id = 0; model_id < num_models; ++model_id)
+				{
+					for(node_t node_id = 0; node_id < visible_nodes[model_id].size(); ++node_id)
+					{
+						if(visible_nodes[model_id][node_id])
+						{
+							visibility_grid->set_cell_visibility(cell_index, model_id, node_id, true);
+						}
+					}
+				}
+
+				// Calculate current rendering state so user gets visual feedback on the preprocessing progress.
+				++cells_finished;
+				float current_percentage_done = ((float)cells_finished / (float)num_cells) * 100.0f;
+				std::cout << "\rrendering in progress [" << current_percentage_done << "]       " << std::flush;
+			}
+		}
+	}
+
+	std::cout << std::endl;
+}
+
+void visibility_test_software_renderer::
+shutdown()
+{
+	if(is_initialized_)
+	{
+		delete lamure::pvs::pvs_database::get_instance();
+
+		delete lamure::ren::controller::get_instance();
+		delete lamure::ren::model_database::get_instance();
+
+		splats_.clear();
+		nodes_.clear();
+		is_initialized_ = false;
+	}
+}
+
+bounding_box visibility_test_software_renderer::
+get_scene_bounds() const
+{
+	return scene_bounds_;
+}
+
+}
+}
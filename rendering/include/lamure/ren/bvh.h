@@ -20,9 +20,32 @@
 
 #include <scm/gl_core/primitives/box.h>
 
+#include <boost/iostreams/device/mapped_file.hpp>
+
 namespace lamure {
 namespace ren {
 
+// read-only view of one node attribute per node, either owned by the bvh
+// or pointing into the memory mapped bvh file
+template <typename T>
+class bvh_node_array
+{
+public:
+                        bvh_node_array(const T* data, const size_t size)
+                        : data_(data), size_(size) {}
+
+    const T&            operator[](const size_t node_id) const { return data_[node_id]; }
+    const T*            data() const { return data_; }
+    const size_t        size() const { return size_; }
+    const bool          empty() const { return size_ == 0; }
+    const T*            begin() const { return data_; }
+    const T*            end() const { return data_ + size_; }
+
+private:
+    const T*            data_;
+    size_t              size_;
+};
+
 class RENDERING_DLL bvh
 {
 
@@ -59,14 +82,16 @@ public:
     const uint32_t      get_size_of_provenance() const { return size_of_provenance_; }
     const uint32_t      get_min_lod_depth() const { return min_lod_depth_; }
     const vec3f         get_translation() const { return translation_; }
-    const std::vector<scm::gl::boxf>& get_bounding_boxes() const { return bounding_boxes_; }
-    const std::vector<vec3f>& get_centroids() const { return centroids_; };
+    const bvh_node_array<scm::gl::boxf> get_bounding_boxes() const;
+    const bvh_node_array<vec3f> get_centroids() const;
+    const bvh_node_array<float> get_avg_primitive_extents() const;
     const scm::gl::boxf& get_bounding_box(const node_t node_id) const; 
     const scm::math::vec3f& get_centroid(const node_t node_id) const;
     const float         get_avg_primitive_extent(const node_t node_id) const;
     const float         get_max_surfel_radius_deviation(const node_t node_id) const;
     const node_visibility get_visibility(const node_t node_id) const;
     const primitive_type get_primitive() const { return primitive_; }
+    const bool          is_memory_mapped() const { return mapped_file_.is_open(); }
     
     void                set_num_nodes(const uint32_t num_nodes) { num_nodes_ = num_nodes; }
     void                set_fan_factor(const uint32_t fan_factor) { fan_factor_ = fan_factor; }
@@ -86,9 +111,20 @@ public:
     void                write_bvh_file(const std::string& filename);
 
 protected:
+    friend class bvh_stream;
 
     void                load_bvh_file(const std::string& filename);
 
+    // node attributes of version 2 files are used in place, offsets are in bytes from the start of the file
+    void                map_node_arrays(const std::string& filename,
+                                        const size_t bounding_boxes_offset,
+                                        const size_t centroids_offset,
+                                        const size_t avg_primitive_extents_offset,
+                                        const size_t max_primitive_extent_deviations_offset,
+                                        const size_t visibilities_offset);
+    // copies mapped node attributes into the vectors before they are modified
+    void                unmap_node_arrays();
+
     uint32_t            num_nodes_;
     uint32_t            fan_factor_;
     uint32_t            depth_;
@@ -104,6 +140,14 @@ protected:
     std::vector<float>  avg_primitive_extent_;
     std::vector<float>  max_primitive_extent_deviation_; //new for radius quantization
 
+    // valid while mapped_file_ is open, the vectors above stay empty in that case
+    boost::iostreams::mapped_file_source mapped_file_;
+    const scm::gl::boxf* mapped_bounding_boxes_;
+    const vec3f*        mapped_centroids_;
+    const float*        mapped_avg_primitive_extent_;
+    const float*        mapped_max_primitive_extent_deviation_;
+    const node_visibility* mapped_visibility_;
+
     std::string         filename_;
 
     vec3f               translation_;
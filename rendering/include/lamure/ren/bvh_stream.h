@@ -442,6 +442,115 @@ protected:
     };
 
 
+    // all node attributes of a version 2 file, stored as one array per attribute so
+    // that the reader can map them instead of deserializing node segments
+    class bvh_node_array_seg : public bvh_serializable {
+    public:
+        bvh_node_array_seg()
+        : bvh_serializable(),
+          bounding_boxes_(nullptr),
+          centroids_(nullptr),
+          avg_surfel_radii_(nullptr),
+          max_surfel_radius_deviations_(nullptr),
+          visibilities_(nullptr) {};
+        ~bvh_node_array_seg() {};
+
+        uint32_t segment_id_;
+        uint32_t num_nodes_;
+        uint64_t reserved_;
+
+        //byte offsets relative to the start of the segment data, multiples of 32
+        uint64_t bounding_boxes_offset_;
+        uint64_t centroids_offset_;
+        uint64_t avg_surfel_radii_offset_;
+        uint64_t max_surfel_radius_deviations_offset_;
+        uint64_t visibilities_offset_;
+
+        //source arrays, only used for serialization
+        const bvh_bounding_box* bounding_boxes_;
+        const bvh_vector* centroids_;
+        const float* avg_surfel_radii_;
+        const float* max_surfel_radius_deviations_;
+        const uint32_t* visibilities_;
+
+        static size_t aligned(const size_t size) {
+            return (size + 31) & ~size_t(31);
+        }
+        void compute_offsets() {
+            bounding_boxes_offset_ = aligned(header_size());
+            centroids_offset_ = bounding_boxes_offset_ + aligned(num_nodes_ * sizeof(bvh_bounding_box));
+            avg_surfel_radii_offset_ = centroids_offset_ + aligned(num_nodes_ * sizeof(bvh_vector));
+            max_surfel_radius_deviations_offset_ = avg_surfel_radii_offset_ + aligned(num_nodes_ * sizeof(float));
+            visibilities_offset_ = max_surfel_radius_deviations_offset_ + aligned(num_nodes_ * sizeof(float));
+        }
+
+    protected:
+        friend class bvh_stream;
+        static size_t header_size() {
+            return 4*sizeof(uint32_t) + 5*sizeof(uint64_t);
+        }
+        const size_t size() const {
+            return visibilities_offset_ + num_nodes_ * sizeof(uint32_t);
+        };
+        void signature(char* signature) {
+            signature[0] = 'B';
+            signature[1] = 'V';
+            signature[2] = 'H';
+            signature[3] = 'X';
+            signature[4] = 'N';
+            signature[5] = 'A';
+            signature[6] = 'R';
+            signature[7] = 'R';
+        }
+        void write_array(std::fstream& file, size_t& position, const uint64_t offset, const void* data, const size_t size) {
+            while (position < offset) {
+                char c = 0;
+                file.write(&c, 1);
+                ++position;
+            }
+            file.write((const char*)data, size);
+            position += size;
+        }
+        void serialize(std::fstream& file) {
+            if (!file.is_open()) {
+                throw std::runtime_error(
+                    "PLOD: bvh_stream::Unable to serialize");
+            }
+            file.write((char*)&segment_id_, 4);
+            file.write((char*)&num_nodes_, 4);
+            file.write((char*)&reserved_, 8);
+            file.write((char*)&bounding_boxes_offset_, 8);
+            file.write((char*)&centroids_offset_, 8);
+            file.write((char*)&avg_surfel_radii_offset_, 8);
+            file.write((char*)&max_surfel_radius_deviations_offset_, 8);
+            file.write((char*)&visibilities_offset_, 8);
+
+            size_t position = header_size();
+            write_array(file, position, bounding_boxes_offset_, bounding_boxes_, num_nodes_ * sizeof(bvh_bounding_box));
+            write_array(file, position, centroids_offset_, centroids_, num_nodes_ * sizeof(bvh_vector));
+            write_array(file, position, avg_surfel_radii_offset_, avg_surfel_radii_, num_nodes_ * sizeof(float));
+            write_array(file, position, max_surfel_radius_deviations_offset_, max_surfel_radius_deviations_, num_nodes_ * sizeof(float));
+            write_array(file, position, visibilities_offset_, visibilities_, num_nodes_ * sizeof(uint32_t));
+        }
+        void deserialize(std::fstream& file) {
+            //only the header, the arrays are mapped by the bvh
+            if (!file.is_open()) {
+                throw std::runtime_error(
+                    "PLOD: bvh_stream::Unable to deserialize");
+            }
+            file.read((char*)&segment_id_, 4);
+            file.read((char*)&num_nodes_, 4);
+            file.read((char*)&reserved_, 8);
+            file.read((char*)&bounding_boxes_offset_, 8);
+            file.read((char*)&centroids_offset_, 8);
+            file.read((char*)&avg_surfel_radii_offset_, 8);
+            file.read((char*)&max_surfel_radius_deviations_offset_, 8);
+            file.read((char*)&visibilities_offset_, 8);
+        }
+
+    };
+
+
     class bvh_tree_extension_seg: public bvh_serializable
     {
     public:
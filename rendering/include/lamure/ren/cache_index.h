@@ -13,6 +13,8 @@
 #include <lamure/ren/config.h>
 #include <lamure/ren/platform.h>
 
+#include <atomic>
+#include <memory>
 #include <vector>
 #include <set>
 #include <map>
@@ -47,9 +49,30 @@ public:
 
 private:
 
+    // (model, node) -> slot, open addressing with linear probing.
+    // Writers hold mutex_ and bump version_ around every modification,
+    // readers do not lock and retry if the version changed meanwhile.
+    struct index_entry
+    {
+        std::atomic<uint64_t> key_;
+        std::atomic<slot_t> slot_;
+    };
+
+    const slot_t        find_slot(const model_t model_id, const node_t node_id, uint64_t *views = nullptr) const;
+    const slot_t        probe(const uint64_t key) const;
+    void                insert_slot(const model_t model_id, const node_t node_id, const slot_t slot_id);
+    void                erase_slot(const model_t model_id, const node_t node_id);
+    void                begin_write();
+    void                end_write();
+
+    const int           find_view_bit(const view_t view_id) const;
+    const int           register_view_bit(const view_t view_id);
+    const bool          insert_view(const slot_t slot_id, const int view_bit, const view_t view_id);
+    const bool          erase_view(const slot_t slot_id, const int view_bit, const view_t view_id);
+
     model_t             num_models_;
     slot_t              num_slots_;
-    slot_t              num_free_slots_;
+    std::atomic<slot_t> num_free_slots_;
 
 
     struct cache_index_node
@@ -74,13 +97,27 @@ private:
         node_t          node_id_;
         slot_t          prev_;
         slot_t          next_;
-        std::set<view_t> views_;
     };
 
     std::mutex          mutex_;
 
     std::vector<cache_index_node> slots_;
-    std::vector<std::map<node_t, slot_t>> maps_;
+
+    //one bit per registered view, indexed like slots_
+    std::unique_ptr<std::atomic<uint64_t>[]> view_masks_;
+
+    //views beyond the registered ones share the last bit of the mask,
+    //which is set while the slot holds an entry here
+    std::unordered_map<slot_t, std::set<view_t>> overflow_views_;
+    std::atomic<bool>   has_overflow_views_;
+
+    std::unique_ptr<index_entry[]> entries_;
+    size_t              entry_mask_;
+    std::atomic<uint64_t> version_;
+
+    static const int    overflow_view_bit_ = 63;
+    std::atomic<view_t> view_ids_[overflow_view_bit_];
+    std::atomic<int>    num_views_;
 };
 
 
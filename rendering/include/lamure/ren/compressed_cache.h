@@ -0,0 +1,85 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group 
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#ifndef REN_COMPRESSED_CACHE_H_
+#define REN_COMPRESSED_CACHE_H_
+
+#include <lamure/ren/dataset.h>
+#include <lamure/ren/platform.h>
+#include <lamure/types.h>
+
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace lamure
+{
+namespace ren
+{
+
+/**
+ * Main memory tier between the disk and the slots of the ooc_cache.
+ *
+ * Nodes of uncompressed point cloud models are kept quantised to 16 bytes
+ * per surfel: positions relative to the bounds of the node and the radius
+ * relative to the largest one of the node on 16 bits, the normal as 16 bit
+ * octahedral coordinates and the color unchanged. The error stays far below
+ * the surfel radius, so a node decoded from this tier renders like the one
+ * on disk while it takes half the memory.
+ *
+ * Every slot holds one node, slots are replaced in clock order. Loader
+ * threads insert nodes after they read them from disk, the cut update
+ * decodes nodes straight into the slot reserved in the ooc_cache.
+ */
+class RENDERING_DLL compressed_cache
+{
+  public:
+    compressed_cache(const size_t budget_in_bytes);
+    compressed_cache(const compressed_cache &) = delete;
+    compressed_cache &operator=(const compressed_cache &) = delete;
+    ~compressed_cache();
+
+    const size_t num_slots() const { return num_slots_; }
+    const bool is_compressible(const model_t model_id) const { return model_id < primitives_per_node_.size() && primitives_per_node_[model_id] > 0; }
+
+    // keeps a copy of the node, node_data holds the node as stored on disk
+    void insert(const model_t model_id, const node_t node_id, const char *node_data);
+
+    // writes the node as stored on disk to node_data,
+    // returns false if the node is not in the cache
+    const bool decompress(const model_t model_id, const node_t node_id, char *node_data);
+
+    static const size_t compressed_size(const size_t num_surfels);
+    static void encode(const dataset::serialized_surfel *surfels, const size_t num_surfels, char *compressed);
+    static void decode(const char *compressed, const size_t num_surfels, dataset::serialized_surfel *surfels);
+
+  private:
+    static const uint64_t invalid_key = std::numeric_limits<uint64_t>::max();
+
+    static const uint64_t key(const model_t model_id, const node_t node_id) { return (uint64_t(model_id) << 32) | node_id; }
+
+    std::mutex mutex_;
+
+    // zero for models that are not compressed
+    std::vector<size_t> primitives_per_node_;
+
+    size_t slot_size_;
+    size_t num_slots_;
+    size_t num_used_slots_;
+    size_t clock_hand_;
+
+    char *cache_data_;
+    std::vector<uint64_t> slot_keys_;
+    std::vector<uint8_t> referenced_;
+    std::unordered_map<uint64_t, size_t> slots_;
+};
+}
+} // namespace lamure
+
+#endif // REN_COMPRESSED_CACHE_H_
@@ -72,6 +72,8 @@ namespace ren {
 #define LAMURE_DEFAULT_UPLOAD_BUDGET 64
 #define LAMURE_DEFAULT_VIDEO_MEMORY_BUDGET 1024
 #define LAMURE_DEFAULT_MAIN_MEMORY_BUDGET 4096
+//compressed main memory tier below the out of core cache, 0 disables it
+#define LAMURE_DEFAULT_COMPRESSED_MEMORY_BUDGET 0
 #define LAMURE_DEFAULT_SIZE_OF_PROVENANCE 0
 
 //minimum depth for trimesh bvh nodes during lod selection
@@ -95,6 +97,11 @@ namespace ren {
 #define LAMURE_CUT_UPDATE_LOADING_QUEUE_MODE cache_queue::update_mode::UPDATE_ALWAYS
 //#define LAMURE_CUT_UPDATE_LOADING_QUEUE_MODE cache_queue::update_mode::UPDATE_INCREMENT_ONLY
 
+//replaces the blocking loader threads by a single thread
+//that keeps up to QUEUE_DEPTH node reads in flight (POSIX AIO)
+//#define LAMURE_CUT_UPDATE_ENABLE_ASYNC_LOADING
+#define LAMURE_CUT_UPDATE_ASYNC_LOADING_QUEUE_DEPTH 64
+
 //------------------------------
 //for bvh_stream: 
 //------------------------------
@@ -108,6 +115,10 @@ namespace ren {
 #undef LAMURE_CUT_UPDATE_ENABLE_SPLIT_AGAIN_MODE
 #endif
 
+#ifdef _WIN32
+#undef LAMURE_CUT_UPDATE_ENABLE_ASYNC_LOADING
+#endif
+
 
 
 } } // namespace lamure
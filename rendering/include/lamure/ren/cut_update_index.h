@@ -21,6 +21,7 @@
 #include <assert.h>
 #include <algorithm>
 #include <stack>
+#include <limits>
 
 #include <lamure/ren/model_database.h>
 
@@ -99,8 +100,9 @@ public:
     void                pop_front_action(const queue_t queue);
     void                Popback_action(const queue_t queue);
 
-    const std::set<node_t>& get_current_cut(const view_t view_id, const model_t model_id);
-    const std::set<node_t>& get_previous_cut(const view_t view_id, const model_t model_id);
+    //cuts are flat node lists, sorted once all actions of an update are resolved
+    const std::vector<node_t>& get_current_cut(const view_t view_id, const model_t model_id);
+    const std::vector<node_t>& get_previous_cut(const view_t view_id, const model_t model_id);
     void                swap_cuts();
     void                reset_cut(const view_t view_id, const model_t model_id);
 
@@ -115,6 +117,14 @@ public:
 
     void                sort();
 
+    //moves the actions left in the keep, collapse-on-need and maybe-collapse
+    //queues to per model buckets, the queues are empty afterwards
+    void                partition_remaining_actions();
+    //approves the remaining keep-actions, rejects the remaining collapse-actions
+    //and sorts the current cuts of the model. only touches data of this model,
+    //so different models can be resolved concurrently
+    void                resolve_remaining_actions(const model_t model_id);
+
 private:
 
     enum cut_front
@@ -125,6 +135,15 @@ private:
     };
 
     void                add_action(const action& action, bool sort);
+    void                insert_action(const action& action);
+    void                approve_action_unlocked(const action& action);
+    void                reject_action_unlocked(const action& action);
+
+    std::vector<node_t>& current_cut(const view_t view_id, const model_t model_id);
+    std::vector<node_t>& previous_cut(const view_t view_id, const model_t model_id);
+
+    void                link_slot(const queue_t queue, const size_t slot_id);
+    void                unlink_slot(const queue_t queue, const size_t slot_id);
 
     void                swap(const queue_t queue, const size_t slot_id_0, const size_t slot_id_1);
     void                shuffle_up(const queue_t queue, const size_t slot_id);
@@ -142,13 +161,27 @@ private:
     std::vector<action> slots_[queue_t::NUM_QUEUES];
     std::stack<action> initial_queue_;
 
-    //mapping [queue] (model, node) to slot
-    std::vector<std::map<node_t, std::set<slot_t>>> slot_maps_[queue_t::NUM_QUEUES];
+    //all slots of a queue holding an action on the same (model, node)
+    //form a doubly linked list, the heads are indexed densely per node
+    struct slot_link
+    {
+        uint32_t        prev_;
+        uint32_t        next_;
+    };
+
+    static const uint32_t invalid_link = std::numeric_limits<uint32_t>::max();
+
+    std::vector<slot_link> slot_links_[queue_t::NUM_QUEUES];
+    //[queue][model][node] first slot
+    std::vector<std::vector<uint32_t>> first_slots_[queue_t::NUM_QUEUES];
+
+    //[model] remaining actions, see partition_remaining_actions()
+    std::vector<std::vector<action>> remaining_actions_;
 
     cut_front            current_cut_front_;
     //[user][model][node]
-    std::map<view_t, std::vector<std::set<node_t>>> front_a_cuts_;
-    std::map<view_t, std::vector<std::set<node_t>>> front_b_cuts_;
+    std::vector<std::vector<std::vector<node_t>>> front_a_cuts_;
+    std::vector<std::vector<std::vector<node_t>>> front_b_cuts_;
 
 };
 
@@ -51,7 +51,7 @@ class cut_update_pool
     void collapse_node(const cut_update_index::action &item);
     void cut_update_split_again(const cut_update_index::action &split_action);
 
-    const bool is_all_nodes_in_cut(const model_t model_id, const std::vector<node_t> &node_ids, const std::set<node_t> &cut);
+    const bool is_all_nodes_in_cut(const model_t model_id, const std::vector<node_t> &node_ids, const std::vector<node_t> &cut);
     const bool is_node_in_frustum(const view_t view_id, const model_t model_id, const node_t node_id, const scm::gl::frustum &frustum);
     const bool is_no_node_in_frustum(const view_t view_id, const model_t model_id, const std::vector<node_t> &node_ids, const scm::gl::frustum &frustum);
 
@@ -63,8 +63,9 @@ class cut_update_pool
     void cut_master();
     void cut_analysis(view_t view_id, model_t model_id);
     void cut_update();
+    void cut_resolve(model_t model_id);
     void compile_transfer_list();
-    void compile_render_list();
+    void compile_render_list(const model_t model_id);
 #ifdef LAMURE_CUT_UPDATE_ENABLE_PREFETCHING
     void prefetch_routine();
 #endif
@@ -24,6 +24,7 @@ public:
         CUT_MASTER_TASK,
         CUT_ANALYSIS_TASK,
         CUT_UPDATE_TASK,
+        CUT_RESOLVE_TASK,
         CUT_INVALID_TASK
     };
 
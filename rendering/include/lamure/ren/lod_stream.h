@@ -36,6 +36,7 @@ public:
     const bool          is_file_open() const { return is_file_open_; };
     const std::string&  file_name() const { return file_name_; };
 
+    // positional read, safe to call concurrently on POSIX systems
     void                read(char* const data,
                             const size_t start_in_file,
                             const size_t length_in_bytes) const;
@@ -46,6 +47,9 @@ public:
 
 private:
     mutable std::fstream stream_;
+#ifndef _WIN32
+    int                 file_descriptor_;   // read-only access through pread
+#endif
 
     std::string         file_name_;
     bool                is_file_open_;
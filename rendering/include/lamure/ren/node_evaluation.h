@@ -0,0 +1,66 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group 
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#ifndef REN_NODE_EVALUATION_H_
+#define REN_NODE_EVALUATION_H_
+
+#include <lamure/types.h>
+#include <lamure/ren/platform.h>
+#include <lamure/ren/bvh.h>
+
+#include <scm/core/math.h>
+
+namespace lamure {
+namespace ren {
+
+// evaluates the screen space error and the frustum visibility of many nodes
+// of one model in one view. everything that only depends on the view and the
+// model is set up once, the nodes are then processed in fixed size batches
+// with their attributes gathered into aligned arrays.
+class RENDERING_DLL node_evaluation
+{
+public:
+                        node_evaluation(const bvh* bvh,
+                                        const scm::math::mat4f& model_matrix,
+                                        const scm::math::mat4f& view_matrix,
+                                        const scm::math::mat4f& projection_matrix,
+                                        const float near_plane,
+                                        const float height_divided_by_top_minus_bottom);
+
+    // same error as cut_update_pool::calculate_node_error()
+    void                compute_errors(const node_t* node_ids,
+                                       const size_t num_nodes,
+                                       float* errors) const;
+
+    // 1 unless the bounding box of the node is completely outside of the frustum
+    void                compute_in_frustum(const node_t* node_ids,
+                                           const size_t num_nodes,
+                                           uint8_t* in_frustum) const;
+
+private:
+    static const size_t batch_size = 64;
+
+    bvh_node_array<vec3f> centroids_;
+    bvh_node_array<float> avg_primitive_extents_;
+    bvh_node_array<scm::gl::boxf> bounding_boxes_;
+
+    // nodes with a smaller id are at or above the min lod depth
+    node_t              first_node_below_min_lod_depth_;
+
+    // third row of the model view matrix, gives the view space depth
+    float               view_z_[4];
+    float               error_scale_;
+
+    // left, right, bottom, top, near, far in model space, inside if a*x + b*y + c*z + d >= 0
+    float               planes_[6][4];
+};
+
+
+} } // namespace lamure
+
+
+#endif // REN_NODE_EVALUATION_H_
@@ -9,9 +9,11 @@
 #define REN_OOC_CACHE_H_
 
 #include <lamure/ren/cache.h>
+#include <lamure/ren/compressed_cache.h>
 #include <lamure/ren/config.h>
 #include <lamure/ren/ooc_pool.h>
 #include <lamure/utils.h>
+#include <atomic>
 #include <map>
 #include <queue>
 
@@ -51,8 +53,15 @@ class RENDERING_DLL ooc_cache : public cache
     void begin_measure();
     void end_measure();
 
+    // register_node calls, how many of them found the node resident
+    // and how many were served from the compressed tier instead of the disk
+    const size_t num_requests() const { return num_requests_.load(std::memory_order_relaxed); }
+    const size_t num_resident_requests() const { return num_resident_requests_.load(std::memory_order_relaxed); }
+    const size_t num_compressed_requests() const { return num_compressed_requests_.load(std::memory_order_relaxed); }
+    const size_t bytes_loaded() { return pool_->bytes_loaded(); }
+
   protected:
-    ooc_cache(const size_t num_slots);
+    ooc_cache(const size_t num_slots, const size_t compressed_cache_budget_in_bytes);
     static bool is_instanced_;
     static ooc_cache *single_;
 
@@ -63,6 +72,11 @@ class RENDERING_DLL ooc_cache : public cache
     char *cache_data_provenance_;
     uint32_t maintenance_counter_;
     ooc_pool *pool_;
+    compressed_cache *compressed_cache_;
+
+    std::atomic<size_t> num_requests_;
+    std::atomic<size_t> num_resident_requests_;
+    std::atomic<size_t> num_compressed_requests_;
 };
 }
 } // namespace lamure
@@ -11,12 +11,14 @@
 #include <lamure/ren/data_provenance.h>
 #include <lamure/ren/cache_index.h>
 #include <lamure/ren/cache_queue.h>
+#include <lamure/ren/compressed_cache.h>
 #include <lamure/ren/config.h>
 #include <lamure/ren/lod_stream.h>
 #include <lamure/ren/model_database.h>
 #include <lamure/ren/provenance_stream.h>
 #include <lamure/types.h>
 #include <lamure/utils.h>
+#include <chrono>
 #include <map>
 #include <mutex>
 #include <set>
@@ -38,7 +40,8 @@ namespace ren {
 class ooc_pool
 {
   public:
-    ooc_pool(const uint32_t num_loader_threads, const size_t size_of_slot_in_bytes, const size_t slot_size_provenance);
+    // loaded nodes are also kept in the compressed cache unless it is nullptr
+    ooc_pool(const uint32_t num_loader_threads, const size_t size_of_slot_in_bytes, const size_t slot_size_provenance, compressed_cache *compressed_cache);
     /*virtual*/ ~ooc_pool();
 
     const uint32_t num_threads() const { return num_threads_; };
@@ -57,15 +60,27 @@ class ooc_pool
     void begin_measure();
     void end_measure();
 
+    // total bytes loaded since construction
+    const size_t bytes_loaded();
+
   protected:
     void run();
+#ifdef LAMURE_CUT_UPDATE_ENABLE_ASYNC_LOADING
+    void run_async();
+#endif
     bool is_shutdown();
 
+    void collect_model_files();
+    void complete_job(const cache_queue::job &job, const size_t bytes_loaded, const std::chrono::steady_clock::time_point &load_start);
+    void fail_job(const cache_queue::job &job);
+    void repack_provenance(const cache_queue::job &job, const char *provenance_on_disk, const size_t size_of_provenance);
+
   private:
     bool locked_;
     semaphore semaphore_;
     size_t size_of_slot_;
     size_t size_of_slot_provenance_;
+    compressed_cache *compressed_cache_;
     std::mutex mutex_;
 
     uint32_t num_threads_;
@@ -73,9 +88,23 @@ class ooc_pool
 
     bool shutdown_;
 
+    std::vector<std::string> lod_files_;
+    std::vector<std::string> provenance_files_;
+    std::vector<size_t> provenance_sizes_;
+
+    size_t bytes_loaded_total_;
+
+    // statistics between begin_measure and end_measure
+    bool measuring_;
     size_t bytes_loaded_;
+    size_t bytes_loaded_in_frame_;
+    std::chrono::steady_clock::time_point measure_start_;
+    std::chrono::steady_clock::time_point last_frame_;
+    std::vector<float> load_latencies_;
+    std::vector<float> frame_throughputs_;
 
     std::vector<cache_queue::job> history_;
+    std::vector<cache_queue::job> failed_jobs_;
 
     cache_queue priority_queue_;
 };
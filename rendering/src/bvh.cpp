@@ -33,6 +33,11 @@ bvh()
   size_of_provenance_(0),
   filename_(""),
   min_lod_depth_(0),
+  mapped_bounding_boxes_(nullptr),
+  mapped_centroids_(nullptr),
+  mapped_avg_primitive_extent_(nullptr),
+  mapped_max_primitive_extent_deviation_(nullptr),
+  mapped_visibility_(nullptr),
   translation_(scm::math::vec3f(0.f)),
   primitive_(primitive_type::POINTCLOUD) {
 
@@ -49,6 +54,11 @@ bvh(const std::string& filename)
   size_of_provenance_(0),
   filename_(""),
   min_lod_depth_(0),
+  mapped_bounding_boxes_(nullptr),
+  mapped_centroids_(nullptr),
+  mapped_avg_primitive_extent_(nullptr),
+  mapped_max_primitive_extent_deviation_(nullptr),
+  mapped_visibility_(nullptr),
   translation_(scm::math::vec3f(0.f)) {
 
     std::string extension = filename.substr(filename.find_last_of(".") + 1);
@@ -120,15 +130,110 @@ write_bvh_file(const std::string& filename) {
 
 }
 
+void bvh::
+map_node_arrays(const std::string& filename,
+                const size_t bounding_boxes_offset,
+                const size_t centroids_offset,
+                const size_t avg_primitive_extents_offset,
+                const size_t max_primitive_extent_deviations_offset,
+                const size_t visibilities_offset) {
+
+    static_assert(sizeof(scm::gl::boxf) == 6 * sizeof(float), "bounding boxes are stored as 6 floats");
+    static_assert(sizeof(vec3f) == 3 * sizeof(float), "centroids are stored as 3 floats");
+    static_assert(sizeof(node_visibility) == sizeof(uint32_t), "visibilities are stored as 32 bit integers");
+
+    bounding_boxes_.clear();
+    centroids_.clear();
+    avg_primitive_extent_.clear();
+    max_primitive_extent_deviation_.clear();
+    visibility_.clear();
+
+    mapped_file_.open(filename);
+
+    if (!mapped_file_.is_open()) {
+        throw std::runtime_error(
+            "lamure: bvh::Unable to map file: " + filename);
+    }
+
+    const size_t num_nodes = num_nodes_;
+    if (bounding_boxes_offset + num_nodes * sizeof(scm::gl::boxf) > mapped_file_.size()
+        || centroids_offset + num_nodes * sizeof(vec3f) > mapped_file_.size()
+        || avg_primitive_extents_offset + num_nodes * sizeof(float) > mapped_file_.size()
+        || max_primitive_extent_deviations_offset + num_nodes * sizeof(float) > mapped_file_.size()
+        || visibilities_offset + num_nodes * sizeof(node_visibility) > mapped_file_.size()) {
+        mapped_file_.close();
+        throw std::runtime_error(
+            "lamure: bvh::File corrupt -- Node arrays exceed file size: " + filename);
+    }
+
+    const char* data = mapped_file_.data();
+    mapped_bounding_boxes_ = reinterpret_cast<const scm::gl::boxf*>(data + bounding_boxes_offset);
+    mapped_centroids_ = reinterpret_cast<const vec3f*>(data + centroids_offset);
+    mapped_avg_primitive_extent_ = reinterpret_cast<const float*>(data + avg_primitive_extents_offset);
+    mapped_max_primitive_extent_deviation_ = reinterpret_cast<const float*>(data + max_primitive_extent_deviations_offset);
+    mapped_visibility_ = reinterpret_cast<const node_visibility*>(data + visibilities_offset);
+
+}
+
+void bvh::
+unmap_node_arrays() {
+
+    if (!mapped_file_.is_open()) {
+        return;
+    }
+
+    bounding_boxes_.assign(mapped_bounding_boxes_, mapped_bounding_boxes_ + num_nodes_);
+    centroids_.assign(mapped_centroids_, mapped_centroids_ + num_nodes_);
+    avg_primitive_extent_.assign(mapped_avg_primitive_extent_, mapped_avg_primitive_extent_ + num_nodes_);
+    max_primitive_extent_deviation_.assign(mapped_max_primitive_extent_deviation_, mapped_max_primitive_extent_deviation_ + num_nodes_);
+    visibility_.assign(mapped_visibility_, mapped_visibility_ + num_nodes_);
+
+    mapped_file_.close();
+    mapped_bounding_boxes_ = nullptr;
+    mapped_centroids_ = nullptr;
+    mapped_avg_primitive_extent_ = nullptr;
+    mapped_max_primitive_extent_deviation_ = nullptr;
+    mapped_visibility_ = nullptr;
+
+}
+
+const bvh_node_array<scm::gl::boxf> bvh::
+get_bounding_boxes() const {
+    if (mapped_bounding_boxes_ != nullptr) {
+        return bvh_node_array<scm::gl::boxf>(mapped_bounding_boxes_, num_nodes_);
+    }
+    return bvh_node_array<scm::gl::boxf>(bounding_boxes_.data(), bounding_boxes_.size());
+}
+
+const bvh_node_array<vec3f> bvh::
+get_centroids() const {
+    if (mapped_centroids_ != nullptr) {
+        return bvh_node_array<vec3f>(mapped_centroids_, num_nodes_);
+    }
+    return bvh_node_array<vec3f>(centroids_.data(), centroids_.size());
+}
+
+const bvh_node_array<float> bvh::
+get_avg_primitive_extents() const {
+    if (mapped_avg_primitive_extent_ != nullptr) {
+        return bvh_node_array<float>(mapped_avg_primitive_extent_, num_nodes_);
+    }
+    return bvh_node_array<float>(avg_primitive_extent_.data(), avg_primitive_extent_.size());
+}
+
 const scm::gl::boxf& bvh::
 get_bounding_box(const node_t node_id) const {
     assert(node_id >= 0 && node_id < num_nodes_);
+    if (mapped_bounding_boxes_ != nullptr) {
+        return mapped_bounding_boxes_[node_id];
+    }
     return bounding_boxes_[node_id];
 }
 
 void bvh::
 set_bounding_box(const node_t node_id, const scm::gl::boxf& bounding_box) {
     assert(node_id >= 0 && node_id < num_nodes_);
+    unmap_node_arrays();
     while (bounding_boxes_.size() <= node_id) {
        bounding_boxes_.push_back(scm::gl::boxf());
     }
@@ -138,12 +243,16 @@ set_bounding_box(const node_t node_id, const scm::gl::boxf& bounding_box) {
 const scm::math::vec3f& bvh::
 get_centroid(const node_t node_id) const {
     assert(node_id >= 0 && node_id < num_nodes_);
+    if (mapped_centroids_ != nullptr) {
+        return mapped_centroids_[node_id];
+    }
     return centroids_[node_id];
 }
 
 void bvh::
 set_centroid(const node_t node_id, const scm::math::vec3f& centroid) {
     assert(node_id >= 0 && node_id < num_nodes_);
+    unmap_node_arrays();
     while (centroids_.size() <= node_id) {
        centroids_.push_back(scm::math::vec3f(0.f, 0.f, 0.f));
     }
@@ -153,12 +262,16 @@ set_centroid(const node_t node_id, const scm::math::vec3f& centroid) {
 const float bvh::
 get_avg_primitive_extent(const node_t node_id) const {
     assert(node_id >= 0 && node_id < num_nodes_);
+    if (mapped_avg_primitive_extent_ != nullptr) {
+        return mapped_avg_primitive_extent_[node_id];
+    }
     return avg_primitive_extent_[node_id];
 }
 
 void bvh::
 set_avg_primitive_extent(const node_t node_id, const float radius) {
     assert(node_id >= 0 && node_id < num_nodes_);
+    unmap_node_arrays();
     while (avg_primitive_extent_.size() <= node_id) {
        avg_primitive_extent_.push_back(0.f);
     }
@@ -168,12 +281,16 @@ set_avg_primitive_extent(const node_t node_id, const float radius) {
 const float bvh::
 get_max_surfel_radius_deviation(const node_t node_id) const {
     assert(node_id >= 0 && node_id < num_nodes_);
+    if (mapped_max_primitive_extent_deviation_ != nullptr) {
+        return mapped_max_primitive_extent_deviation_[node_id];
+    }
     return max_primitive_extent_deviation_[node_id];
 }
 
 void bvh::
 set_max_surfel_radius_deviation(const node_t node_id, const float max_radius_deviation) {
     assert(node_id >= 0 && node_id < num_nodes_);
+    unmap_node_arrays();
     while (max_primitive_extent_deviation_.size() <= node_id) {
        max_primitive_extent_deviation_.push_back(0.f);
     }
@@ -185,12 +302,16 @@ set_max_surfel_radius_deviation(const node_t node_id, const float max_radius_dev
 const bvh::
 node_visibility bvh::get_visibility(const node_t node_id) const {
     assert(node_id >= 0 && node_id < num_nodes_);
+    if (mapped_visibility_ != nullptr) {
+        return mapped_visibility_[node_id];
+    }
     return visibility_[node_id];
 };
 
 void bvh::
 set_visibility(const node_t node_id, const bvh::node_visibility visibility) {
     assert(node_id >= 0 && node_id < num_nodes_);
+    unmap_node_arrays();
     while (visibility_.size() <= node_id) {
        visibility_.push_back(node_visibility::NODE_VISIBLE);
     }
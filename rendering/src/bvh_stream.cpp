@@ -136,14 +136,18 @@ read_bvh(const std::string& filename, bvh& bvh) {
 
     num_segments_ = 0;
 
+    bvh_file_seg file_seg;
     bvh_tree_seg tree;
     bvh_tree_extension_seg tree_ext;
+    bvh_node_array_seg node_arrays;
     std::vector<bvh_node_seg> nodes;
     std::vector<bvh_node_extension_seg> nodes_ext;
     uint32_t tree_id = 0;
     uint32_t tree_ext_id = 0;
     uint32_t node_id = 0;
     uint32_t node_ext_id = 0;
+    uint32_t node_arrays_id = 0;
+    size_t node_arrays_anchor = 0;
 
 
     //go through entire stream and fetch the segments
@@ -163,8 +167,7 @@ read_bvh(const std::string& filename, bvh& bvh) {
         switch (sig.signature_[4]) {
 
             case 'F': { //"BVHXFILE"
-                bvh_file_seg seg;
-                seg.deserialize(file_);
+                file_seg.deserialize(file_);
                 break;
             }
             case 'T': { 
@@ -211,6 +214,12 @@ read_bvh(const std::string& filename, bvh& bvh) {
                         ++node_ext_id;
                         break;
                     }
+                    case 'A': { //"BVHXNARR"
+                        node_arrays.deserialize(file_);
+                        node_arrays_anchor = anchor;
+                        ++node_arrays_id;
+                        break;
+                    }
                     default: {
                         throw std::runtime_error(
                             "lamure: bvh_stream::Stream corrupt -- Invalid segment encountered");
@@ -247,6 +256,11 @@ read_bvh(const std::string& filename, bvh& bvh) {
            "lamure: bvh_stream::Stream corrupt -- Invalid number of bvh extensions");
     }    
 
+    if (node_arrays_id > 1 || (node_arrays_id == 1 && file_seg.major_version_ < 2)) {
+       throw std::runtime_error(
+           "lamure: bvh_stream::Stream corrupt -- Invalid number of node array segments");
+    }
+
     //Note: this is the rendering library version of the file reader!
 
     bvh.set_depth(tree.depth_);
@@ -262,6 +276,22 @@ read_bvh(const std::string& filename, bvh& bvh) {
     bvh.set_translation(translation);
     bvh.set_size_of_provenance(tree.provenance_surfel_size_);
 
+    if (node_arrays_id == 1) {
+       //version 2: node attributes are used in place
+       if (bvh.get_num_nodes() != node_arrays.num_nodes_ || node_id != 0) {
+          throw std::runtime_error(
+              "lamure: bvh_stream::Stream corrupt -- Invalid number of nodes in node arrays");
+       }
+
+       bvh.map_node_arrays(filename,
+                           node_arrays_anchor + node_arrays.bounding_boxes_offset_,
+                           node_arrays_anchor + node_arrays.centroids_offset_,
+                           node_arrays_anchor + node_arrays.avg_surfel_radii_offset_,
+                           node_arrays_anchor + node_arrays.max_surfel_radius_deviations_offset_,
+                           node_arrays_anchor + node_arrays.visibilities_offset_);
+       return;
+    }
+
     if (bvh.get_num_nodes() != node_id) {
        throw std::runtime_error(
            "lamure: bvh_stream::Stream corrupt -- Ivalid number of node segments");
@@ -304,8 +334,8 @@ write_bvh(const std::string& filename, bvh& bvh) {
    file_.seekp(0, std::ios::beg);
 
    bvh_file_seg seg;
-   seg.major_version_ = 1;
-   seg.minor_version_ = 3;
+   seg.major_version_ = 2;
+   seg.minor_version_ = 0;
    seg.reserved_ = 0;
 
    write(seg);
@@ -331,30 +361,43 @@ write_bvh(const std::string& filename, bvh& bvh) {
 
    write(tree);
 
-   for (uint32_t node_id = 0; node_id < bvh.get_num_nodes(); ++node_id) {
-       bvh_node_seg node;
-       node.segment_id_ = num_segments_++;
-       node.node_id_ = node_id;
+   const uint32_t num_nodes = bvh.get_num_nodes();
+   std::vector<bvh_bounding_box> bounding_boxes(num_nodes);
+   std::vector<bvh_vector> centroids(num_nodes);
+   std::vector<float> avg_surfel_radii(num_nodes);
+   std::vector<float> max_surfel_radius_deviations(num_nodes);
+   std::vector<uint32_t> visibilities(num_nodes);
+
+   for (uint32_t node_id = 0; node_id < num_nodes; ++node_id) {
        const scm::math::vec3f centroid = bvh.get_centroid(node_id);
-       node.centroid_.x_ = centroid.x;
-       node.centroid_.y_ = centroid.y;
-       node.centroid_.z_ = centroid.z;
-       node.depth_ = bvh.get_depth_of_node(node_id);
-       node.reduction_error_ = 0.f;
-       node.avg_surfel_radius_ = bvh.get_avg_primitive_extent(node_id);
-       node.visibility_ = (bvh_node_visibility)bvh.get_visibility(node_id);
-       node.max_surfel_radius_deviation_ = bvh.get_max_surfel_radius_deviation(node_id);
+       centroids[node_id].x_ = centroid.x;
+       centroids[node_id].y_ = centroid.y;
+       centroids[node_id].z_ = centroid.z;
+       avg_surfel_radii[node_id] = bvh.get_avg_primitive_extent(node_id);
+       visibilities[node_id] = (uint32_t)bvh.get_visibility(node_id);
+       max_surfel_radius_deviations[node_id] = bvh.get_max_surfel_radius_deviation(node_id);
        const scm::gl::boxf box = bvh.get_bounding_box(node_id);
-       node.bounding_box_.min_.x_ = box.min_vertex().x;
-       node.bounding_box_.min_.y_ = box.min_vertex().y;
-       node.bounding_box_.min_.z_ = box.min_vertex().z;
-       node.bounding_box_.max_.x_ = box.max_vertex().x;
-       node.bounding_box_.max_.y_ = box.max_vertex().y;
-       node.bounding_box_.max_.z_ = box.max_vertex().z;
-
-       write(node);
+       bounding_boxes[node_id].min_.x_ = box.min_vertex().x;
+       bounding_boxes[node_id].min_.y_ = box.min_vertex().y;
+       bounding_boxes[node_id].min_.z_ = box.min_vertex().z;
+       bounding_boxes[node_id].max_.x_ = box.max_vertex().x;
+       bounding_boxes[node_id].max_.y_ = box.max_vertex().y;
+       bounding_boxes[node_id].max_.z_ = box.max_vertex().z;
    }
 
+   bvh_node_array_seg node_arrays;
+   node_arrays.segment_id_ = num_segments_++;
+   node_arrays.num_nodes_ = num_nodes;
+   node_arrays.reserved_ = 0;
+   node_arrays.compute_offsets();
+   node_arrays.bounding_boxes_ = bounding_boxes.data();
+   node_arrays.centroids_ = centroids.data();
+   node_arrays.avg_surfel_radii_ = avg_surfel_radii.data();
+   node_arrays.max_surfel_radius_deviations_ = max_surfel_radius_deviations.data();
+   node_arrays.visibilities_ = visibilities.data();
+
+   write(node_arrays);
+
    close_stream(false);
 
 }
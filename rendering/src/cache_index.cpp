@@ -7,6 +7,8 @@
 
 #include <lamure/ren/cache_index.h>
 
+#include <thread>
+
 
 namespace lamure
 {
@@ -14,9 +16,31 @@ namespace lamure
 namespace ren
 {
 
+namespace
+{
+
+const uint64_t empty_key = std::numeric_limits<uint64_t>::max();
+
+inline uint64_t make_key(const model_t model_id, const node_t node_id) {
+    return (uint64_t(model_id) << 32) | uint64_t(node_id);
+}
+
+//murmur3 finalizer, node ids of one model are dense
+inline uint64_t hash_key(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ull;
+    key ^= key >> 33;
+    return key;
+}
+
+}
+
 cache_index::
 cache_index(const model_t num_models, const slot_t num_slots)
-    : num_models_(num_models), num_slots_(num_slots), num_free_slots_(num_slots) {
+    : num_models_(num_models), num_slots_(num_slots), num_free_slots_(num_slots),
+      has_overflow_views_(false), entry_mask_(0), version_(0), num_views_(0) {
     assert(num_slots > 0);
 
     try {
@@ -27,7 +51,27 @@ cache_index(const model_t num_models, const slot_t num_slots)
       slots_[0].prev_ = invalid_slot_t;
       slots_[num_slots_ + 1].next_ = invalid_slot_t;
 
-      maps_.resize(num_models_);
+      view_masks_.reset(new std::atomic<uint64_t>[num_slots_ + 2]);
+      for (slot_t i = 0; i < num_slots_ + 2; ++i) {
+        view_masks_[i].store(0, std::memory_order_relaxed);
+      }
+
+      //keep the load factor below 1/2 so probe sequences stay short
+      size_t num_entries = 1;
+      while (num_entries < 2 * num_slots_) {
+        num_entries <<= 1;
+      }
+      entry_mask_ = num_entries - 1;
+
+      entries_.reset(new index_entry[num_entries]);
+      for (size_t i = 0; i < num_entries; ++i) {
+        entries_[i].key_.store(empty_key, std::memory_order_relaxed);
+        entries_[i].slot_.store(invalid_slot_t, std::memory_order_relaxed);
+      }
+
+      for (int i = 0; i < overflow_view_bit_; ++i) {
+        view_ids_[i].store(invalid_view_t, std::memory_order_relaxed);
+      }
     }
     catch (...) {
     }
@@ -38,10 +82,192 @@ cache_index::
 
 }
 
+const slot_t cache_index::
+probe(const uint64_t key) const {
+    size_t pos = hash_key(key) & entry_mask_;
+
+    //bounded, a concurrent writer may leave the table in a torn state
+    for (size_t i = 0; i <= entry_mask_; ++i) {
+        const uint64_t entry_key = entries_[pos].key_.load(std::memory_order_relaxed);
+        if (entry_key == key) {
+            return entries_[pos].slot_.load(std::memory_order_relaxed);
+        }
+        if (entry_key == empty_key) {
+            break;
+        }
+        pos = (pos + 1) & entry_mask_;
+    }
+
+    return invalid_slot_t;
+}
+
+const slot_t cache_index::
+find_slot(const model_t model_id, const node_t node_id, uint64_t *views) const {
+    const uint64_t key = make_key(model_id, node_id);
+
+    while (true) {
+        const uint64_t version = version_.load(std::memory_order_acquire);
+        if (version & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        const slot_t slot_id = probe(key);
+
+        //read inside the same version, so the slot cannot
+        //have been handed to another node in between
+        if (views != nullptr && slot_id != invalid_slot_t) {
+            *views = view_masks_[slot_id].load(std::memory_order_relaxed);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (version_.load(std::memory_order_relaxed) == version) {
+            return slot_id;
+        }
+    }
+}
+
+void cache_index::
+begin_write() {
+    version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void cache_index::
+end_write() {
+    version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void cache_index::
+insert_slot(const model_t model_id, const node_t node_id, const slot_t slot_id) {
+    const uint64_t key = make_key(model_id, node_id);
+    size_t pos = hash_key(key) & entry_mask_;
+
+    while (entries_[pos].key_.load(std::memory_order_relaxed) != empty_key) {
+        assert(entries_[pos].key_.load(std::memory_order_relaxed) != key);
+        pos = (pos + 1) & entry_mask_;
+    }
+
+    begin_write();
+    entries_[pos].slot_.store(slot_id, std::memory_order_relaxed);
+    entries_[pos].key_.store(key, std::memory_order_relaxed);
+    end_write();
+}
+
+void cache_index::
+erase_slot(const model_t model_id, const node_t node_id) {
+    const uint64_t key = make_key(model_id, node_id);
+    size_t hole = hash_key(key) & entry_mask_;
+
+    while (entries_[hole].key_.load(std::memory_order_relaxed) != key) {
+        if (entries_[hole].key_.load(std::memory_order_relaxed) == empty_key) {
+            return;
+        }
+        hole = (hole + 1) & entry_mask_;
+    }
+
+    begin_write();
+
+    //backward shift deletion, no tombstones
+    size_t pos = hole;
+    while (true) {
+        pos = (pos + 1) & entry_mask_;
+        const uint64_t entry_key = entries_[pos].key_.load(std::memory_order_relaxed);
+        if (entry_key == empty_key) {
+            break;
+        }
+
+        const size_t home = hash_key(entry_key) & entry_mask_;
+        if (((pos - home) & entry_mask_) >= ((pos - hole) & entry_mask_)) {
+            entries_[hole].slot_.store(entries_[pos].slot_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            entries_[hole].key_.store(entry_key, std::memory_order_relaxed);
+            hole = pos;
+        }
+    }
+
+    entries_[hole].key_.store(empty_key, std::memory_order_relaxed);
+    entries_[hole].slot_.store(invalid_slot_t, std::memory_order_relaxed);
+
+    end_write();
+}
+
+const int cache_index::
+find_view_bit(const view_t view_id) const {
+    const int num_views = num_views_.load(std::memory_order_acquire);
+    for (int i = 0; i < num_views; ++i) {
+        if (view_ids_[i].load(std::memory_order_relaxed) == view_id) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+const int cache_index::
+register_view_bit(const view_t view_id) {
+    //requires mutex_
+    int bit = find_view_bit(view_id);
+    if (bit >= 0) {
+        return bit;
+    }
+
+    bit = num_views_.load(std::memory_order_relaxed);
+    if (bit >= overflow_view_bit_) {
+        //all bits are taken, the view is kept in the per slot sets
+        has_overflow_views_.store(true, std::memory_order_relaxed);
+        return overflow_view_bit_;
+    }
+
+    view_ids_[bit].store(view_id, std::memory_order_relaxed);
+    num_views_.store(bit + 1, std::memory_order_release);
+
+    return bit;
+}
+
+const bool cache_index::
+insert_view(const slot_t slot_id, const int view_bit, const view_t view_id) {
+    //requires mutex_, returns false if the view holds the slot already
+    const uint64_t views = view_masks_[slot_id].load(std::memory_order_relaxed);
+
+    if (view_bit == overflow_view_bit_) {
+        if (!overflow_views_[slot_id].insert(view_id).second) {
+            return false;
+        }
+    }
+    else if (views & (uint64_t(1) << view_bit)) {
+        return false;
+    }
+
+    view_masks_[slot_id].store(views | (uint64_t(1) << view_bit), std::memory_order_release);
+    return true;
+}
+
+const bool cache_index::
+erase_view(const slot_t slot_id, const int view_bit, const view_t view_id) {
+    //requires mutex_, returns false if the view does not hold the slot
+    const uint64_t views = view_masks_[slot_id].load(std::memory_order_relaxed);
+
+    if (!(views & (uint64_t(1) << view_bit))) {
+        return false;
+    }
+
+    if (view_bit == overflow_view_bit_) {
+        auto overflow = overflow_views_.find(slot_id);
+        if (overflow == overflow_views_.end() || overflow->second.erase(view_id) == 0) {
+            return false;
+        }
+        if (!overflow->second.empty()) {
+            return true;
+        }
+        overflow_views_.erase(overflow);
+    }
+
+    view_masks_[slot_id].store(views & ~(uint64_t(1) << view_bit), std::memory_order_release);
+    return true;
+}
+
 const slot_t cache_index::
 num_free_slots() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return num_free_slots_;
+    return num_free_slots_.load(std::memory_order_relaxed);
 }
 
 const slot_t cache_index::
@@ -69,10 +295,10 @@ reserve_slot() {
     node.prev_ = invalid_slot_t;
     node.next_ = invalid_slot_t;
 
-    assert(node.views_.empty());
+    assert(view_masks_[slot_id].load(std::memory_order_relaxed) == 0);
 
     if (node.node_id_ != invalid_node_t) {
-        maps_[node.model_id_].erase(node.node_id_);
+        erase_slot(node.model_id_, node.node_id_);
     }
 
     node.node_id_ = invalid_node_t;
@@ -96,8 +322,8 @@ apply_slot(const slot_t slot_id, const model_t model_id, const node_t node_id) {
     assert(node.next_ == invalid_slot_t);
     assert(node.node_id_ == invalid_node_t);
     assert(node.model_id_ == invalid_model_t);
-    assert(node.views_.empty());
-    assert(maps_[model_id].find(node_id) == maps_[model_id].end());
+    assert(view_masks_[slot_id+1].load(std::memory_order_relaxed) == 0);
+    assert(find_slot(model_id, node_id) == invalid_slot_t);
 
     node.node_id_ = node_id;
     node.model_id_ = model_id;
@@ -109,7 +335,7 @@ apply_slot(const slot_t slot_id, const model_t model_id, const node_t node_id) {
     slots_[slots_[num_slots_+1].prev_].next_ = slot_id+1;
     slots_[num_slots_+1].prev_ = slot_id+1;
 
-    maps_[model_id][node_id] = slot_id+1;
+    insert_slot(model_id, node_id, slot_id+1);
 
     if (num_free_slots_ < num_slots_) {
         ++num_free_slots_;
@@ -128,7 +354,7 @@ unreserve_slot(const slot_t slot_id) {
     assert(node.next_ == invalid_slot_t);
 
     //assert slot was not aquired by any views
-    assert(node.views_.empty());
+    assert(view_masks_[slot_id+1].load(std::memory_order_relaxed) == 0);
 
     //insert to head
     node.prev_ = 0;
@@ -141,13 +367,14 @@ unreserve_slot(const slot_t slot_id) {
     //but let's keep it for sanity
     {
         if (node.node_id_ != invalid_node_t) {
-            maps_[node.model_id_].erase(node.node_id_);
+            erase_slot(node.model_id_, node.node_id_);
         }
 
         node.node_id_ = invalid_node_t;
         node.model_id_ = invalid_model_t;
 
-        node.views_.clear();
+        view_masks_[slot_id+1].store(0, std::memory_order_relaxed);
+        overflow_views_.erase(slot_id+1);
     }
 
     if (num_free_slots_ < num_slots_) {
@@ -157,66 +384,62 @@ unreserve_slot(const slot_t slot_id) {
 
 const slot_t cache_index::
 get_slot(const model_t model_id, const node_t node_id) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
-    const auto it = maps_[model_id].find(node_id);
+    slot_t slot_id = find_slot(model_id, node_id);
 
     //this raises when slot was not applied
-    assert(it != maps_[model_id].end());
+    assert(slot_id != invalid_slot_t);
 
-    //assert that this slot was actually aquired
-    slot_t slot_id = it->second;
-    
     //this raises if attempting to access a slot that was not aquired
     //and, thus, is in danger of being overriden very soon
-    assert(!slots_[slot_id].views_.empty());
-
-    //assert slot was removed from linked list
-    assert(slots_[slot_id].prev_ == invalid_slot_t);
-    assert(slots_[slot_id].next_ == invalid_slot_t);
-
-    assert(slot_id != invalid_slot_t);
+    assert(view_masks_[slot_id].load(std::memory_order_relaxed) != 0);
 
     return slot_id-1;
 }
 
 const bool cache_index::
 is_node_indexed(const model_t model_id, const node_t node_id) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return maps_[model_id].find(node_id) != maps_[model_id].end();
+    return find_slot(model_id, node_id) != invalid_slot_t;
 }
 
 const bool cache_index::
 is_node_aquired(const model_t model_id, const node_t node_id) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
-    const auto it = maps_[model_id].find(node_id);
-    if (it == maps_[model_id].end()) {
+    uint64_t views = 0;
+    if (find_slot(model_id, node_id, &views) == invalid_slot_t) {
       return false;
     }
 
-    slot_t slot_id = it->second;
-    cache_index_node& node = slots_[slot_id];
-
-    return !node.views_.empty();
+    return views != 0;
 }
 
 void cache_index::
 aquire_slot(const view_t view_id, const model_t model_id, const node_t node_id) {
 
+    int view_bit = find_view_bit(view_id);
+
+    //nothing to do if the view holds the slot already
+    if (view_bit >= 0) {
+        uint64_t views = 0;
+        slot_t slot_id = find_slot(model_id, node_id, &views);
+        assert(slot_id != invalid_slot_t);
+
+        if (views & (uint64_t(1) << view_bit)) {
+            return;
+        }
+    }
+
     std::lock_guard<std::mutex> lock(mutex_);
 
-    const auto it = maps_[model_id].find(node_id);
+    if (view_bit < 0) {
+        view_bit = register_view_bit(view_id);
+    }
+
+    slot_t slot_id = find_slot(model_id, node_id);
 
     //this raises when node was not applied
-    assert(it != maps_[model_id].end());
+    assert(slot_id != invalid_slot_t);
 
-    slot_t slot_id = it->second;
     cache_index_node& node = slots_[slot_id];
-
-    if (node.views_.find(view_id) == node.views_.end()) {
-        node.views_.insert(view_id);
-
+    if (insert_view(slot_id, view_bit, view_id)) {
         //if slot was not removed from linked list
         if (node.prev_ != invalid_slot_t || node.next_ != invalid_slot_t) {
             assert(node.prev_ != invalid_slot_t);
@@ -241,20 +464,42 @@ aquire_slot(const view_t view_id, const model_t model_id, const node_t node_id)
 
 void cache_index::
 release_slot(const view_t view_id, const model_t model_id, const node_t node_id) {
+    int view_bit = find_view_bit(view_id);
+
+    //view never aquired anything
+    if (view_bit < 0 && !has_overflow_views_.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    //nothing to do if the view does not hold the slot
+    if (view_bit >= 0) {
+        uint64_t views = 0;
+        slot_t slot_id = find_slot(model_id, node_id, &views);
+        assert(slot_id != invalid_slot_t);
+
+        if (!(views & (uint64_t(1) << view_bit))) {
+            return;
+        }
+    }
+
     std::lock_guard<std::mutex> lock(mutex_);
 
-    const auto it = maps_[model_id].find(node_id);
+    if (view_bit < 0) {
+        view_bit = find_view_bit(view_id);
+        if (view_bit < 0) {
+            view_bit = overflow_view_bit_;
+        }
+    }
+
+    slot_t slot_id = find_slot(model_id, node_id);
 
     //this raises when node was not  applied
-    assert(it != maps_[model_id].end());
+    assert(slot_id != invalid_slot_t);
 
-    slot_t slot_id = it->second;
     cache_index_node& node = slots_[slot_id];
 
-    if (node.views_.find(view_id) != node.views_.end()) {
-        node.views_.erase(view_id);
-
-        if (node.views_.empty()) {
+    if (erase_view(slot_id, view_bit, view_id)) {
+        if (view_masks_[slot_id].load(std::memory_order_relaxed) == 0) {
             //if slot was removed from linked list
             if (node.prev_ == invalid_slot_t && node.next_ == invalid_slot_t) {
                 //insert node at tail
@@ -282,20 +527,31 @@ release_slot_invalidate(const view_t view_id, const model_t model_id, const node
     //return true if and only if the slot was invalidated
     //during current function call
 
+    int view_bit = find_view_bit(view_id);
+
+    //view never aquired anything
+    if (view_bit < 0 && !has_overflow_views_.load(std::memory_order_relaxed)) {
+        return false;
+    }
+
     std::lock_guard<std::mutex> lock(mutex_);
 
-    const auto it = maps_[model_id].find(node_id);
+    if (view_bit < 0) {
+        view_bit = find_view_bit(view_id);
+        if (view_bit < 0) {
+            view_bit = overflow_view_bit_;
+        }
+    }
+
+    slot_t slot_id = find_slot(model_id, node_id);
 
     //this raises when node was not  applied
-    assert(it != maps_[model_id].end());
+    assert(slot_id != invalid_slot_t);
 
-    slot_t slot_id = it->second;
     cache_index_node& node = slots_[slot_id];
 
-    if (node.views_.find(view_id) != node.views_.end()) {
-        node.views_.erase(view_id);
-
-        if (node.views_.empty()) {
+    if (erase_view(slot_id, view_bit, view_id)) {
+        if (view_masks_[slot_id].load(std::memory_order_relaxed) == 0) {
             //if slot was removed from linked list
             if (node.prev_ == invalid_slot_t && node.next_ == invalid_slot_t) {
                 //insert to head
@@ -311,7 +567,7 @@ release_slot_invalidate(const view_t view_id, const model_t model_id, const node
 
                 //invalidate slot
                 if (node.node_id_ != invalid_node_t) {
-                    maps_[node.model_id_].erase(node.node_id_);
+                    erase_slot(node.model_id_, node.node_id_);
                 }
 
                 node.node_id_ = invalid_node_t;
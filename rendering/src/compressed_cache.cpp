@@ -0,0 +1,300 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group 
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#include <lamure/ren/compressed_cache.h>
+#include <lamure/ren/model_database.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+namespace lamure
+{
+namespace ren
+{
+
+namespace
+{
+
+struct compressed_header
+{
+    float min_[3];
+    float scale_[3];
+    float max_size_;
+    uint32_t num_surfels_;
+};
+
+struct compressed_surfel
+{
+    uint16_t x_, y_, z_;
+    uint8_t r_, g_, b_, fake_;
+    uint16_t size_;
+    uint16_t normal_u_, normal_v_;
+};
+
+static_assert(sizeof(compressed_header) == 32, "compressed_header is expected to be 32 bytes");
+static_assert(sizeof(compressed_surfel) == 16, "compressed_surfel is expected to be 16 bytes");
+
+const float max_quantized = 65535.f;
+
+uint16_t quantize(const float value, const float min, const float scale)
+{
+    float quantized = scale > 0.f ? (value - min) / scale + 0.5f : 0.f;
+    // also catches nan
+    if(!(quantized > 0.f))
+    {
+        return 0;
+    }
+    return uint16_t(std::min(quantized, max_quantized));
+}
+
+float sign_not_zero(const float value) { return value < 0.f ? -1.f : 1.f; }
+
+}
+
+const uint64_t compressed_cache::invalid_key;
+
+compressed_cache::compressed_cache(const size_t budget_in_bytes) : slot_size_(0), num_slots_(0), num_used_slots_(0), clock_hand_(0), cache_data_(nullptr)
+{
+    model_database *database = model_database::get_instance();
+
+    primitives_per_node_.resize(database->num_models(), 0);
+
+    for(model_t model_id = 0; model_id < database->num_models(); ++model_id)
+    {
+        // quantized point clouds and meshes are stored as they are in the ooc_cache
+        if(database->get_model(model_id)->get_bvh()->get_primitive() == bvh::primitive_type::POINTCLOUD)
+        {
+            primitives_per_node_[model_id] = database->get_primitives_per_node(model_id);
+            slot_size_ = std::max(slot_size_, compressed_size(primitives_per_node_[model_id]));
+        }
+    }
+
+    if(slot_size_ == 0)
+    {
+        return;
+    }
+
+    num_slots_ = budget_in_bytes / slot_size_;
+    cache_data_ = new char[num_slots_ * slot_size_];
+
+    slot_keys_.resize(num_slots_, invalid_key);
+    referenced_.resize(num_slots_, 0);
+    slots_.reserve(num_slots_);
+
+#ifdef LAMURE_ENABLE_INFO
+    std::cout << "lamure: compressed cache init (" << num_slots_ << " nodes)" << std::endl;
+#endif
+}
+
+compressed_cache::~compressed_cache()
+{
+    if(cache_data_ != nullptr)
+    {
+        delete[] cache_data_;
+        cache_data_ = nullptr;
+    }
+}
+
+const size_t compressed_cache::compressed_size(const size_t num_surfels) { return sizeof(compressed_header) + num_surfels * sizeof(compressed_surfel); }
+
+void compressed_cache::encode(const dataset::serialized_surfel *surfels, const size_t num_surfels, char *compressed)
+{
+    compressed_header *header = reinterpret_cast<compressed_header *>(compressed);
+    compressed_surfel *quantized = reinterpret_cast<compressed_surfel *>(compressed + sizeof(compressed_header));
+
+    // bounds of the surfels in use, nodes are padded with zero radius surfels
+    float min[3] = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+    float max[3] = {std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()};
+    float max_size = 0.f;
+
+    for(size_t i = 0; i < num_surfels; ++i)
+    {
+        const dataset::serialized_surfel &surfel = surfels[i];
+        if(!(surfel.size > 0.f) || !std::isfinite(surfel.size) || !std::isfinite(surfel.x) || !std::isfinite(surfel.y) || !std::isfinite(surfel.z))
+        {
+            continue;
+        }
+        min[0] = std::min(min[0], surfel.x);
+        min[1] = std::min(min[1], surfel.y);
+        min[2] = std::min(min[2], surfel.z);
+        max[0] = std::max(max[0], surfel.x);
+        max[1] = std::max(max[1], surfel.y);
+        max[2] = std::max(max[2], surfel.z);
+        max_size = std::max(max_size, surfel.size);
+    }
+
+    for(uint32_t axis = 0; axis < 3; ++axis)
+    {
+        if(max_size > 0.f)
+        {
+            header->min_[axis] = min[axis];
+            header->scale_[axis] = (max[axis] - min[axis]) / max_quantized;
+        }
+        else
+        {
+            header->min_[axis] = 0.f;
+            header->scale_[axis] = 0.f;
+        }
+    }
+    header->max_size_ = max_size;
+    header->num_surfels_ = num_surfels;
+
+    for(size_t i = 0; i < num_surfels; ++i)
+    {
+        const dataset::serialized_surfel &surfel = surfels[i];
+        compressed_surfel &q = quantized[i];
+
+        q.x_ = quantize(surfel.x, header->min_[0], header->scale_[0]);
+        q.y_ = quantize(surfel.y, header->min_[1], header->scale_[1]);
+        q.z_ = quantize(surfel.z, header->min_[2], header->scale_[2]);
+        q.r_ = surfel.r;
+        q.g_ = surfel.g;
+        q.b_ = surfel.b;
+        q.fake_ = surfel.fake;
+
+        // a surfel in use never ends up with a zero radius
+        q.size_ = surfel.size > 0.f && std::isfinite(surfel.size) ? std::max(uint16_t(1), quantize(surfel.size, 0.f, max_size / max_quantized)) : 0;
+
+        // octahedral mapping, the lower hemisphere is folded over the diagonals
+        float length = std::abs(surfel.nx) + std::abs(surfel.ny) + std::abs(surfel.nz);
+        float u = 0.f;
+        float v = 0.f;
+        if(length > 0.f && std::isfinite(length))
+        {
+            u = surfel.nx / length;
+            v = surfel.ny / length;
+            if(surfel.nz < 0.f)
+            {
+                float folded_u = (1.f - std::abs(v)) * sign_not_zero(u);
+                v = (1.f - std::abs(u)) * sign_not_zero(v);
+                u = folded_u;
+            }
+        }
+        q.normal_u_ = quantize(u, -1.f, 2.f / max_quantized);
+        q.normal_v_ = quantize(v, -1.f, 2.f / max_quantized);
+    }
+}
+
+void compressed_cache::decode(const char *compressed, const size_t num_surfels, dataset::serialized_surfel *surfels)
+{
+    const compressed_header *header = reinterpret_cast<const compressed_header *>(compressed);
+    const compressed_surfel *quantized = reinterpret_cast<const compressed_surfel *>(compressed + sizeof(compressed_header));
+
+    assert(header->num_surfels_ == num_surfels);
+
+    const float size_scale = header->max_size_ / max_quantized;
+    const float normal_scale = 2.f / max_quantized;
+
+    for(size_t i = 0; i < num_surfels; ++i)
+    {
+        const compressed_surfel &q = quantized[i];
+        dataset::serialized_surfel &surfel = surfels[i];
+
+        if(q.size_ == 0)
+        {
+            memset(&surfel, 0, sizeof(dataset::serialized_surfel));
+            continue;
+        }
+
+        surfel.x = header->min_[0] + q.x_ * header->scale_[0];
+        surfel.y = header->min_[1] + q.y_ * header->scale_[1];
+        surfel.z = header->min_[2] + q.z_ * header->scale_[2];
+        surfel.r = q.r_;
+        surfel.g = q.g_;
+        surfel.b = q.b_;
+        surfel.fake = q.fake_;
+        surfel.size = q.size_ * size_scale;
+
+        float u = q.normal_u_ * normal_scale - 1.f;
+        float v = q.normal_v_ * normal_scale - 1.f;
+        float w = 1.f - std::abs(u) - std::abs(v);
+        if(w < 0.f)
+        {
+            float unfolded_u = (1.f - std::abs(v)) * sign_not_zero(u);
+            v = (1.f - std::abs(u)) * sign_not_zero(v);
+            u = unfolded_u;
+        }
+        float inverse_length = 1.f / std::sqrt(u * u + v * v + w * w);
+        surfel.nx = u * inverse_length;
+        surfel.ny = v * inverse_length;
+        surfel.nz = w * inverse_length;
+    }
+}
+
+void compressed_cache::insert(const model_t model_id, const node_t node_id, const char *node_data)
+{
+    if(num_slots_ == 0 || !is_compressible(model_id))
+    {
+        return;
+    }
+
+    // encode outside of the lock, loader threads insert concurrently
+    static thread_local std::vector<char> compressed;
+    const size_t num_surfels = primitives_per_node_[model_id];
+    compressed.resize(compressed_size(num_surfels));
+    encode(reinterpret_cast<const dataset::serialized_surfel *>(node_data), num_surfels, compressed.data());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    const uint64_t node_key = key(model_id, node_id);
+    auto existing = slots_.find(node_key);
+    if(existing != slots_.end())
+    {
+        referenced_[existing->second] = 1;
+        return;
+    }
+
+    size_t slot_id = 0;
+    if(num_used_slots_ < num_slots_)
+    {
+        slot_id = num_used_slots_++;
+    }
+    else
+    {
+        // second chance for every node decoded since the hand passed it
+        while(referenced_[clock_hand_] != 0)
+        {
+            referenced_[clock_hand_] = 0;
+            clock_hand_ = (clock_hand_ + 1) % num_slots_;
+        }
+        slot_id = clock_hand_;
+        clock_hand_ = (clock_hand_ + 1) % num_slots_;
+        slots_.erase(slot_keys_[slot_id]);
+    }
+
+    memcpy(cache_data_ + slot_id * slot_size_, compressed.data(), compressed.size());
+    slot_keys_[slot_id] = node_key;
+    referenced_[slot_id] = 0;
+    slots_[node_key] = slot_id;
+}
+
+const bool compressed_cache::decompress(const model_t model_id, const node_t node_id, char *node_data)
+{
+    if(num_slots_ == 0 || !is_compressible(model_id))
+    {
+        return false;
+    }
+
+    // decoding under the lock keeps the slot from being replaced meanwhile
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto slot = slots_.find(key(model_id, node_id));
+    if(slot == slots_.end())
+    {
+        return false;
+    }
+
+    referenced_[slot->second] = 1;
+    decode(cache_data_ + slot->second * slot_size_, primitives_per_node_[model_id], reinterpret_cast<dataset::serialized_surfel *>(node_data));
+    return true;
+}
+
+} // namespace ren
+
+} // namespace lamure
@@ -13,6 +13,7 @@ namespace lamure
 namespace ren
 {
 
+const uint32_t cut_update_index::invalid_link;
 
 cut_update_index::
 cut_update_index()
@@ -24,20 +25,23 @@ cut_update_index()
 
     num_models_ = database->num_models();
 
+    for (model_t model_id = 0; model_id < num_models_; ++model_id) {
+        fan_factor_table_.push_back(database->get_model(model_id)->get_bvh()->get_fan_factor());
+        num_nodes_table_.push_back(database->get_model(model_id)->get_bvh()->get_num_nodes());
+    }
+
     for (int32_t queue_id = 0; queue_id < queue_t::NUM_QUEUES; ++queue_id) {
         num_slots_[queue_id] = 0;
-        slot_maps_[queue_id].resize(num_models_);
+        first_slots_[queue_id].resize(num_models_);
+        for (model_t model_id = 0; model_id < num_models_; ++model_id) {
+            first_slots_[queue_id][model_id].assign(num_nodes_table_[model_id], invalid_link);
+        }
     }
 
-    for (const auto& view_id : view_ids_) {
-        front_a_cuts_[view_id].resize(num_models_);
-        front_b_cuts_[view_id].resize(num_models_);
-    }
+    remaining_actions_.resize(num_models_);
 
-    for (model_t model_id = 0; model_id < num_models_; ++model_id) {
-        fan_factor_table_.push_back(database->get_model(model_id)->get_bvh()->get_fan_factor());
-        num_nodes_table_.push_back(database->get_model(model_id)->get_bvh()->get_num_nodes());
-    }
+    front_a_cuts_.resize(view_ids_.size(), std::vector<std::vector<node_t>>(num_models_));
+    front_b_cuts_.resize(view_ids_.size(), std::vector<std::vector<node_t>>(num_models_));
 
 }
 
@@ -65,19 +69,6 @@ update_policy(const view_t num_views) {
     if (database->num_models() != num_models_) {
         num_models_ = database->num_models();
 
-        for (int32_t queue_id = 0; queue_id < queue_t::NUM_QUEUES; ++queue_id) {
-            num_slots_[queue_id] = 0;
-            slot_maps_[queue_id].clear();
-            slot_maps_[queue_id].resize(num_models_);
-        }
-
-        for (const auto& view_id : view_ids_) {
-            front_a_cuts_[view_id].clear();
-            front_a_cuts_[view_id].resize(num_models_);
-            front_b_cuts_[view_id].clear();
-            front_b_cuts_[view_id].resize(num_models_);
-        }
-
         fan_factor_table_.clear();
         num_nodes_table_.clear();
 
@@ -86,12 +77,29 @@ update_policy(const view_t num_views) {
             num_nodes_table_.push_back(database->get_model(model_id)->get_bvh()->get_num_nodes());
         }
 
+        for (int32_t queue_id = 0; queue_id < queue_t::NUM_QUEUES; ++queue_id) {
+            num_slots_[queue_id] = 0;
+            slots_[queue_id].clear();
+            slot_links_[queue_id].clear();
+            first_slots_[queue_id].clear();
+            first_slots_[queue_id].resize(num_models_);
+            for (model_t model_id = 0; model_id < num_models_; ++model_id) {
+                first_slots_[queue_id][model_id].assign(num_nodes_table_[model_id], invalid_link);
+            }
+        }
+
+        remaining_actions_.clear();
+        remaining_actions_.resize(num_models_);
+
+        front_a_cuts_.clear();
+        front_a_cuts_.resize(view_ids_.size(), std::vector<std::vector<node_t>>(num_models_));
+        front_b_cuts_.clear();
+        front_b_cuts_.resize(view_ids_.size(), std::vector<std::vector<node_t>>(num_models_));
+
     }
     else if (num_views_ > prev_num_views) {
-        for (const auto& view_id : view_ids_) {
-            front_a_cuts_[view_id].resize(num_models_);
-            front_b_cuts_[view_id].resize(num_models_);
-        }
+        front_a_cuts_.resize(view_ids_.size(), std::vector<std::vector<node_t>>(num_models_));
+        front_b_cuts_.resize(view_ids_.size(), std::vector<std::vector<node_t>>(num_models_));
     }
 
 
@@ -120,50 +128,42 @@ num_actions(const queue_t queue) {
     return num_slots_[queue];
 }
 
-const std::set<node_t>& cut_update_index::
-get_current_cut(const view_t view_id, const model_t model_id) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
-    assert(view_ids_.find(view_id) != view_ids_.end());
-    assert(model_id < num_models_);
-
-    switch (current_cut_front_) {
-        case cut_front::FRONT_A:
-            return front_a_cuts_[view_id][model_id];
-            break;
-
-        case cut_front::FRONT_B:
-            return front_b_cuts_[view_id][model_id];
-            break;
+std::vector<node_t>& cut_update_index::
+current_cut(const view_t view_id, const model_t model_id) {
+    if (current_cut_front_ == cut_front::FRONT_B) {
+        return front_b_cuts_[view_id][model_id];
+    }
 
-        default: break;
+    return front_a_cuts_[view_id][model_id];
+}
 
+std::vector<node_t>& cut_update_index::
+previous_cut(const view_t view_id, const model_t model_id) {
+    if (current_cut_front_ == cut_front::FRONT_B) {
+        return front_a_cuts_[view_id][model_id];
     }
 
-    return front_a_cuts_[view_id][model_id];
+    return front_b_cuts_[view_id][model_id];
 }
 
-const std::set<node_t>& cut_update_index::
-get_previous_cut(const view_t view_id, const model_t model_id) {
+const std::vector<node_t>& cut_update_index::
+get_current_cut(const view_t view_id, const model_t model_id) {
     std::lock_guard<std::mutex> lock(mutex_);
 
     assert(view_ids_.find(view_id) != view_ids_.end());
     assert(model_id < num_models_);
 
-    switch (current_cut_front_) {
-        case cut_front::FRONT_A:
-            return front_b_cuts_[view_id][model_id];
-            break;
-
-        case cut_front::FRONT_B:
-            return front_a_cuts_[view_id][model_id];
-            break;
+    return current_cut(view_id, model_id);
+}
 
-        default: break;
+const std::vector<node_t>& cut_update_index::
+get_previous_cut(const view_t view_id, const model_t model_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
 
-    }
+    assert(view_ids_.find(view_id) != view_ids_.end());
+    assert(model_id < num_models_);
 
-    return front_b_cuts_[view_id][model_id];
+    return previous_cut(view_id, model_id);
 }
 
 void cut_update_index::
@@ -186,18 +186,7 @@ reset_cut(const view_t view_id, const model_t model_id) {
     assert(view_ids_.find(view_id) != view_ids_.end());
     assert(model_id < num_models_);
 
-    switch (current_cut_front_) {
-        case cut_front::FRONT_A:
-            front_a_cuts_[view_id][model_id].clear();
-            break;
-
-        case cut_front::FRONT_B:
-            front_b_cuts_[view_id][model_id].clear();
-            break;
-
-        default: break;
-
-    }
+    current_cut(view_id, model_id).clear();
 
 }
 
@@ -248,26 +237,18 @@ pop_front_action(const queue_t queue) {
 
     assert(queue < queue_t::NUM_QUEUES);
     assert(!slots_[queue].empty());
-
-    action action = slots_[queue].front();
-    assert(action.queue_ == queue);
+    assert(slots_[queue].front().queue_ == queue);
 
     swap(queue, 0, num_slots_[queue]-1);
 
-
-    assert(slot_maps_[queue][action.model_id_][action.node_id_].find(num_slots_[queue]-1) != slot_maps_[queue][action.model_id_][action.node_id_].end());
-
+    unlink_slot(queue, num_slots_[queue]-1);
     slots_[queue].pop_back();
-    slot_maps_[queue][action.model_id_][action.node_id_].erase(num_slots_[queue]-1);
+    slot_links_[queue].pop_back();
 
     --num_slots_[queue];
 
     shuffle_down(queue, 0);
 
-    if (slot_maps_[queue][action.model_id_][action.node_id_].empty()) {
-        slot_maps_[queue][action.model_id_].erase(action.node_id_);
-    }
-
 }
 
 void cut_update_index::
@@ -276,116 +257,55 @@ Popback_action(const queue_t queue) {
 
     assert(queue < queue_t::NUM_QUEUES);
     assert(!slots_[queue].empty());
+    assert(slots_[queue].back().queue_ == queue);
 
-    action action = slots_[queue].back();
-    assert(action.queue_ == queue);
-
-    assert(slot_maps_[queue][action.model_id_][action.node_id_].find(num_slots_[queue]-1) != slot_maps_[queue][action.model_id_][action.node_id_].end());
-
-
+    unlink_slot(queue, num_slots_[queue]-1);
     slots_[queue].pop_back();
-    slot_maps_[queue][action.model_id_][action.node_id_].erase(num_slots_[queue]-1);
+    slot_links_[queue].pop_back();
 
     --num_slots_[queue];
 
-    if (slot_maps_[queue][action.model_id_][action.node_id_].empty()) {
-        slot_maps_[queue][action.model_id_].erase(action.node_id_);
-    }
-
 }
 
 void cut_update_index::
 approve_action(const action& action) {
     std::lock_guard<std::mutex> lock(mutex_);
 
+    approve_action_unlocked(action);
+}
+
+void cut_update_index::
+approve_action_unlocked(const action& action) {
     assert(action.model_id_ < num_models_);
     assert(action.node_id_ < num_nodes_table_[action.model_id_]);
     assert(action.queue_ < queue_t::NUM_QUEUES);
 
+    std::vector<node_t>& cut = current_cut(action.view_id_, action.model_id_);
+
     //approve action, this adds the action to all cuts of all the users in question.
     switch (action.queue_) {
         case queue_t::KEEP:
-            switch (current_cut_front_) {
-                case cut_front::FRONT_A:
-                    front_a_cuts_[action.view_id_][action.model_id_].insert(action.node_id_);
-                    break;
-
-                case cut_front::FRONT_B:
-                    front_b_cuts_[action.view_id_][action.model_id_].insert(action.node_id_);
-                    break;
-
-                default: break;
-
-            }
+            cut.push_back(action.node_id_);
             break;
 
         case queue_t::MUST_SPLIT:
-            {
-                std::vector<node_t> children;
-                get_all_children(action.model_id_, action.node_id_, children);
-
-                switch (current_cut_front_) {
-                    case cut_front::FRONT_A:
-                        front_a_cuts_[action.view_id_][action.model_id_].insert(children.begin(), children.end());
-                        break;
-
-                    case cut_front::FRONT_B:
-                        front_b_cuts_[action.view_id_][action.model_id_].insert(children.begin(), children.end());
-                        break;
-
-                    default: break;
-
-                }
-
+            for (node_t i = 0; i < (node_t)fan_factor_table_[action.model_id_]; ++i) {
+                cut.push_back(get_child_id(action.model_id_, action.node_id_, i));
             }
             break;
 
         case queue_t::MUST_COLLAPSE:
-            switch (current_cut_front_) {
-                case cut_front::FRONT_A:
-                    front_a_cuts_[action.view_id_][action.model_id_].insert(action.node_id_);
-                    break;
-
-                case cut_front::FRONT_B:
-                    front_b_cuts_[action.view_id_][action.model_id_].insert(action.node_id_);
-                    break;
-
-                default: break;
-
-            }
+            cut.push_back(action.node_id_);
             break;
 
         case queue_t::COLLAPSE_ON_NEED:
             //if a collapse-on-need-action is approved, we collapse the node
-            switch (current_cut_front_) {
-                case cut_front::FRONT_A:
-                    front_a_cuts_[action.view_id_][action.model_id_].insert(action.node_id_);
-                    break;
-
-                case cut_front::FRONT_B:
-                    front_b_cuts_[action.view_id_][action.model_id_].insert(action.node_id_);
-                    break;
-
-                default: break;
-
-            }
+            cut.push_back(action.node_id_);
             break;
 
-
         case queue_t::MAYBE_COLLAPSE:
             //if a maybe-collapse-action is approved, we collapse the node
-            switch (current_cut_front_) {
-                case cut_front::FRONT_A:
-                    front_a_cuts_[action.view_id_][action.model_id_].insert(action.node_id_);
-                    break;
-
-                case cut_front::FRONT_B:
-                    front_b_cuts_[action.view_id_][action.model_id_].insert(action.node_id_);
-                    break;
-
-                default: break;
-
-            }
+            cut.push_back(action.node_id_);
             break;
 
         default: break;
@@ -397,10 +317,17 @@ void cut_update_index::
 reject_action(const action& action) {
     std::lock_guard<std::mutex> lock(mutex_);
 
+    reject_action_unlocked(action);
+}
+
+void cut_update_index::
+reject_action_unlocked(const action& action) {
     assert(action.model_id_ < num_models_);
     assert(action.node_id_ < num_nodes_table_[action.model_id_]);
     assert(action.queue_ < queue_t::NUM_QUEUES);
 
+    std::vector<node_t>& cut = current_cut(action.view_id_, action.model_id_);
+
     //raise replacement action
     switch (action.queue_) {
         case queue_t::KEEP:
@@ -408,75 +335,15 @@ reject_action(const action& action) {
             break;
 
         case queue_t::MUST_SPLIT:
-            switch (current_cut_front_) {
-                case cut_front::FRONT_A:
-                    front_a_cuts_[action.view_id_][action.model_id_].insert(action.node_id_);
-                    break;
-
-                case cut_front::FRONT_B:
-                    front_b_cuts_[action.view_id_][action.model_id_].insert(action.node_id_);
-                    break;
-
-                default: break;
-
-            }
-            break;
-
-        case queue_t::MUST_COLLAPSE: {
-                std::vector<node_t> children;
-                get_all_children(action.model_id_, action.node_id_, children);
-
-                switch (current_cut_front_) {
-                    case cut_front::FRONT_A:
-                        front_a_cuts_[action.view_id_][action.model_id_].insert(children.begin(), children.end());
-                        break;
-
-                    case cut_front::FRONT_B:
-                        front_b_cuts_[action.view_id_][action.model_id_].insert(children.begin(), children.end());
-                        break;
-
-                    default: break;
-
-                }
-            }
-            break;
-
-        case queue_t::COLLAPSE_ON_NEED: {
-                std::vector<node_t> children;
-                get_all_children(action.model_id_, action.node_id_, children);
-
-                switch (current_cut_front_) {
-                    case cut_front::FRONT_A:
-                        front_a_cuts_[action.view_id_][action.model_id_].insert(children.begin(), children.end());
-                        break;
-
-                    case cut_front::FRONT_B:
-                        front_b_cuts_[action.view_id_][action.model_id_].insert(children.begin(), children.end());
-                        break;
-
-                    default: break;
-
-                }
-            }
+            cut.push_back(action.node_id_);
             break;
 
+        case queue_t::MUST_COLLAPSE:
+        case queue_t::COLLAPSE_ON_NEED:
         case queue_t::MAYBE_COLLAPSE:
-            {
-                std::vector<node_t> children;
-                get_all_children(action.model_id_, action.node_id_, children);
-
-                switch (current_cut_front_) {
-                    case cut_front::FRONT_A:
-                        front_a_cuts_[action.view_id_][action.model_id_].insert(children.begin(), children.end());
-                        break;
-
-                    case cut_front::FRONT_B:
-                        front_b_cuts_[action.view_id_][action.model_id_].insert(children.begin(), children.end());
-                        break;
-
-                    default: break;
-
-                }
+            //the children stay in the cut
+            for (node_t i = 0; i < (node_t)fan_factor_table_[action.model_id_]; ++i) {
+                cut.push_back(get_child_id(action.model_id_, action.node_id_, i));
             }
             break;
 
@@ -492,13 +359,7 @@ add_action(const action& action, bool sort) {
     assert(action.queue_ < queue_t::NUM_QUEUES);
 
     if (sort) {
-        slots_[action.queue_].push_back(action);
-        ++num_slots_[action.queue_];
-
-        slot_maps_[action.queue_][action.model_id_][action.node_id_].insert(num_slots_[action.queue_]-1);
-
-        shuffle_up(action.queue_, num_slots_[action.queue_]-1);
-
+        insert_action(action);
     }
     else {
         initial_queue_.push(action);
@@ -506,6 +367,17 @@ add_action(const action& action, bool sort) {
 
 }
 
+void cut_update_index::
+insert_action(const action& action) {
+    slots_[action.queue_].push_back(action);
+    slot_links_[action.queue_].push_back(slot_link());
+    ++num_slots_[action.queue_];
+
+    link_slot(action.queue_, num_slots_[action.queue_]-1);
+
+    shuffle_up(action.queue_, num_slots_[action.queue_]-1);
+}
+
 void cut_update_index::
 cancel_action(const view_t view_id, const model_t model_id, const node_t node_id) {
     assert(model_id < num_models_);
@@ -514,101 +386,132 @@ cancel_action(const view_t view_id, const model_t model_id, const node_t node_id
 
     //firstly, cancel actions that already happened (remove nodes from cuts)
 
-    switch (current_cut_front_) {
-        case cut_front::FRONT_A:
-            if (front_a_cuts_[view_id][model_id].find(node_id) != front_a_cuts_[view_id][model_id].end()) {
-                front_a_cuts_[view_id][model_id].erase(node_id);
-            }
-            break;
-
-        case cut_front::FRONT_B:
-            if (front_b_cuts_[view_id][model_id].find(node_id) != front_b_cuts_[view_id][model_id].end()) {
-                front_b_cuts_[view_id][model_id].erase(node_id);
-            }
-            break;
-
-        default: break;
-
-    }
+    std::vector<node_t>& cut = current_cut(view_id, model_id);
+    cut.erase(std::remove(cut.begin(), cut.end(), node_id), cut.end());
 
     //secondly, cancel all pending actions (remove actions from queues)
 
     for (uint32_t queue = 0; queue < queue_t::NUM_QUEUES; ++queue) {
-        const auto slot_it = slot_maps_[queue][model_id].find(node_id);
+        uint32_t slot_id = first_slots_[queue][model_id][node_id];
 
-        if (slot_it == slot_maps_[queue][model_id].end()) {
-            continue;
-        }
+        while (slot_id != invalid_link) {
+            if (slots_[queue][slot_id].view_id_ != view_id) {
+                slot_id = slot_links_[queue][slot_id].next_;
+                continue;
+            }
 
-        assert(slot_it != slot_maps_[queue][model_id].end());
+            assert(slots_[queue][slot_id].queue_ == queue);
+            assert(slots_[queue][slot_id].model_id_ == model_id);
+            assert(slots_[queue][slot_id].node_id_ == node_id);
 
-        std::set<slot_t> slot_ids = slot_it->second; //copy
+            swap((queue_t)queue, slot_id, num_slots_[queue]-1);
 
-        std::set<slot_t>::iterator it = std::prev(slot_ids.end());
+            unlink_slot((queue_t)queue, num_slots_[queue]-1);
+            slots_[queue].pop_back();
+            slot_links_[queue].pop_back();
 
-        while (true) {
-            std::set<slot_t>::iterator current_it = it--;
+            --num_slots_[queue];
 
-            slot_t slot_id = *(current_it);
+            //the last action moved in and may belong either above or below
+            if (slot_id < num_slots_[queue]) {
+                shuffle_down((queue_t)queue, slot_id);
+                shuffle_up((queue_t)queue, slot_id);
+            }
 
-            if (slots_[queue][slot_id].view_id_ == view_id) {
+            //the list was relinked, start over
+            slot_id = first_slots_[queue][model_id][node_id];
+        }
+    }
 
-                action current_item = slots_[queue][slot_id];
-                action last_item = slots_[queue][num_slots_[queue]-1];
+}
 
-                assert(slot_maps_[queue][current_item.model_id_][current_item.node_id_].find(slot_id) != slot_maps_[queue][current_item.model_id_][current_item.node_id_].end());
-                assert(slot_maps_[queue][last_item.model_id_][last_item.node_id_].find(num_slots_[queue]-1) != slot_maps_[queue][last_item.model_id_][last_item.node_id_].end());
+void cut_update_index::
+sort() {
+    while(!initial_queue_.empty()) {
+        action action = initial_queue_.top();
+        initial_queue_.pop();
 
-                assert(current_item.queue_ == queue);
-                assert(current_item.model_id_ == model_id);
-                assert(current_item.node_id_ == node_id);
-                assert(last_item.queue_ == queue);
+        insert_action(action);
+    }
 
-                slot_maps_[queue][current_item.model_id_][current_item.node_id_].erase(slot_id);
-                slot_maps_[queue][last_item.model_id_][last_item.node_id_].erase(num_slots_[queue]-1);
+}
 
-                slot_maps_[queue][current_item.model_id_][current_item.node_id_].insert(num_slots_[queue]-1);
-                slot_maps_[queue][last_item.model_id_][last_item.node_id_].insert(slot_id);
+void cut_update_index::
+partition_remaining_actions() {
+    std::lock_guard<std::mutex> lock(mutex_);
 
-                std::swap(slots_[queue][slot_id], slots_[queue][num_slots_[queue]-1]);
+    const queue_t remaining_queues[] = {queue_t::KEEP, queue_t::COLLAPSE_ON_NEED, queue_t::MAYBE_COLLAPSE};
 
-                slot_maps_[queue][current_item.model_id_][current_item.node_id_].erase(num_slots_[queue]-1);
+    for (const auto queue : remaining_queues) {
+        for (size_t slot_id = 0; slot_id < num_slots_[queue]; ++slot_id) {
+            const action& action = slots_[queue][slot_id];
 
-                slots_[queue].pop_back();
+            first_slots_[queue][action.model_id_][action.node_id_] = invalid_link;
+            remaining_actions_[action.model_id_].push_back(action);
+        }
 
-                --num_slots_[queue];
+        slots_[queue].clear();
+        slot_links_[queue].clear();
+        num_slots_[queue] = 0;
+    }
 
-                shuffle_down((queue_t)queue, slot_id);
+}
 
-            }
+void cut_update_index::
+resolve_remaining_actions(const model_t model_id) {
+    assert(model_id < num_models_);
 
-            if (current_it == slot_ids.begin()) {
-                break;
-            }
+    for (const auto& action : remaining_actions_[model_id]) {
+        if (action.queue_ == queue_t::KEEP) {
+            approve_action_unlocked(action);
         }
-
-        if (slot_maps_[queue][model_id][node_id].empty()) {
-            slot_maps_[queue][model_id].erase(node_id);
+        else {
+            reject_action_unlocked(action);
         }
     }
 
+    remaining_actions_[model_id].clear();
+
+    for (const auto& view_id : view_ids_) {
+        std::vector<node_t>& cut = current_cut(view_id, model_id);
+        std::sort(cut.begin(), cut.end());
+        cut.erase(std::unique(cut.begin(), cut.end()), cut.end());
+    }
+
 }
 
 void cut_update_index::
-sort() {
-    while(!initial_queue_.empty()) {
-        action action = initial_queue_.top();
-        initial_queue_.pop();
+link_slot(const queue_t queue, const size_t slot_id) {
+    const action& action = slots_[queue][slot_id];
+    uint32_t& first_slot = first_slots_[queue][action.model_id_][action.node_id_];
 
-        slots_[action.queue_].push_back(action);
-        ++num_slots_[action.queue_];
+    slot_link& link = slot_links_[queue][slot_id];
+    link.prev_ = invalid_link;
+    link.next_ = first_slot;
 
-        slot_maps_[action.queue_][action.model_id_][action.node_id_].insert(num_slots_[action.queue_]-1);
+    if (first_slot != invalid_link) {
+        slot_links_[queue][first_slot].prev_ = (uint32_t)slot_id;
+    }
 
-        shuffle_up(action.queue_, num_slots_[action.queue_]-1);
+    first_slot = (uint32_t)slot_id;
+}
 
+void cut_update_index::
+unlink_slot(const queue_t queue, const size_t slot_id) {
+    const action& action = slots_[queue][slot_id];
+    const slot_link& link = slot_links_[queue][slot_id];
+
+    if (link.prev_ != invalid_link) {
+        slot_links_[queue][link.prev_].next_ = link.next_;
+    }
+    else {
+        assert(first_slots_[queue][action.model_id_][action.node_id_] == slot_id);
+        first_slots_[queue][action.model_id_][action.node_id_] = link.next_;
     }
 
+    if (link.next_ != invalid_link) {
+        slot_links_[queue][link.next_].prev_ = link.prev_;
+    }
 }
 
 void cut_update_index::
@@ -617,21 +520,22 @@ swap(const queue_t queue, const size_t slot_id_0, const size_t slot_id_1) {
         return;
     }
 
-    action& item0 = slots_[queue][slot_id_0];
-    action& item1 = slots_[queue][slot_id_1];
-
+    const action& item0 = slots_[queue][slot_id_0];
+    const action& item1 = slots_[queue][slot_id_1];
 
-    assert(slot_maps_[queue][item0.model_id_][item0.node_id_].find(slot_id_0) != slot_maps_[queue][item0.model_id_][item0.node_id_].end());
-    assert(slot_maps_[queue][item1.model_id_][item1.node_id_].find(slot_id_1) != slot_maps_[queue][item1.model_id_][item1.node_id_].end());
-
-
-    slot_maps_[queue][item0.model_id_][item0.node_id_].erase(slot_id_0);
-    slot_maps_[queue][item1.model_id_][item1.node_id_].erase(slot_id_1);
+    //both slots are in the same list, which does not change
+    if (item0.model_id_ == item1.model_id_ && item0.node_id_ == item1.node_id_) {
+        std::swap(slots_[queue][slot_id_0], slots_[queue][slot_id_1]);
+        return;
+    }
 
-    slot_maps_[queue][item0.model_id_][item0.node_id_].insert(slot_id_1);
-    slot_maps_[queue][item1.model_id_][item1.node_id_].insert(slot_id_0);
+    unlink_slot(queue, slot_id_0);
+    unlink_slot(queue, slot_id_1);
 
     std::swap(slots_[queue][slot_id_0], slots_[queue][slot_id_1]);
+
+    link_slot(queue, slot_id_0);
+    link_slot(queue, slot_id_1);
 }
 
 void cut_update_index::
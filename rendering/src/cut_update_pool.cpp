@@ -6,9 +6,12 @@
 // http://www.uni-weimar.de/medien/vr
 
 #include <lamure/ren/cut_update_pool.h>
+#include <lamure/ren/node_evaluation.h>
 #include <lamure/pvs/pvs_database.h>
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 
 namespace lamure
 {
@@ -170,6 +173,10 @@ void cut_update_pool::run()
                 cut_update();
                 break;
 
+            case cut_update_queue::task_t::CUT_RESOLVE_TASK:
+                cut_resolve(job.model_id_);
+                break;
+
             default:
                 break;
             }
@@ -398,6 +405,45 @@ void cut_update_pool::cut_master()
         if(is_shutdown())
             return;
 
+        assert(semaphore_.num_signals() == 0);
+        assert(master_semaphore_.num_signals() == 0);
+
+        // the budget is spent, resolve the remaining actions and compile the render lists per model
+        render_list_.clear();
+        render_list_.resize(index_->view_ids().size(), std::vector<std::vector<cut::node_slot_aggregate>>(index_->num_models()));
+
+        master_semaphore_.lock();
+        master_semaphore_.set_max_signal_count(index_->num_models());
+        master_semaphore_.set_min_signal_count(index_->num_models());
+        master_semaphore_.unlock();
+
+        semaphore_.lock();
+        semaphore_.set_max_signal_count(index_->num_models());
+        semaphore_.set_min_signal_count(1);
+        semaphore_.unlock();
+
+        for(model_t model_id = 0; model_id < index_->num_models(); ++model_id)
+        {
+            job_queue_.push_job(cut_update_queue::job(cut_update_queue::task_t::CUT_RESOLVE_TASK, invalid_view_t, model_id));
+        }
+
+        semaphore_.signal(index_->num_models());
+
+        master_semaphore_.wait();
+        if(is_shutdown())
+            return;
+
+        // back to single jobs for the next dispatch
+        master_semaphore_.lock();
+        master_semaphore_.set_max_signal_count(1);
+        master_semaphore_.set_min_signal_count(1);
+        master_semaphore_.unlock();
+
+        semaphore_.lock();
+        semaphore_.set_max_signal_count(1);
+        semaphore_.set_min_signal_count(1);
+        semaphore_.unlock();
+
 #ifdef LAMURE_CUT_UPDATE_ENABLE_REPEAT_MODE
     }
 #endif
@@ -447,10 +493,13 @@ cut_analysis(view_t view_id, model_t model_id) {
     assert(model_id < index_->num_models());
 
     scm::math::mat4f model_matrix;
+    scm::math::mat4f view_matrix;
+    scm::math::mat4f projection_matrix;
+    float near_plane;
+    float height_divided_by_top_minus_bottom;
 #ifdef LAMURE_CUT_UPDATE_ENABLE_MODEL_TIMEOUT
     size_t freshness;
 #endif
-    scm::gl::frustum frustum;
 
     {
         std::lock_guard<std::mutex> lock(mutex_);
@@ -458,11 +507,18 @@ cut_analysis(view_t view_id, model_t model_id) {
 #ifdef LAMURE_CUT_UPDATE_ENABLE_MODEL_TIMEOUT
         freshness = model_freshness_[model_id];
 #endif
-        frustum = user_cameras_[view_id].get_frustum_by_model(model_matrix);
+        const camera &user_camera = user_cameras_[view_id];
+        view_matrix = user_camera.get_view_matrix();
+        projection_matrix = user_camera.get_projection_matrix();
+        near_plane = user_camera.near_plane_value();
+        height_divided_by_top_minus_bottom = height_divided_by_top_minus_bottoms_[view_id];
     }
 
-    // perform cut analysis
-    std::set<node_t> old_cut = index_->get_previous_cut(view_id, model_id);
+    const bvh *bvh = model_database::get_instance()->get_model(model_id)->get_bvh();
+    const node_evaluation evaluation(bvh, model_matrix, view_matrix, projection_matrix, near_plane, height_divided_by_top_minus_bottom);
+
+    // perform cut analysis, the previous cut is only read until the next swap
+    const std::vector<node_t> &old_cut = index_->get_previous_cut(view_id, model_id);
 
     index_->reset_cut(view_id, model_id);
 
@@ -476,11 +532,94 @@ cut_analysis(view_t view_id, model_t model_id) {
     float min_error_threshold = model_thresholds_[model_id] - 0.1f;
     float max_error_threshold = model_thresholds_[model_id] + 0.1f;
 
+    // errors and frustum visibility of the cut nodes and their parents are evaluated in batches.
+    // siblings are adjacent in the sorted cut, so they share one parent entry
+    const size_t num_cut_nodes = old_cut.size();
+
+    std::vector<float> node_errors(num_cut_nodes);
+    std::vector<uint8_t> nodes_in_frustum(num_cut_nodes);
+    evaluation.compute_errors(old_cut.data(), num_cut_nodes, node_errors.data());
+    evaluation.compute_in_frustum(old_cut.data(), num_cut_nodes, nodes_in_frustum.data());
+
+    std::vector<node_t> parent_ids;
+    std::vector<size_t> parent_indices(num_cut_nodes, 0);
+    for(size_t i = 0; i < num_cut_nodes; ++i)
+    {
+        node_t node_id = old_cut[i];
+        if(node_id > 0 && node_id < index_->num_nodes(model_id))
+        {
+            node_t parent_id = index_->get_parent_id(model_id, node_id);
+            if(parent_ids.empty() || parent_ids.back() != parent_id)
+            {
+                parent_ids.push_back(parent_id);
+            }
+            parent_indices[i] = parent_ids.size() - 1;
+        }
+    }
+
+    std::vector<float> parent_errors(parent_ids.size());
+    std::vector<uint8_t> parents_in_frustum(parent_ids.size());
+    evaluation.compute_errors(parent_ids.data(), parent_ids.size(), parent_errors.data());
+    evaluation.compute_in_frustum(parent_ids.data(), parent_ids.size(), parents_in_frustum.data());
+
+    // children are only evaluated for nodes that may be split
+    const size_t no_children = std::numeric_limits<size_t>::max();
+
+    std::vector<node_t> child_ids;
+    std::vector<size_t> first_child_indices(num_cut_nodes, no_children);
+    for(size_t i = 0; i < num_cut_nodes; ++i)
+    {
+        if(!nodes_in_frustum[i] || node_errors[i] <= max_error_threshold)
+        {
+            continue;
+        }
+
+        size_t first_child_index = child_ids.size();
+        bool all_children_valid = true;
+        for(node_t child_index = 0; child_index < fan_factor; ++child_index)
+        {
+            node_t child_id = index_->get_child_id(model_id, old_cut[i], child_index);
+            if(child_id == invalid_node_t)
+            {
+                all_children_valid = false;
+                break;
+            }
+            child_ids.push_back(child_id);
+        }
+
+        if(all_children_valid)
+        {
+            first_child_indices[i] = first_child_index;
+        }
+        else
+        {
+            child_ids.resize(first_child_index);
+        }
+    }
+
+    std::vector<float> child_errors(child_ids.size());
+    evaluation.compute_errors(child_ids.data(), child_ids.size(), child_errors.data());
+
+    // only split if the predicted error of children does not require collapsing
+    auto is_split_allowed = [&](const size_t cut_index) {
+        if(first_child_indices[cut_index] == no_children)
+        {
+            return false;
+        }
+        for(uint32_t child_index = 0; child_index < fan_factor; ++child_index)
+        {
+            if(child_errors[first_child_indices[cut_index] + child_index] < min_error_threshold)
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+
     // cut analysis
-    std::set<node_t>::iterator cut_it;
-    for(cut_it = old_cut.begin(); cut_it != old_cut.end(); ++cut_it)
+    for(size_t i = 0; i < num_cut_nodes; ++i)
     {
-        node_t node_id = *cut_it;
+        node_t node_id = old_cut[i];
 
         bool all_siblings_in_cut = false;
         bool no_sibling_in_frustum = true;
@@ -496,13 +635,13 @@ cut_analysis(view_t view_id, model_t model_id) {
 
         if (node_id > 0 && node_id < index_->num_nodes(model_id))
         {
-            parent_id = index_->get_parent_id(model_id, node_id);
-            parent_error = calculate_node_error(view_id, model_id, parent_id);
+            parent_id = parent_ids[parent_indices[i]];
+            parent_error = parent_errors[parent_indices[i]];
 
             index_->get_all_siblings(model_id, node_id, siblings);
 
             all_siblings_in_cut = is_all_nodes_in_cut(model_id, siblings, old_cut);
-            no_sibling_in_frustum = !is_node_in_frustum(view_id, model_id, parent_id, frustum);
+            no_sibling_in_frustum = !parents_in_frustum[parent_indices[i]];
 
             // Check if no sibling is visible via PVS.
             for(node_t sibling_id : siblings)
@@ -517,30 +656,12 @@ cut_analysis(view_t view_id, model_t model_id) {
 
         if (!all_siblings_in_cut)
         {
-            float node_error = calculate_node_error(view_id, model_id, node_id);
-            bool node_in_frustum = is_node_in_frustum(view_id, model_id, node_id, frustum);
+            float node_error = node_errors[i];
+            bool node_in_frustum = nodes_in_frustum[i];
 
             if (node_in_frustum && node_error > max_error_threshold && pvs->get_viewer_visibility(model_id, node_id))
             {
-                //only split if the predicted error of children does not require collapsing
-                bool split = true;
-                std::vector<node_t> children;
-                index_->get_all_children(model_id, node_id, children);
-                for (const auto& child_id : children)
-                {
-                    if (child_id == invalid_node_t)
-                    {
-                        split = false;
-                        break;
-                    }
-
-                    float child_error = calculate_node_error(view_id, model_id, child_id);
-                    if(child_error < min_error_threshold)
-                    {
-                        split = false;
-                        break;
-                    }
-                }
+                bool split = is_split_allowed(i);
 
                 if (!split || freshness_timeout)
                 {
@@ -581,7 +702,7 @@ cut_analysis(view_t view_id, model_t model_id) {
                     index_->push_action(cut_update_index::action(cut_update_index::queue_t::COLLAPSE_ON_NEED, view_id, model_id, parent_id, parent_error), false);
 
                     // skip to next group of siblings
-                    std::advance(cut_it, fan_factor - 1);
+                    i += fan_factor - 1;
                     continue;
                 }
 
@@ -591,33 +712,19 @@ cut_analysis(view_t view_id, model_t model_id) {
 
                 std::vector<bool> keep_sibling;
 
-                for (const auto& sibling_id : siblings)
+                // the group starts at the current node
+                for (uint32_t j = 0; j < fan_factor; ++j)
                 {
-                    float sibling_error = calculate_node_error(view_id, model_id, sibling_id);
-                    bool sibling_in_frustum = is_node_in_frustum(view_id, model_id, sibling_id, frustum);
+                    const size_t sibling_index = i + j;
+                    const node_t sibling_id = siblings[j];
+                    assert(old_cut[sibling_index] == sibling_id);
+
+                    float sibling_error = node_errors[sibling_index];
+                    bool sibling_in_frustum = nodes_in_frustum[sibling_index];
 
                     if (sibling_error > max_error_threshold && sibling_in_frustum && pvs->get_viewer_visibility(model_id, sibling_id))
                     {
-                        //only split if the predicted error of children does not require collapsing
-                        bool split = true;
-                        std::vector<node_t> children;
-                        index_->get_all_children(model_id, sibling_id, children);
-                        for (const auto& child_id : children)
-                        {
-                            if (child_id == invalid_node_t)
-                            {
-                                split = false;
-                                break;
-                            }
-
-                            float child_error = calculate_node_error(view_id, model_id, child_id);
-
-                            if (child_error < min_error_threshold)
-                            {
-                                split = false;
-                                break;
-                            }
-                        }
+                        bool split = is_split_allowed(sibling_index);
 
                         if (!split)
                         {
@@ -665,7 +772,7 @@ cut_analysis(view_t view_id, model_t model_id) {
             }
 
             // skip to next group of siblings
-            std::advance(cut_it, fan_factor - 1);
+            i += fan_factor - 1;
         }
     }
 
@@ -1005,29 +1112,9 @@ void cut_update_pool::cut_update()
     gpu_cache_->unlock();
     ooc_cache->unlock();
 
-    // reject remaining collapse-on-need-actions
-    while(index_->num_actions(cut_update_index::queue_t::COLLAPSE_ON_NEED) > 0)
-    {
-        cut_update_index::action collapse_on_need_action = index_->front_action(cut_update_index::queue_t::COLLAPSE_ON_NEED);
-        index_->pop_front_action(cut_update_index::queue_t::COLLAPSE_ON_NEED);
-        index_->reject_action(collapse_on_need_action);
-    }
-
-    // reject remaining maybe-collapse-actions
-    while(index_->num_actions(cut_update_index::queue_t::MAYBE_COLLAPSE) > 0)
-    {
-        cut_update_index::action maybe_collapse_action = index_->front_action(cut_update_index::queue_t::MAYBE_COLLAPSE);
-        index_->pop_front_action(cut_update_index::queue_t::MAYBE_COLLAPSE);
-        index_->reject_action(maybe_collapse_action);
-    }
-
-    // approve all keep-actions
-    while(index_->num_actions(cut_update_index::queue_t::KEEP) > 0)
-    {
-        cut_update_index::action keep_action = index_->front_action(cut_update_index::queue_t::KEEP);
-        index_->pop_front_action(cut_update_index::queue_t::KEEP);
-        index_->approve_action(keep_action);
-    }
+    // remaining keep-, collapse-on-need- and maybe-collapse-actions do not touch the caches,
+    // they are resolved per model by cut_resolve()
+    index_->partition_remaining_actions();
 
     assert(index_->num_actions(cut_update_index::queue_t::KEEP) == 0);
     assert(index_->num_actions(cut_update_index::queue_t::MUST_SPLIT) == 0);
@@ -1035,36 +1122,40 @@ void cut_update_pool::cut_update()
     assert(index_->num_actions(cut_update_index::queue_t::COLLAPSE_ON_NEED) == 0);
     assert(index_->num_actions(cut_update_index::queue_t::MAYBE_COLLAPSE) == 0);
 
-    compile_render_list();
     compile_transfer_list();
 
     master_semaphore_.signal(1);
 }
 
-void cut_update_pool::compile_render_list()
+void cut_update_pool::cut_resolve(model_t model_id)
 {
-    render_list_.clear();
+    assert(model_id != invalid_model_t);
+    assert(model_id < index_->num_models());
+
+    index_->resolve_remaining_actions(model_id);
 
+    compile_render_list(model_id);
+
+    master_semaphore_.signal(1);
+}
+
+void cut_update_pool::compile_render_list(const model_t model_id)
+{
     const std::set<view_t> &view_ids = index_->view_ids();
 
     for(const auto view_id : view_ids)
     {
-        std::vector<std::vector<cut::node_slot_aggregate>> view_render_lists;
-
-        for(model_t model_id = 0; model_id < index_->num_models(); ++model_id)
-        {
-            std::vector<cut::node_slot_aggregate> model_render_lists;
+        std::vector<cut::node_slot_aggregate> &model_render_list = render_list_[view_id][model_id];
 
-            const std::set<node_t> &current_cut = index_->get_current_cut(view_id, model_id);
+        const std::vector<node_t> &current_cut = index_->get_current_cut(view_id, model_id);
 
-            for(const auto &node_id : current_cut)
-            {
-                model_render_lists.push_back(cut::node_slot_aggregate(node_id, gpu_cache_->slot_id(model_id, node_id)));
-            }
+        model_render_list.clear();
+        model_render_list.reserve(current_cut.size());
 
-            view_render_lists.push_back(model_render_lists);
+        for(const auto &node_id : current_cut)
+        {
+            model_render_list.push_back(cut::node_slot_aggregate(node_id, gpu_cache_->slot_id(model_id, node_id)));
         }
-        render_list_.push_back(view_render_lists);
     }
 }
 
@@ -1230,7 +1321,12 @@ void cut_update_pool::split_node(const cut_update_index::action &action)
                     ooc_cache->register_node(action.model_id_, child_id, (int32_t)action.error_);
                 }
             }
-            all_children_available = false;
+
+            // children found in the compressed tier are resident right away
+            if(!ooc_cache->is_node_resident(action.model_id_, child_id))
+            {
+                all_children_available = false;
+            }
         }
     }
 
@@ -1322,7 +1418,7 @@ void cut_update_pool::collapse_node(const cut_update_index::action &action)
     index_->approve_action(action);
 }
 
-const bool cut_update_pool::is_all_nodes_in_cut(const model_t model_id, const std::vector<node_t> &node_ids, const std::set<node_t> &cut)
+const bool cut_update_pool::is_all_nodes_in_cut(const model_t model_id, const std::vector<node_t> &node_ids, const std::vector<node_t> &cut)
 {
     for(node_t i = 0; i < node_ids.size(); ++i)
     {
@@ -1334,7 +1430,7 @@ const bool cut_update_pool::is_all_nodes_in_cut(const model_t model_id, const st
         if(node_id == invalid_node_t)
             return false;
 
-        if(cut.find(node_id) == cut.end())
+        if(!std::binary_search(cut.begin(), cut.end(), node_id))
             return false;
     }
 
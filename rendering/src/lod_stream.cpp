@@ -7,15 +7,26 @@
 
 #include <lamure/ren/lod_stream.h>
 
+#include <cerrno>
 #include <cstdio>
 #include <iostream>
 #include <stdexcept>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 namespace lamure
 {
 namespace ren
 {
-lod_stream::lod_stream() : is_file_open_(false) {}
+lod_stream::lod_stream() : is_file_open_(false)
+{
+#ifndef _WIN32
+    file_descriptor_ = -1;
+#endif
+}
 
 lod_stream::~lod_stream()
 {
@@ -31,6 +42,14 @@ lod_stream::~lod_stream()
 void lod_stream::open(const std::string &file_name)
 {
     file_name_ = file_name;
+
+#ifndef _WIN32
+    file_descriptor_ = ::open(file_name_.c_str(), O_RDONLY);
+    if(file_descriptor_ < 0)
+    {
+        throw std::runtime_error("lamure: lod_stream::Unable to open file: " + file_name_);
+    }
+#else
     std::ios::openmode mode = std::ios::in | std::ios::binary;
 
     stream_.open(file_name_, mode);
@@ -49,6 +68,7 @@ void lod_stream::open(const std::string &file_name)
     {
         throw std::runtime_error("lamure: lod_stream::Unable to open file: " + file_name_);
     }
+#endif
 
     is_file_open_ = true;
 }
@@ -72,7 +92,17 @@ void lod_stream::close()
 {
     if(is_file_open_)
     {
-        stream_.close();
+#ifndef _WIN32
+        if(file_descriptor_ >= 0)
+        {
+            ::close(file_descriptor_);
+            file_descriptor_ = -1;
+        }
+#endif
+        if(stream_.is_open())
+        {
+            stream_.close();
+        }
         stream_.exceptions(std::ifstream::failbit);
 
         file_name_ = "";
@@ -86,6 +116,27 @@ void lod_stream::read(char *const data, const size_t offset_in_bytes, const size
     assert(is_file_open_);
     assert(data != nullptr);
 
+#ifndef _WIN32
+    if(file_descriptor_ >= 0)
+    {
+        size_t bytes_read = 0;
+        while(bytes_read < length_in_bytes)
+        {
+            ssize_t result = ::pread(file_descriptor_, data + bytes_read, length_in_bytes - bytes_read, offset_in_bytes + bytes_read);
+            if(result < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if(result <= 0)
+            {
+                throw std::runtime_error("lamure: lod_stream::Unable to read from file: " + file_name_);
+            }
+            bytes_read += result;
+        }
+        return;
+    }
+#endif
+
     stream_.seekg(offset_in_bytes);
     stream_.read(data, length_in_bytes);
 }
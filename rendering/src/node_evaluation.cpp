@@ -0,0 +1,142 @@
+// Copyright (c) 2014-2018 Bauhaus-Universitaet Weimar
+// This Software is distributed under the Modified BSD License, see license.txt.
+//
+// Virtual Reality and Visualization Research Group 
+// Faculty of Media, Bauhaus-Universitaet Weimar
+// http://www.uni-weimar.de/medien/vr
+
+#include <lamure/ren/node_evaluation.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace lamure
+{
+
+namespace ren
+{
+
+node_evaluation::
+node_evaluation(const bvh* bvh,
+                const scm::math::mat4f& model_matrix,
+                const scm::math::mat4f& view_matrix,
+                const scm::math::mat4f& projection_matrix,
+                const float near_plane,
+                const float height_divided_by_top_minus_bottom)
+: centroids_(bvh->get_centroids()),
+  avg_primitive_extents_(bvh->get_avg_primitive_extents()),
+  bounding_boxes_(bvh->get_bounding_boxes()),
+  first_node_below_min_lod_depth_(bvh->get_first_node_id_of_depth(bvh->get_min_lod_depth() + 1)) {
+
+    // matrices are column major
+    const scm::math::mat4f model_view_matrix = view_matrix * model_matrix;
+    for (uint32_t column = 0; column < 4; ++column) {
+        view_z_[column] = model_view_matrix[column * 4 + 2];
+    }
+
+    const float radius_scaling = scm::math::length(model_matrix * scm::math::vec4f(1.0f, 0.f, 0.f, 0.f));
+    error_scale_ = 2.0f * radius_scaling * near_plane * height_divided_by_top_minus_bottom;
+
+    // planes of the clip space cube in model space
+    const scm::math::mat4f clip_matrix = projection_matrix * model_view_matrix;
+    for (uint32_t column = 0; column < 4; ++column) {
+        const float row_x = clip_matrix[column * 4 + 0];
+        const float row_y = clip_matrix[column * 4 + 1];
+        const float row_z = clip_matrix[column * 4 + 2];
+        const float row_w = clip_matrix[column * 4 + 3];
+
+        planes_[0][column] = row_w + row_x;
+        planes_[1][column] = row_w - row_x;
+        planes_[2][column] = row_w + row_y;
+        planes_[3][column] = row_w - row_y;
+        planes_[4][column] = row_w + row_z;
+        planes_[5][column] = row_w - row_z;
+    }
+
+}
+
+void node_evaluation::
+compute_errors(const node_t* node_ids,
+               const size_t num_nodes,
+               float* errors) const {
+
+    alignas(64) float x[batch_size], y[batch_size], z[batch_size], extent[batch_size];
+
+    for (size_t first = 0; first < num_nodes; first += batch_size) {
+        const size_t count = std::min(batch_size, num_nodes - first);
+        const node_t* ids = node_ids + first;
+
+        for (size_t i = 0; i < count; ++i) {
+            const vec3f& centroid = centroids_[ids[i]];
+            x[i] = centroid.x;
+            y[i] = centroid.y;
+            z[i] = centroid.z;
+            extent[i] = avg_primitive_extents_[ids[i]];
+        }
+
+        float* batch_errors = errors + first;
+
+        #pragma omp simd
+        for (size_t i = 0; i < count; ++i) {
+            const float view_depth = view_z_[0] * x[i] + view_z_[1] * y[i] + view_z_[2] * z[i] + view_z_[3];
+            batch_errors[i] = std::abs(error_scale_ * extent[i] / -view_depth);
+        }
+
+        // nodes at or above the min lod depth are always refined
+        for (size_t i = 0; i < count; ++i) {
+            if (ids[i] < first_node_below_min_lod_depth_) {
+                batch_errors[i] = 100.f;
+            }
+        }
+    }
+
+}
+
+void node_evaluation::
+compute_in_frustum(const node_t* node_ids,
+                   const size_t num_nodes,
+                   uint8_t* in_frustum) const {
+
+    alignas(64) float min_x[batch_size], min_y[batch_size], min_z[batch_size];
+    alignas(64) float max_x[batch_size], max_y[batch_size], max_z[batch_size];
+
+    for (size_t first = 0; first < num_nodes; first += batch_size) {
+        const size_t count = std::min(batch_size, num_nodes - first);
+        const node_t* ids = node_ids + first;
+
+        for (size_t i = 0; i < count; ++i) {
+            const scm::gl::boxf& box = bounding_boxes_[ids[i]];
+            min_x[i] = box.min_vertex().x;
+            min_y[i] = box.min_vertex().y;
+            min_z[i] = box.min_vertex().z;
+            max_x[i] = box.max_vertex().x;
+            max_y[i] = box.max_vertex().y;
+            max_z[i] = box.max_vertex().z;
+        }
+
+        uint8_t* batch_in_frustum = in_frustum + first;
+
+        // a box is outside if its corner furthest along the normal is behind one of the planes
+        #pragma omp simd
+        for (size_t i = 0; i < count; ++i) {
+            uint8_t inside = 1;
+            for (uint32_t plane = 0; plane < 6; ++plane) {
+                const float a = planes_[plane][0];
+                const float b = planes_[plane][1];
+                const float c = planes_[plane][2];
+                const float distance = a * (a >= 0.f ? max_x[i] : min_x[i])
+                                     + b * (b >= 0.f ? max_y[i] : min_y[i])
+                                     + c * (c >= 0.f ? max_z[i] : min_z[i])
+                                     + planes_[plane][3];
+                inside &= (uint8_t)(distance >= 0.f);
+            }
+            batch_in_frustum[i] = inside;
+        }
+    }
+
+}
+
+
+} // namespace ren
+
+} // namespace lamure
@@ -7,6 +7,8 @@
 
 #include <lamure/ren/ooc_cache.h>
 
+#include <algorithm>
+
 namespace lamure
 {
 namespace ren
@@ -15,7 +17,8 @@ std::mutex ooc_cache::mutex_;
 bool ooc_cache::is_instanced_ = false;
 ooc_cache *ooc_cache::single_ = nullptr;
 
-ooc_cache::ooc_cache(const slot_t num_slots) : cache(num_slots), maintenance_counter_(0)
+ooc_cache::ooc_cache(const slot_t num_slots, const size_t compressed_cache_budget_in_bytes)
+    : cache(num_slots), maintenance_counter_(0), compressed_cache_(nullptr), num_requests_(0), num_resident_requests_(0), num_compressed_requests_(0)
 {
     model_database *database = model_database::get_instance();
 
@@ -35,7 +38,18 @@ ooc_cache::ooc_cache(const slot_t num_slots) : cache(num_slots), maintenance_cou
 #endif
       
     }
-    pool_ = new ooc_pool(LAMURE_CUT_UPDATE_NUM_LOADING_THREADS, database->get_slot_size(), slot_size_provenance);
+    if(compressed_cache_budget_in_bytes > 0)
+    {
+        compressed_cache_ = new compressed_cache(compressed_cache_budget_in_bytes);
+
+        if(compressed_cache_->num_slots() == 0)
+        {
+            delete compressed_cache_;
+            compressed_cache_ = nullptr;
+        }
+    }
+
+    pool_ = new ooc_pool(LAMURE_CUT_UPDATE_NUM_LOADING_THREADS, database->get_slot_size(), slot_size_provenance, compressed_cache_);
 
 
 }
@@ -52,6 +66,12 @@ ooc_cache::~ooc_cache()
         pool_ = nullptr;
     }
 
+    if(compressed_cache_ != nullptr)
+    {
+        delete compressed_cache_;
+        compressed_cache_ = nullptr;
+    }
+
     if(cache_data_ != nullptr)
     {
         delete[] cache_data_;
@@ -98,6 +118,36 @@ ooc_cache *ooc_cache::get_instance()
             ram_free_in_bytes = (unsigned long long)(status.ullAvailPhys * safety);
 #endif
 
+            // nodes decoded from the compressed tier would come without their provenance,
+            // and only point clouds are compressed
+            bool use_compressed_cache = policy->compressed_cache_budget_in_mb() > 0 && lamure::ren::data_provenance::get_instance()->get_size_in_bytes() == 0;
+
+            if(use_compressed_cache)
+            {
+                use_compressed_cache = false;
+                for(model_t model_id = 0; model_id < database->num_models(); ++model_id)
+                {
+                    if(database->get_model(model_id)->get_bvh()->get_primitive() == bvh::primitive_type::POINTCLOUD)
+                    {
+                        use_compressed_cache = true;
+                        break;
+                    }
+                }
+            }
+
+            // the compressed tier is taken from the free memory first,
+            // but never from the minimum main memory budget of the ooc cache
+            size_t compressed_cache_budget_in_bytes = 0;
+            unsigned long long min_out_of_core_budget_in_bytes = (unsigned long long)LAMURE_MIN_MAIN_MEMORY_BUDGET * 1024 * 1024;
+
+            if(use_compressed_cache && ram_free_in_bytes > min_out_of_core_budget_in_bytes)
+            {
+                compressed_cache_budget_in_bytes =
+                    std::min<unsigned long long>((unsigned long long)policy->compressed_cache_budget_in_mb() * 1024 * 1024, ram_free_in_bytes - min_out_of_core_budget_in_bytes);
+                ram_free_in_bytes -= compressed_cache_budget_in_bytes;
+                std::cout << "##### " << compressed_cache_budget_in_bytes / (1024 * 1024) << " MB will be used for the compressed cache #####" << std::endl;
+            }
+
             long out_of_core_budget_in_bytes = policy->out_of_core_budget_in_mb() * 1024 * 1024;
 
             if(policy->out_of_core_budget_in_mb() == 0)
@@ -119,7 +169,7 @@ ooc_cache *ooc_cache::get_instance()
             long node_size_total = database->get_primitives_per_node() * lamure::ren::data_provenance::get_instance()->get_size_in_bytes() + database->get_slot_size();
             size_t out_of_core_budget_in_nodes = out_of_core_budget_in_bytes / node_size_total;
 
-            single_ = new ooc_cache(out_of_core_budget_in_nodes);
+            single_ = new ooc_cache(out_of_core_budget_in_nodes, compressed_cache_budget_in_bytes);
 
             is_instanced_ = true;
         }
@@ -135,8 +185,11 @@ ooc_cache *ooc_cache::get_instance()
 
 void ooc_cache::register_node(const model_t model_id, const node_t node_id, const int32_t priority)
 {
+    num_requests_.fetch_add(1, std::memory_order_relaxed);
+
     if(is_node_resident(model_id, node_id))
     {
+        num_resident_requests_.fetch_add(1, std::memory_order_relaxed);
         return;
     }
 
@@ -149,6 +202,16 @@ void ooc_cache::register_node(const model_t model_id, const node_t node_id, cons
         
         model_database *database = model_database::get_instance();
         slot_t slot_id = index_->reserve_slot();
+
+        // nodes kept in the compressed tier are decoded right away
+        // and become resident without going through the loading queue
+        if(compressed_cache_ != nullptr && compressed_cache_->decompress(model_id, node_id, cache_data_ + slot_id * slot_size()))
+        {
+            index_->apply_slot(slot_id, model_id, node_id);
+            num_compressed_requests_.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+
         cache_queue::job job(model_id, node_id, slot_id, priority, cache_data_ + slot_id * slot_size(),
                              cache_data_provenance_ + slot_id * database->get_primitives_per_node() * lamure::ren::data_provenance::get_instance()->get_size_in_bytes());
         if(!pool_->acknowledge_request(job))
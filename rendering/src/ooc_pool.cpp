@@ -7,13 +7,116 @@
 
 #include <lamure/ren/ooc_pool.h>
 
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+#ifdef LAMURE_CUT_UPDATE_ENABLE_ASYNC_LOADING
+#include <aio.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace lamure
 {
 namespace ren
 {
 
-ooc_pool::ooc_pool(const uint32_t num_threads, const size_t size_of_slot_in_bytes, const size_t size_of_slot_provenance)
-    : locked_(false), size_of_slot_(size_of_slot_in_bytes), size_of_slot_provenance_(size_of_slot_provenance), num_threads_(num_threads), shutdown_(false), bytes_loaded_(0)
+namespace
+{
+
+float percentile(std::vector<float> values, const float p)
+{
+    if(values.empty())
+    {
+        return 0.f;
+    }
+    size_t n = std::min(values.size() - 1, size_t(p * values.size()));
+    std::nth_element(values.begin(), values.begin() + n, values.end());
+    return values[n];
+}
+
+#ifdef LAMURE_CUT_UPDATE_ENABLE_ASYNC_LOADING
+
+bool read_fully(const int file_descriptor, char *data, size_t offset_in_bytes, size_t length_in_bytes)
+{
+    while(length_in_bytes > 0)
+    {
+        ssize_t result = ::pread(file_descriptor, data, length_in_bytes, offset_in_bytes);
+        if(result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(result <= 0)
+        {
+            return false;
+        }
+        data += result;
+        offset_in_bytes += result;
+        length_in_bytes -= result;
+    }
+    return true;
+}
+
+// enqueues an asynchronous read, returns false if the read was
+// performed synchronously because the request could not be queued,
+// failed is set if that synchronous read did not succeed
+bool submit_read(aiocb &control_block, const int file_descriptor, char *data, const size_t offset_in_bytes, const size_t length_in_bytes, bool &failed)
+{
+    memset(&control_block, 0, sizeof(aiocb));
+    control_block.aio_fildes = file_descriptor;
+    control_block.aio_buf = data;
+    control_block.aio_nbytes = length_in_bytes;
+    control_block.aio_offset = offset_in_bytes;
+    control_block.aio_sigevent.sigev_notify = SIGEV_NONE;
+
+    if(aio_read(&control_block) == 0)
+    {
+        return true;
+    }
+
+    if(!read_fully(file_descriptor, data, offset_in_bytes, length_in_bytes))
+    {
+        std::cout << "lamure: ooc_pool::read failed: " << strerror(errno) << std::endl;
+        failed = true;
+    }
+    return false;
+}
+
+// returns true while the read is still in flight, short reads are continued,
+// failed is set if the read did not succeed
+bool poll_read(aiocb &control_block, bool &failed)
+{
+    int error = aio_error(&control_block);
+    if(error == EINPROGRESS)
+    {
+        return true;
+    }
+
+    ssize_t result = aio_return(&control_block);
+    if(error != 0 || result <= 0)
+    {
+        std::cout << "lamure: ooc_pool::async read failed: " << strerror(error != 0 ? error : EIO) << std::endl;
+        failed = true;
+        return false;
+    }
+    if(size_t(result) < control_block.aio_nbytes)
+    {
+        return submit_read(control_block, control_block.aio_fildes, (char *)control_block.aio_buf + result, control_block.aio_offset + result,
+                           control_block.aio_nbytes - result, failed);
+    }
+    return false;
+}
+
+#endif
+
+}
+
+ooc_pool::ooc_pool(const uint32_t num_threads, const size_t size_of_slot_in_bytes, const size_t size_of_slot_provenance, compressed_cache *compressed_cache)
+    : locked_(false), size_of_slot_(size_of_slot_in_bytes), size_of_slot_provenance_(size_of_slot_provenance), compressed_cache_(compressed_cache), num_threads_(num_threads), shutdown_(false), bytes_loaded_total_(0), measuring_(false), bytes_loaded_(0), bytes_loaded_in_frame_(0)
 {
     assert(num_threads_ > 0);
 
@@ -24,10 +127,18 @@ ooc_pool::ooc_pool(const uint32_t num_threads, const size_t size_of_slot_in_byte
 
     priority_queue_.initialize(LAMURE_CUT_UPDATE_LOADING_QUEUE_MODE, database->num_models());
 
+    collect_model_files();
+
+#ifdef LAMURE_CUT_UPDATE_ENABLE_ASYNC_LOADING
+    // a single thread keeps many reads in flight
+    num_threads_ = 1;
+    threads_.push_back(std::thread(&ooc_pool::run_async, this));
+#else
     for(uint32_t i = 0; i < num_threads_; ++i)
     {
         threads_.push_back(std::thread(&ooc_pool::run, this));
     }
+#endif
 }
 
 ooc_pool::~ooc_pool()
@@ -70,24 +181,46 @@ void ooc_pool::unlock()
 void ooc_pool::begin_measure()
 {
     std::lock_guard<std::mutex> lock(mutex_);
+    measuring_ = true;
     bytes_loaded_ = 0;
+    bytes_loaded_in_frame_ = 0;
+    load_latencies_.clear();
+    frame_throughputs_.clear();
+    measure_start_ = std::chrono::steady_clock::now();
+    last_frame_ = measure_start_;
 }
 
 void ooc_pool::end_measure()
 {
     std::lock_guard<std::mutex> lock(mutex_);
-    std::cout << "megabytes loaded: " << bytes_loaded_ / 1024 / 1024 << std::endl;
+    if(!measuring_)
+    {
+        return;
+    }
+    measuring_ = false;
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - measure_start_).count();
+    double megabytes = bytes_loaded_ / (1024.0 * 1024.0);
+
+    std::cout << "megabytes loaded: " << megabytes << " in " << seconds << " s (" << (seconds > 0.0 ? megabytes / seconds : 0.0) << " MB/s)" << std::endl;
+    std::cout << "nodes loaded: " << load_latencies_.size() << ", frames: " << frame_throughputs_.size() << std::endl;
+    std::cout << "MB/s per frame: min " << percentile(frame_throughputs_, 0.f) << " / median " << percentile(frame_throughputs_, 0.5f) << " / max "
+              << percentile(frame_throughputs_, 1.f) << std::endl;
+    std::cout << "load latency in ms: p50 " << percentile(load_latencies_, 0.5f) << " / p90 " << percentile(load_latencies_, 0.9f) << " / p99 "
+              << percentile(load_latencies_, 0.99f) << " / max " << percentile(load_latencies_, 1.f) << std::endl;
 }
 
-void ooc_pool::run()
+const size_t ooc_pool::bytes_loaded()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_loaded_total_;
+}
+
+void ooc_pool::collect_model_files()
 {
     model_database *database = model_database::get_instance();
     model_t num_models = database->num_models();
 
-    std::vector<std::string> lod_files;
-    std::vector<std::string> provenance_files;
-    std::vector<size_t> provenance_sizes;
-
     uint64_t data_provenance_size_in_bytes = lamure::ren::data_provenance::get_instance()->get_size_in_bytes();
 
     for (model_t model_id = 0; model_id < num_models; ++model_id) {
@@ -100,30 +233,65 @@ void ooc_pool::run()
         std::string provenance_file_name = bvh_filename.substr(0, bvh_filename.size() - 3) + "prov";
 
 
-        lod_files.push_back(lod_file_name);
+        lod_files_.push_back(lod_file_name);
 
         if (data_provenance_size_in_bytes > 0)
         {
             std::ifstream f(provenance_file_name.c_str());
             if (f.good()) {
               //check if corresponding .prov file exists
-              provenance_files.push_back(provenance_file_name);
+              provenance_files_.push_back(provenance_file_name);
               f.close();
             }
             else {
-              provenance_files.push_back("");   
+              provenance_files_.push_back("");   
             }
         }
 
-        provenance_sizes.push_back(database->get_model(model_id)->get_bvh()->get_size_of_provenance());
+        size_t size_of_provenance = database->get_model(model_id)->get_bvh()->get_size_of_provenance();
+        if (data_provenance_size_in_bytes > 0 && size_of_provenance == 0) {
+            std::cout << "Warning!" << std::endl;
+            //WARNING! You invoked the provenance backend, but your provenance size for this model is zero.
+            //In this case, revert to the system-wide provenance size. 
+            //For .bvh files generated before bvh format revision 1.3, this should do the trick.
+            size_of_provenance = data_provenance_size_in_bytes;
+        }
+        provenance_sizes_.push_back(size_of_provenance);
     }
+}
+
+void ooc_pool::complete_job(const cache_queue::job &job, const size_t bytes_loaded, const std::chrono::steady_clock::time_point &load_start)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    history_.push_back(job);
+    bytes_loaded_total_ += bytes_loaded;
 
-    char *local_cache = new char[size_of_slot_];
-    
-    char *local_cache_provenance = nullptr;
-    if(data_provenance_size_in_bytes > 0) {
-      local_cache_provenance = new char[size_of_slot_provenance_];
+    if(measuring_)
+    {
+        bytes_loaded_ += bytes_loaded;
+        bytes_loaded_in_frame_ += bytes_loaded;
+        load_latencies_.push_back(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - load_start).count());
     }
+}
+
+void ooc_pool::fail_job(const cache_queue::job &job)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    failed_jobs_.push_back(job);
+}
+
+void ooc_pool::run()
+{
+    model_database *database = model_database::get_instance();
+    model_t num_models = database->num_models();
+
+    uint64_t data_provenance_size_in_bytes = lamure::ren::data_provenance::get_instance()->get_size_in_bytes();
+
+    // each loader thread keeps its files open for its whole lifetime
+    std::vector<std::unique_ptr<lod_stream>> lod_streams(num_models);
+    std::vector<std::unique_ptr<provenance_stream>> provenance_streams(num_models);
+
+    std::vector<char> local_cache_provenance;
 
     while(true)
     {
@@ -137,78 +305,288 @@ void ooc_pool::run()
         if(job.node_id_ != invalid_node_t)
         {
             assert(job.slot_mem_ != nullptr);
-            
+
+            auto load_start = std::chrono::steady_clock::now();
 
             size_t stride_in_bytes = database->get_node_size(job.model_id_);
             size_t offset_in_bytes = job.node_id_ * stride_in_bytes;
+            size_t bytes_loaded = stride_in_bytes;
 
-            lod_stream access;
-            access.open(lod_files[job.model_id_]);
-            access.read(local_cache, offset_in_bytes, stride_in_bytes);
-            access.close();
-
-            std::lock_guard<std::mutex> lock(mutex_);
+            if(!lod_streams[job.model_id_])
+            {
+                lod_streams[job.model_id_].reset(new lod_stream());
+                lod_streams[job.model_id_]->open(lod_files_[job.model_id_]);
+            }
 
-            memcpy(job.slot_mem_, local_cache, stride_in_bytes);
+            // the slot is reserved for this job and is not accessed by anyone
+            // else until the job shows up in the history
+            lod_streams[job.model_id_]->read(job.slot_mem_, offset_in_bytes, stride_in_bytes);
 
-            history_.push_back(job);
+            if(compressed_cache_ != nullptr)
+            {
+                compressed_cache_->insert(job.model_id_, job.node_id_, job.slot_mem_);
+            }
 
             if(data_provenance_size_in_bytes > 0) { //check if provenance backend invoked
                 if (job.slot_mem_provenance_ == nullptr) {
                     std::cout << "prov slot mem not allocated" << std::endl;
                 }
-                if (provenance_files[job.model_id_] != "") {
-                    provenance_stream access_provenance;
-                    access_provenance.open(provenance_files[job.model_id_]);
-                    
-                    size_t size_of_provenance = provenance_sizes[job.model_id_];
-                    if (size_of_provenance == 0) {
-                        std::cout << "Warning!" << std::endl;
-                        //WARNING! You invoked the provenance backend, but your provenance size for this model is zero.
-                        //In this case, revert to the system-wide provenance size. 
-                        //For .bvh files generated before bvh format revision 1.3, this should do the trick.
-                        size_of_provenance = data_provenance_size_in_bytes;
+                if (provenance_files_[job.model_id_] != "") {
+                    if (!provenance_streams[job.model_id_]) {
+                        provenance_streams[job.model_id_].reset(new provenance_stream());
+                        provenance_streams[job.model_id_]->open(provenance_files_[job.model_id_]);
                     }
-
+                    
+                    size_t size_of_provenance = provenance_sizes_[job.model_id_];
                     size_t stride_in_bytes_provenance = database->get_primitives_per_node(job.model_id_) * size_of_provenance;
 
                     size_t offset_in_bytes_provenance = job.node_id_ * stride_in_bytes_provenance;
-                    access_provenance.read(local_cache_provenance, offset_in_bytes_provenance, stride_in_bytes_provenance);
 
                     if (data_provenance_size_in_bytes == size_of_provenance) {
-                        memcpy(job.slot_mem_provenance_, local_cache_provenance, stride_in_bytes_provenance);
+                        provenance_streams[job.model_id_]->read(job.slot_mem_provenance_, offset_in_bytes_provenance, stride_in_bytes_provenance);
                     }
                     else {
+                      local_cache_provenance.resize(stride_in_bytes_provenance);
+                      provenance_streams[job.model_id_]->read(local_cache_provenance.data(), offset_in_bytes_provenance, stride_in_bytes_provenance);
+                      repack_provenance(job, local_cache_provenance.data(), size_of_provenance);
+                    }
 
-                      for (uint64_t surfel_id = 0; surfel_id < database->get_primitives_per_node(job.model_id_); ++surfel_id) {
-                        memcpy(job.slot_mem_provenance_+surfel_id*data_provenance_size_in_bytes, 
-                            local_cache_provenance+surfel_id*size_of_provenance, size_of_provenance);
-                      }
+                    bytes_loaded += stride_in_bytes_provenance;
+                }
+            }
+
+            complete_job(job, bytes_loaded, load_start);
+        }
+    }
+}
+
+void ooc_pool::repack_provenance(const cache_queue::job &job, const char *provenance_on_disk, const size_t size_of_provenance)
+{
+    model_database *database = model_database::get_instance();
+    uint64_t data_provenance_size_in_bytes = lamure::ren::data_provenance::get_instance()->get_size_in_bytes();
+    size_t size_to_copy = std::min<size_t>(size_of_provenance, data_provenance_size_in_bytes);
+
+    for (uint64_t surfel_id = 0; surfel_id < database->get_primitives_per_node(job.model_id_); ++surfel_id) {
+      memcpy(job.slot_mem_provenance_+surfel_id*data_provenance_size_in_bytes, 
+          provenance_on_disk+surfel_id*size_of_provenance, size_to_copy);
+    }
+}
+
+#ifdef LAMURE_CUT_UPDATE_ENABLE_ASYNC_LOADING
+
+void ooc_pool::run_async()
+{
+    model_database *database = model_database::get_instance();
+    model_t num_models = database->num_models();
+
+    uint64_t data_provenance_size_in_bytes = lamure::ren::data_provenance::get_instance()->get_size_in_bytes();
+
+    std::vector<int> lod_descriptors(num_models, -1);
+    std::vector<int> provenance_descriptors(num_models, -1);
+    std::vector<uint64_t> provenance_file_sizes(num_models, 0);
+
+    struct request
+    {
+        cache_queue::job job_;
+        aiocb lod_read_;
+        aiocb provenance_read_;
+        bool lod_pending_;
+        bool provenance_pending_;
+        bool repack_provenance_;
+        bool failed_;
+        size_t bytes_loaded_;
+        std::chrono::steady_clock::time_point load_start_;
+        std::vector<char> provenance_on_disk_;
+    };
+
+    std::vector<request> requests(LAMURE_CUT_UPDATE_ASYNC_LOADING_QUEUE_DEPTH);
+    std::vector<size_t> free_requests;
+    std::vector<size_t> active_requests;
+    std::vector<const aiocb *> pending_reads;
+
+    for(size_t i = 0; i < requests.size(); ++i)
+    {
+        free_requests.push_back(requests.size() - 1 - i);
+    }
+
+    while(!is_shutdown())
+    {
+        // fill the queue, block only if there is nothing in flight
+        while(!free_requests.empty())
+        {
+            if(!active_requests.empty() && semaphore_.num_signals() == 0)
+                break;
+
+            semaphore_.wait();
+
+            if(is_shutdown())
+                break;
+
+            cache_queue::job job = priority_queue_.top_job();
+
+            if(job.node_id_ == invalid_node_t)
+                continue;
+
+            assert(job.slot_mem_ != nullptr);
+
+            size_t request_id = free_requests.back();
+            free_requests.pop_back();
+
+            request &req = requests[request_id];
+            req.job_ = job;
+            req.load_start_ = std::chrono::steady_clock::now();
+            req.lod_pending_ = false;
+            req.provenance_pending_ = false;
+            req.repack_provenance_ = false;
+            req.failed_ = false;
+
+            if(lod_descriptors[job.model_id_] < 0)
+            {
+                lod_descriptors[job.model_id_] = ::open(lod_files_[job.model_id_].c_str(), O_RDONLY);
+                if(lod_descriptors[job.model_id_] < 0)
+                {
+                    throw std::runtime_error("lamure: ooc_pool::Unable to open file: " + lod_files_[job.model_id_]);
+                }
+            }
+
+            size_t stride_in_bytes = database->get_node_size(job.model_id_);
+            size_t offset_in_bytes = job.node_id_ * stride_in_bytes;
+            req.bytes_loaded_ = stride_in_bytes;
+
+            // the slot is reserved for this job and is not accessed by anyone
+            // else until the job shows up in the history
+            req.lod_pending_ = submit_read(req.lod_read_, lod_descriptors[job.model_id_], job.slot_mem_, offset_in_bytes, stride_in_bytes, req.failed_);
+
+            if(data_provenance_size_in_bytes > 0 && provenance_files_[job.model_id_] != "")
+            {
+                if(provenance_descriptors[job.model_id_] < 0)
+                {
+                    int file_descriptor = ::open(provenance_files_[job.model_id_].c_str(), O_RDONLY);
+                    struct stat file_stat;
+                    if(file_descriptor < 0 || ::fstat(file_descriptor, &file_stat) != 0)
+                    {
+                        throw std::runtime_error("lamure: ooc_pool::Unable to open file: " + provenance_files_[job.model_id_]);
                     }
-                    
-                    access_provenance.close();
+                    provenance_descriptors[job.model_id_] = file_descriptor;
+                    provenance_file_sizes[job.model_id_] = file_stat.st_size;
+                }
+
+                size_t size_of_provenance = provenance_sizes_[job.model_id_];
+                size_t stride_in_bytes_provenance = database->get_primitives_per_node(job.model_id_) * size_of_provenance;
+                size_t offset_in_bytes_provenance = job.node_id_ * stride_in_bytes_provenance;
+
+                // same as provenance_stream, nodes beyond the end of the file are skipped
+                if(offset_in_bytes_provenance + stride_in_bytes_provenance <= provenance_file_sizes[job.model_id_])
+                {
+                    char *target = job.slot_mem_provenance_;
+                    if(data_provenance_size_in_bytes != size_of_provenance)
+                    {
+                        req.provenance_on_disk_.resize(stride_in_bytes_provenance);
+                        req.repack_provenance_ = true;
+                        target = req.provenance_on_disk_.data();
+                    }
+                    req.provenance_pending_ =
+                        submit_read(req.provenance_read_, provenance_descriptors[job.model_id_], target, offset_in_bytes_provenance, stride_in_bytes_provenance, req.failed_);
+                    req.bytes_loaded_ += stride_in_bytes_provenance;
                 }
             }
+
+            active_requests.push_back(request_id);
+        }
+
+        if(active_requests.empty())
+            continue;
+
+        // wait for at least one completion, but look for new jobs regularly
+        pending_reads.clear();
+        for(size_t request_id : active_requests)
+        {
+            if(requests[request_id].lod_pending_)
+                pending_reads.push_back(&requests[request_id].lod_read_);
+            if(requests[request_id].provenance_pending_)
+                pending_reads.push_back(&requests[request_id].provenance_read_);
+        }
+
+        if(!pending_reads.empty())
+        {
+            timespec timeout = {0, 1000000};
+            aio_suspend(pending_reads.data(), pending_reads.size(), &timeout);
+        }
+
+        for(size_t i = 0; i < active_requests.size();)
+        {
+            request &req = requests[active_requests[i]];
+
+            if(req.lod_pending_)
+                req.lod_pending_ = poll_read(req.lod_read_, req.failed_);
+            if(req.provenance_pending_)
+                req.provenance_pending_ = poll_read(req.provenance_read_, req.failed_);
+
+            if(req.lod_pending_ || req.provenance_pending_)
+            {
+                ++i;
+                continue;
+            }
+
+            if(req.failed_)
+            {
+                // the slot holds no valid node, it is handed back instead
+                fail_job(req.job_);
+            }
+            else
+            {
+                if(req.repack_provenance_)
+                {
+                    repack_provenance(req.job_, req.provenance_on_disk_.data(), provenance_sizes_[req.job_.model_id_]);
+                }
+
+                if(compressed_cache_ != nullptr)
+                {
+                    compressed_cache_->insert(req.job_.model_id_, req.job_.node_id_, req.job_.slot_mem_);
+                }
+
+                complete_job(req.job_, req.bytes_loaded_, req.load_start_);
+            }
+
+            free_requests.push_back(active_requests[i]);
+            active_requests[i] = active_requests.back();
+            active_requests.pop_back();
         }
     }
 
-    
-    lod_files.clear();
-    provenance_files.clear();
+    // reads must not outlive the request buffers
+    auto cancel_read = [](aiocb &control_block) {
+        aio_cancel(control_block.aio_fildes, &control_block);
+        while(aio_error(&control_block) == EINPROGRESS)
+        {
+            const aiocb *wait_list[1] = {&control_block};
+            aio_suspend(wait_list, 1, nullptr);
+        }
+        aio_return(&control_block);
+    };
 
+    for(size_t request_id : active_requests)
+    {
+        if(requests[request_id].lod_pending_)
+            cancel_read(requests[request_id].lod_read_);
+        if(requests[request_id].provenance_pending_)
+            cancel_read(requests[request_id].provenance_read_);
+    }
 
-    if(local_cache != nullptr)
+    for(int file_descriptor : lod_descriptors)
     {
-        delete[] local_cache;
-        local_cache = nullptr;
+        if(file_descriptor >= 0)
+            ::close(file_descriptor);
     }
-    if(local_cache_provenance != nullptr)
+    for(int file_descriptor : provenance_descriptors)
     {
-        delete[] local_cache_provenance;
-        local_cache_provenance = nullptr;
+        if(file_descriptor >= 0)
+            ::close(file_descriptor);
     }
 }
 
+#endif
+
 void ooc_pool::resolve_cache_history(cache_index *index)
 {
     assert(locked_);
@@ -220,6 +598,27 @@ void ooc_pool::resolve_cache_history(cache_index *index)
     }
 
     history_.clear();
+
+    // the nodes are requested again by the next cut update
+    for(auto entry : failed_jobs_)
+    {
+        priority_queue_.pop_job(entry);
+        index->unreserve_slot(entry.slot_id_);
+    }
+
+    failed_jobs_.clear();
+
+    if(measuring_)
+    {
+        auto now = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(now - last_frame_).count();
+        if(seconds > 0.0)
+        {
+            frame_throughputs_.push_back(float(bytes_loaded_in_frame_ / (1024.0 * 1024.0) / seconds));
+        }
+        bytes_loaded_in_frame_ = 0;
+        last_frame_ = now;
+    }
 }
 
 void ooc_pool::perform_queue_maintenance(cache_index *index)
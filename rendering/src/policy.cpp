@@ -25,6 +25,7 @@ policy()
   max_upload_budget_in_mb_(LAMURE_DEFAULT_UPLOAD_BUDGET),
   render_budget_in_mb_(LAMURE_DEFAULT_VIDEO_MEMORY_BUDGET),
   out_of_core_budget_in_mb_(LAMURE_DEFAULT_MAIN_MEMORY_BUDGET),
+  compressed_cache_budget_in_mb_(LAMURE_DEFAULT_COMPRESSED_MEMORY_BUDGET),
   window_width_(800),
   window_height_(600) {
 
@@ -8,16 +8,25 @@
 #include <lamure/ren/provenance_stream.h>
 
 #include <stdexcept>
+#include <cerrno>
 #include <cstdio>
 #include <iostream>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace lamure {
 namespace ren {
 
 provenance_stream::
 provenance_stream()
 : is_file_open_(false), file_size_(0) {
-
+#ifndef _WIN32
+    file_descriptor_ = -1;
+#endif
 }
 
 provenance_stream::
@@ -31,6 +40,22 @@ provenance_stream::
 void provenance_stream::
 open(const std::string& file_name) {
     file_name_ = file_name;
+
+#ifndef _WIN32
+    file_descriptor_ = ::open(file_name_.c_str(), O_RDONLY);
+    struct stat file_stat;
+    if (file_descriptor_ < 0 || ::fstat(file_descriptor_, &file_stat) != 0) {
+        if (file_descriptor_ >= 0) {
+            ::close(file_descriptor_);
+            file_descriptor_ = -1;
+        }
+        throw std::runtime_error(
+            "lamure: provenance_stream::Unable to open file: " + file_name_);
+    }
+
+    is_file_open_ = true;
+    file_size_ = (uint64_t)file_stat.st_size;
+#else
     std::ios::openmode mode = std::ios::in |
                               std::ios::binary;
 
@@ -54,6 +79,7 @@ open(const std::string& file_name) {
     stream_.seekg(0, std::ios::end);
     file_size_ = (uint64_t)stream_.tellg();
     stream_.seekg(0, std::ios::beg);
+#endif
 }
 
 
@@ -76,7 +102,15 @@ open_for_writing(const std::string& file_name) {
 void provenance_stream::
 close() {
     if (is_file_open_) {
-        stream_.close();
+#ifndef _WIN32
+        if (file_descriptor_ >= 0) {
+            ::close(file_descriptor_);
+            file_descriptor_ = -1;
+        }
+#endif
+        if (stream_.is_open()) {
+            stream_.close();
+        }
         stream_.exceptions(std::ifstream::failbit);
 
         file_name_ = "";
@@ -103,6 +137,25 @@ read(char* const data,
         return;
     }
 
+#ifndef _WIN32
+    if (file_descriptor_ >= 0) {
+        size_t bytes_read = 0;
+        while (bytes_read < length_in_bytes) {
+            ssize_t result = ::pread(file_descriptor_, data + bytes_read,
+                                     length_in_bytes - bytes_read, offset_in_bytes + bytes_read);
+            if (result < 0 && errno == EINTR) {
+                continue;
+            }
+            if (result <= 0) {
+                throw std::runtime_error(
+                    "lamure: provenance_stream::Unable to read from file: " + file_name_);
+            }
+            bytes_read += result;
+        }
+        return;
+    }
+#endif
+
     stream_.seekg(offset_in_bytes);
     stream_.read(data, length_in_bytes);
 
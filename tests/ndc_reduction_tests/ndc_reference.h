@@ -0,0 +1,375 @@
+#ifndef NDC_REFERENCE_H
+#define NDC_REFERENCE_H
+
+// list based normal deviation clustering as it was before the counting sort
+// grid, kept to check that the reduction still produces the same surfels
+
+#include <lamure/pre/basic_algorithms.h>
+#include <lamure/pre/surfel_mem_array.h>
+#include <lamure/bounding_box.h>
+
+#include <algorithm>
+#include <cmath>
+#include <list>
+#include <memory>
+#include <queue>
+#include <vector>
+
+namespace ndc_reference {
+
+using namespace lamure;
+using namespace pre;
+
+using value_index_pair = std::pair<real, uint16_t>;
+
+struct surfel_cluster_with_error {
+    std::shared_ptr<std::list<surfel>> cluster;
+    float merge_treshold;
+};
+
+struct order_by_size {
+    bool operator() (const surfel_cluster_with_error& left,
+                     const surfel_cluster_with_error& right) {
+        return left.cluster->size() < right.cluster->size();
+    }
+};
+
+inline surfel create_representative(const std::vector<surfel>& input)
+{
+    if (input.size() == 1)
+        return input.front();
+
+    vec3r pos = vec3r(0);
+    vec3f nml = vec3f(0);
+    vec3f col = vec3f(0);
+    real weight_sum = 0.f;
+    for (const auto& surfel : input)
+    {
+        real weight = 1.0;
+        weight_sum += weight;
+
+        pos += weight * surfel.pos();
+        nml += float(weight) * surfel.normal();
+        col += surfel.color();
+    }
+
+    pos /= weight_sum;
+    nml /= weight_sum;
+    col /= input.size();
+
+    nml = scm::math::normalize(nml);
+
+    real radius = 0.0;
+
+    for (const auto& surfel : input)
+    {
+        real dist = scm::math::distance(pos, surfel.pos());
+        if (radius < dist + surfel.radius()) radius = dist + surfel.radius();
+    }
+
+    return surfel(pos, vec3b(col.x, col.y, col.z), radius, nml);
+}
+
+inline vec3ui cell_index(const vec3r& surfel_pos,
+                         const vec3r& cell_size,
+                         const vec3ui& grid_dimensions,
+                         const vec3b& locked_grid_dimensions)
+{
+    vec3ui index;
+
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+        index[axis] = locked_grid_dimensions[axis] ? 0 : uint32_t(floor(surfel_pos[axis]/cell_size[axis]));
+
+        if ((index[axis] != 0) && (index[axis] == grid_dimensions[axis]))
+            index[axis] = grid_dimensions[axis]-1;
+    }
+
+    return index;
+}
+
+inline vec3r relative_position(const surfel& surfel, const bounding_box& bounding_box)
+{
+    vec3r surfel_pos = surfel.pos() - bounding_box.min();
+    if (surfel_pos.x < 0.f) surfel_pos.x = 0.f;
+    if (surfel_pos.y < 0.f) surfel_pos.y = 0.f;
+    if (surfel_pos.z < 0.f) surfel_pos.z = 0.f;
+    return surfel_pos;
+}
+
+inline std::pair<vec3ui, vec3b> compute_grid_dimensions(const std::vector<surfel_mem_array*>& input,
+                                                        const bounding_box& bounding_box,
+                                                        const uint32_t surfels_per_node)
+{
+    uint16_t max_axis_ratio = 1000;
+
+    vec3r bb_dimensions = bounding_box.get_dimensions();
+
+    vec3ui grid_dimensions;
+    vec3b locked_grid_dimensions(false, false, false);
+
+    std::vector<value_index_pair> sorted_bb_dimensions;
+    sorted_bb_dimensions.push_back(std::make_pair(bb_dimensions[0], 0));
+    sorted_bb_dimensions.push_back(std::make_pair(bb_dimensions[1], 1));
+    sorted_bb_dimensions.push_back(std::make_pair(bb_dimensions[2], 2));
+
+    std::sort(sorted_bb_dimensions.begin(), sorted_bb_dimensions.end());
+
+    vec3ui sorted_grid_dimensions;
+    vec3b sorted_locked_grid_dimensions(false, false, false);
+
+    bool bb_zero_size = false;
+
+    if  ((sorted_bb_dimensions[0].first == 0) &&
+        (sorted_bb_dimensions[1].first == 0) &&
+        (sorted_bb_dimensions[2].first == 0))
+    {
+        bb_zero_size = true;
+    }
+    else if ((sorted_bb_dimensions[0].first == 0) &&
+            (sorted_bb_dimensions[1].first == 0))
+    {
+        sorted_locked_grid_dimensions[0] = true;
+        sorted_locked_grid_dimensions[1] = true;
+        sorted_grid_dimensions = vec3ui(1,1,1);
+    }
+    else if (sorted_bb_dimensions[0].first == 0)
+    {
+        sorted_locked_grid_dimensions[0] = true;
+
+        if (sorted_bb_dimensions[1].first < sorted_bb_dimensions[2].first)
+        {
+            sorted_grid_dimensions = vec3ui(1,1,floor(sorted_bb_dimensions[2].first/sorted_bb_dimensions[1].first));
+            if (sorted_grid_dimensions[2] > max_axis_ratio)
+                sorted_grid_dimensions[2] = max_axis_ratio;
+        }
+        else
+        {
+            sorted_grid_dimensions = vec3ui(1,floor(sorted_bb_dimensions[1].first/sorted_bb_dimensions[2].first),1);
+            if (sorted_grid_dimensions[1] > max_axis_ratio)
+                sorted_grid_dimensions[1] = max_axis_ratio;
+        }
+    } else {
+        sorted_grid_dimensions = vec3ui(1,floor(sorted_bb_dimensions[1].first/sorted_bb_dimensions[0].first),floor(sorted_bb_dimensions[2].first/sorted_bb_dimensions[0].first));
+        if (sorted_grid_dimensions[1] > max_axis_ratio)
+            sorted_grid_dimensions[1] = max_axis_ratio;
+        if (sorted_grid_dimensions[2] > max_axis_ratio)
+            sorted_grid_dimensions[2] = max_axis_ratio;
+    }
+
+    if (bb_zero_size) {
+        return std::make_pair(vec3ui(1,1,1), locked_grid_dimensions);
+    }
+
+    for (uint32_t i = 0; i < 3; ++i) {
+        grid_dimensions[sorted_bb_dimensions[i].second] = sorted_grid_dimensions[i];
+        locked_grid_dimensions[sorted_bb_dimensions[i].second] = sorted_locked_grid_dimensions[i];
+    }
+
+    uint32_t total_grid_dimensions = (grid_dimensions[0]*grid_dimensions[1]*grid_dimensions[2]);
+
+    if (total_grid_dimensions < surfels_per_node)
+    {
+        while (((grid_dimensions[0]+1)*(grid_dimensions[1]+1)*(grid_dimensions[2]+1)) < surfels_per_node)
+        {
+            for (uint32_t axis = 0; axis < 3; ++axis)
+                if (!locked_grid_dimensions[axis])
+                    grid_dimensions[axis] = grid_dimensions[axis]+1;
+        }
+    }
+    else if (total_grid_dimensions > surfels_per_node)
+    {
+        while (total_grid_dimensions > surfels_per_node)
+        {
+            for (uint32_t axis = 0; axis < 3; ++axis)
+                if (grid_dimensions[axis] != 1)
+                    grid_dimensions[axis] = grid_dimensions[axis]-1;
+            total_grid_dimensions = (grid_dimensions[0]*grid_dimensions[1]*grid_dimensions[2]);
+        }
+    }
+
+    for (size_t termination_ctr = 0; termination_ctr < 40000; ++termination_ctr) {
+
+        std::vector<std::vector<std::vector<bool>>> grid(grid_dimensions[0],
+                                                         std::vector<std::vector<bool>>(grid_dimensions[1],
+                                                                                        std::vector<bool>(grid_dimensions[2], false)));
+
+        vec3r cell_size = vec3r(fabs(bb_dimensions[0]/grid_dimensions[0]),
+                                fabs(bb_dimensions[1]/grid_dimensions[1]),
+                                fabs(bb_dimensions[2]/grid_dimensions[2]));
+
+        for (uint32_t i = 0; i < input.size(); ++i)
+        {
+            for (uint32_t j = 0; j < input[i]->length(); ++j)
+            {
+                vec3ui index = cell_index(relative_position(input[i]->read_surfel_ref(j), bounding_box),
+                                          cell_size, grid_dimensions, locked_grid_dimensions);
+                grid[index[0]][index[1]][index[2]] = true;
+            }
+        }
+
+        uint32_t occupied_cells = 0;
+
+        for (const auto& plane : grid)
+            for (const auto& row : plane)
+                occupied_cells += std::count(row.begin(), row.end(), true);
+
+        if ((occupied_cells > surfels_per_node) || (grid_dimensions[0]*grid_dimensions[1]*grid_dimensions[2] > 100000))  {
+            for (uint32_t axis = 0; axis < 3; ++axis)
+                if (grid_dimensions[axis] != 1)
+                    grid_dimensions[axis] = grid_dimensions[axis]-1;
+            break;
+        } else {
+            for (uint32_t axis = 0; axis < 3; ++axis)
+                if (!locked_grid_dimensions[axis])
+                    grid_dimensions[axis] = grid_dimensions[axis]+1;
+        }
+    }
+
+    return std::make_pair(grid_dimensions, locked_grid_dimensions);
+}
+
+inline surfel_mem_array create_lod(const std::vector<surfel_mem_array*>& input,
+                                   const uint32_t surfels_per_node)
+{
+    bounding_box bbox = basic_algorithms::compute_aabb(*input[0], true);
+
+    for (auto child_surfels = input.begin() + 1; child_surfels !=input.end(); ++child_surfels)
+    {
+        bbox.expand(basic_algorithms::compute_aabb(*(*child_surfels), true));
+    }
+
+    vec3r bb_dimensions = bbox.get_dimensions();
+
+    std::pair<vec3ui, vec3b> grid_data = compute_grid_dimensions(input, bbox, surfels_per_node);
+    vec3ui grid_dimensions = grid_data.first;
+    vec3b locked_grid_dimensions = grid_data.second;
+
+    std::vector<std::vector<std::vector<std::shared_ptr<std::list<surfel>>>>> grid(grid_dimensions[0],
+        std::vector<std::vector<std::shared_ptr<std::list<surfel>>>>(grid_dimensions[1], std::vector<std::shared_ptr<std::list<surfel>>>(grid_dimensions[2])));
+
+    for (auto& plane : grid)
+        for (auto& row : plane)
+            for (auto& cell : row)
+                cell = std::make_shared<std::list<surfel>>();
+
+    vec3r cell_size = vec3r(fabs(bb_dimensions[0]/grid_dimensions[0]),fabs(bb_dimensions[1]/grid_dimensions[1]),fabs(bb_dimensions[2]/grid_dimensions[2]));
+
+    for (uint32_t i = 0; i < input.size(); ++i)
+    {
+        for (uint32_t j = 0; j < input[i]->length(); ++j)
+        {
+            vec3ui index = cell_index(relative_position(input[i]->read_surfel_ref(j), bbox),
+                                      cell_size, grid_dimensions, locked_grid_dimensions);
+            grid[index[0]][index[1]][index[2]]->push_back(input[i]->read_surfel_ref(j));
+        }
+    }
+
+    std::priority_queue<surfel_cluster_with_error, std::vector<surfel_cluster_with_error>, order_by_size> cell_pq;
+    uint32_t surfel_count = 0;
+
+    for (auto& plane : grid)
+    {
+        for (auto& row : plane)
+        {
+            for (auto& cell : row)
+            {
+                cell_pq.push({cell, 0.1f});
+                surfel_count += cell->size();
+            }
+        }
+    }
+
+    for (size_t termination_ctr = 0; surfel_count > surfels_per_node && termination_ctr < 30000; ++termination_ctr)
+    {
+        std::shared_ptr<std::list<surfel>> input_cluster = cell_pq.top().cluster;
+        float merge_treshold = cell_pq.top().merge_treshold;
+        cell_pq.pop();
+
+        uint32_t input_cluster_size = input_cluster->size();
+        surfel_count -= input_cluster_size;
+        bool early_termination = false;
+
+        auto output_cluster = std::make_shared<std::list<surfel>>();
+
+        while(input_cluster->size() != 0)
+        {
+            std::vector<surfel> surfels_to_merge;
+            surfels_to_merge.push_back(input_cluster->front());
+            input_cluster->pop_front();
+
+            std::list<surfel>::iterator surfel_to_compare = input_cluster->begin();
+
+            while(surfel_to_compare != input_cluster->end())
+            {
+                vec3f normal1 = surfels_to_merge.front().normal();
+                vec3f normal2 = (*surfel_to_compare).normal();
+
+                bool flip_normal = false;
+
+                float dot_product = scm::math::dot(normal1,normal2);
+
+                if (dot_product > 1.0)
+                    dot_product = 1.0;
+                else if ((dot_product < -1.0))
+                    dot_product = -1.0;
+
+                if (dot_product < 0) {
+                    flip_normal = true;
+                    dot_product *= -1;
+                }
+                float angle = acos(dot_product);
+                float angle_normalized = angle/(0.5*M_PI);
+
+                if(angle_normalized <= merge_treshold)
+                {
+                    if (flip_normal) {
+                        surfel_to_compare->normal() = surfel_to_compare->normal() * (-1.0);
+                    }
+
+                    surfels_to_merge.push_back(*surfel_to_compare);
+                    surfel_to_compare = input_cluster->erase(surfel_to_compare);
+
+                    if (( surfel_count + input_cluster->size() + output_cluster->size() + 1) <= surfels_per_node) {
+                        early_termination = true;
+                        break;
+                    }
+
+                } else {
+                    std::advance(surfel_to_compare,1);
+                }
+            }
+            output_cluster->push_back(create_representative(surfels_to_merge));
+
+            if (early_termination) {
+                output_cluster->insert(output_cluster->end(), input_cluster->begin(), input_cluster->end());
+                break;
+            }
+        }
+
+        surfel_count += output_cluster->size();
+
+        if (input_cluster_size == output_cluster->size()) {
+            merge_treshold += 0.1;
+        }
+
+        cell_pq.push({output_cluster, merge_treshold});
+    }
+
+    surfel_mem_array mem_array(std::make_shared<surfel_vector>(surfel_vector()), 0, 0);
+
+    while (!cell_pq.empty())
+    {
+        std::shared_ptr<std::list<surfel>> cluster = cell_pq.top().cluster;
+        cell_pq.pop();
+
+        mem_array.surfel_mem_data()->insert(mem_array.surfel_mem_data()->end(), cluster->begin(), cluster->end());
+    }
+
+    mem_array.set_length(mem_array.surfel_mem_data()->size());
+
+    return mem_array;
+}
+
+}
+
+#endif
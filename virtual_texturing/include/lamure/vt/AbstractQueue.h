@@ -68,6 +68,8 @@ class VT_DLL AbstractQueue
 
     virtual void _extractUnsafe(AbstractQueueEntry<content_type>& entry)
     {
+        --_size;
+
         auto prev = entry.getPrev();
         auto next = entry.getNext();
 
@@ -118,6 +120,7 @@ class VT_DLL AbstractQueue
   public:
     AbstractQueue()
     {
+        _size.store(0);
         _first.store(nullptr);
         _last.store(nullptr);
     }
@@ -138,6 +141,8 @@ class VT_DLL AbstractQueue
 
     virtual bool pop(content_type& content, const std::chrono::milliseconds maxTime) = 0;
 
+    size_t size() { return _size.load(); }
+
     virtual void remove(AbstractQueueEntry<content_type>& entry)
     {
         std::lock_guard<std::mutex> lock(_lock);
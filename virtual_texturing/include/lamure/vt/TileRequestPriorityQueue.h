@@ -50,6 +50,8 @@ class VT_DLL TileRequestPriorityQueue : public AbstractQueue<ooc::TileRequest*>
   protected:
     virtual void _insertUnsafe(TileRequestPriorityQueueEntry<priority_type>& entry)
     {
+        ++this->_size;
+
         auto next = (TileRequestPriorityQueueEntry<priority_type>*)this->_first.load();
         TileRequestPriorityQueueEntry<priority_type>* prev = nullptr;
 
@@ -99,9 +101,13 @@ class VT_DLL TileRequestPriorityQueue : public AbstractQueue<ooc::TileRequest*>
     {
         auto entry = new TileRequestPriorityQueueEntry<priority_type>(content, *this);
 
-        std::lock_guard<std::mutex> lock(this->_lock);
+        {
+            std::lock_guard<std::mutex> lock(this->_lock);
+
+            this->_insertUnsafe(*entry);
+        }
 
-        this->_insertUnsafe(*entry);
+        this->_newEntry.notify_one();
     }
 
     virtual bool pop(ooc::TileRequest*& content, const std::chrono::milliseconds maxTime)
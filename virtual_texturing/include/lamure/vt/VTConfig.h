@@ -65,6 +65,7 @@ class VT_DLL VTConfig
     uint32_t get_size_physical_update_throughput() const;
 
     uint32_t get_size_ram_cache() const;
+    uint16_t get_count_loader_threads() const;
 
     FORMAT_TEXTURE get_format_texture() const;
     bool is_verbose() const;
@@ -78,6 +79,7 @@ class VT_DLL VTConfig
     void set_size_physical_texture(uint32_t sizePhysicalTexture);
     void set_size_physical_update_throughput(uint32_t sizePhysicalUpdateThroughput);
     void set_size_ram_cache(uint32_t sizeRamCache);
+    void set_count_loader_threads(uint16_t countLoaderThreads);
     void set_format_texture(FORMAT_TEXTURE formatTexture);
     void set_verbose(bool verbose);
 
@@ -95,6 +97,7 @@ private:
     static constexpr const char* PHYSICAL_SIZE_MB = "PHYSICAL_SIZE_MB";
     static constexpr const char* PHYSICAL_UPDATE_THROUGHPUT_MB = "PHYSICAL_UPDATE_THROUGHPUT_MB";
     static constexpr const char* RAM_CACHE_SIZE_MB = "RAM_CACHE_SIZE_MB";
+    static constexpr const char* LOADER_THREADS = "LOADER_THREADS";
 
     static constexpr const char* TEXTURE_FORMAT = "TEXTURE_FORMAT";
     static constexpr const char* TEXTURE_FORMAT_RGBA8 = "RGBA8";
@@ -114,6 +117,7 @@ private:
     uint32_t _size_physical_texture;
     uint32_t _size_physical_update_throughput;
     uint32_t _size_ram_cache;
+    uint16_t _count_loader_threads;
 
     VTConfig::FORMAT_TEXTURE _format_texture;
     bool _verbose;
@@ -15,6 +15,7 @@
 #include <lamure/vt/ooc/TileCache.h>
 #include <lamure/vt/ooc/TileRequest.h>
 #include <thread>
+#include <vector>
 
 namespace vt
 {
@@ -26,7 +27,10 @@ class VT_DLL HeapProcessor
     TileRequestPriorityQueue<float> _requests_prio_queue;
 
     std::atomic<bool> _running;
-    std::thread* _thread;
+    std::vector<std::thread> _threads;
+    size_t _threadCount;
+
+    std::atomic<uint64_t> _processedCount;
 
     TileCache* _cache;
 
@@ -36,6 +40,15 @@ class VT_DLL HeapProcessor
 
     void request(TileRequest* request);
 
+    // Workers pop from the shared queue, so requests are still taken in order of priority.
+    void setThreadCount(size_t threadCount);
+
+    size_t getThreadCount();
+
+    size_t getQueueDepth();
+
+    uint64_t getProcessedCount();
+
     void start();
 
     void run();
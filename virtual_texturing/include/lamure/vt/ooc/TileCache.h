@@ -8,15 +8,15 @@
 #ifndef VT_OOC_TILECACHE_H
 #define VT_OOC_TILECACHE_H
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cstddef>
 #include <cstdint>
 #include <iostream>
 #include <lamure/vt/platform.h>
 #include <lamure/vt/pre/AtlasFile.h>
-#include <map>
 #include <mutex>
-#include <queue>
 
 namespace vt
 {
@@ -36,14 +36,19 @@ class VT_DLL TileCacheSlot
     };
 
   protected:
-    STATE _state;
+    friend class TileCache;
+
+    // state in the upper half, one bit per referencing context in the lower half,
+    // so pinning a slot for reading is a single compare-and-swap
+    std::atomic<uint64_t> _control;
+    std::atomic<bool> _referenced;
+
     uint8_t* _buffer;
     size_t _size;
     size_t _id;
-    uint32_t _context_reference;
 
-    pre::AtlasFile* _resource;
-    uint64_t _tileId;
+    std::atomic<pre::AtlasFile*> _resource;
+    std::atomic<uint64_t> _tileId;
 
     TileCache* _cache;
 
@@ -83,24 +88,50 @@ class VT_DLL TileCacheSlot
     void removeAllContextReferences();
 };
 
+// Occupied slots are found through an open addressing hash of (resource, tile id) with buckets of about one cache line.
+// Entries never move, lookups and read references are lock-free. Only writers serialise on inserting into and
+// erasing from the hash. Slots are recycled with CLOCK replacement, slots referenced by a context are never evicted.
 class VT_DLL TileCache
 {
   protected:
     typedef TileCacheSlot slot_type;
 
+    static constexpr size_t BUCKET_SIZE = 7;
+
+    struct Bucket
+    {
+        // (tag << 32) | (slot id + 1), 0 if empty
+        std::atomic<uint64_t> entries[BUCKET_SIZE];
+
+        // number of entries stored beyond this bucket, lookups continue in the next bucket while non-zero
+        std::atomic<uint32_t> overflow;
+    };
+
     size_t _tileByteSize;
     size_t _slotCount;
 
-    std::mutex* _locks;
     uint8_t* _buffer;
     slot_type* _slots;
 
-    std::mutex _lruLock;
-    std::condition_variable _lruRepopulationCV;
-    std::queue<TileCacheSlot*> _lru;
+    Bucket* _buckets;
+    size_t _bucketMask;
+    std::mutex _indexLock;
+
+    std::atomic<size_t> _clockHand;
+
+    std::atomic<size_t> _evictableCount;
+    std::atomic<size_t> _waitingWriters;
+    std::mutex _evictableLock;
+    std::condition_variable _evictableCV;
+
+    static uint64_t _hash(pre::AtlasFile* resource, uint64_t tile_id);
+
+    slot_type* _find(pre::AtlasFile* resource, uint64_t tile_id);
+    void _insertUnsafe(slot_type* slot);
+    void _eraseUnsafe(slot_type* slot);
 
-    std::mutex _idsLock;
-    std::map<std::pair<pre::AtlasFile*, uint64_t>, slot_type*> _ids;
+    bool _pin(slot_type* slot, uint16_t context_id);
+    void _makeEvictable();
 
   public:
     TileCache(size_t tileByteSize, size_t slotCount);
@@ -32,6 +32,9 @@ class VT_DLL TileProvider
     TileRequestMap _requestsMap;
     TileLoader _loader;
 
+    uint64_t _printedCount;
+    std::chrono::steady_clock::time_point _printedTime;
+
     std::mutex _cacheLock;
     TileCache* _cache;
 
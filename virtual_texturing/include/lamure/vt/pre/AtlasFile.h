@@ -11,6 +11,7 @@
 #include <cstdint>
 #include <fstream>
 #include <cstring>
+#include <mutex>
 #include <lamure/vt/common.h>
 #include <lamure/vt/pre/Bitmap.h>
 #include <lamure/vt/pre/QuadTree.h>
@@ -37,6 +38,14 @@ class VT_DLL AtlasFile
     const char* _fileName;
     std::ifstream _file;
 
+    // Tiles are read with pread, so concurrent getTile calls do not share a stream position.
+    // Windows falls back to serialised reads on the stream.
+#ifdef _WIN32
+    std::mutex _fileLock;
+#else
+    int _fd;
+#endif
+
     uint64_t _imageWidth;
     uint64_t _imageHeight;
     uint64_t _tileWidth;
@@ -71,6 +80,8 @@ class VT_DLL AtlasFile
 
     uint64_t _getOffset(uint64_t id);
 
+    bool _readAt(uint64_t offset, uint8_t* out, size_t size);
+
   public:
     AtlasFile(const char* fileName);
     ~AtlasFile();
@@ -53,7 +53,7 @@ class VT_DLL Index
     explicit Index<val_type>(size_t size)
     {
         _size = size;
-        _data = new val_type[size];
+        _data = new val_type[size]();
     }
 
     ~Index() { delete[] _data; }
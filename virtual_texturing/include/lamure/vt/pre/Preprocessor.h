@@ -21,6 +21,10 @@
 #include <cstring>
 #include <iomanip>
 #include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
 
 #include <lamure/vt/common.h>
 #include <lamure/vt/pre/QuadTree.h>
@@ -46,6 +50,9 @@ class VT_DLL Preprocessor
   protected:
     static constexpr size_t _HEADER_SIZE = 71;
 
+    // children and left and top neighbour children of a tile, followed by the tile itself
+    static constexpr size_t _DEFLATE_TILE_BUFFERS = 10;
+
     std::string _srcFileName;
     Bitmap::PIXEL_FORMAT _srcPxFormat;
 
@@ -68,6 +75,8 @@ class VT_DLL Preprocessor
 
     size_t _treeDepth;
 
+    size_t _threadCount;
+
     std::ifstream _srcFile;
     uint64_t _srcFileSize;
 
@@ -94,6 +103,7 @@ class VT_DLL Preprocessor
     void _writeHeader();
     void _extract(size_t bufferTileWidth, size_t writeBufferTileSize);
     void _deflate(size_t tilesInWriteBuffer);
+    void _deflateTile(uint64_t relIterationId, size_t iterationLevel, uint8_t* buffer);
 
     void _putLE(uint64_t num, uint8_t* out);
     void _putPixelFormat(Bitmap::PIXEL_FORMAT pxFormat, uint8_t* out);
@@ -108,6 +118,8 @@ class VT_DLL Preprocessor
 
     void setOutput(const std::string& destFileName, Bitmap::PIXEL_FORMAT destPxFormat, AtlasFile::LAYOUT format, size_t tileWidth, size_t tileHeight, size_t padding, bool combine = true);
 
+    void setThreadCount(size_t threadCount);
+
     void run(size_t maxMemory);
 };
 } // namespace pre
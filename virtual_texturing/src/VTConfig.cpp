@@ -32,8 +32,15 @@ void VTConfig::read_config(const char* path_config)
     _size_physical_texture = (uint32_t)atoi(ini_config->GetValue(VTConfig::TEXTURE_MANAGEMENT, VTConfig::PHYSICAL_SIZE_MB, VTConfig::UNDEF));
     _size_physical_update_throughput = (uint32_t)atoi(ini_config->GetValue(VTConfig::TEXTURE_MANAGEMENT, VTConfig::PHYSICAL_UPDATE_THROUGHPUT_MB, VTConfig::UNDEF));
     _size_ram_cache = (uint32_t)atoi(ini_config->GetValue(VTConfig::TEXTURE_MANAGEMENT, VTConfig::RAM_CACHE_SIZE_MB, VTConfig::UNDEF));
+    _count_loader_threads = (uint16_t)atoi(ini_config->GetValue(VTConfig::TEXTURE_MANAGEMENT, VTConfig::LOADER_THREADS, VTConfig::UNDEF));
     _format_texture = VTConfig::which_texture_format(ini_config->GetValue(VTConfig::TEXTURE_MANAGEMENT, VTConfig::TEXTURE_FORMAT, VTConfig::UNDEF));
     _verbose = atoi(ini_config->GetValue(VTConfig::DEBUG, VTConfig::VERBOSE, VTConfig::UNDEF)) == 1;
+
+    // optional field, older configurations do not specify it
+    if(_count_loader_threads == 0)
+    {
+        _count_loader_threads = 4;
+    }
 }
 void VTConfig::define_size_physical_texture(uint32_t max_tex_layers, uint32_t max_tex_px_width_gl)
 {
@@ -95,6 +102,7 @@ const VTConfig::FORMAT_TEXTURE VTConfig::which_texture_format(const char* _textu
 }
 
 uint32_t VTConfig::get_size_ram_cache() const { return _size_ram_cache; }
+uint16_t VTConfig::get_count_loader_threads() const { return _count_loader_threads; }
 void VTConfig::set_defaults()
 {
     _size_tile = 256;
@@ -102,6 +110,7 @@ void VTConfig::set_defaults()
     _size_physical_texture = 4096;
     _size_physical_update_throughput = 4;
     _size_ram_cache = 16384;
+    _count_loader_threads = 4;
     _format_texture = FORMAT_TEXTURE::RGB8;
     _verbose = false;
 
@@ -112,6 +121,7 @@ void VTConfig::set_size_padding(uint16_t sizePadding) { _size_padding = sizePadd
 void VTConfig::set_size_physical_texture(uint32_t sizePhysicalTexture) { _size_physical_texture = sizePhysicalTexture; }
 void VTConfig::set_size_physical_update_throughput(uint32_t sizePhysicalUpdateThroughput) { _size_physical_update_throughput = sizePhysicalUpdateThroughput; }
 void VTConfig::set_size_ram_cache(uint32_t sizeRamCache) { _size_ram_cache = sizeRamCache; }
+void VTConfig::set_count_loader_threads(uint16_t countLoaderThreads) { _count_loader_threads = countLoaderThreads; }
 void VTConfig::set_format_texture(VTConfig::FORMAT_TEXTURE formatTexture) { _format_texture = formatTexture; }
 void VTConfig::set_verbose(bool verbose) { _verbose = verbose; }
 } // namespace vt
\ No newline at end of file
@@ -7,27 +7,43 @@
 
 #include <lamure/vt/ooc/HeapProcessor.h>
 
+#include <algorithm>
+
 namespace vt
 {
 namespace ooc
 {
 HeapProcessor::HeapProcessor()
 {
-    _thread = nullptr;
+    _running = false;
+    _threadCount = 1;
+    _processedCount = 0;
     _cache = nullptr;
 }
 
-HeapProcessor::~HeapProcessor()
+HeapProcessor::~HeapProcessor() { stop(); }
+
+void HeapProcessor::request(TileRequest* request) { _requests_prio_queue.push(request); }
+
+void HeapProcessor::setThreadCount(size_t threadCount)
 {
-    stop();
-    delete _thread;
+    if(!_threads.empty())
+    {
+        throw std::runtime_error("Thread count of HeapProcessor cannot be changed while running.");
+    }
+
+    _threadCount = std::max(threadCount, (size_t)1);
 }
 
-void HeapProcessor::request(TileRequest* request) { _requests_prio_queue.push(request); }
+size_t HeapProcessor::getThreadCount() { return _threadCount; }
+
+size_t HeapProcessor::getQueueDepth() { return _requests_prio_queue.size(); }
+
+uint64_t HeapProcessor::getProcessedCount() { return _processedCount.load(); }
 
 void HeapProcessor::start()
 {
-    if(_thread != nullptr)
+    if(!_threads.empty())
     {
         throw std::runtime_error("HeapProcessor is already started.");
     }
@@ -38,7 +54,11 @@ void HeapProcessor::start()
     }
 
     _running = true;
-    _thread = new std::thread(&HeapProcessor::run, this);
+
+    for(size_t i = 0; i < _threadCount; ++i)
+    {
+        _threads.emplace_back(&HeapProcessor::run, this);
+    }
 }
 
 void HeapProcessor::run()
@@ -57,7 +77,10 @@ void HeapProcessor::run()
         if(!process(req))
         {
             _cache->waitUntilLRURepopulation(std::chrono::milliseconds(200));
+            continue;
         }
+
+        ++_processedCount;
     }
 
     beforeStop();
@@ -68,10 +91,16 @@ void HeapProcessor::writeTo(TileCache* cache) { _cache = cache; }
 void HeapProcessor::stop()
 {
     _running = false;
-    if(_thread->joinable())
+
+    for(auto& thread : _threads)
     {
-        _thread->join();
+        if(thread.joinable())
+        {
+            thread.join();
+        }
     }
+
+    _threads.clear();
 }
 
 } // namespace ooc
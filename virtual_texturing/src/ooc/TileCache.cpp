@@ -14,14 +14,49 @@ namespace ooc
 {
 typedef TileCacheSlot slot_type;
 
+namespace
+{
+constexpr uint64_t CONTEXT_MASK = 0xffffffffull;
+
+inline uint64_t makeControl(slot_type::STATE state, uint64_t contexts) { return ((uint64_t)state << 32) | contexts; }
+
+inline slot_type::STATE stateOf(uint64_t control) { return (slot_type::STATE)(control >> 32); }
+
+inline uint64_t contextsOf(uint64_t control) { return control & CONTEXT_MASK; }
+
+inline uint64_t contextBit(uint16_t context_id)
+{
+    if(context_id >= 32)
+    {
+        throw std::runtime_error("Only 32 contexts are supported");
+    }
+
+    return 1ull << context_id;
+}
+
+inline uint16_t countBits(uint64_t bits)
+{
+    uint16_t count = 0;
+
+    for(; bits != 0; bits &= bits - 1)
+    {
+        ++count;
+    }
+
+    return count;
+}
+} // namespace
+
 TileCacheSlot::TileCacheSlot()
 {
-    _state = STATE::FREE;
+    _control = makeControl(STATE::FREE, 0);
+    _referenced = false;
     _buffer = nullptr;
     _cache = nullptr;
     _size = 0;
+    _id = 0;
+    _resource = nullptr;
     _tileId = 0;
-    _context_reference = 0;
 }
 
 TileCacheSlot::~TileCacheSlot()
@@ -29,15 +64,22 @@ TileCacheSlot::~TileCacheSlot()
     // std::cout << "del slot " << this << std::endl;
 }
 
-bool TileCacheSlot::compareState(STATE state) { return _state == state; }
+bool TileCacheSlot::compareState(STATE state) { return stateOf(_control.load()) == state; }
 
-void TileCacheSlot::setTileId(uint64_t tileId) { _tileId = tileId; }
+void TileCacheSlot::setTileId(uint64_t tileId) { _tileId.store(tileId, std::memory_order_relaxed); }
 
-uint64_t TileCacheSlot::getTileId() { return _tileId; }
+uint64_t TileCacheSlot::getTileId() { return _tileId.load(std::memory_order_relaxed); }
 
 void TileCacheSlot::setCache(TileCache* cache) { _cache = cache; }
 
-void TileCacheSlot::setState(STATE state) { _state = state; }
+void TileCacheSlot::setState(STATE state)
+{
+    uint64_t control = _control.load();
+
+    while(!_control.compare_exchange_weak(control, makeControl(state, contextsOf(control))))
+    {
+    }
+}
 
 void TileCacheSlot::setId(size_t id) { _id = id; }
 
@@ -51,193 +93,367 @@ void TileCacheSlot::setSize(size_t size) { _size = size; }
 
 size_t TileCacheSlot::getSize() { return _size; }
 
-void TileCacheSlot::setResource(pre::AtlasFile* res) { _resource = res; }
+void TileCacheSlot::setResource(pre::AtlasFile* res) { _resource.store(res, std::memory_order_relaxed); }
 
-pre::AtlasFile* TileCacheSlot::getResource() { return _resource; }
+pre::AtlasFile* TileCacheSlot::getResource() { return _resource.load(std::memory_order_relaxed); }
 
-void TileCacheSlot::addContextReference(uint16_t context_id)
+void TileCacheSlot::addContextReference(uint16_t context_id) { _control.fetch_or(contextBit(context_id)); }
+
+void TileCacheSlot::removeContextReference(uint16_t context_id) { _control.fetch_and(~contextBit(context_id)); }
+
+uint16_t TileCacheSlot::getContextReferenceCount() { return countBits(contextsOf(_control.load())); }
+
+void TileCacheSlot::removeAllContextReferences() { _control.fetch_and(~CONTEXT_MASK); }
+
+TileCache::TileCache(size_t tileByteSize, size_t slotCount)
 {
-    if(context_id > 32)
+    _tileByteSize = tileByteSize;
+    _slotCount = slotCount;
+    _buffer = new uint8_t[tileByteSize * slotCount];
+    _slots = new slot_type[slotCount];
+
+    for(size_t i = 0; i < slotCount; ++i)
     {
-        throw std::runtime_error("Only 32 contexts are supported");
+        _slots[i].setId(i);
+        _slots[i].setBuffer(&_buffer[tileByteSize * i]);
+        _slots[i].setCache(this);
     }
 
-    _context_reference |= 1UL << context_id;
-}
-void TileCacheSlot::removeContextReference(uint16_t context_id)
-{
-    if(context_id > 32)
+    // about four entries per bucket at most
+    size_t bucketCount = 1;
+
+    while(bucketCount * 4 < slotCount)
     {
-        throw std::runtime_error("Only 32 contexts are supported");
+        bucketCount <<= 1;
+    }
+
+    _buckets = new Bucket[bucketCount];
+    _bucketMask = bucketCount - 1;
+
+    for(size_t i = 0; i < bucketCount; ++i)
+    {
+        for(auto& entry : _buckets[i].entries)
+        {
+            entry = 0;
+        }
+
+        _buckets[i].overflow = 0;
     }
 
-    _context_reference &= ~(1UL << context_id);
+    _clockHand = 0;
+    _evictableCount = slotCount;
+    _waitingWriters = 0;
 }
-static const unsigned int num_to_bits[16] = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
 
-unsigned int countSetBitsRec(unsigned int num)
+uint64_t TileCache::_hash(pre::AtlasFile* resource, uint64_t tile_id)
 {
-    int nibble = 0;
-    if(0 == num)
-        return num_to_bits[0];
+    // splitmix64 finaliser
+    uint64_t hash = tile_id ^ ((uint64_t)(uintptr_t)resource * 0x9e3779b97f4a7c15ull);
 
-    nibble = num & 0xf;
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ull;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebull;
 
-    return num_to_bits[nibble] + countSetBitsRec(num >> 4);
+    return hash ^ (hash >> 31);
 }
 
-uint16_t TileCacheSlot::getContextReferenceCount() { return (uint16_t)countSetBitsRec(_context_reference); }
-void TileCacheSlot::removeAllContextReferences() { _context_reference = 0u; }
-TileCache::TileCache(size_t tileByteSize, size_t slotCount)
+slot_type* TileCache::_find(pre::AtlasFile* resource, uint64_t tile_id)
 {
-    _tileByteSize = tileByteSize;
-    _slotCount = slotCount;
-    _buffer = new uint8_t[tileByteSize * slotCount];
-    _slots = new slot_type[slotCount];
-    _locks = new std::mutex[slotCount];
+    uint64_t hash = _hash(resource, tile_id);
+    uint64_t tag = hash >> 32;
+    size_t bucketIdx = hash & _bucketMask;
 
-    for(size_t i = 0; i < slotCount; ++i)
+    for(size_t probe = 0; probe <= _bucketMask; ++probe)
     {
-        _slots[i].setId(i);
-        _slots[i].setBuffer(&_buffer[tileByteSize * i]);
-        _slots[i].setCache(this);
+        Bucket& bucket = _buckets[bucketIdx];
 
-        _lru.push(&_slots[i]);
+        for(auto& entry : bucket.entries)
+        {
+            uint64_t value = entry.load(std::memory_order_acquire);
+
+            if(value == 0 || (value >> 32) != tag)
+            {
+                continue;
+            }
+
+            slot_type* slot = &_slots[(value & CONTEXT_MASK) - 1];
+
+            if(slot->getResource() == resource && slot->getTileId() == tile_id)
+            {
+                return slot;
+            }
+        }
+
+        if(bucket.overflow.load(std::memory_order_acquire) == 0)
+        {
+            break;
+        }
+
+        bucketIdx = (bucketIdx + 1) & _bucketMask;
     }
+
+    return nullptr;
 }
 
-slot_type* TileCache::requestSlotForReading(pre::AtlasFile* resource, uint64_t tile_id, uint16_t context_id)
+void TileCache::_insertUnsafe(slot_type* slot)
 {
-    std::lock_guard<std::mutex> lock(_idsLock);
+    uint64_t hash = _hash(slot->getResource(), slot->getTileId());
+    uint64_t value = ((hash >> 32) << 32) | (slot->getId() + 1);
+    size_t bucketIdx = hash & _bucketMask;
+
+    for(;;)
+    {
+        Bucket& bucket = _buckets[bucketIdx];
 
-    auto iter = _ids.find(std::make_pair(resource, tile_id));
+        for(auto& entry : bucket.entries)
+        {
+            if(entry.load(std::memory_order_relaxed) == 0)
+            {
+                entry.store(value, std::memory_order_release);
+                return;
+            }
+        }
 
-    if(iter == _ids.end())
+        // there are at most slotCount entries in more than slotCount entry places, so this terminates
+        bucket.overflow.fetch_add(1, std::memory_order_release);
+        bucketIdx = (bucketIdx + 1) & _bucketMask;
+    }
+}
+
+void TileCache::_eraseUnsafe(slot_type* slot)
+{
+    uint64_t hash = _hash(slot->getResource(), slot->getTileId());
+    uint64_t value = ((hash >> 32) << 32) | (slot->getId() + 1);
+    size_t homeIdx = hash & _bucketMask;
+    size_t bucketIdx = homeIdx;
+
+    for(size_t probe = 0; probe <= _bucketMask; ++probe)
     {
-        return nullptr;
+        Bucket& bucket = _buckets[bucketIdx];
+
+        for(auto& entry : bucket.entries)
+        {
+            if(entry.load(std::memory_order_relaxed) == value)
+            {
+                entry.store(0, std::memory_order_release);
+
+                // the buckets passed on insertion no longer overflow on behalf of this entry
+                for(size_t passedIdx = homeIdx; passedIdx != bucketIdx; passedIdx = (passedIdx + 1) & _bucketMask)
+                {
+                    _buckets[passedIdx].overflow.fetch_sub(1, std::memory_order_release);
+                }
+
+                return;
+            }
+        }
+
+        if(bucket.overflow.load(std::memory_order_relaxed) == 0)
+        {
+            break;
+        }
+
+        bucketIdx = (bucketIdx + 1) & _bucketMask;
+    }
+
+    if(VTConfig::get_instance().is_verbose())
+    {
+        std::cerr << "Erasing IDX slot, which does not exist in IDX." << std::endl;
     }
+}
 
-    auto slot = iter->second;
+bool TileCache::_pin(slot_type* slot, uint16_t context_id)
+{
+    uint64_t bit = contextBit(context_id);
+    uint64_t control = slot->_control.load();
 
-    if(slot == nullptr)
+    for(;;)
     {
-        if(VTConfig::get_instance().is_verbose())
+        auto state = stateOf(control);
+
+        if(state != slot_type::STATE::OCCUPIED && state != slot_type::STATE::READING)
         {
-            std::cerr << "IDX slot is null." << std::endl;
+            return false;
+        }
+
+        if(slot->_control.compare_exchange_weak(control, makeControl(slot_type::STATE::READING, contextsOf(control) | bit)))
+        {
+            if(state == slot_type::STATE::OCCUPIED)
+            {
+                --_evictableCount;
+            }
+
+            slot->_referenced.store(true, std::memory_order_relaxed);
+            return true;
         }
-        return nullptr;
     }
+}
+
+void TileCache::_makeEvictable()
+{
+    ++_evictableCount;
 
+    if(_waitingWriters.load() > 0)
     {
-        std::lock_guard<std::mutex> lockSlot(_locks[slot->getId()]);
-        slot->addContextReference(context_id);
-        slot->setState(slot_type::STATE::READING);
+        std::lock_guard<std::mutex> lock(_evictableLock);
+        _evictableCV.notify_all();
     }
+}
 
-    return slot;
+slot_type* TileCache::requestSlotForReading(pre::AtlasFile* resource, uint64_t tile_id, uint16_t context_id)
+{
+    for(;;)
+    {
+        auto slot = _find(resource, tile_id);
+
+        if(slot == nullptr || !_pin(slot, context_id))
+        {
+            return nullptr;
+        }
+
+        // the slot may have been recycled between lookup and pinning
+        if(slot->getResource() == resource && slot->getTileId() == tile_id)
+        {
+            return slot;
+        }
+
+        uint64_t bit = contextBit(context_id);
+        uint64_t control = slot->_control.load();
+
+        while(!slot->_control.compare_exchange_weak(control,
+                                                    makeControl(contextsOf(control) == bit ? slot_type::STATE::OCCUPIED : slot_type::STATE::READING, contextsOf(control) & ~bit)))
+        {
+        }
+
+        if(contextsOf(control) == bit)
+        {
+            _makeEvictable();
+        }
+    }
 }
 
 slot_type* TileCache::requestSlotForWriting()
 {
-    std::lock_guard<std::mutex> lock(_lruLock);
-    while(!_lru.empty())
+    // two rounds of the clock hand, the first may only clear reference bits
+    for(size_t step = 0; step < (_slotCount << 1); ++step)
     {
-        TileCacheSlot* slot = _lru.front();
-        _lru.pop();
+        slot_type* slot = &_slots[_clockHand.fetch_add(1, std::memory_order_relaxed) % _slotCount];
+        uint64_t control = slot->_control.load();
+        auto state = stateOf(control);
 
+        if(state == slot_type::STATE::FREE)
         {
-            std::lock_guard<std::mutex> lockSlot(_locks[slot->getId()]);
-            if(slot->compareState(TileCacheSlot::STATE::FREE))
+            if(slot->_control.compare_exchange_strong(control, makeControl(slot_type::STATE::WRITING, 0)))
             {
-                slot->setState(slot_type::STATE::WRITING);
+                --_evictableCount;
                 return slot;
             }
-            else if(slot->compareState(TileCacheSlot::STATE::OCCUPIED))
+
+            continue;
+        }
+
+        if(state != slot_type::STATE::OCCUPIED || contextsOf(control) != 0)
+        {
+            continue;
+        }
+
+        // second chance
+        if(slot->_referenced.exchange(false, std::memory_order_relaxed))
+        {
+            continue;
+        }
+
+        if(slot->_control.compare_exchange_strong(control, makeControl(slot_type::STATE::WRITING, 0)))
+        {
+            --_evictableCount;
+
             {
-                unregisterOccupiedId(slot->getResource(), slot->getTileId());
-                slot->removeAllContextReferences();
-                slot->setState(slot_type::STATE::WRITING);
-                return slot;
+                std::lock_guard<std::mutex> lock(_indexLock);
+                _eraseUnsafe(slot);
             }
+
+            return slot;
         }
-    };
+    }
 
     return nullptr;
 }
 
 void TileCache::registerOccupiedId(pre::AtlasFile* resource, uint64_t tile_id, slot_type* slot)
 {
-    std::unique_lock<std::mutex> lockSlot(_locks[slot->getId()], std::defer_lock);
-    std::unique_lock<std::mutex> lock(_idsLock, std::defer_lock);
-    std::unique_lock<std::mutex> lockLRU(_lruLock, std::defer_lock);
-
-    std::lock(lockSlot, lock, lockLRU); // transition to scoped_lock when migrating to C++17
-
-    if(slot->compareState(TileCacheSlot::WRITING))
+    if(!slot->compareState(slot_type::STATE::WRITING))
     {
-        _ids.insert(std::make_pair(std::make_pair(resource, tile_id), slot));
-        slot->setState(slot_type::STATE::OCCUPIED);
-
-        _lru.push(slot);
-        _lruRepopulationCV.notify_one();
+        return;
     }
-}
 
-void TileCache::removeContextReferenceFromReadId(pre::AtlasFile* resource, uint64_t tile_id, uint16_t context_id)
-{
-    TileCacheSlot* slot = nullptr;
+    slot->setResource(resource);
+    slot->setTileId(tile_id);
 
     {
-        std::lock_guard<std::mutex> lock(_idsLock);
-
-        auto iter = _ids.find(std::make_pair(resource, tile_id));
+        std::lock_guard<std::mutex> lock(_indexLock);
 
-        if(iter == _ids.end())
+        if(_find(resource, tile_id) != nullptr)
         {
-            if(VTConfig::get_instance().is_verbose())
-            {
-                std::cerr << "Context reference removal from a slot, which does not exist in IDX." << std::endl;
-            }
+            // loaded twice, keep the registered copy
+            slot->_control.store(makeControl(slot_type::STATE::FREE, 0));
+            _makeEvictable();
             return;
         }
 
-        slot = iter->second;
+        _insertUnsafe(slot);
     }
 
-    if(slot == nullptr || !slot->compareState(TileCacheSlot::READING))
+    slot->_referenced.store(true, std::memory_order_relaxed);
+    slot->_control.store(makeControl(slot_type::STATE::OCCUPIED, 0), std::memory_order_release);
+    _makeEvictable();
+}
+
+void TileCache::removeContextReferenceFromReadId(pre::AtlasFile* resource, uint64_t tile_id, uint16_t context_id)
+{
+    TileCacheSlot* slot = _find(resource, tile_id);
+
+    if(slot == nullptr)
     {
         if(VTConfig::get_instance().is_verbose())
         {
-            std::cerr << "Context reference removal from a slot, which is not read." << std::endl;
+            std::cerr << "Context reference removal from a slot, which does not exist in IDX." << std::endl;
         }
         return;
     }
 
-    {
-        std::unique_lock<std::mutex> lockSlot(_locks[slot->getId()], std::defer_lock);
-        std::unique_lock<std::mutex> lock(_idsLock, std::defer_lock);
-        std::unique_lock<std::mutex> lockLRU(_lruLock, std::defer_lock);
+    uint64_t bit = contextBit(context_id);
+    uint64_t control = slot->_control.load();
 
-        std::lock(lockSlot, lock, lockLRU); // transition to scoped_lock when migrating to C++17
+    for(;;)
+    {
+        if(stateOf(control) != slot_type::STATE::READING || (contextsOf(control) & bit) == 0)
+        {
+            if(VTConfig::get_instance().is_verbose())
+            {
+                std::cerr << "Context reference removal from a slot, which is not read." << std::endl;
+            }
+            return;
+        }
 
-        slot->removeContextReference(context_id);
+        uint64_t contexts = contextsOf(control) & ~bit;
 
-        if(slot->getContextReferenceCount() == 0)
+        if(slot->_control.compare_exchange_weak(control, makeControl(contexts == 0 ? slot_type::STATE::OCCUPIED : slot_type::STATE::READING, contexts)))
         {
-            slot->setState(TileCacheSlot::OCCUPIED);
-            _lru.push(slot);
-            _lruRepopulationCV.notify_one();
+            if(contexts == 0)
+            {
+                _makeEvictable();
+            }
+
+            return;
         }
     }
 }
 
 void TileCache::unregisterOccupiedId(pre::AtlasFile* resource, uint64_t tile_id)
 {
-    std::lock_guard<std::mutex> lock(_idsLock);
+    std::lock_guard<std::mutex> lock(_indexLock);
 
-    auto iter = _ids.find(std::make_pair(resource, tile_id));
+    auto slot = _find(resource, tile_id);
 
-    if(iter == _ids.end())
+    if(slot == nullptr)
     {
         if(VTConfig::get_instance().is_verbose())
         {
@@ -246,14 +462,14 @@ void TileCache::unregisterOccupiedId(pre::AtlasFile* resource, uint64_t tile_id)
         return;
     }
 
-    _ids.erase(iter);
+    _eraseUnsafe(slot);
 }
 
 TileCache::~TileCache()
 {
     delete[] _buffer;
     delete[] _slots;
-    delete[] _locks;
+    delete[] _buckets;
 }
 
 void TileCache::print()
@@ -278,23 +494,30 @@ void TileCache::print()
 
     std::cout << std::endl << "IDs:" << std::endl;
 
-    for(auto pair : _ids)
+    for(size_t bucketIdx = 0; bucketIdx <= _bucketMask; ++bucketIdx)
     {
-        std::cout << "\t" << pair.second->getId() << " " << pair.first.first << " " << pair.first.second << " --> " << pair.second->getResource() << " " << pair.second->getTileId() << std::endl;
+        for(auto& entry : _buckets[bucketIdx].entries)
+        {
+            uint64_t value = entry.load();
+
+            if(value != 0)
+            {
+                auto slot = &_slots[(value & CONTEXT_MASK) - 1];
+                std::cout << "\t" << slot->getId() << " " << slot->getResource() << " " << slot->getTileId() << std::endl;
+            }
+        }
     }
 
     std::cout << std::endl;
 }
+
 void TileCache::waitUntilLRURepopulation(std::chrono::milliseconds maxTime)
 {
-    std::unique_lock<std::mutex> lk(_lruLock);
-
-    if(!_lru.empty())
-    {
-        return;
-    }
+    std::unique_lock<std::mutex> lk(_evictableLock);
 
-    _lruRepopulationCV.wait_until(lk, std::chrono::system_clock::now() + maxTime, [&]() -> bool { return !_lru.empty(); });
+    ++_waitingWriters;
+    _evictableCV.wait_for(lk, maxTime, [&]() -> bool { return _evictableCount.load() > 0; });
+    --_waitingWriters;
 }
 } // namespace ooc
 } // namespace vt
\ No newline at end of file
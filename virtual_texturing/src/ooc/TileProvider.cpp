@@ -6,6 +6,7 @@
 // http://www.uni-weimar.de/medien/vr
 
 #include <lamure/vt/ooc/TileProvider.h>
+#include <lamure/vt/VTConfig.h>
 
 namespace vt
 {
@@ -15,6 +16,7 @@ TileProvider::TileProvider() : _resourcesLock(), _cacheLock()
 {
     _cache = nullptr;
     _tileByteSize = 0;
+    _printedCount = 0;
 }
 
 TileProvider::~TileProvider()
@@ -43,7 +45,11 @@ void TileProvider::start(size_t maxMemSize)
 
     _cache = new TileCache(_tileByteSize, slotCount);
     _loader.writeTo(_cache);
+    _loader.setThreadCount(VTConfig::get_instance().get_count_loader_threads());
     _loader.start();
+
+    _printedCount = 0;
+    _printedTime = std::chrono::steady_clock::now();
 }
 
 pre::AtlasFile* TileProvider::loadResource(const char* fileName)
@@ -122,7 +128,23 @@ void TileProvider::stop() { _loader.stop(); }
 void TileProvider::print()
 {
     std::lock_guard<std::mutex> lock(_cacheLock);
-    _cache->print();
+
+    // throughput since the previous call
+    auto now = std::chrono::steady_clock::now();
+    auto processedCount = _loader.getProcessedCount();
+    auto seconds = std::chrono::duration<double>(now - _printedTime).count();
+    auto tilesPerSecond = seconds > 0.0 ? (double)(processedCount - _printedCount) / seconds : 0.0;
+
+    _printedCount = processedCount;
+    _printedTime = now;
+
+    std::cout << "Loader: " << _loader.getThreadCount() << " threads, " << tilesPerSecond << " tiles/s, " << _loader.getQueueDepth() << " queued, " << processedCount << " loaded" << std::endl
+              << std::endl;
+
+    if(_cache != nullptr)
+    {
+        _cache->print();
+    }
 }
 
 bool TileProvider::wait(std::chrono::milliseconds maxTime) { return _requestsMap.waitUntilEmpty(maxTime); }
@@ -8,6 +8,12 @@
 #include <lamure/vt/pre/AtlasFile.h>
 #include <lamure/vt/pre/OffsetIndex.h>
 
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 namespace vt
 {
 namespace pre
@@ -146,11 +152,23 @@ AtlasFile::AtlasFile(const char* fileName)
     _cielabIndex = new CielabIndex(_totalTileCount);
     _file.seekg(_cielabIndexOffset);
     _cielabIndex->readFromFile(_file);
+
+#ifndef _WIN32
+    _fd = ::open(fileName, O_RDONLY);
+
+    if(_fd == -1)
+    {
+        throw std::runtime_error("Could not open Atlas-File.");
+    }
+#endif
 }
 
 AtlasFile::~AtlasFile()
 {
     _file.close();
+#ifndef _WIN32
+    ::close(_fd);
+#endif
     delete _offsetIndex;
     delete _cielabIndex;
 }
@@ -220,10 +238,43 @@ bool AtlasFile::getTile(uint64_t id, uint8_t* out)
         return false;
     }
 
-    _file.seekg(_payloadOffset + offset);
-    _file.read((char*)out, _tileByteSize);
+    return _readAt(_payloadOffset + offset, out, _tileByteSize);
+}
+
+bool AtlasFile::_readAt(uint64_t offset, uint8_t* out, size_t size)
+{
+#ifdef _WIN32
+    std::lock_guard<std::mutex> lock(_fileLock);
+
+    _file.clear();
+    _file.seekg(offset);
+    _file.read((char*)out, size);
+
+    return (size_t)_file.gcount() == size;
+#else
+    size_t bytesRead = 0;
+
+    while(bytesRead < size)
+    {
+        auto result = ::pread(_fd, out + bytesRead, size - bytesRead, (off_t)(offset + bytesRead));
+
+        if(result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if(result <= 0)
+        {
+            std::memset((char*)out + bytesRead, 0x00, size - bytesRead);
+
+            return false;
+        }
+
+        bytesRead += (size_t)result;
+    }
 
     return true;
+#endif
 }
 
 void AtlasFile::extractLevel(uint32_t level, const char* fileName)
@@ -7,6 +7,12 @@
 
 #include <lamure/vt/pre/Bitmap.h>
 #include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BITMAP_DEFLATE_SSE2
+#include <emmintrin.h>
+#endif
 
 namespace vt
 {
@@ -40,6 +46,130 @@ inline double cielabNormaliseRGB(double rgb)
     return rgb * 100;
 }
 
+// 2x2 box filters for one pair of source rows, producing count destination pixels.
+// Each destination channel is (p0 + p1 + p2 + p3) >> 2, identical to _deflatePixels.
+inline void deflateRowR8(const uint8_t* const srcRow0, const uint8_t* const srcRow1, uint8_t* const destRow, size_t count)
+{
+    size_t i = 0;
+
+#ifdef BITMAP_DEFLATE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i lowWords = _mm_set1_epi32(0x0000ffff);
+
+    for(; i + 8 <= count; i += 8)
+    {
+        __m128i row0 = _mm_loadu_si128((const __m128i*)&srcRow0[i << 1]);
+        __m128i row1 = _mm_loadu_si128((const __m128i*)&srcRow1[i << 1]);
+
+        // vertical sums of 16 source pixels
+        __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(row0, zero), _mm_unpacklo_epi8(row1, zero));
+        __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(row0, zero), _mm_unpackhi_epi8(row1, zero));
+
+        // horizontal sums of neighbouring pixels
+        lo = _mm_add_epi32(_mm_and_si128(lo, lowWords), _mm_srli_epi32(lo, 16));
+        hi = _mm_add_epi32(_mm_and_si128(hi, lowWords), _mm_srli_epi32(hi, 16));
+
+        __m128i avrg = _mm_srli_epi16(_mm_packs_epi32(lo, hi), 2);
+        _mm_storel_epi64((__m128i*)&destRow[i], _mm_packus_epi16(avrg, avrg));
+    }
+#endif
+
+    for(; i < count; ++i)
+    {
+        auto src0 = &srcRow0[i << 1];
+        auto src1 = &srcRow1[i << 1];
+
+        destRow[i] = (uint8_t)(((uint16_t)src0[0] + src0[1] + src1[0] + src1[1]) >> 2);
+    }
+}
+
+inline void deflateRowRGB8(const uint8_t* const srcRow0, const uint8_t* const srcRow1, uint8_t* const destRow, size_t count)
+{
+    size_t i = 0;
+
+#ifdef BITMAP_DEFLATE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i firstPixel = _mm_setr_epi16(-1, -1, -1, 0, 0, 0, 0, 0);
+
+    // 2 destination pixels per iteration, the 16 byte loads need one more source pixel pair to stay in the row
+    for(; i + 3 <= count; i += 2)
+    {
+        __m128i row0 = _mm_loadu_si128((const __m128i*)&srcRow0[i * 6]);
+        __m128i row1 = _mm_loadu_si128((const __m128i*)&srcRow1[i * 6]);
+
+        // vertical sums, lo holds source bytes 0 to 7, hi holds source bytes 8 to 15
+        __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(row0, zero), _mm_unpacklo_epi8(row1, zero));
+        __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(row0, zero), _mm_unpackhi_epi8(row1, zero));
+
+        // source pixels 0 and 1 are bytes 0 to 5, source pixels 2 and 3 are bytes 6 to 11
+        __m128i pair0 = _mm_add_epi16(lo, _mm_srli_si128(lo, 6));
+        __m128i pair1 = _mm_or_si128(_mm_srli_si128(lo, 12), _mm_slli_si128(hi, 4));
+        pair1 = _mm_add_epi16(pair1, _mm_srli_si128(pair1, 6));
+
+        __m128i avrg = _mm_or_si128(_mm_and_si128(pair0, firstPixel), _mm_slli_si128(_mm_and_si128(pair1, firstPixel), 6));
+        avrg = _mm_srli_epi16(avrg, 2);
+        avrg = _mm_packus_epi16(avrg, avrg);
+
+        int32_t first = _mm_cvtsi128_si32(avrg);
+        int16_t second = (int16_t)_mm_extract_epi16(avrg, 2);
+
+        std::memcpy(&destRow[i * 3], &first, 4);
+        std::memcpy(&destRow[i * 3 + 4], &second, 2);
+    }
+#endif
+
+    for(; i < count; ++i)
+    {
+        auto src0 = &srcRow0[i * 6];
+        auto src1 = &srcRow1[i * 6];
+        auto dest = &destRow[i * 3];
+
+        dest[0] = (uint8_t)(((uint16_t)src0[0] + src0[3] + src1[0] + src1[3]) >> 2);
+        dest[1] = (uint8_t)(((uint16_t)src0[1] + src0[4] + src1[1] + src1[4]) >> 2);
+        dest[2] = (uint8_t)(((uint16_t)src0[2] + src0[5] + src1[2] + src1[5]) >> 2);
+    }
+}
+
+inline void deflateRowRGBA8(const uint8_t* const srcRow0, const uint8_t* const srcRow1, uint8_t* const destRow, size_t count)
+{
+    size_t i = 0;
+
+#ifdef BITMAP_DEFLATE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+
+    for(; i + 4 <= count; i += 4)
+    {
+        __m128i avrg[2];
+
+        for(size_t half = 0; half < 2; ++half)
+        {
+            __m128i row0 = _mm_loadu_si128((const __m128i*)&srcRow0[(i << 3) + (half << 4)]);
+            __m128i row1 = _mm_loadu_si128((const __m128i*)&srcRow1[(i << 3) + (half << 4)]);
+
+            // vertical sums of source pixels 0 and 1 (lo) and 2 and 3 (hi)
+            __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(row0, zero), _mm_unpacklo_epi8(row1, zero));
+            __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(row0, zero), _mm_unpackhi_epi8(row1, zero));
+
+            avrg[half] = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi)), 2);
+        }
+
+        _mm_storeu_si128((__m128i*)&destRow[i << 2], _mm_packus_epi16(avrg[0], avrg[1]));
+    }
+#endif
+
+    for(; i < count; ++i)
+    {
+        auto src0 = &srcRow0[i << 3];
+        auto src1 = &srcRow1[i << 3];
+        auto dest = &destRow[i << 2];
+
+        dest[0] = (uint8_t)(((uint16_t)src0[0] + src0[4] + src1[0] + src1[4]) >> 2);
+        dest[1] = (uint8_t)(((uint16_t)src0[1] + src0[5] + src1[1] + src1[5]) >> 2);
+        dest[2] = (uint8_t)(((uint16_t)src0[2] + src0[6] + src1[2] + src1[6]) >> 2);
+        dest[3] = (uint8_t)(((uint16_t)src0[3] + src0[7] + src1[3] + src1[7]) >> 2);
+    }
+}
+
 void Bitmap::_copyPixel(const uint8_t* const srcPx, PIXEL_FORMAT srcFormat, uint8_t* const destPx, PIXEL_FORMAT destFormat)
 {
     switch(srcFormat)
@@ -541,6 +671,34 @@ void Bitmap::deflateRectFrom(const Bitmap& src, size_t srcX, size_t srcY, size_t
     size_t srcPixelSize = pixelSize(src._format);
     size_t destPixelSize = pixelSize(_format);
 
+    if(src._format == _format && _format != PIXEL_FORMAT::LAB)
+    {
+        // no conversion, filter whole rows with the kernel of the format
+        size_t count = (cpyWidth + 1) >> 1;
+
+        for(size_t y = 0; y < cpyHeight; y += 2)
+        {
+            auto srcRow0 = &src._data[((srcY + y) * src._width + srcX) * srcPixelSize];
+            auto srcRow1 = &src._data[((srcY + y + 1) * src._width + srcX) * srcPixelSize];
+            auto destRow = &_data[((destY + (y >> 1)) * _width + destX) * destPixelSize];
+
+            switch(_format)
+            {
+            case PIXEL_FORMAT::R8:
+                deflateRowR8(srcRow0, srcRow1, destRow, count);
+                break;
+            case PIXEL_FORMAT::RGB8:
+                deflateRowRGB8(srcRow0, srcRow1, destRow, count);
+                break;
+            default:
+                deflateRowRGBA8(srcRow0, srcRow1, destRow, count);
+                break;
+            }
+        }
+
+        return;
+    }
+
     for(size_t y = 0; y < cpyHeight; y += 2)
     {
         for(size_t x = 0; x < cpyWidth; x += 2)
@@ -13,16 +13,29 @@ namespace pre
 {
 bool Preprocessor::_isPowerOfTwo(size_t val) { return val != 0 && (val & (val - 1)) == 0; }
 
-void memset_volatile(volatile uint8_t* s, uint8_t val, size_t n)
+void Preprocessor::_deflate(size_t writeBufferSize)
 {
-    for(size_t i = 0; i < n; ++i)
+    // Tiles of a level are deflated in batches: the inputs of a batch are read in write order, the children are
+    // filtered in parallel and the bottom and right padding, which copy from finished neighbours, are applied in
+    // write order again. Batch memory is taken from the write buffer, so the total stays within maxMemory.
+    size_t threadCount = std::max(_threadCount, (size_t)1);
+    size_t batchTileByteSize = _destTileByteSize * _DEFLATE_TILE_BUFFERS;
+    size_t batchTileCount = 1;
+
+    if(threadCount > 1)
     {
-        s[i] = val;
+        batchTileCount = std::min(threadCount * 8, (writeBufferSize >> 2) / batchTileByteSize);
+
+        if(batchTileCount > 1)
+        {
+            writeBufferSize -= batchTileCount * batchTileByteSize;
+        }
+        else
+        {
+            batchTileCount = 1;
+        }
     }
-}
 
-void Preprocessor::_deflate(size_t writeBufferSize)
-{
     size_t writeBufferTileSize = writeBufferSize / _destTileByteSize;
     writeBufferSize = writeBufferTileSize * _destTileByteSize;
 
@@ -51,22 +64,22 @@ void Preprocessor::_deflate(size_t writeBufferSize)
         }
     }
 
-    size_t bufferSize = _destTileByteSize * 12;
-    auto buffer = new uint8_t[bufferSize];
+    auto batchBuffer = new uint8_t[batchTileCount * batchTileByteSize];
+    auto neighbourBuffer = new uint8_t[_destTileByteSize * 2];
     auto writeBuffer = new uint8_t[writeBufferSize];
 
-    Bitmap bufferBitmap0(_tileWidth, _tileHeight, _destPxFormat, buffer);
-    Bitmap bufferBitmap1(_tileWidth, _tileHeight, _destPxFormat, &buffer[_destTileByteSize]);
-    Bitmap bufferBitmap2(_tileWidth, _tileHeight, _destPxFormat, &buffer[_destTileByteSize * 2]);
-    Bitmap bufferBitmap3(_tileWidth, _tileHeight, _destPxFormat, &buffer[_destTileByteSize * 3]);
-    Bitmap bufferBitmap4(_tileWidth, _tileHeight, _destPxFormat, &buffer[_destTileByteSize * 4]);
-    Bitmap bufferBitmap5(_tileWidth, _tileHeight, _destPxFormat, &buffer[_destTileByteSize * 5]);
-    Bitmap bufferBitmap6(_tileWidth, _tileHeight, _destPxFormat, &buffer[_destTileByteSize * 6]);
-    Bitmap bufferBitmap7(_tileWidth, _tileHeight, _destPxFormat, &buffer[_destTileByteSize * 7]);
-    Bitmap bufferBitmap8(_tileWidth, _tileHeight, _destPxFormat, &buffer[_destTileByteSize * 8]);
-    Bitmap bufferBitmap9(_tileWidth, _tileHeight, _destPxFormat, &buffer[_destTileByteSize * 9]);
-    Bitmap bufferBitmap10(_tileWidth, _tileHeight, _destPxFormat, &buffer[_destTileByteSize * 10]);
-    Bitmap writeBitmap(_tileWidth, _tileHeight, _destPxFormat, &buffer[_destTileByteSize * 11]);
+    Bitmap bottomBitmap(_tileWidth, _tileHeight, _destPxFormat, neighbourBuffer);
+    Bitmap rightBitmap(_tileWidth, _tileHeight, _destPxFormat, &neighbourBuffer[_destTileByteSize]);
+
+    auto getTile = [&](uint64_t id, uint8_t* out) {
+        if(_getTileById(id, writeBuffer, writeBufferFirstId, writeBufferLastId, idLookup, writeBufferTileSize, out) == 0)
+        {
+            std::memset(out, 0, _destTileByteSize);
+        }
+    };
+
+    std::vector<uint64_t> batch;
+    batch.reserve(batchTileCount);
 
     auto levelTileWidth = _imageTileWidth;
     auto levelTileHeight = _imageTileHeight;
@@ -112,267 +125,227 @@ void Preprocessor::_deflate(size_t writeBufferSize)
 
                 QuadTree::getCoordinatesInLevel(relIterationId, iterationLevel, x, y);
 
-                if(x >= iterationLevelTileWidth || y >= iterationLevelTileHeight)
+                if(x < iterationLevelTileWidth && y < iterationLevelTileHeight)
                 {
-                    continue;
+                    batch.push_back(relIterationId);
                 }
 
-                uint64_t absIterationId = firstIdOfIterationLevel + relIterationId;
-                size_t bufferOffset = 0;
-
-                for(uint8_t relQuadId = 3;; --relQuadId)
+                if(batch.empty() || (batch.size() < batchTileCount && relIterationId != 0))
                 {
-                    uint64_t relId = (relIterationId << 2) + relQuadId;
-                    uint64_t absId = firstIdOfCurrentLevel + relId;
-
-                    uint64_t len = 0;
-
-                    uint64_t childX;
-                    uint64_t childY;
-
-                    QuadTree::getCoordinatesInLevel(relId, iterationLevel + 1, childX, childY);
-
-                    if(childX < levelTileWidth && childY < levelTileHeight)
-                    {
-                        len = _getTileById(absId, writeBuffer, writeBufferFirstId, writeBufferLastId, idLookup, writeBufferTileSize, &buffer[bufferOffset]);
-                    }
-
-                    if(len == 0)
-                    {
-                        std::memset(&buffer[bufferOffset], 0, _destTileByteSize);
-                    }
-
-                    if(relQuadId == 0)
+                    if(relIterationId == 0)
                     {
                         break;
                     }
 
-                    bufferOffset += _destTileByteSize;
+                    continue;
                 }
 
-                uint64_t relId = relIterationId << 2;
+                // read the children of all tiles in the batch, including those needed for left and top padding
+                for(size_t batchIdx = 0; batchIdx < batch.size(); ++batchIdx)
+                {
+                    uint64_t batchRelId = batch[batchIdx];
+                    auto tileBuffer = &batchBuffer[batchIdx * batchTileByteSize];
 
-                uint64_t relId1 = QuadTree::getNeighbour(relId, QuadTree::NEIGHBOUR::LEFT);
-                uint64_t relId2 = QuadTree::getNeighbour(relId1, QuadTree::NEIGHBOUR::BOTTOM);
-                uint64_t relId0 = QuadTree::getNeighbour(relId1, QuadTree::NEIGHBOUR::TOP);
+                    for(uint8_t relQuadId = 3;; --relQuadId)
+                    {
+                        uint64_t relId = (batchRelId << 2) + relQuadId;
 
-                uint64_t len = 0;
+                        uint64_t childX;
+                        uint64_t childY;
 
-                bufferOffset += _destTileByteSize;
-                if(relId1 != relId)
-                    len = _getTileById(firstIdOfCurrentLevel + relId2, writeBuffer, writeBufferFirstId, writeBufferLastId, idLookup, writeBufferTileSize, &buffer[bufferOffset]);
-                if(len == 0)
-                    memset_volatile(&buffer[bufferOffset], 0, _destTileByteSize);
+                        QuadTree::getCoordinatesInLevel(relId, iterationLevel + 1, childX, childY);
 
-                bufferOffset += _destTileByteSize;
-                if(relId1 != relId)
-                    len = _getTileById(firstIdOfCurrentLevel + relId1, writeBuffer, writeBufferFirstId, writeBufferLastId, idLookup, writeBufferTileSize, &buffer[bufferOffset]);
-                if(len == 0)
-                    memset_volatile(&buffer[bufferOffset], 0, _destTileByteSize);
+                        if(childX < levelTileWidth && childY < levelTileHeight)
+                        {
+                            getTile(firstIdOfCurrentLevel + relId, tileBuffer);
+                        }
+                        else
+                        {
+                            std::memset(tileBuffer, 0, _destTileByteSize);
+                        }
 
-                len = 0;
+                        tileBuffer += _destTileByteSize;
 
-                bufferOffset += _destTileByteSize;
-                if(relId1 != relId && relId0 != relId1)
-                    len = _getTileById(firstIdOfCurrentLevel + relId0, writeBuffer, writeBufferFirstId, writeBufferLastId, idLookup, writeBufferTileSize, &buffer[bufferOffset]);
-                if(len == 0)
-                    memset_volatile(&buffer[bufferOffset], 0, _destTileByteSize);
+                        if(relQuadId == 0)
+                        {
+                            break;
+                        }
+                    }
 
-                relId0 = QuadTree::getNeighbour(relId, QuadTree::NEIGHBOUR::TOP);
-                relId1 = QuadTree::getNeighbour(relId0, QuadTree::NEIGHBOUR::RIGHT);
+                    uint64_t relId = batchRelId << 2;
 
-                len = 0;
+                    uint64_t relId1 = QuadTree::getNeighbour(relId, QuadTree::NEIGHBOUR::LEFT);
+                    uint64_t relId2 = QuadTree::getNeighbour(relId1, QuadTree::NEIGHBOUR::BOTTOM);
+                    uint64_t relId0 = QuadTree::getNeighbour(relId1, QuadTree::NEIGHBOUR::TOP);
 
-                QuadTree::getCoordinatesInLevel(relId2, iterationLevel + 1, x, y);
+                    // the left and top neighbours only exist off the border, their buffers are unused otherwise
+                    if(relId1 != relId)
+                    {
+                        getTile(firstIdOfCurrentLevel + relId2, tileBuffer);
+                        getTile(firstIdOfCurrentLevel + relId1, &tileBuffer[_destTileByteSize]);
+                    }
 
-                bufferOffset += _destTileByteSize;
-                if(relId0 != relId)
-                    len = _getTileById(firstIdOfCurrentLevel + relId1, writeBuffer, writeBufferFirstId, writeBufferLastId, idLookup, writeBufferTileSize, &buffer[bufferOffset]);
-                if(len == 0)
-                    memset_volatile(&buffer[bufferOffset], 0, _destTileByteSize);
+                    if(relId1 != relId && relId0 != relId1)
+                    {
+                        getTile(firstIdOfCurrentLevel + relId0, &tileBuffer[_destTileByteSize * 2]);
+                    }
 
-                bufferOffset += _destTileByteSize;
-                if(relId0 != relId)
-                    len = _getTileById(firstIdOfCurrentLevel + relId0, writeBuffer, writeBufferFirstId, writeBufferLastId, idLookup, writeBufferTileSize, &buffer[bufferOffset]);
-                if(len == 0)
-                    memset_volatile(&buffer[bufferOffset], 0, _destTileByteSize);
+                    relId0 = QuadTree::getNeighbour(relId, QuadTree::NEIGHBOUR::TOP);
+                    relId1 = QuadTree::getNeighbour(relId0, QuadTree::NEIGHBOUR::RIGHT);
 
-                relId0 = relIterationId;
-                relId1 = QuadTree::getNeighbour(relId0, QuadTree::NEIGHBOUR::RIGHT);
-                relId2 = QuadTree::getNeighbour(relId0, QuadTree::NEIGHBOUR::BOTTOM);
+                    if(relId0 != relId)
+                    {
+                        getTile(firstIdOfCurrentLevel + relId1, &tileBuffer[_destTileByteSize * 3]);
+                        getTile(firstIdOfCurrentLevel + relId0, &tileBuffer[_destTileByteSize * 4]);
+                    }
+                }
 
-                bufferOffset += _destTileByteSize;
-                len = _getTileById(firstIdOfIterationLevel + relId2, writeBuffer, writeBufferFirstId, writeBufferLastId, idLookup, writeBufferTileSize, &buffer[bufferOffset]);
-                if(len == 0)
-                    memset_volatile(&buffer[bufferOffset], 0, _destTileByteSize);
+                // filter the children and left and top padding
+                std::atomic<size_t> nextBatchIdx(0);
 
-                bufferOffset += _destTileByteSize;
-                len = _getTileById(firstIdOfIterationLevel + relId1, writeBuffer, writeBufferFirstId, writeBufferLastId, idLookup, writeBufferTileSize, &buffer[bufferOffset]);
-                if(len == 0)
-                    memset_volatile(&buffer[bufferOffset], 0, _destTileByteSize);
+                auto deflateBatch = [&]() {
+                    for(size_t batchIdx = nextBatchIdx++; batchIdx < batch.size(); batchIdx = nextBatchIdx++)
+                    {
+                        _deflateTile(batch[batchIdx], iterationLevel, &batchBuffer[batchIdx * batchTileByteSize]);
+                    }
+                };
 
-                bufferOffset += _destTileByteSize;
+                std::vector<std::thread> threads;
 
-                size_t halfTileWidthInner = _innerTileWidth >> 1;
-                size_t halfTileHeightInner = _innerTileHeight >> 1;
+                for(size_t i = 1; i < std::min(threadCount, batch.size()); ++i)
+                {
+                    threads.emplace_back(deflateBatch);
+                }
 
-                QuadTree::getCoordinatesInLevel(relIterationId, iterationLevel, x, y);
+                deflateBatch();
 
-                std::memset((void*)&buffer[bufferOffset], 0, _destTileByteSize);
+                for(auto& thread : threads)
+                {
+                    thread.join();
+                }
 
-                writeBitmap.deflateRectFrom(bufferBitmap0, _padding, _padding, _padding + halfTileWidthInner, _padding + (_innerTileHeight >> 1), _innerTileWidth, _innerTileHeight);
+                // pad bottom and right side from the finished neighbours and write in order
+                for(size_t batchIdx = 0; batchIdx < batch.size(); ++batchIdx)
+                {
+                    uint64_t batchRelId = batch[batchIdx];
+                    uint64_t absIterationId = firstIdOfIterationLevel + batchRelId;
+                    auto tileBuffer = &batchBuffer[batchIdx * batchTileByteSize + _destTileByteSize * (_DEFLATE_TILE_BUFFERS - 1)];
 
-                writeBitmap.deflateRectFrom(bufferBitmap1, _padding, _padding, _padding, _padding + halfTileHeightInner, _innerTileWidth, _innerTileHeight);
+                    getTile(firstIdOfIterationLevel + QuadTree::getNeighbour(batchRelId, QuadTree::NEIGHBOUR::BOTTOM), neighbourBuffer);
+                    getTile(firstIdOfIterationLevel + QuadTree::getNeighbour(batchRelId, QuadTree::NEIGHBOUR::RIGHT), &neighbourBuffer[_destTileByteSize]);
 
-                writeBitmap.deflateRectFrom(bufferBitmap2, _padding, _padding, _padding + halfTileWidthInner, _padding, _innerTileWidth, _innerTileHeight);
+                    QuadTree::getCoordinatesInLevel(batchRelId, iterationLevel, x, y);
 
-                writeBitmap.deflateRectFrom(bufferBitmap3, _padding, _padding, _padding, _padding, _innerTileWidth, _innerTileHeight);
+                    Bitmap writeBitmap(_tileWidth, _tileHeight, _destPxFormat, tileBuffer);
 
-                if(x == 0)
-                {
-                    writeBitmap.smearHorizontal(_padding, _padding, 0, _padding, _padding, _innerTileHeight);
-                }
-                else
-                {
-                    // pad lower left side
-                    writeBitmap.deflateRectFrom(bufferBitmap4, _padding + _innerTileWidth - (_padding << 1), _padding, 0, _padding + halfTileHeightInner, _padding << 1, _innerTileHeight);
+                    bool xIsLast = x == (iterationLevelTileWidth - 1);
+                    bool yIsLast = y == (iterationLevelTileHeight - 1);
 
-                    // pad upper left side
-                    writeBitmap.deflateRectFrom(bufferBitmap5, _padding + _innerTileWidth - (_padding << 1), _padding, 0, _padding, _padding << 1, _innerTileHeight);
+                    size_t padWidth = _padding;
+                    size_t padHeight = _padding;
 
-                    if(y > 0)
+                    if(xIsLast)
                     {
-                        // pad upper left corner
-                        writeBitmap.deflateRectFrom(bufferBitmap6, _padding + _innerTileWidth - (_padding << 1), _padding + _innerTileHeight - (_padding << 1), 0, 0, _padding << 1, _padding << 1);
+                        padWidth += ((levelPixelWidth - 1) % _innerTileWidth) + 1;
                     }
-                }
-
-                if(y == 0)
-                {
-                    // pad top side
-                    writeBitmap.smearVertical(0, _padding, 0, 0, _padding + _innerTileWidth, _padding);
-                }
-                else
-                {
-                    // pad right top side
-                    writeBitmap.deflateRectFrom(bufferBitmap7, _padding, _padding + _innerTileHeight - (_padding << 1), _padding + halfTileWidthInner, 0, _innerTileWidth, _padding << 1);
-
-                    // pad left top side
-                    writeBitmap.deflateRectFrom(bufferBitmap8, _padding, _padding + _innerTileHeight - (_padding << 1), _padding, 0, _innerTileWidth, _padding << 1);
-
-                    if(x == 0)
+                    else
                     {
-                        // pad upper left corner
-                        writeBitmap.smearHorizontal(_padding, 0, 0, 0, _padding, _padding);
+                        padWidth += _innerTileWidth;
                     }
-                }
-
-                bool xIsLast = x == (iterationLevelTileWidth - 1);
-                bool yIsLast = y == (iterationLevelTileHeight - 1);
-
-                size_t padWidth = _padding;
-                size_t padHeight = _padding;
 
-                if(xIsLast)
-                {
-                    padWidth += ((levelPixelWidth - 1) % _innerTileWidth) + 1;
-                }
-                else
-                {
-                    padWidth += _innerTileWidth;
-                }
+                    if(yIsLast)
+                    {
+                        padHeight += ((levelPixelHeight - 1) % _innerTileHeight) + 1;
+                    }
+                    else
+                    {
+                        padHeight += _innerTileHeight;
+                    }
 
-                if(yIsLast)
-                {
-                    padHeight += ((levelPixelHeight - 1) % _innerTileHeight) + 1;
-                }
-                else
-                {
-                    padHeight += _innerTileHeight;
-                }
+                    if(yIsLast)
+                    {
+                        // pad bottom side
+                        writeBitmap.smearVertical(0, padHeight - 1, 0, padHeight, padWidth, _padding);
 
-                if(yIsLast)
-                {
-                    // pad bottom side
-                    writeBitmap.smearVertical(0, padHeight - 1, 0, padHeight, padWidth, _padding);
+                        uint8_t transPx[4] = {0x00, 0x00, 0x00, 0x00};
 
-                    uint8_t transPx[4] = {0x00, 0x00, 0x00, 0x00};
+                        writeBitmap.fillRect(transPx, Bitmap::PIXEL_FORMAT::RGBA8, 0, padHeight + _padding, padWidth + _padding, _tileHeight - padHeight - _padding);
+                    }
+                    else
+                    {
+                        // pad bottom side
+                        writeBitmap.copyRectFrom(bottomBitmap, 0, _padding, 0, _padding + _innerTileHeight, padWidth + _padding, _padding);
+                    }
 
-                    writeBitmap.fillRect(transPx, Bitmap::PIXEL_FORMAT::RGBA8, 0, padHeight + _padding, padWidth + _padding, _tileHeight - padHeight - _padding);
-                }
-                else
-                {
-                    // pad bottom side
-                    writeBitmap.copyRectFrom(bufferBitmap9, 0, _padding, 0, _padding + _innerTileHeight, padWidth + _padding, _padding);
-                }
+                    if(xIsLast)
+                    {
+                        // pad right side
+                        writeBitmap.smearHorizontal(padWidth - 1, 0, padWidth, 0, _padding, padHeight + _padding);
 
-                if(xIsLast)
-                {
-                    // pad right side
-                    writeBitmap.smearHorizontal(padWidth - 1, 0, padWidth, 0, _padding, padHeight + _padding);
+                        uint8_t transPx[4] = {0x00, 0x00, 0x00, 0x00};
 
-                    uint8_t transPx[4] = {0x00, 0x00, 0x00, 0x00};
+                        writeBitmap.fillRect(transPx, Bitmap::PIXEL_FORMAT::RGBA8, padWidth + _padding, 0, _tileWidth - padWidth - _padding, _tileHeight);
+                    }
+                    else
+                    {
+                        // pad right side
+                        writeBitmap.copyRectFrom(rightBitmap, _padding, 0, _padding + _innerTileWidth, 0, _padding, padHeight + _padding);
+                    }
 
-                    writeBitmap.fillRect(transPx, Bitmap::PIXEL_FORMAT::RGBA8, padWidth + _padding, 0, _tileWidth - padWidth - _padding, _tileHeight);
-                }
-                else
-                {
-                    // pad right side
-                    writeBitmap.copyRectFrom(bufferBitmap10, _padding, 0, _padding + _innerTileWidth, 0, _padding, padHeight + _padding);
-                }
+                    if(_destLayout == AtlasFile::LAYOUT::RAW)
+                    {
+                        currentOffset = absIterationId * _destTileByteSize;
+                        _offsetIndex->set(absIterationId, currentOffset, _destTileByteSize);
 
-                if(_destLayout == AtlasFile::LAYOUT::RAW)
-                {
-                    currentOffset = absIterationId * _destTileByteSize;
-                    _offsetIndex->set(absIterationId, currentOffset, _destTileByteSize);
+                        while(currentOffset < writeBufferOffset)
+                        {
+                            std::memset(writeBuffer, 0x00, lastWriteOffset - writeBufferOffset);
 
-                    while(currentOffset < writeBufferOffset)
-                    {
-                        std::memset(writeBuffer, 0x00, lastWriteOffset - writeBufferOffset);
+                            _destPayloadFile.seekp(_destPayloadOffset + writeBufferOffset);
+                            _destPayloadFile.write((char*)writeBuffer, std::min(writeBufferSize, offsetAfterLastTile - writeBufferOffset));
 
-                        _destPayloadFile.seekp(_destPayloadOffset + writeBufferOffset);
-                        _destPayloadFile.write((char*)writeBuffer, std::min(writeBufferSize, offsetAfterLastTile - writeBufferOffset));
+                            lastWriteOffset = writeBufferOffset;
+                            writeBufferOffset -= writeBufferSize;
+                            writeBufferFirstId -= writeBufferTileSize;
+                        }
 
-                        lastWriteOffset = writeBufferOffset;
-                        writeBufferOffset -= writeBufferSize;
-                        writeBufferFirstId -= writeBufferTileSize;
+                        std::memset(&writeBuffer[currentOffset - writeBufferOffset + _destTileByteSize], 0x00, lastWriteOffset - currentOffset - _destTileByteSize);
+                        std::memcpy(&writeBuffer[currentOffset - writeBufferOffset], (char*)tileBuffer, _destTileByteSize);
+                        lastWriteOffset = currentOffset;
                     }
-
-                    std::memset(&writeBuffer[currentOffset - writeBufferOffset + _destTileByteSize], 0x00, lastWriteOffset - currentOffset - _destTileByteSize);
-                    std::memcpy(&writeBuffer[currentOffset - writeBufferOffset], (char*)&buffer[bufferOffset], _destTileByteSize);
-                    lastWriteOffset = currentOffset;
-                }
-                else
-                {
-                    if((currentOffset + _destTileByteSize) > (writeBufferOffset + writeBufferSize))
+                    else
                     {
-                        _destPayloadFile.seekp(_destPayloadOffset + writeBufferOffset);
-                        _destPayloadFile.write((char*)writeBuffer, writeBufferSize);
+                        if((currentOffset + _destTileByteSize) > (writeBufferOffset + writeBufferSize))
+                        {
+                            _destPayloadFile.seekp(_destPayloadOffset + writeBufferOffset);
+                            _destPayloadFile.write((char*)writeBuffer, writeBufferSize);
 
-                        writeBufferOffset += writeBufferSize;
-                    }
+                            writeBufferOffset += writeBufferSize;
+                        }
 
-                    // std::cout << currentOffset << std::endl;
-                    _offsetIndex->set(absIterationId, currentOffset, _destTileByteSize);
+                        _offsetIndex->set(absIterationId, currentOffset, _destTileByteSize);
 
-                    std::memcpy(&writeBuffer[currentOffset - writeBufferOffset], (char*)&buffer[bufferOffset], _destTileByteSize);
-                    writeBufferLastId = idLookup[(((currentOffset - writeBufferOffset) / _destTileByteSize) + 1) % writeBufferTileSize];
-                    writeBufferFirstId = absIterationId;
-                    idLookup[(currentOffset - writeBufferOffset) / _destTileByteSize] = absIterationId;
-                    currentOffset += _destTileByteSize;
-                }
+                        std::memcpy(&writeBuffer[currentOffset - writeBufferOffset], (char*)tileBuffer, _destTileByteSize);
+                        writeBufferLastId = idLookup[(((currentOffset - writeBufferOffset) / _destTileByteSize) + 1) % writeBufferTileSize];
+                        writeBufferFirstId = absIterationId;
+                        idLookup[(currentOffset - writeBufferOffset) / _destTileByteSize] = absIterationId;
+                        currentOffset += _destTileByteSize;
+                    }
 
 #ifdef PREPROCESSOR_LOG_PROGRESS
-                ++tilesWritten;
-                auto currentProgress = (uint8_t)(tilesWritten * 100 / iterationLevelTileWidth / iterationLevelTileHeight);
+                    ++tilesWritten;
+                    auto currentProgress = (uint8_t)(tilesWritten * 100 / iterationLevelTileWidth / iterationLevelTileHeight);
 
-                if(currentProgress != progress)
-                {
-                    progress = currentProgress;
-                    std::cout << '\r' << std::setw(3) << (int)progress << " %";
-                    std::cout.flush();
-                }
+                    if(currentProgress != progress)
+                    {
+                        progress = currentProgress;
+                        std::cout << '\r' << std::setw(3) << (int)progress << " %";
+                        std::cout.flush();
+                    }
 #endif
+                }
+
+                batch.clear();
 
                 if(relIterationId == 0)
                 {
@@ -413,11 +386,83 @@ void Preprocessor::_deflate(size_t writeBufferSize)
     _destIndexFile->seekp(_destCielabIndexOffset);
     _cielabIndex->writeToFile(*_destIndexFile);
 
-    delete[] buffer;
+    delete[] batchBuffer;
+    delete[] neighbourBuffer;
     delete[] writeBuffer;
     delete[] idLookup;
 }
 
+void Preprocessor::_deflateTile(uint64_t relIterationId, size_t iterationLevel, uint8_t* buffer)
+{
+    Bitmap bufferBitmap0(_tileWidth, _tileHeight, _destPxFormat, buffer);
+    Bitmap bufferBitmap1(_tileWidth, _tileHeight, _destPxFormat, &buffer[_destTileByteSize]);
+    Bitmap bufferBitmap2(_tileWidth, _tileHeight, _destPxFormat, &buffer[_destTileByteSize * 2]);
+    Bitmap bufferBitmap3(_tileWidth, _tileHeight, _destPxFormat, &buffer[_destTileByteSize * 3]);
+    Bitmap bufferBitmap4(_tileWidth, _tileHeight, _destPxFormat, &buffer[_destTileByteSize * 4]);
+    Bitmap bufferBitmap5(_tileWidth, _tileHeight, _destPxFormat, &buffer[_destTileByteSize * 5]);
+    Bitmap bufferBitmap6(_tileWidth, _tileHeight, _destPxFormat, &buffer[_destTileByteSize * 6]);
+    Bitmap bufferBitmap7(_tileWidth, _tileHeight, _destPxFormat, &buffer[_destTileByteSize * 7]);
+    Bitmap bufferBitmap8(_tileWidth, _tileHeight, _destPxFormat, &buffer[_destTileByteSize * 8]);
+    Bitmap writeBitmap(_tileWidth, _tileHeight, _destPxFormat, &buffer[_destTileByteSize * 9]);
+
+    size_t halfTileWidthInner = _innerTileWidth >> 1;
+    size_t halfTileHeightInner = _innerTileHeight >> 1;
+
+    uint64_t x;
+    uint64_t y;
+
+    QuadTree::getCoordinatesInLevel(relIterationId, iterationLevel, x, y);
+
+    std::memset((void*)writeBitmap.getData(), 0, _destTileByteSize);
+
+    writeBitmap.deflateRectFrom(bufferBitmap0, _padding, _padding, _padding + halfTileWidthInner, _padding + halfTileHeightInner, _innerTileWidth, _innerTileHeight);
+
+    writeBitmap.deflateRectFrom(bufferBitmap1, _padding, _padding, _padding, _padding + halfTileHeightInner, _innerTileWidth, _innerTileHeight);
+
+    writeBitmap.deflateRectFrom(bufferBitmap2, _padding, _padding, _padding + halfTileWidthInner, _padding, _innerTileWidth, _innerTileHeight);
+
+    writeBitmap.deflateRectFrom(bufferBitmap3, _padding, _padding, _padding, _padding, _innerTileWidth, _innerTileHeight);
+
+    if(x == 0)
+    {
+        writeBitmap.smearHorizontal(_padding, _padding, 0, _padding, _padding, _innerTileHeight);
+    }
+    else
+    {
+        // pad lower left side
+        writeBitmap.deflateRectFrom(bufferBitmap4, _padding + _innerTileWidth - (_padding << 1), _padding, 0, _padding + halfTileHeightInner, _padding << 1, _innerTileHeight);
+
+        // pad upper left side
+        writeBitmap.deflateRectFrom(bufferBitmap5, _padding + _innerTileWidth - (_padding << 1), _padding, 0, _padding, _padding << 1, _innerTileHeight);
+
+        if(y > 0)
+        {
+            // pad upper left corner
+            writeBitmap.deflateRectFrom(bufferBitmap6, _padding + _innerTileWidth - (_padding << 1), _padding + _innerTileHeight - (_padding << 1), 0, 0, _padding << 1, _padding << 1);
+        }
+    }
+
+    if(y == 0)
+    {
+        // pad top side
+        writeBitmap.smearVertical(0, _padding, 0, 0, _padding + _innerTileWidth, _padding);
+    }
+    else
+    {
+        // pad right top side
+        writeBitmap.deflateRectFrom(bufferBitmap7, _padding, _padding + _innerTileHeight - (_padding << 1), _padding + halfTileWidthInner, 0, _innerTileWidth, _padding << 1);
+
+        // pad left top side
+        writeBitmap.deflateRectFrom(bufferBitmap8, _padding, _padding + _innerTileHeight - (_padding << 1), _padding, 0, _innerTileWidth, _padding << 1);
+
+        if(x == 0)
+        {
+            // pad upper left corner
+            writeBitmap.smearHorizontal(_padding, 0, 0, 0, _padding, _padding);
+        }
+    }
+}
+
 size_t Preprocessor::_getTileById(uint64_t id, const uint8_t* buffer, uint64_t firstIdInBuffer, uint64_t lastIdInBuffer, const uint64_t* idLookup, size_t bufferTileLen, uint8_t* out)
 {
     size_t len = _getBufferedTileById(id, buffer, firstIdInBuffer, lastIdInBuffer, idLookup, bufferTileLen, out);
@@ -504,6 +549,7 @@ Preprocessor::Preprocessor(const std::string& srcFileName, Bitmap::PIXEL_FORMAT
     _destHeaderFile = nullptr;
     _destIndexFile = nullptr;
     _destCombined = DEST_COMBINED::NONE;
+    _threadCount = std::max(std::thread::hardware_concurrency(), 1u);
 
     _srcFileName = srcFileName;
     _srcPxFormat = srcPxFormat;
@@ -1042,6 +1088,8 @@ void Preprocessor::_extract(size_t bufferTileWidth, size_t writeBufferSize)
     delete[] writeBuffer;
 }
 
+void Preprocessor::setThreadCount(size_t threadCount) { _threadCount = threadCount; }
+
 void Preprocessor::run(size_t maxMemory)
 {
 #ifdef PREPROCESSOR_LOG_PROGRESS